@@ -0,0 +1,618 @@
+/*!
+* \brief Benchmark of the matrix kernels and of the full Kalman filter cycle
+*
+* Every kernel declared in matrix.h, matrix_q.h and cholesky.h is timed for square operands of each
+* dimension in {\ref bench_sizes}; kalman_predict() followed by kalman_correct() is timed for every
+* combination of state, input and measurement dimension from the same list. All runs are repeated for
+* each matrix backend supported by the CPU.
+*
+* The results are written to stdout as a JSON document with one record per run:
+*
+* \code{.json}
+* { "benchmarks": [
+*   { "name": "matrix_mult", "backend": "scalar", "states": 8, "inputs": 8, "measurements": 8,
+*     "ns_per_op": 123.4, "gflops": 8.3, "bytes_per_op": 768 },
+*   ...
+* ] }
+* \endcode
+*
+* For the kernels, all three dimension fields hold the operand dimension. The FLOP counts are the
+* multiply-add count of the algorithm times two; bytes/op counts every operand read or written once.
+* Kernels that work in place are timed together with restoring their input where that is required to
+* keep the numbers meaningful, which is noted in the respective case.
+*
+* Build from the repository root with e.g.
+*
+* \code
+* gcc -std=gnu99 -O3 -Iinclude benchmark/benchmark.c src/matrix.c src/matrix_avx2.c src/matrix_q.c src/cholesky.c src/kalman.c -lm -o kalman_benchmark
+* \endcode
+*
+* and run with \c --quick to only use a reduced set of dimensions.
+*/
+
+#define EXTERN_INLINE_MATRIX static INLINE
+#define EXTERN_INLINE_KALMAN static INLINE
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "matrix.h"
+#include "matrix_q.h"
+#include "cholesky.h"
+#include "kalman.h"
+
+/************************************************************************/
+/* Configuration                                                        */
+/************************************************************************/
+
+// largest dimension of any operand
+#define BENCH_MAX_DIM       (64)
+
+// minimum duration of one timed batch, in nanoseconds
+#define BENCH_MIN_BATCH_NS  (500000.0)
+
+// number of timed batches, the fastest one is reported
+#define BENCH_BATCHES       (3)
+
+// fractional bits of the fixed-point operands
+#define BENCH_Q_FRACTION_BITS (16)
+
+// the dimensions to sweep
+static const uint_fast8_t bench_sizes[] = { 1, 2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64 };
+static const uint_fast8_t bench_sizes_quick[] = { 1, 4, 16, 64 };
+
+/************************************************************************/
+/* Operands                                                             */
+/************************************************************************/
+
+static matrix_data_t buffer_a[BENCH_MAX_DIM * BENCH_MAX_DIM];
+static matrix_data_t buffer_b[BENCH_MAX_DIM * BENCH_MAX_DIM];
+static matrix_data_t buffer_c[BENCH_MAX_DIM * BENCH_MAX_DIM];
+static matrix_data_t buffer_spd[BENCH_MAX_DIM * BENCH_MAX_DIM];
+static matrix_data_t buffer_aux[BENCH_MAX_DIM];
+static matrix_q_data_t buffer_qa[BENCH_MAX_DIM * BENCH_MAX_DIM];
+static matrix_q_data_t buffer_qb[BENCH_MAX_DIM * BENCH_MAX_DIM];
+static matrix_q_data_t buffer_qc[BENCH_MAX_DIM * BENCH_MAX_DIM];
+static matrix_q_data_t buffer_qspd[BENCH_MAX_DIM * BENCH_MAX_DIM];
+static matrix_data_t buffer_w[BENCH_MAX_DIM];
+static matrix_data_t buffer_ud[BENCH_MAX_DIM * (BENCH_MAX_DIM + 1) / 2];
+static matrix_wide_t buffer_wide[BENCH_MAX_DIM * BENCH_MAX_DIM];
+static matrix_wide_t buffer_wide_aux[BENCH_MAX_DIM];
+static uint_fast16_t buffer_offsets[2 * BENCH_MAX_DIM + 1];
+static uint_fast8_t buffer_columns[BENCH_MAX_DIM * BENCH_MAX_DIM];
+
+/*!
+* \brief The operands of a kernel benchmark
+*/
+typedef struct
+{
+    matrix_t a, b, c, spd, x, y;
+    matrix_q_t qa, qb, qc, qspd, qx, qy;
+    matrix_sparsity_t sparsity;
+    uint_fast8_t n;
+} bench_operands_t;
+
+/*!
+* \brief Fills the operand buffers with well-conditioned values of dimension {\ref n}.
+*
+* A is a cyclic permutation, so that repeated in-place products neither grow nor decay, B holds small
+* values and SPD is symmetric and diagonally dominant.
+*/
+static void bench_prepare(bench_operands_t *ops, uint_fast8_t n)
+{
+    uint_fast8_t i, j;
+
+    for (i = 0; i < n; ++i)
+    {
+        for (j = 0; j < n; ++j)
+        {
+            buffer_a[i * n + j] = (j == (i + 1) % n) ? 1 : 0;
+            buffer_b[i * n + j] = (matrix_data_t)1e-3 * (matrix_data_t)((i * 7 + j * 3) % 11);
+            buffer_c[i * n + j] = (i == j) ? 1 : 0;
+            buffer_spd[i * n + j] = (i == j) ? (matrix_data_t)(n + 1) : (matrix_data_t)1 / (matrix_data_t)(1 + i + j);
+        }
+    }
+
+    matrix_init(&ops->a, n, n, buffer_a);
+    matrix_init(&ops->b, n, n, buffer_b);
+    matrix_init(&ops->c, n, n, buffer_c);
+    matrix_init(&ops->spd, n, n, buffer_spd);
+    matrix_init(&ops->x, n, 1, &buffer_b[0]);
+    matrix_init(&ops->y, n, 1, &buffer_c[0]);
+    matrix_q_init(&ops->qa, n, n, BENCH_Q_FRACTION_BITS, buffer_qa);
+    matrix_q_init(&ops->qb, n, n, BENCH_Q_FRACTION_BITS, buffer_qb);
+    matrix_q_init(&ops->qc, n, n, BENCH_Q_FRACTION_BITS, buffer_qc);
+    matrix_q_init(&ops->qspd, n, n, BENCH_Q_FRACTION_BITS, buffer_qspd);
+    matrix_q_init(&ops->qx, n, 1, BENCH_Q_FRACTION_BITS, &buffer_qb[0]);
+    matrix_q_init(&ops->qy, n, 1, BENCH_Q_FRACTION_BITS, &buffer_qc[0]);
+    ops->sparsity.offsets = buffer_offsets;
+    ops->sparsity.columns = buffer_columns;
+    ops->n = n;
+}
+
+/*!
+* \brief Negates every other row of the cyclic permutation in A and determines its sparsity pattern.
+*
+* A stays orthogonal, and half of its rows take the unit path of the sparse kernels and half the general one.
+*/
+static void bench_prepare_sparse(bench_operands_t *ops)
+{
+    uint_fast8_t i;
+
+    for (i = 1; i < ops->n; i += 2)
+    {
+        buffer_a[i * ops->n + (i + 1) % ops->n] = -1;
+    }
+
+    matrix_sparsity_analyze(&ops->a, &ops->sparsity);
+}
+
+/*!
+* \brief Converts A, B, C and SPD to fixed-point.
+*/
+static void bench_prepare_q(bench_operands_t *ops)
+{
+    matrix_q_from_float(&ops->a, &ops->qa);
+    matrix_q_from_float(&ops->b, &ops->qb);
+    matrix_q_from_float(&ops->c, &ops->qc);
+    matrix_q_from_float(&ops->spd, &ops->qspd);
+}
+
+/*!
+* \brief Converts the operands to fixed-point and factors SPD.
+*/
+static void bench_prepare_q_factored(bench_operands_t *ops)
+{
+    bench_prepare_q(ops);
+    cholesky_decompose_lower_q(&ops->qspd);
+}
+
+/*!
+* \brief Factors SPD into the packed U*D*U' buffer.
+*/
+static void bench_prepare_udu(bench_operands_t *ops)
+{
+    cholesky_decompose_udu(&ops->spd, buffer_ud);
+}
+
+/*!
+* \brief Fills the weights with equal weights summing to one.
+*/
+static void bench_prepare_weights(bench_operands_t *ops)
+{
+    uint_fast8_t i;
+
+    for (i = 0; i < ops->n; ++i)
+    {
+        buffer_w[i] = (matrix_data_t)1 / (matrix_data_t)ops->n;
+    }
+}
+
+/*!
+* \brief Widens SPD into the double precision buffer.
+*/
+static void bench_widen_spd(const bench_operands_t *ops)
+{
+    uint_fast16_t i;
+
+    for (i = 0; i < (uint_fast16_t)ops->n * ops->n; ++i)
+    {
+        buffer_wide[i] = buffer_spd[i];
+    }
+}
+
+/*!
+* \brief Factors SPD in double precision into the wide buffer.
+*/
+static void bench_prepare_wide_factored(bench_operands_t *ops)
+{
+    bench_widen_spd(ops);
+    cholesky_decompose_lower_wide(buffer_wide, ops->n);
+}
+
+/************************************************************************/
+/* Timing                                                               */
+/************************************************************************/
+
+/*!
+* \brief Reads the monotonic clock.
+* \return The time in nanoseconds.
+*/
+static double bench_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/*!
+* \brief Times a benchmark case.
+* \param[in] run The case to run
+* \param[in] context The argument to the case
+* \return The time per call in nanoseconds.
+*/
+static double bench_time(void (*run)(void *context), void *context)
+{
+    unsigned long iterations = 1, i;
+    double best = 0;
+    int batch;
+
+    // grow the batch until it takes long enough to be timed reliably
+    for (;;)
+    {
+        const double start = bench_now();
+        for (i = 0; i < iterations; ++i) run(context);
+        if (bench_now() - start >= BENCH_MIN_BATCH_NS) break;
+        iterations *= 2;
+    }
+
+    for (batch = 0; batch < BENCH_BATCHES; ++batch)
+    {
+        const double start = bench_now();
+        double elapsed;
+        for (i = 0; i < iterations; ++i) run(context);
+        elapsed = (bench_now() - start) / (double)iterations;
+        if (batch == 0 || elapsed < best) best = elapsed;
+    }
+
+    return best;
+}
+
+static int bench_first_record = 1;
+
+/*!
+* \brief Writes one JSON record.
+*/
+static void bench_report(const char *name, const char *backend, uint_fast8_t states, uint_fast8_t inputs, uint_fast8_t measurements,
+    double ns, double flops, double bytes)
+{
+    printf("%s\n    { \"name\": \"%s\", \"backend\": \"%s\", \"states\": %u, \"inputs\": %u, \"measurements\": %u, "
+           "\"ns_per_op\": %.3f, \"gflops\": %.4f, \"bytes_per_op\": %.0f }",
+           bench_first_record ? "" : ",", name, backend, (unsigned)states, (unsigned)inputs, (unsigned)measurements,
+           ns, flops / ns, bytes);
+    bench_first_record = 0;
+}
+
+/************************************************************************/
+/* Kernel cases                                                         */
+/************************************************************************/
+
+#define OPS ((bench_operands_t*)context)
+
+static void run_matrix_mult(void *context)                      { matrix_mult(&OPS->a, &OPS->b, &OPS->c, buffer_aux); }
+static void run_matrix_mult_transb(void *context)               { matrix_mult_transb(&OPS->a, &OPS->b, &OPS->c); }
+static void run_matrix_multadd_transb(void *context)            { matrix_multadd_transb(&OPS->a, &OPS->b, &OPS->c); }
+static void run_matrix_multscale_transb(void *context)          { matrix_multscale_transb(&OPS->a, &OPS->b, (matrix_data_t)0.5, &OPS->c); }
+static void run_matrix_mult_transb_symmetric(void *context)     { matrix_mult_transb_symmetric(&OPS->a, &OPS->b, &OPS->c); }
+static void run_matrix_multadd_transb_symmetric(void *context)  { matrix_multadd_transb_symmetric(&OPS->a, &OPS->b, &OPS->c); }
+static void run_matrix_multscale_transb_symmetric(void *context){ matrix_multscale_transb_symmetric(&OPS->a, &OPS->b, (matrix_data_t)0.5, &OPS->c); }
+static void run_matrix_mult_rowvector(void *context)            { matrix_mult_rowvector(&OPS->a, &OPS->x, &OPS->y); }
+static void run_matrix_multadd_rowvector(void *context)         { matrix_multadd_rowvector(&OPS->a, &OPS->x, &OPS->y); }
+static void run_matrix_mult_abat(void *context)                 { matrix_mult_abat(&OPS->a, &OPS->c, 1, (matrix_t*)0, (matrix_t*)0, buffer_aux); }
+static void run_matrix_multsub_symmetric(void *context)         { matrix_multsub_symmetric(&OPS->b, &OPS->b, &OPS->c); }
+static void run_matrix_invert_lower(void *context)              { matrix_invert_lower(&OPS->spd, &OPS->c); }
+static void run_matrix_copy(void *context)                      { matrix_copy(&OPS->b, &OPS->c); }
+static void run_matrix_add_inplace(void *context)               { matrix_add_inplace(&OPS->c, &OPS->b); }
+static void run_matrix_sub_inplace_b(void *context)             { matrix_sub_inplace_b(&OPS->b, &OPS->c); }
+static void run_matrix_sub(void *context)                       { matrix_sub(&OPS->b, &OPS->spd, &OPS->c); }
+static void run_cholesky_solve_transb(void *context)            { cholesky_solve_transb(&OPS->spd, &OPS->b, &OPS->c); }
+static void run_matrix_sparsity_analyze(void *context)          { matrix_sparsity_analyze(&OPS->a, &OPS->sparsity); }
+static void run_matrix_mult_rowvector_sparse(void *context)     { matrix_mult_rowvector_sparse(&OPS->a, &OPS->sparsity, &OPS->x, &OPS->y); }
+static void run_matrix_mult_abat_sparse(void *context)          { matrix_mult_abat_sparse(&OPS->a, &OPS->sparsity, &OPS->c, 1, (matrix_t*)0, (matrix_t*)0, buffer_aux); }
+
+// the decomposition works in place, so the input is restored on every call
+static void run_cholesky_decompose_lower(void *context)
+{
+    matrix_copy(&OPS->b, &OPS->c);
+    cholesky_decompose_lower(&OPS->c);
+}
+
+// the triangularization works in place, so the input is restored on every call
+static void run_matrix_triangularize_lower(void *context)
+{
+    matrix_copy(&OPS->spd, &OPS->c);
+    matrix_triangularize_lower(&OPS->c);
+}
+
+static void run_matrix_q_from_float(void *context)              { matrix_q_from_float(&OPS->b, &OPS->qc); }
+static void run_matrix_q_to_float(void *context)                { matrix_q_to_float(&OPS->qb, &OPS->c); }
+static void run_matrix_q_mult(void *context)                    { matrix_q_mult(&OPS->qa, &OPS->qb, &OPS->qc); }
+static void run_matrix_q_mult_transb(void *context)             { matrix_q_mult_transb(&OPS->qa, &OPS->qb, &OPS->qc); }
+static void run_matrix_q_mult_rowvector(void *context)          { matrix_q_mult_rowvector(&OPS->qa, &OPS->qx, &OPS->qy); }
+static void run_matrix_q_multadd_rowvector(void *context)       { matrix_q_multadd_rowvector(&OPS->qa, &OPS->qx, &OPS->qy); }
+static void run_matrix_q_multsub(void *context)                 { matrix_q_multsub(&OPS->qb, &OPS->qb, &OPS->qc); }
+static void run_matrix_q_add_inplace(void *context)             { matrix_q_add_inplace(&OPS->qc, &OPS->qb); }
+static void run_matrix_q_sub_inplace_b(void *context)           { matrix_q_sub_inplace_b(&OPS->qb, &OPS->qc); }
+static void run_cholesky_solve_transb_q(void *context)          { cholesky_solve_transb_q(&OPS->qspd, &OPS->qb, &OPS->qc); }
+
+// the decomposition works in place, so the input is restored on every call
+static void run_cholesky_decompose_lower_q(void *context)
+{
+    matrix_q_from_float(&OPS->spd, &OPS->qc);
+    cholesky_decompose_lower_q(&OPS->qc);
+}
+
+static void run_matrix_multadd_weighted_transb(void *context)   { matrix_multadd_weighted_transb(&OPS->b, buffer_w, &OPS->spd, &OPS->c); }
+static void run_cholesky_decompose_udu(void *context)           { cholesky_decompose_udu(&OPS->spd, buffer_ud); }
+static void run_cholesky_compose_udu(void *context)             { cholesky_compose_udu(buffer_ud, &OPS->c); }
+static void run_cholesky_solve_transb_wide(void *context)       { cholesky_solve_transb_wide(buffer_wide, &OPS->b, &OPS->c, buffer_wide_aux); }
+
+// the decomposition works in place, so the input is restored on every call
+static void run_cholesky_decompose_lower_wide(void *context)
+{
+    bench_widen_spd(OPS);
+    cholesky_decompose_lower_wide(buffer_wide, OPS->n);
+}
+
+#undef OPS
+
+/*!
+* \brief A kernel benchmark case
+*/
+typedef struct
+{
+    const char *name;
+    void (*run)(void *context);
+
+    // multiply-adds and elements touched, in units of n^3, n^2 and n
+    double madd3, madd2, madd1, elements2, elements1;
+
+    // nonzero if the case needs a factored SPD matrix in spd
+    int factored;
+
+    // nonzero if the case needs an SPD matrix in b (restored on each call)
+    int spd_in_b;
+
+    // optional further preparation of the operands; may be null
+    void (*prepare)(bench_operands_t *ops);
+} bench_kernel_t;
+
+static const bench_kernel_t bench_kernels[] = {
+    { "matrix_mult",                        run_matrix_mult,                        1.0,     0,   0,   3, 1, 0, 0, 0 },
+    { "matrix_mult_transb",                 run_matrix_mult_transb,                 1.0,     0,   0,   3, 0, 0, 0, 0 },
+    { "matrix_multadd_transb",              run_matrix_multadd_transb,              1.0,     0,   0,   4, 0, 0, 0, 0 },
+    { "matrix_multscale_transb",            run_matrix_multscale_transb,            1.0,     0,   0,   3, 0, 0, 0, 0 },
+    { "matrix_mult_transb_symmetric",       run_matrix_mult_transb_symmetric,       0.5,     0.5, 0,   3, 0, 0, 0, 0 },
+    { "matrix_multadd_transb_symmetric",    run_matrix_multadd_transb_symmetric,    0.5,     0.5, 0,   4, 0, 0, 0, 0 },
+    { "matrix_multscale_transb_symmetric",  run_matrix_multscale_transb_symmetric,  0.5,     0.5, 0,   3, 0, 0, 0, 0 },
+    { "matrix_mult_rowvector",              run_matrix_mult_rowvector,              0,       1,   0,   1, 2, 0, 0, 0 },
+    { "matrix_multadd_rowvector",           run_matrix_multadd_rowvector,           0,       1,   0,   1, 3, 0, 0, 0 },
+    { "matrix_mult_abat",                   run_matrix_mult_abat,                   1.5,     0.5, 0,   3, 1, 0, 0, 0 },
+    { "matrix_multsub_symmetric",           run_matrix_multsub_symmetric,           0.5,     0.5, 0,   4, 0, 0, 0, 0 },
+    { "matrix_invert_lower",                run_matrix_invert_lower,                0.5,     0,   0,   2, 0, 1, 0, 0 },
+    { "matrix_copy",                        run_matrix_copy,                        0,       0,   0,   2, 0, 0, 0, 0 },
+    { "matrix_add_inplace",                 run_matrix_add_inplace,                 0,       0.5, 0,   3, 0, 0, 0, 0 },
+    { "matrix_sub_inplace_b",               run_matrix_sub_inplace_b,               0,       0.5, 0,   3, 0, 0, 0, 0 },
+    { "matrix_sub",                         run_matrix_sub,                         0,       0.5, 0,   3, 0, 0, 0, 0 },
+    { "cholesky_decompose_lower",           run_cholesky_decompose_lower,           1.0 / 6, 0,   0,   3, 0, 0, 1, 0 },
+    { "cholesky_solve_transb",              run_cholesky_solve_transb,              1.0,     0,   0,   3, 0, 1, 0, 0 },
+    { "matrix_sparsity_analyze",            run_matrix_sparsity_analyze,            0,       0,   0,   1, 3, 0, 0, bench_prepare_sparse },
+    { "matrix_mult_rowvector_sparse",       run_matrix_mult_rowvector_sparse,       0,       0,   1,   0, 6, 0, 0, bench_prepare_sparse },
+    { "matrix_mult_abat_sparse",            run_matrix_mult_abat_sparse,            0,       1.5, 0.5, 2, 5, 0, 0, bench_prepare_sparse },
+    { "cholesky_decompose_lower_wide",      run_cholesky_decompose_lower_wide,      1.0 / 6, 0,   0,   3, 0, 0, 0, 0 },
+    { "cholesky_solve_transb_wide",         run_cholesky_solve_transb_wide,         1.0,     0,   0,   3, 1, 0, 0, bench_prepare_wide_factored },
+    { "matrix_q_from_float",                run_matrix_q_from_float,                0,       0,   0,   2, 0, 0, 0, 0 },
+    { "matrix_q_to_float",                  run_matrix_q_to_float,                  0,       0,   0,   2, 0, 0, 0, bench_prepare_q },
+    { "matrix_q_mult",                      run_matrix_q_mult,                      1.0,     0,   0,   3, 0, 0, 0, bench_prepare_q },
+    { "matrix_q_mult_transb",               run_matrix_q_mult_transb,               1.0,     0,   0,   3, 0, 0, 0, bench_prepare_q },
+    { "matrix_q_mult_rowvector",            run_matrix_q_mult_rowvector,            0,       1,   0,   1, 2, 0, 0, bench_prepare_q },
+    { "matrix_q_multadd_rowvector",         run_matrix_q_multadd_rowvector,         0,       1,   0,   1, 3, 0, 0, bench_prepare_q },
+    { "matrix_q_multsub",                   run_matrix_q_multsub,                   1.0,     0,   0,   4, 0, 0, 0, bench_prepare_q },
+    { "matrix_q_add_inplace",               run_matrix_q_add_inplace,               0,       0.5, 0,   3, 0, 0, 0, bench_prepare_q },
+    { "matrix_q_sub_inplace_b",             run_matrix_q_sub_inplace_b,             0,       0.5, 0,   3, 0, 0, 0, bench_prepare_q },
+    { "cholesky_decompose_lower_q",         run_cholesky_decompose_lower_q,         1.0 / 6, 0,   0,   3, 0, 0, 0, 0 },
+    { "cholesky_solve_transb_q",            run_cholesky_solve_transb_q,            1.0,     0,   0,   3, 0, 0, 0, bench_prepare_q_factored },
+    { "matrix_triangularize_lower",         run_matrix_triangularize_lower,         1.0,     0,   0,   3, 0, 0, 0, 0 },
+    { "cholesky_decompose_udu",             run_cholesky_decompose_udu,             1.0 / 3, 0,   0,   1.5, 0, 0, 0, 0 },
+    { "cholesky_compose_udu",               run_cholesky_compose_udu,               1.0 / 3, 0,   0,   1.5, 0, 0, 0, bench_prepare_udu },
+    { "matrix_multadd_weighted_transb",     run_matrix_multadd_weighted_transb,     1.0,     0,   0,   4, 1, 0, 0, bench_prepare_weights },
+};
+
+/*!
+* \brief Runs all kernel benchmarks for one dimension.
+*/
+static void bench_run_kernels(const char *backend, uint_fast8_t n)
+{
+    size_t i;
+    const double N = n;
+
+    for (i = 0; i < sizeof(bench_kernels) / sizeof(bench_kernels[0]); ++i)
+    {
+        const bench_kernel_t *kernel = &bench_kernels[i];
+        bench_operands_t ops;
+        double ns;
+
+        bench_prepare(&ops, n);
+        if (kernel->factored)
+        {
+            cholesky_decompose_lower(&ops.spd);
+        }
+        if (kernel->spd_in_b)
+        {
+            matrix_copy(&ops.spd, &ops.b);
+        }
+        if (kernel->prepare)
+        {
+            kernel->prepare(&ops);
+        }
+
+        ns = bench_time(kernel->run, &ops);
+        bench_report(kernel->name, backend, n, n, n, ns,
+                     2.0 * (kernel->madd3 * N * N * N + kernel->madd2 * N * N + kernel->madd1 * N),
+                     (double)sizeof(matrix_data_t) * (kernel->elements2 * N * N + kernel->elements1 * N));
+    }
+}
+
+/************************************************************************/
+/* Filter cycle                                                         */
+/************************************************************************/
+
+static matrix_data_t kf_A[BENCH_MAX_DIM * BENCH_MAX_DIM];
+static matrix_data_t kf_x[BENCH_MAX_DIM];
+static matrix_data_t kf_B[BENCH_MAX_DIM * BENCH_MAX_DIM];
+static matrix_data_t kf_u[BENCH_MAX_DIM];
+static matrix_data_t kf_P[BENCH_MAX_DIM * BENCH_MAX_DIM];
+static matrix_data_t kf_Q[BENCH_MAX_DIM * BENCH_MAX_DIM];
+static matrix_data_t kf_aux[BENCH_MAX_DIM];
+static matrix_data_t kf_predicted_x[BENCH_MAX_DIM];
+static matrix_data_t kf_BQ[BENCH_MAX_DIM * BENCH_MAX_DIM];
+
+static matrix_data_t kfm_H[BENCH_MAX_DIM * BENCH_MAX_DIM];
+static matrix_data_t kfm_z[BENCH_MAX_DIM];
+static matrix_data_t kfm_R[BENCH_MAX_DIM * BENCH_MAX_DIM];
+static matrix_data_t kfm_y[BENCH_MAX_DIM];
+static matrix_data_t kfm_S[BENCH_MAX_DIM * BENCH_MAX_DIM];
+static matrix_data_t kfm_K[BENCH_MAX_DIM * BENCH_MAX_DIM];
+static matrix_data_t kfm_aux[BENCH_MAX_DIM];
+static matrix_data_t kfm_HP[BENCH_MAX_DIM * BENCH_MAX_DIM];
+
+/*!
+* \brief A filter and measurement under test
+*/
+typedef struct
+{
+    kalman_t kf;
+    kalman_measurement_t kfm;
+} bench_filter_t;
+
+/*!
+* \brief Sets up a random-walk filter that observes every state, so that P stays bounded.
+*/
+static void bench_prepare_filter(bench_filter_t *filter, uint_fast8_t n, uint_fast8_t k, uint_fast8_t m)
+{
+    uint_fast8_t i, j;
+
+    kalman_filter_initialize(&filter->kf, n, k, kf_A, kf_x, kf_B, kf_u, kf_P, kf_Q, kf_aux, kf_predicted_x, kf_BQ);
+    kalman_measurement_initialize(&filter->kfm, n, m, kfm_H, kfm_z, kfm_R, kfm_y, kfm_S, kfm_K, kfm_aux, kfm_HP);
+
+    for (i = 0; i < n; ++i)
+    {
+        kf_x[i] = 0;
+        for (j = 0; j < n; ++j)
+        {
+            kf_A[i * n + j] = (i == j) ? 1 : 0;
+            kf_P[i * n + j] = (i == j) ? 1 : 0;
+        }
+        for (j = 0; j < k; ++j)
+        {
+            kf_B[i * k + j] = (matrix_data_t)0.1;
+        }
+    }
+
+    for (i = 0; i < k; ++i)
+    {
+        for (j = 0; j < k; ++j)
+        {
+            kf_Q[i * k + j] = (i == j) ? (matrix_data_t)0.01 : 0;
+        }
+    }
+
+    for (i = 0; i < m; ++i)
+    {
+        kfm_z[i] = 1;
+        for (j = 0; j < n; ++j)
+        {
+            kfm_H[i * n + j] = (j == i % n) ? 1 : 0;
+        }
+        for (j = 0; j < m; ++j)
+        {
+            kfm_R[i * m + j] = (i == j) ? 1 : 0;
+        }
+    }
+}
+
+static void run_kalman_cycle(void *context)
+{
+    bench_filter_t *filter = (bench_filter_t*)context;
+    kalman_predict(&filter->kf);
+    kalman_correct(&filter->kf, &filter->kfm);
+}
+
+/*!
+* \brief Runs the predict+correct benchmark for one set of dimensions.
+*/
+static void bench_run_filter(const char *backend, uint_fast8_t n, uint_fast8_t k, uint_fast8_t m)
+{
+    bench_filter_t filter;
+    const double N = n, K = k, M = m;
+    double madds, elements, ns;
+
+    bench_prepare_filter(&filter, n, k, m);
+    ns = bench_time(run_kalman_cycle, &filter);
+
+    // predict: A*x, B*Q, A*P*A' + BQ*B' (lower triangle)
+    madds = N * N + N * K * K + N * N * N + N * (N + 1) / 2 * (N + K);
+
+    // correct: H*x, H*P, HP*H' (lower triangle), Cholesky, gain substitution, K*y, K*HP (lower triangle)
+    madds += M * N + M * N * N + M * (M + 1) / 2 * N + M * M * M / 6 + N * M * M + N * M + N * (N + 1) / 2 * M;
+
+    // A, x, P, B, Q, H, z, R, y, S, K
+    elements = 2 * N * N + N + N * K + K * K + 2 * M * N + 2 * M * M + 2 * M;
+
+    bench_report("kalman_predict_correct", backend, n, k, m, ns, 2.0 * madds, (double)sizeof(matrix_data_t) * elements);
+}
+
+/************************************************************************/
+/* Main                                                                 */
+/************************************************************************/
+
+/*!
+* \brief Returns the name of a backend.
+*/
+static const char* bench_backend_name(matrix_backend_t backend)
+{
+    switch (backend)
+    {
+    case MATRIX_BACKEND_AVX2_FMA:
+        return "avx2_fma";
+    default:
+        return "scalar";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static const matrix_backend_t backends[] = { MATRIX_BACKEND_SCALAR, MATRIX_BACKEND_AVX2_FMA };
+    const uint_fast8_t *sizes = bench_sizes;
+    size_t num_sizes = sizeof(bench_sizes) / sizeof(bench_sizes[0]);
+    size_t b, i, j, l;
+
+    if (argc > 1 && strcmp(argv[1], "--quick") == 0)
+    {
+        sizes = bench_sizes_quick;
+        num_sizes = sizeof(bench_sizes_quick) / sizeof(bench_sizes_quick[0]);
+    }
+
+    printf("{ \"benchmarks\": [");
+
+    for (b = 0; b < sizeof(backends) / sizeof(backends[0]); ++b)
+    {
+        const char *backend;
+
+        // skip backends the CPU does not support
+        if (matrix_select_backend(backends[b]) != backends[b]) continue;
+        backend = bench_backend_name(backends[b]);
+
+        for (i = 0; i < num_sizes; ++i)
+        {
+            bench_run_kernels(backend, sizes[i]);
+        }
+
+        for (i = 0; i < num_sizes; ++i)
+        {
+            for (j = 0; j < num_sizes; ++j)
+            {
+                for (l = 0; l < num_sizes; ++l)
+                {
+                    bench_run_filter(backend, sizes[i], sizes[j], sizes[l]);
+                }
+            }
+        }
+    }
+
+    printf("\n] }\n");
+
+    matrix_select_backend(MATRIX_BACKEND_AUTO);
+    return 0;
+}
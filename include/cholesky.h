@@ -3,6 +3,7 @@
 
 #include "compiler.h"
 #include "matrix.h"
+#include "matrix_q.h"
 
 /**
 * \brief Decomposes a matrix into lower triangular form using Cholesky decomposition.
@@ -13,4 +14,94 @@
 */
 int cholesky_decompose_lower(register const matrix_t *const mat) HOT;
 
+/**
+* \brief Solves {\ref x} * (L*L') = {\ref b'} for {\ref x} using forward and back substitution.
+* \param[in] lower The lower triangular Cholesky factor L ({\ref n} x {\ref n}), as created by {\ref cholesky_decompose_lower}.
+* \param[in] b The right hand side B ({\ref n} x {\ref k}).
+* \param[out] x The solution X ({\ref k} x {\ref n}), i.e. X = B' * (L*L')^-1.
+*
+* Each row of X is a separate system that is solved in place, so no inverse and no temporary is required.
+* The buffer of {\ref x} MUST NOT be aliased with either {\ref lower} or {\ref b}.
+*/
+void cholesky_solve_transb(const matrix_t *RESTRICT const lower, const matrix_t *RESTRICT const b, const matrix_t *RESTRICT x) HOT;
+
+/**
+* \brief Decomposes a double precision matrix into lower triangular form using Cholesky decomposition.
+* \param[in] t The {\ref n} x {\ref n} matrix to decompose in place into a lower triangular matrix.
+* \param[in] n The dimension of the matrix
+* \return Zero in case of success, nonzero if the matrix is not positive semi-definite.
+*
+* \see cholesky_decompose_lower
+*/
+int cholesky_decompose_lower_wide(matrix_wide_t *RESTRICT const t, const uint_fast8_t n) HOT;
+
+/**
+* \brief Solves {\ref x} * (L*L') = {\ref b'} for {\ref x} with a double precision factor L.
+* \param[in] lower The lower triangular Cholesky factor L ({\ref n} x {\ref n}), as created by {\ref cholesky_decompose_lower_wide}.
+* \param[in] b The right hand side B ({\ref n} x {\ref k}).
+* \param[out] x The solution X ({\ref k} x {\ref n}), i.e. X = B' * (L*L')^-1.
+* \param[in] aux Auxiliary buffer of {\ref n} elements holding a row of X during the substitution.
+*
+* The substitutions are carried out in double precision; only the solution is rounded to {\ref matrix_data_t}.
+*
+* \see cholesky_solve_transb
+*/
+void cholesky_solve_transb_wide(const matrix_wide_t *RESTRICT const lower, const matrix_t *RESTRICT const b, const matrix_t *RESTRICT x, matrix_wide_t *RESTRICT const aux) HOT;
+
+/**
+* \brief Decomposes a fixed-point matrix into lower triangular form using Cholesky decomposition.
+* \param[in] mat The matrix to decompose in place into a lower triangular matrix.
+* \return Zero in case of success, nonzero if the matrix is not positive semi-definite.
+*
+* Square roots are calculated with an integer square root, so no floating point unit is required.
+*
+* \see cholesky_decompose_lower
+*/
+int cholesky_decompose_lower_q(const matrix_q_t *const mat) HOT;
+
+/**
+* \brief Solves {\ref x} * (L*L') = {\ref b'} for {\ref x} in fixed-point arithmetic.
+* \param[in] lower The lower triangular Cholesky factor L ({\ref n} x {\ref n}), as created by {\ref cholesky_decompose_lower_q}.
+* \param[in] b The right hand side B ({\ref n} x {\ref k}).
+* \param[out] x The solution X ({\ref k} x {\ref n}), i.e. X = B' * (L*L')^-1.
+*
+* The fractional bits of L and X together must not be less than those of B.
+*
+* \see cholesky_solve_transb
+*/
+void cholesky_solve_transb_q(const matrix_q_t *RESTRICT const lower, const matrix_q_t *RESTRICT const b, const matrix_q_t *RESTRICT x) HOT;
+
+/**
+* \brief Returns the index of element ({\ref row}, {\ref col}) of a packed upper triangular matrix.
+* \param[in] row The row index, not greater than {\ref col}
+* \param[in] col The column index
+* \return The index into the packed array
+*
+* The upper triangle is packed column by column, i.e. column j occupies j+1 elements
+* starting at j*(j+1)/2, so that a {\ref n} x {\ref n} matrix takes n*(n+1)/2 elements.
+*/
+PURE UNUSED STATIC_INLINE uint_fast16_t cholesky_packed_index(const uint_fast8_t row, const uint_fast8_t col)
+{
+    return (uint_fast16_t)row + (((uint_fast16_t)col * (col + 1)) >> 1);
+}
+
+/**
+* \brief Decomposes a symmetric matrix into U*D*U' with unit upper triangular U and diagonal D.
+* \param[in] mat The symmetric matrix ({\ref n} x {\ref n}); only the upper triangle is read.
+* \param[out] ud The packed factors ({\ref n} * ({\ref n} + 1) / 2), see {\ref cholesky_packed_index}.
+*               The strictly upper part holds U and the diagonal holds D; the unit diagonal of U is implied.
+* \return Zero in case of success, nonzero if the matrix is not positive definite.
+*
+* Unlike {\ref cholesky_decompose_lower}, no square roots are required.
+* The buffer of {\ref ud} MUST NOT be aliased with {\ref mat}.
+*/
+int cholesky_decompose_udu(const matrix_t *RESTRICT const mat, matrix_data_t *RESTRICT const ud) COLD;
+
+/**
+* \brief Recomposes a symmetric matrix from its packed U*D*U' factors.
+* \param[in] ud The packed factors, as created by {\ref cholesky_decompose_udu}.
+* \param[out] mat The symmetric matrix ({\ref n} x {\ref n}).
+*/
+void cholesky_compose_udu(const matrix_data_t *RESTRICT const ud, const matrix_t *RESTRICT const mat) COLD;
+
 #endif
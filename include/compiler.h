@@ -37,6 +37,15 @@
 #define COLD
 #endif
 
+/**
+* \def UNUSED Marks a static function that is not called by every translation unit defining it
+*/
+#ifdef __GNUC__
+#define UNUSED __attribute__ ((unused))
+#else
+#define UNUSED
+#endif
+
 /**
 * \def INLINE Marks a function as to be inlined
 */
@@ -51,6 +51,20 @@ typedef struct
     */
     matrix_t Q;
 
+    /*!
+    * \brief Optional sparsity pattern of the system matrix
+    *
+    * If the pattern buffers are set, the prediction skips the zero and unit entries of A.
+    * \see kalman_filter_set_sparsity
+    */
+    matrix_sparsity_t A_sparsity;
+
+    /*!
+    * \brief Nonzero while the covariance is frozen at steady state, in which case the prediction only propagates x
+    * \see kalman_measurement_enable_steady_state
+    */
+    uint_fast8_t covariance_frozen;
+
     /*!
     * \brief Temporary variables.
     */
@@ -60,7 +74,7 @@ typedef struct
         * \brief Auxiliary array for matrix multiplication, needs to be MAX(num states, num inputs)
         *
         * This auxiliary field can also be used as a backing field for the predicted x vector, however
-        * it MUST NOT be aliased with either temporary P or temporary BQ.
+        * it MUST NOT be aliased with temporary BQ.
         */
         matrix_data_t *aux;
 
@@ -71,23 +85,30 @@ typedef struct
         matrix_t predicted_x;
 
         /*!
-        * \brief P-Sized temporary matrix  (number of states x number of states)
+        * \brief BxQ-sized temporary matrix (number of states x number of inputs)
         *
-        * The backing field for this temporary MAY be aliased with temporary BQ.
+        * The backing field for this temporary MUST NOT be aliased with aux.
         *
-        * \see P
+        * \see B
+        * \see Q
         */
-        matrix_t P;
+        matrix_t BQ;
 
         /*!
-        * \brief BxQ-sized temporary matrix (number of states x number of inputs)
+        * \brief Work array of the square root filter (number of states x (number of states + number of inputs)),
+        * or null if the filter propagates the full covariance
         *
-        * The backing field for this temporary MAY be aliased with temporary P.
+        * \see kalman_filter_enable_sqrt
+        */
+        matrix_data_t *sqrt_work;
+
+        /*!
+        * \brief Work array of the UD filter ((number of states + 1) x (number of states + number of inputs)),
+        * or null if the filter propagates the full covariance
         *
-        * \see B
-        * \see Q
+        * \see kalman_filter_enable_ud
         */
-        matrix_t BQ;
+        matrix_data_t *ud_work;
 
     } temporary;
 
@@ -133,55 +154,69 @@ typedef struct
     matrix_t K;
 
     /*!
-    * \brief Temporary variables.
+    * \brief Steady state detection of the Kalman gain.
+    * \see kalman_measurement_enable_steady_state
     */
     struct
     {
         /*!
-        * \brief Auxiliary array for matrix multiplication, needs to be MAX(num states, num measurements)
-        *
-        * This auxiliary field MUST NOT be aliased with either temporary HP, KHP, HPt or S_inverted.
+        * \brief The gain of the previous correction (num states x num measurements), or null if the detection is disabled
         */
-        matrix_data_t *aux;
+        matrix_data_t *K_previous;
 
         /*!
-        * \brief S-Sized temporary matrix  (number of measurements x number of measurements)
-        *
-        * The backing field for this temporary MAY be aliased with temporary temp_KHP.
-        * The backing field for this temporary MAY be aliased with temporary temp_HP (if it is not aliased with temp_PHt).
-        * The backing field for this temporary MUST NOT be aliased with temporary temp_PHt.
-        * The backing field for this temporary MUST NOT be aliased with aux.
+        * \brief The largest absolute change of any gain element between two corrections that counts as converged
+        */
+        matrix_data_t tolerance;
+
+        /*!
+        * \brief Nonzero once the gain has converged; the correction then only updates x
+        */
+        uint_fast8_t frozen;
+
+        /*!
+        * \brief The number of full corrections since the detection was enabled or reset,
+        * i.e. the number of corrections it took to converge once {\ref frozen} is set
+        */
+        uint_fast32_t updates;
+
+    } steady_state;
+
+    /*!
+    * \brief Temporary variables.
+    */
+    struct
+    {
+        /*!
+        * \brief Auxiliary array for matrix multiplication, needs to be MAX(num states, num measurements)
         *
-        * \see S
+        * This auxiliary field MUST NOT be aliased with temporary HP.
         */
-        matrix_t S_inv;
+        matrix_data_t *aux;
 
         /*!
         * \brief H-Sized temporary matrix  (number of measurements x number of states)
         *
-        * The backing field for this temporary MAY be aliased with temporary S_inv.
-        * The backing field for this temporary MAY be aliased with temporary temp_PHt.
-        * The backing field for this temporary MUST NOT be aliased with temporary temp_KHP.
+        * Holds H*P for the duration of the correction; it is used both as the right-hand
+        * side of the gain substitution and for the covariance update.
         */
         matrix_t HP;
 
         /*!
-        * \brief P-Sized temporary matrix  (number of states x number of states)
+        * \brief Double precision workspace of the mixed precision correction (num measurements x (num measurements + 1)),
+        * or null if the correction runs in {\ref matrix_data_t} precision only
         *
-        * The backing field for this temporary MAY be aliased with temporary S_inv.
-        * The backing field for this temporary MAY be aliased with temporary temp_PHt.
-        * The backing field for this temporary MUST NOT be aliased with temporary temp_HP.
+        * \see kalman_measurement_set_mixed_precision
         */
-        matrix_t KHP;
+        matrix_wide_t *wide;
 
         /*!
-        * \brief PxH'-Sized (H'-Sized) temporary matrix  (number of states x number of measurements)
+        * \brief Work array of the square root correction ((num measurements + num states) x (num measurements + num states)),
+        * or null if the measurement is used with a filter propagating the full covariance
         *
-        * The backing field for this temporary MAY be aliased with temporary temp_HP.
-        * The backing field for this temporary MAY be aliased with temporary temp_KHP.
-        * The backing field for this temporary MUST NOT be aliased with temporary S_inv.
+        * \see kalman_measurement_enable_sqrt
         */
-        matrix_t PHt;
+        matrix_data_t *sqrt_work;
 
     } temporary;
 
@@ -200,12 +235,76 @@ typedef struct
 * \param[in] Q The input covariance matrix ({\ref num_inputs} x {\ref num_inputs})
 * \param[in] aux The auxiliary buffer (length {\ref num_states} or {\ref num_inputs}, whichever is greater)
 * \param[in] predictedX The temporary vector for predicted X ({\ref num_states} x \c 1)
-* \param[in] temp_P The temporary matrix for P calculation ({\ref num_states} x {\ref num_states})
 * \param[in] temp_BQ The temporary matrix for BQ calculation ({\ref num_states} x {\ref num_inputs})
 */
 void kalman_filter_initialize(kalman_t *kf, uint_fast8_t num_states, uint_fast8_t num_inputs, matrix_data_t *A, matrix_data_t *x,
                               matrix_data_t *B, matrix_data_t *u, matrix_data_t *P, matrix_data_t *Q,
-                              matrix_data_t *aux, matrix_data_t *predictedX, matrix_data_t *temp_P, matrix_data_t *temp_BQ) COLD;
+                              matrix_data_t *aux, matrix_data_t *predictedX, matrix_data_t *temp_BQ) COLD;
+
+/*!
+* \brief Enables the sparse prediction by determining the sparsity pattern of the system matrix A.
+* \param[in] kf The Kalman Filter structure
+* \param[in] offsets The buffer for the row offsets (length 2 * {\ref num_states} + 1), or null to disable the sparse prediction
+* \param[in] columns The buffer for the column indices (length {\ref num_states} x {\ref num_states})
+* \return The number of multiplications per row vector product with A
+*
+* A must be set before calling this function. If entries of A change later on, the pattern must be
+* refreshed with {\ref kalman_filter_update_sparsity} unless the changes keep every zero and unit entry as is.
+*/
+uint_fast16_t kalman_filter_set_sparsity(kalman_t *kf, uint_fast16_t *offsets, uint_fast8_t *columns) COLD;
+
+/*!
+* \brief Refreshes the sparsity pattern of the system matrix A after its entries changed.
+* \param[in] kf The Kalman Filter structure
+*
+* Does nothing if the sparse prediction is not enabled.
+* \see kalman_filter_set_sparsity
+*/
+void kalman_filter_update_sparsity(kalman_t *kf) COLD;
+
+/*!
+* \brief Switches the filter to square root form, i.e. to propagating the lower triangular Cholesky factor of P.
+* \param[in] kf The Kalman Filter structure
+* \param[in] work The work array ({\ref num_states} x ({\ref num_states} + {\ref num_inputs}))
+* \return Zero in case of success, nonzero if P or Q is not positive definite, in which case neither is changed.
+*
+* P and Q must be set before calling this function; both are replaced in place by their lower triangular
+* Cholesky factors, which are then used by {\ref kalman_predict} and {\ref kalman_correct}: the prediction
+* triangularizes [A*L, B*sqrt(Q)] with Givens rotations and the correction performs a triangular array update,
+* so no covariance is ever formed and decomposed. The factor's condition number is the square root of that of P,
+* which keeps single precision stable where the conventional form would need double precision.
+* All measurements used with the filter must be enabled with {\ref kalman_measurement_enable_sqrt}.
+*
+* \see kalman_filter_get_covariance
+*/
+int kalman_filter_enable_sqrt(kalman_t *kf, matrix_data_t *work) COLD;
+
+/*!
+* \brief Gets the state covariance matrix, regardless of whether the filter is in square root or UD form.
+* \param[in] kf The Kalman Filter structure
+* \param[out] P The state covariance ({\ref num_states} x {\ref num_states}), must not be aliased with the filter's P
+*/
+void kalman_filter_get_covariance(const kalman_t *kf, matrix_t *P) COLD;
+
+/*!
+* \brief Switches the filter to UD form, i.e. to propagating P = U*D*U' with unit upper triangular U and diagonal D.
+* \param[in] kf The Kalman Filter structure
+* \param[in] P The initial state covariance ({\ref num_states} x {\ref num_states}); may be the filter's own P.
+* \param[in] work The work array (({\ref num_states} + 1) x ({\ref num_states} + {\ref num_inputs}))
+* \return Zero in case of success, nonzero if P or Q is not positive definite, in which case neither is changed.
+*
+* The factors of P are stored packed in the buffer of the filter's P, which thus only needs to hold
+* {\ref num_states} * ({\ref num_states} + 1) / 2 elements (see {\ref cholesky_packed_index}); Q must be set before
+* calling this function and is replaced in place by its packed factors. {\ref kalman_predict} then uses Thornton's
+* modified weighted Gram-Schmidt orthogonalization and {\ref kalman_correct} uses Bierman's scalar updates, neither
+* of which requires a square root or a matrix inversion. As with {\ref kalman_correct_sequential}, the measurement
+* covariance R must be diagonal; S and the temporary HP of the measurements are neither used nor required.
+* Both factors are formed in the work array before either is stored, which limits the number of inputs to
+* 2 x {\ref num_states} + 1.
+*
+* \see kalman_filter_get_covariance
+*/
+int kalman_filter_enable_ud(kalman_t *kf, const matrix_t *P, matrix_data_t *work) COLD;
 
 /*!
 * \brief Sets the measurement vector
@@ -219,14 +318,66 @@ void kalman_filter_initialize(kalman_t *kf, uint_fast8_t num_states, uint_fast8_
 * \param[in] S The residual covariance ({\ref num_measurements} x {\ref num_measurements})
 * \param[in] K The Kalman gain ({\ref num_states} x {\ref num_measurements})
 * \param[in] aux The auxiliary buffer (length {\ref num_states} or {\ref num_measurements}, whichever is greater)
-* \param[in] S_inv The temporary matrix for the inverted residual covariance  ({\ref num_measurements} x {\ref num_measurements})
 * \param[in] temp_HP The temporary matrix for HxP ({\ref num_measurements} x {\ref num_states})
-* \param[in] temp_PHt The temporary matrix for PxH' ({\ref num_states} x {\ref num_measurements})
-* \param[in] temp_KHP The temporary matrix for KxHxP ({\ref num_states} x {\ref num_states})
 */
 void kalman_measurement_initialize(kalman_measurement_t *kfm, uint_fast8_t num_states, uint_fast8_t num_measurements, matrix_data_t *H, matrix_data_t *z, matrix_data_t *R,
                                    matrix_data_t *y, matrix_data_t *S, matrix_data_t *K,
-                                   matrix_data_t *aux, matrix_data_t *S_inv, matrix_data_t *temp_HP, matrix_data_t *temp_PHt, matrix_data_t *temp_KHP) COLD;
+                                   matrix_data_t *aux, matrix_data_t *temp_HP) COLD;
+
+/*!
+* \brief Enables or disables the mixed precision correction of a measurement.
+* \param[in] kfm The Kalman Filter measurement structure
+* \param[in] wide The double precision workspace ({\ref num_measurements} x ({\ref num_measurements} + 1)), or null to disable
+*
+* With mixed precision, x and P remain in {\ref matrix_data_t} precision while the residual covariance S
+* is accumulated, factored and substituted against in double precision; only the resulting gain is
+* rounded. This protects filters whose S spans many orders of magnitude at the cost of a single
+* double precision m x m factorization per correction. After the correction, S holds the rounded factor.
+*/
+void kalman_measurement_set_mixed_precision(kalman_measurement_t *kfm, matrix_wide_t *wide) COLD;
+
+/*!
+* \brief Enables the steady state detection of the Kalman gain.
+* \param[in] kfm The Kalman Filter measurement structure
+* \param[in] K_previous The buffer for the previous gain ({\ref num_states} x {\ref num_measurements}), or null to disable
+* \param[in] tolerance The largest absolute change of any gain element between two corrections that counts as converged
+*
+* In time-invariant setups, where the same measurement corrects the filter after every prediction, P and K converge.
+* Once no element of K changes by more than {\ref tolerance} between two corrections of {\ref kalman_correct},
+* the gain is frozen: the correction is reduced to x = x + K*(z - H*x) and the prediction stops propagating P,
+* so no covariance math remains. P keeps the value of the last full correction.
+* The number of corrections it took is found in the measurement's steady_state.updates.
+*
+* While the covariance is frozen, no correction changes P: any other measurement correcting the filter with
+* {\ref kalman_correct} calculates its gain once against the frozen P and is then frozen as well, and the sequential
+* and stacked corrections must not be used. Freezing is only valid while A, B, Q, H and R stay the same;
+* call {\ref kalman_steady_state_reset} after changing any of them, after which the other measurements calculate
+* their gain again. Only the full covariance correction detects convergence, i.e. not the square root, UD and
+* sequential ones.
+*/
+void kalman_measurement_enable_steady_state(kalman_measurement_t *kfm, matrix_data_t *K_previous, matrix_data_t tolerance) COLD;
+
+/*!
+* \brief Leaves steady state, e.g. after A, B, Q, H or R have changed.
+* \param[in] kf The Kalman Filter structure
+* \param[in] kfm The Kalman Filter measurement structure
+*
+* The covariance is propagated again from the value of the last full correction, and the detection starts over.
+*/
+void kalman_steady_state_reset(kalman_t *kf, kalman_measurement_t *kfm) COLD;
+
+/*!
+* \brief Prepares a measurement for the correction of a filter in square root form.
+* \param[in] kfm The Kalman Filter measurement structure
+* \param[in] work The work array (({\ref num_measurements} + {\ref num_states}) x ({\ref num_measurements} + {\ref num_states}))
+* \return Zero in case of success, nonzero if R is not positive definite.
+*
+* R must be set before calling this function and is replaced in place by its lower triangular Cholesky factor.
+* After a correction, S holds the lower triangular factor of the residual covariance.
+*
+* \see kalman_filter_enable_sqrt
+*/
+int kalman_measurement_enable_sqrt(kalman_measurement_t *kfm, matrix_data_t *work) COLD;
 
 /*!
 * \brief Performs the time update / prediction step of only the state vector
@@ -312,9 +463,44 @@ HOT EXTERN_INLINE_KALMAN void kalman_predict_tuned(kalman_t *kf, matrix_data_t l
 /*!
 * \brief Performs the measurement update step.
 * \param[in] kf The Kalman Filter structure to correct.
+*
+* If the filter is in square root form, the measurement must have been prepared with
+* {\ref kalman_measurement_enable_sqrt}. If the filter is in UD form, R must be diagonal.
+* While the covariance is frozen at steady state, P is left unchanged and the gain of the measurement is frozen
+* (see {\ref kalman_measurement_enable_steady_state}).
 */
 void kalman_correct(kalman_t *kf, kalman_measurement_t *kfm) HOT;
 
+/*!
+* \brief Performs the measurement update step with the innovation y already calculated.
+* \param[in] kf The Kalman Filter structure to correct.
+* \param[in] kfm The measurement to correct with, holding the innovation in y.
+*
+* This is the second half of {\ref kalman_correct}, which calculates y = z - H*x first, for callers
+* whose innovation is not linear in x (e.g. y = z - h(x) of an extended Kalman filter). z is not used.
+* Not available for filters in UD form, whose scalar updates need the innovation against the partially
+* corrected state.
+*/
+void kalman_correct_innovation(kalman_t *kf, kalman_measurement_t *kfm) HOT;
+
+/*!
+* \brief Performs the measurement update step as a sequence of scalar updates.
+* \param[in] kf The Kalman Filter structure to correct.
+* \param[in] kfm The measurement to correct with.
+*
+* The measurement covariance R must be diagonal, i.e. the measured channels must be independent;
+* off-diagonal entries are ignored. The result is then identical to {\ref kalman_correct}, but each
+* measurement only costs a rank-1 update of P and the residual covariance S and the temporary HP
+* are neither used nor required. Not available for filters in square root form or while the covariance is
+* frozen at steady state; for filters in UD form, this is identical to {\ref kalman_correct}.
+*
+* After the call, y holds the innovation of each channel against the state as corrected by the
+* preceding channels, and column i of K holds the gain that was applied for channel i.
+*
+* \see kalman_correct
+*/
+void kalman_correct_sequential(kalman_t *kf, kalman_measurement_t *kfm) HOT;
+
 /*!
 * \brief Gets a pointer to the state vector x.
 * \param[in] kf The Kalman Filter structure
@@ -0,0 +1,162 @@
+#ifndef KALMAN_BANK_H_
+#define KALMAN_BANK_H_
+
+#include <stdint.h>
+#include "compiler.h"
+#include "matrix.h"
+#include "kalman.h"
+
+/*!
+* \brief A bank of identically shaped Kalman filters that are processed in lockstep.
+*
+* All filters in the bank share the model (A, B, Q) of one Kalman filter and the H and R of one
+* measurement, e.g. as created by kalman_factory_filter.h and kalman_factory_measurement.h,
+* while every filter has its own state, covariance, measurement and gain.
+*
+* The per-filter data is stored interleaved, element-major and filter-minor: element \c e of
+* filter \c f is found at index <tt>e * count + f</tt>. For P, the element index of (row, column)
+* is <tt>row * num_states + column</tt>, likewise for S and K. All bank kernels iterate over the
+* filters in their innermost loop, so that a vectorizing compiler can process as many filters per
+* instruction as the vector width allows, regardless of how small the filter dimensions are.
+* For best results, \c count should be a multiple of the vector width.
+*
+* \see kalman_bank_initialize
+*/
+typedef struct
+{
+    /*!
+    * \brief The number of filters in the bank
+    */
+    uint_fast16_t count;
+
+    /*!
+    * \brief The filter providing the shared A, B and Q matrices (and the dimensions)
+    */
+    kalman_t *model;
+
+    /*!
+    * \brief The measurement providing the shared H and R matrices
+    */
+    kalman_measurement_t *measurement;
+
+    /*!
+    * \brief Interleaved state vectors (num states x count)
+    */
+    matrix_data_t *x;
+
+    /*!
+    * \brief Interleaved state covariance matrices (num states * num states x count)
+    */
+    matrix_data_t *P;
+
+    /*!
+    * \brief Interleaved measurement vectors (num measurements x count)
+    */
+    matrix_data_t *z;
+
+    /*!
+    * \brief Interleaved innovation vectors (num measurements x count)
+    */
+    matrix_data_t *y;
+
+    /*!
+    * \brief Interleaved residual covariance matrices (num measurements * num measurements x count)
+    *
+    * After a correction, this holds the lower triangular Cholesky factors.
+    */
+    matrix_data_t *S;
+
+    /*!
+    * \brief Interleaved Kalman gain matrices (num states * num measurements x count)
+    */
+    matrix_data_t *K;
+
+    /*!
+    * \brief Temporary variables.
+    */
+    struct
+    {
+        /*!
+        * \brief Interleaved work matrices (MAX(num states, num measurements) * num states x count)
+        *
+        * Holds A*P during the prediction and H*P during the correction.
+        */
+        matrix_data_t *work;
+
+        /*!
+        * \brief Per-filter mask (count), one if the residual covariance could be factored, zero otherwise.
+        */
+        matrix_data_t *mask;
+
+    } temporary;
+
+} kalman_bank_t;
+
+/*!
+* \brief Initializes a Kalman filter bank.
+* \param[in] bank The bank to initialize
+* \param[in] count The number of filters in the bank
+* \param[in] model The filter providing the shared A, B and Q matrices and the dimensions
+* \param[in] measurement The measurement providing the shared H and R matrices
+* \param[in] x The interleaved state vectors ({\ref num_states} x {\ref count})
+* \param[in] P The interleaved state covariances ({\ref num_states} * {\ref num_states} x {\ref count})
+* \param[in] z The interleaved measurement vectors ({\ref num_measurements} x {\ref count})
+* \param[in] y The interleaved innovation vectors ({\ref num_measurements} x {\ref count})
+* \param[in] S The interleaved residual covariances ({\ref num_measurements} * {\ref num_measurements} x {\ref count})
+* \param[in] K The interleaved Kalman gains ({\ref num_states} * {\ref num_measurements} x {\ref count})
+* \param[in] work The interleaved work buffer (MAX({\ref num_states}, {\ref num_measurements}) * {\ref num_states} x {\ref count})
+* \param[in] mask The mask buffer (length {\ref count})
+*
+* The state and covariance of every filter are initialized from the model filter.
+*/
+void kalman_bank_initialize(kalman_bank_t *bank, uint_fast16_t count, kalman_t *model, kalman_measurement_t *measurement,
+                            matrix_data_t *x, matrix_data_t *P, matrix_data_t *z, matrix_data_t *y, matrix_data_t *S, matrix_data_t *K,
+                            matrix_data_t *work, matrix_data_t *mask) COLD;
+
+/*!
+* \brief Copies the state vector and covariance of a single filter into the bank.
+* \param[in] bank The bank
+* \param[in] index The index of the filter in the bank
+* \param[in] kf The filter to copy x and P from
+*/
+void kalman_bank_set_filter(kalman_bank_t *bank, uint_fast16_t index, const kalman_t *kf);
+
+/*!
+* \brief Copies the state vector and covariance of a single filter out of the bank.
+* \param[in] bank The bank
+* \param[in] index The index of the filter in the bank
+* \param[out] kf The filter to copy x and P to
+*/
+void kalman_bank_get_filter(const kalman_bank_t *bank, uint_fast16_t index, kalman_t *kf);
+
+/*!
+* \brief Performs the time update / prediction step for all filters in the bank.
+* \param[in] bank The bank to predict with.
+*
+* Calculates x = A*x and P = A*P*A' + B*Q*B' for every filter.
+*/
+void kalman_bank_predict(kalman_bank_t *bank) HOT;
+
+/*!
+* \brief Decomposes interleaved symmetric matrices into lower triangular form using Cholesky decomposition.
+* \param[in] mat The interleaved matrices ({\ref n} * {\ref n} x {\ref count}) to decompose in place.
+* \param[in] n The dimension of each matrix
+* \param[in] count The number of interleaved matrices
+* \param[out] mask Set to one for each matrix that was decomposed and to zero for each matrix that is not positive definite.
+* \return The number of matrices that were not positive definite.
+*
+* Matrices that are not positive definite do not stop the decomposition of the others; their factors
+* are meaningless and must be ignored using {\ref mask}. The upper triangles are not modified.
+*/
+uint_fast16_t kalman_bank_cholesky_decompose_lower(matrix_data_t *RESTRICT const mat, const uint_fast8_t n, const uint_fast16_t count, matrix_data_t *RESTRICT const mask) HOT;
+
+/*!
+* \brief Performs the measurement update step for all filters in the bank.
+* \param[in] bank The bank to correct.
+* \return The number of filters whose residual covariance was not positive definite.
+*
+* Filters whose residual covariance is not positive definite are left uncorrected and their gain is set to zero.
+*/
+uint_fast16_t kalman_bank_correct(kalman_bank_t *bank) HOT;
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef KALMAN_DARE_H_
+#define KALMAN_DARE_H_
+
+#include <stdint.h>
+#include "compiler.h"
+#include "matrix.h"
+#include "kalman.h"
+
+/*!
+* \brief The maximum number of doubling steps of {\ref kalman_dare_solve}.
+*
+* Each step doubles the horizon of the Riccati recursion, so stable models converge quadratically
+* within a few steps; marginally stable ones (e.g. integrators without process noise) converge linearly.
+*/
+#define KALMAN_DARE_MAX_ITERATIONS (64)
+
+/*!
+* \brief Solves the discrete algebraic Riccati equation and installs the steady state into the filter.
+* \param[in] kf The filter providing A, B and Q; receives the steady state a posteriori covariance in P
+* \param[in] kfm The measurement providing H and R; receives the steady state gain in K
+* \param[in] work The work buffer (6 x {\ref num_states} x {\ref num_states})
+* \param[in] tolerance The relative change of the a priori covariance between two doubling steps that counts as converged
+* \return Zero in case of success, nonzero if R is not positive definite, a doubling step is singular
+*         or the solution did not converge within {\ref KALMAN_DARE_MAX_ITERATIONS} steps.
+*
+* The a priori covariance of a time-invariant filter converges to the solution X of
+*
+*   X = A*X*A' - A*X*H'*(H*X*H' + R)^-1*H*X*A' + B*Q*B'
+*
+* which is found with the structured doubling algorithm: starting from A_0 = A', G_0 = H'*R^-1*H
+* and X_0 = B*Q*B', every step
+*
+*   W = I + G_k*X_k
+*   X_k+1 = X_k + A_k'*X_k*W^-1*A_k
+*   G_k+1 = G_k + A_k*W^-1*G_k*A_k'
+*   A_k+1 = A_k*W^-1*A_k
+*
+* costs a handful of n x n products and one Gauss-Jordan solve, independent of the horizon covered.
+*
+* On success, K = X*H'*(H*X*H' + R)^-1 and P = X - K*H*X are installed and both the filter and the
+* measurement are put into steady state, as if {\ref kalman_measurement_enable_steady_state} had detected
+* convergence: the first correction already runs at steady state cost and the prediction leaves P unchanged.
+* The state x is not touched. Call {\ref kalman_steady_state_reset} to return to the full covariance math.
+*
+* The filter must propagate the full covariance and the measurement must not be sequential.
+* Without process noise (i.e. without inputs or Q = 0), the solution is P = 0 and K = 0.
+*/
+int kalman_dare_solve(kalman_t *kf, kalman_measurement_t *kfm, matrix_data_t *work, matrix_data_t tolerance) COLD;
+
+#endif
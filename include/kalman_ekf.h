@@ -0,0 +1,52 @@
+#ifndef KALMAN_EKF_H_
+#define KALMAN_EKF_H_
+
+#include "compiler.h"
+#include "matrix.h"
+#include "kalman.h"
+
+/*!
+* \brief Evaluates a nonlinear model function, i.e. the state transition f(x) or the measurement function h(x).
+* \param[in] x The current state estimate (number of states x \c 1)
+* \param[out] result The function value (number of states x \c 1 for f, number of measurements x \c 1 for h)
+* \param[in] context The user context passed through by the caller
+*/
+typedef void (*kalman_ekf_function_t)(const matrix_t *x, matrix_t *result, void *context);
+
+/*!
+* \brief Evaluates the Jacobian of a nonlinear model function at the current state estimate.
+* \param[in] x The current state estimate (number of states x \c 1)
+* \param[out] jacobian The Jacobian, written in place into A of the filter or H of the measurement
+* \param[in] context The user context passed through by the caller
+*/
+typedef void (*kalman_ekf_jacobian_t)(const matrix_t *x, matrix_t *jacobian, void *context);
+
+/*!
+* \brief Performs the time update / prediction step of an extended Kalman filter.
+* \param[in] kf The Kalman Filter structure to predict with.
+* \param[in] f The nonlinear state transition x = f(x)
+* \param[in] jacobian The Jacobian of f, which is written into A of the filter
+* \param[in] context The user context passed to both callbacks
+*
+* The Jacobian is evaluated at the current estimate and written into A before f is evaluated into the
+* filter's temporary predicted x; P is then propagated as by {\ref kalman_predict_Q}. No buffers are
+* required besides those of the filter, so factory-created filters can be used as they are, in
+* square root and UD form as well. If a sparsity pattern of A is set, the Jacobian must keep the zero
+* and unit entries it was analyzed with.
+*/
+void kalman_ekf_predict(kalman_t *kf, kalman_ekf_function_t f, kalman_ekf_jacobian_t jacobian, void *context) HOT;
+
+/*!
+* \brief Performs the measurement update step of an extended Kalman filter.
+* \param[in] kf The Kalman Filter structure to correct.
+* \param[in] kfm The measurement to correct with; z must be set.
+* \param[in] h The nonlinear measurement function
+* \param[in] jacobian The Jacobian of h, which is written into H of the measurement
+* \param[in] context The user context passed to both callbacks
+*
+* The Jacobian is written into H and h(x) into y, which then becomes the innovation y = z - h(x)
+* for {\ref kalman_correct_innovation}. Not available for filters in UD form.
+*/
+void kalman_ekf_correct(kalman_t *kf, kalman_measurement_t *kfm, kalman_ekf_function_t h, kalman_ekf_jacobian_t jacobian, void *context) HOT;
+
+#endif
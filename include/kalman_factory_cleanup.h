@@ -54,10 +54,77 @@
 
 // remove auxiliaries
 #undef __KALMAN_BUFFER_aux
-#undef __KALMAN_BUFFER_tempPBQ
-#undef __KALMAN_tempP_size
+#undef __KALMAN_BUFFER_tempBQ
 #undef __KALMAN_tempBQ_size
-#undef __KALMAN_tempPBQ_size
+
+// remove fixed-point macros
+#undef KALMAN_Q_FRACTION_BITS
+#undef __KALMAN_BUFFER_Aq
+#undef __KALMAN_BUFFER_Pq
+#undef __KALMAN_BUFFER_xq
+#undef __KALMAN_BUFFER_Bq
+#undef __KALMAN_BUFFER_Qq
+#undef __KALMAN_BUFFER_predictedxq
+#undef __KALMAN_BUFFER_tempAPq
+#undef __KALMAN_BUFFER_tempBQq
+
+// remove sparsity macros
+#undef KALMAN_SPARSE_A
+#undef __KALMAN_BUFFER_Aoffsets
+#undef __KALMAN_BUFFER_Acolumns
+
+// remove square root macros
+#undef KALMAN_SQRT
+#undef __KALMAN_sqrt_ROWS
+#undef __KALMAN_sqrt_COLS
+#undef __KALMAN_BUFFER_sqrt
+
+// remove UD macros
+#undef KALMAN_UD
+#undef __KALMAN_P_size
+#undef __KALMAN_ud_ROWS
+#undef __KALMAN_ud_COLS
+#undef __KALMAN_BUFFER_ud
+
+// remove transition cache macros
+#undef KALMAN_TRANSITION_CACHE
+#undef __KALMAN_BUFFER_tcache
+#undef __KALMAN_BUFFER_tentries
+#undef __KALMAN_BUFFER_ttemp
+#undef __KALMAN_TRANSITIONS_NAME
+
+// remove smoother macros
+#undef KALMAN_SMOOTHER_LENGTH
+#undef __KALMAN_BUFFER_shistory
+#undef __KALMAN_BUFFER_srecords
+#undef __KALMAN_BUFFER_stemp
+#undef __KALMAN_SMOOTHER_NAME
+
+// remove fixed-lag smoother macros
+#undef KALMAN_FIXED_LAG
+#undef __KALMAN_BUFFER_lagged
+#undef __KALMAN_BUFFER_lagentries
+#undef __KALMAN_FIXED_LAG_NAME
+
+// remove out-of-sequence measurement macros
+#undef KALMAN_OOSM_CHECKPOINTS
+#undef KALMAN_OOSM_LOG
+#undef KALMAN_OOSM_MAX_MEASUREMENTS
+#undef __KALMAN_BUFFER_ocheckpoints
+#undef __KALMAN_BUFFER_ostates
+#undef __KALMAN_BUFFER_olog
+#undef __KALMAN_BUFFER_ologz
+#undef __KALMAN_BUFFER_otemp
+#undef __KALMAN_OOSM_NAME
+
+// remove measurement stack macros
+#undef KALMAN_STACKED_MEASUREMENTS
+#undef __KALMAN_BUFFER_stack
+#undef __KALMAN_BUFFER_stacky
+#undef __KALMAN_BUFFER_stackS
+#undef __KALMAN_BUFFER_stackK
+#undef __KALMAN_BUFFER_stackHP
+#undef __KALMAN_STACK_NAME
 
 // remove measurement defines just because we can
 #undef KALMAN_MEASUREMENT_NAME
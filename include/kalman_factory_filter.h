@@ -31,6 +31,58 @@
 * In addition, a parameterless static initialization function \c {kalman_filter_acceleration_init()} will
 * be created which you will need to call manually in order to set up the filter.
 *
+* Next to the generic \c kalman_predict(), a prediction function \c {kalman_filter_acceleration_predict()}
+* is created that works directly on the filter buffers. Since all dimensions are compile time constants
+* there, the compiler is free to unroll the loops and keep the operands in registers.
+*
+* If the system matrix A is mostly made of zeros and ones (e.g. for kinematic models), KALMAN_SPARSE_A can be
+* defined to \c 1 prior to inclusion of this file. Buffers for the sparsity pattern of A are then created along with a
+* function \c {kalman_filter_acceleration_analyze_sparsity()}, which must be called once A is set and enables the
+* prediction to skip the zero and unit entries of A.
+*
+* If P is poorly conditioned (e.g. in single precision with very precise measurements), KALMAN_SQRT can be defined to \c 1
+* prior to inclusion of this file. A work buffer is then created along with a function \c {kalman_filter_acceleration_enable_sqrt()},
+* which must be called once P and Q are set and switches the filter to propagating the Cholesky factor of P instead of P.
+* All measurements of the filter then create their own work buffers and \c enable_sqrt() functions.
+*
+* For a square root free alternative, KALMAN_UD can be defined to \c 1 prior to inclusion of this file. The P buffer then only
+* holds the packed U*D*U' factors of P (nearly half the size) and a function \c {kalman_filter_acceleration_enable_ud()} is created,
+* which must be called once Q is set and takes the initial covariance. R of all measurements must then be diagonal, and the
+* measurements are created without S and HxP buffers. KALMAN_UD cannot be combined with KALMAN_SQRT or KALMAN_Q_FRACTION_BITS.
+*
+* If the filter has to coast over gaps of several ticks without measurements, KALMAN_TRANSITION_CACHE can be defined to the
+* number of cached gap lengths prior to inclusion of this file. A transition cache \c kalman_filter_acceleration_transitions
+* is then created along with a function \c {kalman_filter_acceleration_predict_steps(k)}, which performs k prediction
+* steps at the cost of one. The cache must be cleared with \c kalman_transition_cache_clear() when A, B or Q change.
+* Alternatively, after the cache has been keyed on time steps with \c kalman_transition_cache_set_model(), a function
+* \c {kalman_filter_acceleration_predict_dt(dt)} predicts over irregular time steps.
+*
+* For smoothing, KALMAN_SMOOTHER_LENGTH can be defined to the number of recorded time steps prior to inclusion of this
+* file. A smoother \c kalman_filter_acceleration_smoother is then created along with its ring buffer of filter history.
+* After every prediction and correction the filter is recorded with \c kalman_smoother_record_prediction() and
+* \c kalman_smoother_record_correction() respectively, and \c kalman_smoother_smooth() runs the backward pass on demand.
+*
+* For smoothed estimates at a constant delay, KALMAN_FIXED_LAG can be defined to the lag in time steps prior to inclusion
+* of this file. A fixed-lag smoother \c kalman_filter_acceleration_fixed_lag is then created along with the buffers of its
+* lagged states. The filter is then predicted with \c kalman_fixed_lag_predict() and corrected with \c kalman_fixed_lag_correct(),
+* and \c kalman_fixed_lag_state() returns the smoothed state of any of the lagged time steps.
+*
+* If measurements arrive late, KALMAN_OOSM_CHECKPOINTS can be defined to the number of checkpointed time steps prior to
+* inclusion of this file. A structure \c kalman_filter_acceleration_oosm is then created along with its checkpoint ring and
+* measurement logs, holding KALMAN_OOSM_LOG (default \c 1) measurements of up to KALMAN_OOSM_MAX_MEASUREMENTS (default
+* KALMAN_NUM_STATES) rows per time step. After every prediction the filter is recorded with \c kalman_oosm_record_prediction(),
+* and measurements are applied with \c kalman_oosm_correct() at their time stamp.
+*
+* If independent measurements arrive at the same time step, KALMAN_STACKED_MEASUREMENTS can be defined to the largest
+* number of their rows combined prior to inclusion of this file. A measurement stack \c kalman_filter_acceleration_stack
+* is then created along with its buffers. Once the measurements are initialized, they are appended with \c kalman_stack_add()
+* and \c kalman_correct_stacked() corrects the filter with all of them at the cost of a single covariance update.
+*
+* For targets without a floating point unit, KALMAN_Q_FRACTION_BITS can be defined to the number of fractional bits
+* prior to inclusion of this file. A fixed-point copy \c kalman_filter_acceleration_q of the filter is then created
+* with its own Q-format buffers, along with a function \c {kalman_filter_acceleration_init_q()} that converts the model and
+* state set up in the floating point filter into it. The fixed-point filter is used with \c kalman_q_predict().
+*
 * To clean up the defined macros (e.g. in order to be able to create another named Kalman filter),
 * you will have to include kalman_factory_cleanup.h:
 *
@@ -77,6 +129,94 @@
 #error KALMAN_NUM_INPUTS must be a positive integer or zero if no inputs are used
 #endif
 
+#ifndef KALMAN_SPARSE_A
+#define KALMAN_SPARSE_A 0
+#endif
+
+#ifndef KALMAN_SQRT
+#define KALMAN_SQRT 0
+#endif
+
+#ifndef KALMAN_UD
+#define KALMAN_UD 0
+#endif
+
+#ifndef KALMAN_TRANSITION_CACHE
+#define KALMAN_TRANSITION_CACHE 0
+#endif
+
+#ifndef KALMAN_SMOOTHER_LENGTH
+#define KALMAN_SMOOTHER_LENGTH 0
+#endif
+
+#ifndef KALMAN_FIXED_LAG
+#define KALMAN_FIXED_LAG 0
+#endif
+
+#ifndef KALMAN_OOSM_CHECKPOINTS
+#define KALMAN_OOSM_CHECKPOINTS 0
+#endif
+
+#ifndef KALMAN_OOSM_LOG
+#define KALMAN_OOSM_LOG 1
+#endif
+
+#ifndef KALMAN_OOSM_MAX_MEASUREMENTS
+#define KALMAN_OOSM_MAX_MEASUREMENTS KALMAN_NUM_STATES
+#endif
+
+#ifndef KALMAN_STACKED_MEASUREMENTS
+#define KALMAN_STACKED_MEASUREMENTS 0
+#endif
+
+#if KALMAN_UD && (KALMAN_SQRT || defined(KALMAN_Q_FRACTION_BITS))
+#error KALMAN_UD cannot be combined with KALMAN_SQRT or KALMAN_Q_FRACTION_BITS, which require the full P buffer
+#endif
+
+#if KALMAN_TRANSITION_CACHE < 0 || KALMAN_TRANSITION_CACHE > 255
+#error KALMAN_TRANSITION_CACHE must be the number of cache entries (1 to 255) or zero
+#endif
+
+#if KALMAN_TRANSITION_CACHE && KALMAN_UD
+#error KALMAN_TRANSITION_CACHE cannot be combined with KALMAN_UD, which does not store P
+#endif
+
+#if KALMAN_SMOOTHER_LENGTH < 0 || KALMAN_SMOOTHER_LENGTH == 1 || KALMAN_SMOOTHER_LENGTH > 65535
+#error KALMAN_SMOOTHER_LENGTH must be the number of recorded time steps (2 to 65535) or zero
+#endif
+
+#if KALMAN_SMOOTHER_LENGTH && KALMAN_UD
+#error KALMAN_SMOOTHER_LENGTH cannot be combined with KALMAN_UD, which does not store P
+#endif
+
+#if KALMAN_FIXED_LAG < 0 || KALMAN_FIXED_LAG > 255
+#error KALMAN_FIXED_LAG must be the lag in time steps (1 to 255) or zero
+#endif
+
+#if KALMAN_FIXED_LAG && KALMAN_UD
+#error KALMAN_FIXED_LAG cannot be combined with KALMAN_UD, which does not store P
+#endif
+
+#if KALMAN_OOSM_CHECKPOINTS < 0 || KALMAN_OOSM_CHECKPOINTS == 1 || KALMAN_OOSM_CHECKPOINTS > 65535
+#error KALMAN_OOSM_CHECKPOINTS must be the number of checkpointed time steps (2 to 65535) or zero
+#endif
+
+#if KALMAN_OOSM_LOG <= 0 || KALMAN_OOSM_LOG > 255 || KALMAN_OOSM_MAX_MEASUREMENTS <= 0 || KALMAN_OOSM_MAX_MEASUREMENTS > 255
+#error KALMAN_OOSM_LOG and KALMAN_OOSM_MAX_MEASUREMENTS must be between 1 and 255
+#endif
+
+#if KALMAN_OOSM_CHECKPOINTS && KALMAN_UD
+#error KALMAN_OOSM_CHECKPOINTS cannot be combined with KALMAN_UD, which does not store P
+#endif
+
+#if KALMAN_STACKED_MEASUREMENTS < 0 || KALMAN_STACKED_MEASUREMENTS > 255
+#error KALMAN_STACKED_MEASUREMENTS must be the number of stacked rows (1 to 255) or zero
+#endif
+
+#if KALMAN_STACKED_MEASUREMENTS && KALMAN_UD
+#error KALMAN_STACKED_MEASUREMENTS cannot be combined with KALMAN_UD, which has no residual covariance to stack
+#endif
+
 /************************************************************************/
 /* Prepare dimensions                                                   */
 /************************************************************************/
@@ -87,6 +227,13 @@
 #define __KALMAN_P_ROWS     KALMAN_NUM_STATES
 #define __KALMAN_P_COLS     KALMAN_NUM_STATES
 
+// the UD factors of P are stored as a packed triangle
+#if KALMAN_UD
+#define __KALMAN_P_size     ((KALMAN_NUM_STATES * (KALMAN_NUM_STATES + 1)) / 2)
+#else
+#define __KALMAN_P_size     (__KALMAN_P_ROWS * __KALMAN_P_COLS)
+#endif
+
 #define __KALMAN_x_ROWS     KALMAN_NUM_STATES
 #define __KALMAN_x_COLS     1
 
@@ -102,12 +249,17 @@
 #define __KALMAN_aux_ROWS     ((KALMAN_NUM_STATES > KALMAN_NUM_INPUTS) ? KALMAN_NUM_STATES : KALMAN_NUM_INPUTS)
 #define __KALMAN_aux_COLS     1
 
-#define __KALMAN_tempP_ROWS  __KALMAN_P_ROWS
-#define __KALMAN_tempP_COLS  __KALMAN_P_COLS
-
 #define __KALMAN_tempBQ_ROWS __KALMAN_B_ROWS
 #define __KALMAN_tempBQ_COLS __KALMAN_B_COLS
 
+// square root prediction pre-array [A*L, B*sqrt(Q)]
+#define __KALMAN_sqrt_ROWS  KALMAN_NUM_STATES
+#define __KALMAN_sqrt_COLS  (KALMAN_NUM_STATES + KALMAN_NUM_INPUTS)
+
+// UD prediction array W = [A*U, B*Uq] and its weights
+#define __KALMAN_ud_ROWS    (KALMAN_NUM_STATES + 1)
+#define __KALMAN_ud_COLS    (KALMAN_NUM_STATES + KALMAN_NUM_INPUTS)
+
 /************************************************************************/
 /* Name helper macro                                                    */
 /************************************************************************/
@@ -155,7 +307,7 @@
 static matrix_data_t __KALMAN_BUFFER_A[__KALMAN_A_ROWS * __KALMAN_A_COLS];
 
 #pragma message("Creating Kalman filter P buffer: " STRINGIFY(__KALMAN_BUFFER_P))
-static matrix_data_t __KALMAN_BUFFER_P[__KALMAN_P_ROWS * __KALMAN_P_COLS];
+static matrix_data_t __KALMAN_BUFFER_P[__KALMAN_P_size];
 
 #pragma message("Creating Kalman filter x buffer: " STRINGIFY(__KALMAN_BUFFER_x))
 static matrix_data_t __KALMAN_BUFFER_x[__KALMAN_x_ROWS * __KALMAN_x_COLS];
@@ -197,19 +349,164 @@ static matrix_data_t __KALMAN_BUFFER_u[__KALMAN_x_ROWS * __KALMAN_u_COLS];
 /************************************************************************/
 
 #define __KALMAN_BUFFER_aux     KALMAN_BUFFER_NAME(aux)
-#define __KALMAN_BUFFER_tempPBQ KALMAN_BUFFER_NAME(tempPBQ)
 
 #define __KALMAN_aux_size       (__KALMAN_aux_ROWS * __KALMAN_aux_COLS)
-#define __KALMAN_tempP_size     (__KALMAN_tempP_ROWS * __KALMAN_tempP_COLS)
 #define __KALMAN_tempBQ_size    (__KALMAN_tempBQ_ROWS * __KALMAN_tempBQ_COLS)
 
-#define __KALMAN_tempPBQ_size   ((__KALMAN_tempP_size > __KALMAN_tempBQ_size) ? __KALMAN_tempP_size : __KALMAN_tempBQ_size)
-
 #pragma message("Creating Kalman filter aux buffer: " STRINGIFY(__KALMAN_BUFFER_aux))
 static matrix_data_t __KALMAN_BUFFER_aux[__KALMAN_aux_size];
 
-#pragma message("Creating Kalman filter temporary P/BQ buffer: " STRINGIFY(__KALMAN_BUFFER_tempPBQ))
-static matrix_data_t __KALMAN_BUFFER_tempPBQ[__KALMAN_tempPBQ_size];
+// the covariance prediction works in place, so only B*Q needs a temporary
+#if KALMAN_NUM_INPUTS > 0
+
+#define __KALMAN_BUFFER_tempBQ  KALMAN_BUFFER_NAME(tempBQ)
+#pragma message("Creating Kalman filter temporary BQ buffer: " STRINGIFY(__KALMAN_BUFFER_tempBQ))
+static matrix_data_t __KALMAN_BUFFER_tempBQ[__KALMAN_tempBQ_size];
+
+#else
+
+#pragma message("Skipping Kalman filter temporary BQ buffer: (zero inputs)")
+#define __KALMAN_BUFFER_tempBQ ((matrix_data_t*)0)
+
+#endif
+
+// sparsity pattern of A
+#if KALMAN_SPARSE_A
+
+#define __KALMAN_BUFFER_Aoffsets    KALMAN_BUFFER_NAME(Aoffsets)
+#define __KALMAN_BUFFER_Acolumns    KALMAN_BUFFER_NAME(Acolumns)
+
+#pragma message("Creating Kalman filter A sparsity buffers: " STRINGIFY(__KALMAN_BUFFER_Aoffsets) ", " STRINGIFY(__KALMAN_BUFFER_Acolumns))
+static uint_fast16_t __KALMAN_BUFFER_Aoffsets[2 * __KALMAN_A_ROWS + 1];
+static uint_fast8_t __KALMAN_BUFFER_Acolumns[__KALMAN_A_ROWS * __KALMAN_A_COLS];
+
+#endif
+
+// square root work array
+#if KALMAN_SQRT
+
+#define __KALMAN_BUFFER_sqrt    KALMAN_BUFFER_NAME(sqrt)
+
+#pragma message("Creating Kalman filter square root work buffer: " STRINGIFY(__KALMAN_BUFFER_sqrt))
+static matrix_data_t __KALMAN_BUFFER_sqrt[__KALMAN_sqrt_ROWS * __KALMAN_sqrt_COLS];
+
+#endif
+
+// UD work array
+#if KALMAN_UD
+
+#define __KALMAN_BUFFER_ud      KALMAN_BUFFER_NAME(ud)
+
+#pragma message("Creating Kalman filter UD work buffer: " STRINGIFY(__KALMAN_BUFFER_ud))
+static matrix_data_t __KALMAN_BUFFER_ud[__KALMAN_ud_ROWS * __KALMAN_ud_COLS];
+
+#endif
+
+// transition cache for multi-step predictions
+#if KALMAN_TRANSITION_CACHE
+
+#include "kalman_transition.h"
+
+#define __KALMAN_BUFFER_tcache      KALMAN_BUFFER_NAME(tcache)
+#define __KALMAN_BUFFER_tentries    KALMAN_BUFFER_NAME(tentries)
+#define __KALMAN_BUFFER_ttemp       KALMAN_BUFFER_NAME(ttemp)
+#define __KALMAN_TRANSITIONS_NAME   KALMAN_FUNCTION_NAME(transitions)
+
+#pragma message("Creating Kalman filter transition cache buffers: " STRINGIFY(__KALMAN_BUFFER_tcache) ", " STRINGIFY(__KALMAN_BUFFER_tentries) ", " STRINGIFY(__KALMAN_BUFFER_ttemp))
+static matrix_data_t __KALMAN_BUFFER_tcache[2 * KALMAN_TRANSITION_CACHE * KALMAN_NUM_STATES * KALMAN_NUM_STATES];
+static kalman_transition_t __KALMAN_BUFFER_tentries[KALMAN_TRANSITION_CACHE];
+static matrix_data_t __KALMAN_BUFFER_ttemp[3 * KALMAN_NUM_STATES * KALMAN_NUM_STATES];
+
+#pragma message("Creating Kalman filter transition cache: " STRINGIFY(__KALMAN_TRANSITIONS_NAME))
+static kalman_transition_cache_t __KALMAN_TRANSITIONS_NAME;
+
+#endif
+
+// filter history for smoothing
+#if KALMAN_SMOOTHER_LENGTH
+
+#include "kalman_smoother.h"
+
+#define __KALMAN_BUFFER_shistory    KALMAN_BUFFER_NAME(shistory)
+#define __KALMAN_BUFFER_srecords    KALMAN_BUFFER_NAME(srecords)
+#define __KALMAN_BUFFER_stemp       KALMAN_BUFFER_NAME(stemp)
+#define __KALMAN_SMOOTHER_NAME      KALMAN_FUNCTION_NAME(smoother)
+
+#pragma message("Creating Kalman filter smoother buffers: " STRINGIFY(__KALMAN_BUFFER_shistory) ", " STRINGIFY(__KALMAN_BUFFER_srecords) ", " STRINGIFY(__KALMAN_BUFFER_stemp))
+static matrix_data_t __KALMAN_BUFFER_shistory[KALMAN_SMOOTHER_LENGTH * (2 * KALMAN_NUM_STATES + 3 * KALMAN_NUM_STATES * KALMAN_NUM_STATES)];
+static kalman_smoother_record_t __KALMAN_BUFFER_srecords[KALMAN_SMOOTHER_LENGTH];
+static matrix_data_t __KALMAN_BUFFER_stemp[4 * KALMAN_NUM_STATES * KALMAN_NUM_STATES + 3 * KALMAN_NUM_STATES];
+
+#pragma message("Creating Kalman filter smoother: " STRINGIFY(__KALMAN_SMOOTHER_NAME))
+static kalman_smoother_t __KALMAN_SMOOTHER_NAME;
+
+#endif
+
+// lagged states for fixed-lag smoothing
+#if KALMAN_FIXED_LAG
+
+#include "kalman_fixed_lag.h"
+
+#define __KALMAN_BUFFER_lagged      KALMAN_BUFFER_NAME(lagged)
+#define __KALMAN_BUFFER_lagentries  KALMAN_BUFFER_NAME(lagentries)
+#define __KALMAN_FIXED_LAG_NAME     KALMAN_FUNCTION_NAME(fixed_lag)
+
+#pragma message("Creating Kalman filter fixed-lag smoother buffers: " STRINGIFY(__KALMAN_BUFFER_lagged) ", " STRINGIFY(__KALMAN_BUFFER_lagentries))
+static matrix_data_t __KALMAN_BUFFER_lagged[KALMAN_FIXED_LAG * KALMAN_NUM_STATES * (KALMAN_NUM_STATES + 1)];
+static kalman_fixed_lag_entry_t __KALMAN_BUFFER_lagentries[KALMAN_FIXED_LAG];
+
+#pragma message("Creating Kalman filter fixed-lag smoother: " STRINGIFY(__KALMAN_FIXED_LAG_NAME))
+static kalman_fixed_lag_t __KALMAN_FIXED_LAG_NAME;
+
+#endif
+
+// checkpoints for out-of-sequence measurements
+#if KALMAN_OOSM_CHECKPOINTS
+
+#include "kalman_oosm.h"
+
+#define __KALMAN_BUFFER_ocheckpoints    KALMAN_BUFFER_NAME(ocheckpoints)
+#define __KALMAN_BUFFER_ostates         KALMAN_BUFFER_NAME(ostates)
+#define __KALMAN_BUFFER_olog            KALMAN_BUFFER_NAME(olog)
+#define __KALMAN_BUFFER_ologz           KALMAN_BUFFER_NAME(ologz)
+#define __KALMAN_BUFFER_otemp           KALMAN_BUFFER_NAME(otemp)
+#define __KALMAN_OOSM_NAME              KALMAN_FUNCTION_NAME(oosm)
+
+#pragma message("Creating Kalman filter out-of-sequence measurement buffers: " STRINGIFY(__KALMAN_BUFFER_ocheckpoints) ", " STRINGIFY(__KALMAN_BUFFER_ostates) ", " STRINGIFY(__KALMAN_BUFFER_olog) ", " STRINGIFY(__KALMAN_BUFFER_ologz) ", " STRINGIFY(__KALMAN_BUFFER_otemp))
+static kalman_oosm_checkpoint_t __KALMAN_BUFFER_ocheckpoints[KALMAN_OOSM_CHECKPOINTS];
+static matrix_data_t __KALMAN_BUFFER_ostates[KALMAN_OOSM_CHECKPOINTS * (2 * KALMAN_NUM_STATES + 3 * KALMAN_NUM_STATES * KALMAN_NUM_STATES)];
+static kalman_oosm_log_t __KALMAN_BUFFER_olog[KALMAN_OOSM_CHECKPOINTS * KALMAN_OOSM_LOG];
+static matrix_data_t __KALMAN_BUFFER_ologz[KALMAN_OOSM_CHECKPOINTS * KALMAN_OOSM_LOG * KALMAN_OOSM_MAX_MEASUREMENTS];
+static matrix_data_t __KALMAN_BUFFER_otemp[5 * KALMAN_NUM_STATES * KALMAN_NUM_STATES + 3 * KALMAN_NUM_STATES];
+
+#pragma message("Creating Kalman filter out-of-sequence measurement structure: " STRINGIFY(__KALMAN_OOSM_NAME))
+static kalman_oosm_t __KALMAN_OOSM_NAME;
+
+#endif
+
+// stack of measurements corrected at once
+#if KALMAN_STACKED_MEASUREMENTS
+
+#include "kalman_stacked.h"
+
+#define __KALMAN_BUFFER_stack           KALMAN_BUFFER_NAME(stack)
+#define __KALMAN_BUFFER_stacky          KALMAN_BUFFER_NAME(stacky)
+#define __KALMAN_BUFFER_stackS          KALMAN_BUFFER_NAME(stackS)
+#define __KALMAN_BUFFER_stackK          KALMAN_BUFFER_NAME(stackK)
+#define __KALMAN_BUFFER_stackHP         KALMAN_BUFFER_NAME(stackHP)
+#define __KALMAN_STACK_NAME             KALMAN_FUNCTION_NAME(stack)
+
+#pragma message("Creating Kalman filter measurement stack buffers: " STRINGIFY(__KALMAN_BUFFER_stack) ", " STRINGIFY(__KALMAN_BUFFER_stacky) ", " STRINGIFY(__KALMAN_BUFFER_stackS) ", " STRINGIFY(__KALMAN_BUFFER_stackK) ", " STRINGIFY(__KALMAN_BUFFER_stackHP))
+static kalman_measurement_t *__KALMAN_BUFFER_stack[KALMAN_STACKED_MEASUREMENTS];
+static matrix_data_t __KALMAN_BUFFER_stacky[KALMAN_STACKED_MEASUREMENTS];
+static matrix_data_t __KALMAN_BUFFER_stackS[KALMAN_STACKED_MEASUREMENTS * KALMAN_STACKED_MEASUREMENTS];
+static matrix_data_t __KALMAN_BUFFER_stackK[KALMAN_NUM_STATES * KALMAN_STACKED_MEASUREMENTS];
+static matrix_data_t __KALMAN_BUFFER_stackHP[KALMAN_STACKED_MEASUREMENTS * KALMAN_NUM_STATES];
+
+#pragma message("Creating Kalman filter measurement stack: " STRINGIFY(__KALMAN_STACK_NAME))
+static kalman_stack_t __KALMAN_STACK_NAME;
+
+#endif
 
 /************************************************************************/
 /* Construct Kalman filter                                              */
@@ -233,7 +530,7 @@ static kalman_t* KALMAN_FUNCTION_NAME(init)()
     int i;
     for (i = 0; i < __KALMAN_x_ROWS * __KALMAN_x_COLS; ++i) { __KALMAN_BUFFER_x[i] = 0; }
     for (i = 0; i < __KALMAN_A_ROWS * __KALMAN_A_COLS; ++i) { __KALMAN_BUFFER_A[i] = 0; }
-    for (i = 0; i < __KALMAN_P_ROWS * __KALMAN_P_COLS; ++i) { __KALMAN_BUFFER_P[i] = 0; }
+    for (i = 0; i < __KALMAN_P_size; ++i) { __KALMAN_BUFFER_P[i] = 0; }
 
 #if KALMAN_NUM_INPUTS > 0
     for (i = 0; i < __KALMAN_B_ROWS * __KALMAN_B_COLS; ++i) { __KALMAN_BUFFER_B[i] = 0; }
@@ -243,7 +540,315 @@ static kalman_t* KALMAN_FUNCTION_NAME(init)()
 
     kalman_filter_initialize(&KALMAN_STRUCT_NAME, KALMAN_NUM_STATES, KALMAN_NUM_INPUTS, __KALMAN_BUFFER_A, __KALMAN_BUFFER_x,
                             __KALMAN_BUFFER_B, __KALMAN_BUFFER_u, __KALMAN_BUFFER_P, __KALMAN_BUFFER_Q,
-                            __KALMAN_BUFFER_aux, __KALMAN_BUFFER_aux, __KALMAN_BUFFER_tempPBQ, __KALMAN_BUFFER_tempPBQ);
+                            __KALMAN_BUFFER_aux, __KALMAN_BUFFER_aux, __KALMAN_BUFFER_tempBQ);
+#if KALMAN_TRANSITION_CACHE
+    kalman_transition_cache_initialize(&__KALMAN_TRANSITIONS_NAME, KALMAN_NUM_STATES, __KALMAN_BUFFER_tentries, KALMAN_TRANSITION_CACHE,
+                                       __KALMAN_BUFFER_tcache, __KALMAN_BUFFER_ttemp);
+#endif
+#if KALMAN_SMOOTHER_LENGTH
+    kalman_smoother_initialize(&__KALMAN_SMOOTHER_NAME, KALMAN_NUM_STATES, __KALMAN_BUFFER_srecords, KALMAN_SMOOTHER_LENGTH,
+                               __KALMAN_BUFFER_shistory, __KALMAN_BUFFER_stemp);
+#endif
+#if KALMAN_FIXED_LAG
+    kalman_fixed_lag_initialize(&__KALMAN_FIXED_LAG_NAME, KALMAN_NUM_STATES, __KALMAN_BUFFER_lagentries, KALMAN_FIXED_LAG, __KALMAN_BUFFER_lagged);
+#endif
+#if KALMAN_OOSM_CHECKPOINTS
+    kalman_oosm_initialize(&__KALMAN_OOSM_NAME, KALMAN_NUM_STATES, __KALMAN_BUFFER_ocheckpoints, KALMAN_OOSM_CHECKPOINTS, __KALMAN_BUFFER_ostates,
+                           __KALMAN_BUFFER_olog, KALMAN_OOSM_LOG, __KALMAN_BUFFER_ologz, KALMAN_OOSM_MAX_MEASUREMENTS, __KALMAN_BUFFER_otemp);
+#endif
+#if KALMAN_STACKED_MEASUREMENTS
+    kalman_stack_initialize(&__KALMAN_STACK_NAME, KALMAN_NUM_STATES, __KALMAN_BUFFER_stack, KALMAN_STACKED_MEASUREMENTS,
+                            __KALMAN_BUFFER_stacky, __KALMAN_BUFFER_stackS, __KALMAN_BUFFER_stackK, __KALMAN_BUFFER_aux, __KALMAN_BUFFER_stackHP);
+#endif
     return &KALMAN_STRUCT_NAME;
 }
 
+#if KALMAN_TRANSITION_CACHE
+
+#pragma message ("Creating Kalman filter multi-step prediction function: " STRINGIFY(KALMAN_FUNCTION_NAME(predict_steps()) ))
+
+/*!
+* \brief Performs a number of prediction steps at the cost of a single one.
+* \param[in] steps The number of prediction steps (\c 1 or more)
+*
+* This is equivalent to calling \c kalman_predict_steps() with the filter's transition cache.
+*/
+UNUSED static void KALMAN_FUNCTION_NAME(predict_steps)(uint_fast16_t steps)
+{
+    kalman_predict_steps(&KALMAN_STRUCT_NAME, &__KALMAN_TRANSITIONS_NAME, steps);
+}
+
+#pragma message ("Creating Kalman filter variable time step prediction function: " STRINGIFY(KALMAN_FUNCTION_NAME(predict_dt()) ))
+
+/*!
+* \brief Predicts over a variable time step.
+* \param[in] dt The time step
+*
+* This is equivalent to calling \c kalman_predict_dt() with the filter's transition cache,
+* which must have been keyed on time steps with \c kalman_transition_cache_set_model().
+*/
+UNUSED static void KALMAN_FUNCTION_NAME(predict_dt)(matrix_data_t dt)
+{
+    kalman_predict_dt(&KALMAN_STRUCT_NAME, &__KALMAN_TRANSITIONS_NAME, dt);
+}
+
+#endif
+
+#if KALMAN_SPARSE_A
+
+#pragma message ("Creating Kalman filter sparsity analysis function: " STRINGIFY(KALMAN_FUNCTION_NAME(analyze_sparsity()) ))
+
+/*!
+* \brief Determines the sparsity pattern of A and enables the sparse prediction.
+* \return The number of multiplications per row vector product with A
+*
+* Must be called after A has been set, and again whenever an entry of A changes between zero, one and any other value.
+*/
+UNUSED static uint_fast16_t KALMAN_FUNCTION_NAME(analyze_sparsity)()
+{
+    return kalman_filter_set_sparsity(&KALMAN_STRUCT_NAME, __KALMAN_BUFFER_Aoffsets, __KALMAN_BUFFER_Acolumns);
+}
+
+#endif
+
+#if KALMAN_SQRT
+
+#pragma message ("Creating Kalman filter square root enabling function: " STRINGIFY(KALMAN_FUNCTION_NAME(enable_sqrt()) ))
+
+/*!
+* \brief Replaces P and Q by their Cholesky factors and switches the filter to square root form.
+* \return Zero in case of success, nonzero if P or Q is not positive definite.
+*
+* Must be called once after P and Q have been set.
+*/
+UNUSED static int KALMAN_FUNCTION_NAME(enable_sqrt)()
+{
+    return kalman_filter_enable_sqrt(&KALMAN_STRUCT_NAME, __KALMAN_BUFFER_sqrt);
+}
+
+#endif
+
+#if KALMAN_UD
+
+#pragma message ("Creating Kalman filter UD enabling function: " STRINGIFY(KALMAN_FUNCTION_NAME(enable_ud()) ))
+
+/*!
+* \brief Factors the initial covariance into the packed P buffer and switches the filter to UD form.
+* \param[in] P The initial state covariance (number of states x number of states)
+* \return Zero in case of success, nonzero if P or Q is not positive definite.
+*
+* Must be called once after Q has been set.
+*/
+UNUSED static int KALMAN_FUNCTION_NAME(enable_ud)(const matrix_t *P)
+{
+    return kalman_filter_enable_ud(&KALMAN_STRUCT_NAME, P, __KALMAN_BUFFER_ud);
+}
+
+#pragma message ("Creating Kalman filter UD prediction function: " STRINGIFY(KALMAN_FUNCTION_NAME(predict()) ))
+
+/*!
+* \brief Performs the time update / prediction step of the filter in UD form.
+*
+* This is equivalent to calling \c kalman_predict() on the filter structure.
+*/
+UNUSED static void KALMAN_FUNCTION_NAME(predict)()
+{
+    kalman_predict(&KALMAN_STRUCT_NAME);
+}
+
+#else
+
+#pragma message ("Creating Kalman filter fixed-size prediction function: " STRINGIFY(KALMAN_FUNCTION_NAME(predict()) ))
+
+/*!
+* \brief Performs the time update / prediction step using the compile time filter dimensions.
+*
+* This is equivalent to calling \c kalman_predict() on the filter structure.
+* If the sparsity pattern of A has been analyzed or the filter is in square root form, \c kalman_predict() is used instead.
+*/
+UNUSED static void KALMAN_FUNCTION_NAME(predict)()
+{
+    int i, j, k;
+    matrix_data_t *RESTRICT const aux = __KALMAN_BUFFER_aux;
+
+#if KALMAN_SPARSE_A
+    if (KALMAN_STRUCT_NAME.A_sparsity.offsets != (uint_fast16_t*)0)
+    {
+        kalman_predict(&KALMAN_STRUCT_NAME);
+        return;
+    }
+#endif
+
+#if KALMAN_SQRT
+    if (KALMAN_STRUCT_NAME.temporary.sqrt_work != (matrix_data_t*)0)
+    {
+        kalman_predict(&KALMAN_STRUCT_NAME);
+        return;
+    }
+#endif
+
+    /************************************************************************/
+    /* Predict next state using system dynamics                             */
+    /* x = A*x                                                              */
+    /************************************************************************/
+
+    for (i = 0; i < KALMAN_NUM_STATES; ++i)
+    {
+        matrix_data_t total = 0;
+        for (k = 0; k < KALMAN_NUM_STATES; ++k)
+        {
+            total += __KALMAN_BUFFER_A[i * KALMAN_NUM_STATES + k] * __KALMAN_BUFFER_x[k];
+        }
+        aux[i] = total;
+    }
+    for (i = 0; i < KALMAN_NUM_STATES; ++i) { __KALMAN_BUFFER_x[i] = aux[i]; }
+
+    // the covariance is at steady state
+    if (KALMAN_STRUCT_NAME.covariance_frozen) return;
+
+    /************************************************************************/
+    /* Predict next covariance using system dynamics and input              */
+    /* P = A*P*A' + B*Q*B'                                                  */
+    /*                                                                      */
+    /* This is the in-place scheme of matrix_mult_abat().                   */
+    /************************************************************************/
+
+#if KALMAN_NUM_INPUTS > 0
+
+    // BQ = B*Q
+    for (i = 0; i < KALMAN_NUM_STATES; ++i)
+    {
+        for (j = 0; j < KALMAN_NUM_INPUTS; ++j)
+        {
+            matrix_data_t total = 0;
+            for (k = 0; k < KALMAN_NUM_INPUTS; ++k)
+            {
+                total += __KALMAN_BUFFER_B[i * KALMAN_NUM_INPUTS + k] * __KALMAN_BUFFER_Q[k * KALMAN_NUM_INPUTS + j];
+            }
+            __KALMAN_BUFFER_tempBQ[i * KALMAN_NUM_INPUTS + j] = total;
+        }
+    }
+
+#endif
+
+    // P = P*A', row by row
+    for (i = 0; i < KALMAN_NUM_STATES; ++i)
+    {
+        for (k = 0; k < KALMAN_NUM_STATES; ++k) { aux[k] = __KALMAN_BUFFER_P[i * KALMAN_NUM_STATES + k]; }
+        for (j = 0; j < KALMAN_NUM_STATES; ++j)
+        {
+            matrix_data_t total = 0;
+            for (k = 0; k < KALMAN_NUM_STATES; ++k)
+            {
+                total += aux[k] * __KALMAN_BUFFER_A[j * KALMAN_NUM_STATES + k];
+            }
+            __KALMAN_BUFFER_P[i * KALMAN_NUM_STATES + j] = total;
+        }
+    }
+
+    // P = A*P + BQ*B', row by row from the last, lower triangle stored transposed
+    for (i = KALMAN_NUM_STATES - 1; i >= 0; --i)
+    {
+        for (j = 0; j <= i; ++j) { aux[j] = 0; }
+        for (k = 0; k < KALMAN_NUM_STATES; ++k)
+        {
+            const matrix_data_t factor = __KALMAN_BUFFER_A[i * KALMAN_NUM_STATES + k];
+            for (j = 0; j <= i; ++j)
+            {
+                aux[j] += factor * __KALMAN_BUFFER_P[k * KALMAN_NUM_STATES + j];
+            }
+        }
+        for (j = 0; j <= i; ++j)
+        {
+            matrix_data_t total = aux[j];
+#if KALMAN_NUM_INPUTS > 0
+            for (k = 0; k < KALMAN_NUM_INPUTS; ++k)
+            {
+                total += __KALMAN_BUFFER_tempBQ[i * KALMAN_NUM_INPUTS + k] * __KALMAN_BUFFER_B[j * KALMAN_NUM_INPUTS + k];
+            }
+#endif
+            __KALMAN_BUFFER_P[j * KALMAN_NUM_STATES + i] = total;
+        }
+    }
+
+    // mirror the upper triangle
+    for (i = 1; i < KALMAN_NUM_STATES; ++i)
+    {
+        for (j = 0; j < i; ++j)
+        {
+            __KALMAN_BUFFER_P[i * KALMAN_NUM_STATES + j] = __KALMAN_BUFFER_P[j * KALMAN_NUM_STATES + i];
+        }
+    }
+}
+
+#endif
+
+/************************************************************************/
+/* Construct fixed-point Kalman filter                                  */
+/************************************************************************/
+
+#ifdef KALMAN_Q_FRACTION_BITS
+
+#include "kalman_q.h"
+
+#pragma message("KALMAN_Q_FRACTION_BITS was set. Creating fixed-point filter with " STRINGIFY(KALMAN_Q_FRACTION_BITS) " fractional bits.")
+
+#define __KALMAN_BUFFER_Aq          KALMAN_BUFFER_NAME(Aq)
+#define __KALMAN_BUFFER_Pq          KALMAN_BUFFER_NAME(Pq)
+#define __KALMAN_BUFFER_xq          KALMAN_BUFFER_NAME(xq)
+#define __KALMAN_BUFFER_predictedxq KALMAN_BUFFER_NAME(predictedxq)
+#define __KALMAN_BUFFER_tempAPq     KALMAN_BUFFER_NAME(tempAPq)
+
+#pragma message("Creating fixed-point Kalman filter buffers: " STRINGIFY(__KALMAN_BUFFER_Aq) ", " STRINGIFY(__KALMAN_BUFFER_Pq) ", " STRINGIFY(__KALMAN_BUFFER_xq))
+static matrix_q_data_t __KALMAN_BUFFER_Aq[__KALMAN_A_ROWS * __KALMAN_A_COLS];
+static matrix_q_data_t __KALMAN_BUFFER_Pq[__KALMAN_P_ROWS * __KALMAN_P_COLS];
+static matrix_q_data_t __KALMAN_BUFFER_xq[__KALMAN_x_ROWS * __KALMAN_x_COLS];
+
+#pragma message("Creating fixed-point Kalman filter temporary buffers: " STRINGIFY(__KALMAN_BUFFER_predictedxq) ", " STRINGIFY(__KALMAN_BUFFER_tempAPq))
+static matrix_q_data_t __KALMAN_BUFFER_predictedxq[__KALMAN_x_ROWS * __KALMAN_x_COLS];
+static matrix_q_data_t __KALMAN_BUFFER_tempAPq[__KALMAN_P_ROWS * __KALMAN_P_COLS];
+
+#if KALMAN_NUM_INPUTS > 0
+
+#define __KALMAN_BUFFER_Bq          KALMAN_BUFFER_NAME(Bq)
+#define __KALMAN_BUFFER_Qq          KALMAN_BUFFER_NAME(Qq)
+#define __KALMAN_BUFFER_tempBQq     KALMAN_BUFFER_NAME(tempBQq)
+
+#pragma message("Creating fixed-point Kalman filter input buffers: " STRINGIFY(__KALMAN_BUFFER_Bq) ", " STRINGIFY(__KALMAN_BUFFER_Qq) ", " STRINGIFY(__KALMAN_BUFFER_tempBQq))
+static matrix_q_data_t __KALMAN_BUFFER_Bq[__KALMAN_B_ROWS * __KALMAN_B_COLS];
+static matrix_q_data_t __KALMAN_BUFFER_Qq[__KALMAN_Q_ROWS * __KALMAN_Q_COLS];
+static matrix_q_data_t __KALMAN_BUFFER_tempBQq[__KALMAN_tempBQ_size];
+
+#else
+
+#define __KALMAN_BUFFER_Bq          ((matrix_q_data_t*)0)
+#define __KALMAN_BUFFER_Qq          ((matrix_q_data_t*)0)
+#define __KALMAN_BUFFER_tempBQq     ((matrix_q_data_t*)0)
+
+#endif
+
+#pragma message("Creating fixed-point Kalman filter structure: " STRINGIFY(KALMAN_FUNCTION_NAME(q)))
+
+/*!
+* \brief The fixed-point Kalman filter structure
+*/
+static kalman_q_t KALMAN_FUNCTION_NAME(q);
+
+#pragma message ("Creating fixed-point Kalman filter initialization function: " STRINGIFY(KALMAN_FUNCTION_NAME(init_q()) ))
+
+/*!
+* \brief Initializes the fixed-point Kalman Filter from the floating point filter
+* \return Pointer to the fixed-point filter.
+*
+* Must be called after the floating point filter has been initialized and its model and state have been set.
+*/
+UNUSED static kalman_q_t* KALMAN_FUNCTION_NAME(init_q)()
+{
+    kalman_q_filter_initialize(&KALMAN_FUNCTION_NAME(q), KALMAN_NUM_STATES, KALMAN_NUM_INPUTS, KALMAN_Q_FRACTION_BITS,
+                               __KALMAN_BUFFER_Aq, __KALMAN_BUFFER_xq, __KALMAN_BUFFER_Bq, __KALMAN_BUFFER_Pq, __KALMAN_BUFFER_Qq,
+                               __KALMAN_BUFFER_predictedxq, __KALMAN_BUFFER_tempAPq, __KALMAN_BUFFER_tempBQq);
+    kalman_q_filter_from_float(&KALMAN_STRUCT_NAME, &KALMAN_FUNCTION_NAME(q));
+    return &KALMAN_FUNCTION_NAME(q);
+}
+
+#endif
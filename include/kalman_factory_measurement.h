@@ -29,6 +29,9 @@
 * In addition, a parameterless static initialization function \code {kalman_filter_direction_measurement_gyroscope_init()} will
 * be created which you will need to call manually in order to set up the measurement.
 *
+* Next to the generic \c kalman_correct(), a correction function \code {kalman_filter_direction_measurement_gyroscope_correct()}
+* is created that works directly on the filter and measurement buffers with compile time dimensions.
+*
 * A full example would be
 
 * \code{.c}
@@ -55,12 +58,51 @@
 *
 * In order to force creation of separate auxiliary buffers (thus preventing buffer reuse), MEASUREMENT_FORCE_NEW_BUFFERS can be defined
 * prior to inclusion of this file.
+*
+* If the measurement covariance R is diagonal, KALMAN_MEASUREMENT_SEQUENTIAL can be defined to \c 1 prior to inclusion of this file.
+* The S and HxP buffers are then not created and the generated correction function processes the measurements one at a time,
+* i.e. the measurement must only be used with \c kalman_correct_sequential(). The define only applies to the current measurement.
+*
+* If the residual covariance S of the measurement spans many orders of magnitude, KALMAN_MEASUREMENT_MIXED_PRECISION can be defined
+* to \c 1 prior to inclusion of this file. A double precision workspace is then created and both \c kalman_correct() and the generated
+* correction function accumulate, factor and substitute S in double precision, while x and P keep their precision.
+* The define only applies to the current measurement.
+*
+* If the same measurement corrects the filter after every prediction and A, Q, H and R do not change, KALMAN_MEASUREMENT_STEADY_STATE
+* can be defined to \c 1 prior to inclusion of this file. A buffer for the previous gain is created along with a function
+* \code {kalman_filter_direction_measurement_gyroscope_enable_steady_state(tolerance)} that enables the detection; the generated
+* correction function then defers to \c kalman_correct(), which freezes K and stops the covariance math once K has converged.
+* Only the full covariance correction detects convergence, i.e. not while the filter is in square root form.
+* The define only applies to the current measurement.
+*
+* If the filter was created with KALMAN_SQRT, a work buffer is created along with a function
+* \code {kalman_filter_direction_measurement_gyroscope_enable_sqrt()} that must be called once R is set. The generated correction
+* function then defers to \c kalman_correct() while the filter is in square root form.
+*
+* If the filter was created with KALMAN_UD, the measurement is created as with KALMAN_MEASUREMENT_SEQUENTIAL and the
+* generated correction function defers to the Bierman updates of \c kalman_correct().
+*
+* If the filter was created with KALMAN_Q_FRACTION_BITS, a fixed-point copy \c kalman_filter_direction_measurement_gyroscope_q
+* of the measurement is created with its own Q-format buffers, along with a function \code {kalman_filter_direction_measurement_gyroscope_init_q()}
+* that converts H, R and z of the floating point measurement into it. The fixed-point measurement is used with \c kalman_q_correct().
 */
 
 #ifndef MEASUREMENT_FORCE_NEW_BUFFERS
 #define MEASUREMENT_FORCE_NEW_BUFFERS 0
 #endif
 
+#ifndef KALMAN_MEASUREMENT_SEQUENTIAL
+#define KALMAN_MEASUREMENT_SEQUENTIAL 0
+#endif
+
+#ifndef KALMAN_MEASUREMENT_MIXED_PRECISION
+#define KALMAN_MEASUREMENT_MIXED_PRECISION 0
+#endif
+
+#ifndef KALMAN_MEASUREMENT_STEADY_STATE
+#define KALMAN_MEASUREMENT_STEADY_STATE 0
+#endif
+
 /************************************************************************/
 /* Check for inputs                                                     */
 /************************************************************************/
@@ -85,12 +127,46 @@
 #error KALMAN_NUM_MEASUREMENTS must be a positive integer or zero if no inputs are used
 #endif
 
+#if KALMAN_MEASUREMENT_SEQUENTIAL && KALMAN_MEASUREMENT_MIXED_PRECISION
+#error KALMAN_MEASUREMENT_MIXED_PRECISION cannot be combined with KALMAN_MEASUREMENT_SEQUENTIAL, which has no residual covariance to factor
+#endif
+
+#if KALMAN_SQRT && (KALMAN_MEASUREMENT_SEQUENTIAL || KALMAN_MEASUREMENT_MIXED_PRECISION)
+#error KALMAN_MEASUREMENT_SEQUENTIAL and KALMAN_MEASUREMENT_MIXED_PRECISION cannot be used with a filter created with KALMAN_SQRT
+#endif
+
+#if KALMAN_MEASUREMENT_STEADY_STATE && (KALMAN_MEASUREMENT_SEQUENTIAL || KALMAN_MEASUREMENT_MIXED_PRECISION || KALMAN_UD)
+#error KALMAN_MEASUREMENT_STEADY_STATE cannot be combined with KALMAN_MEASUREMENT_SEQUENTIAL, KALMAN_MEASUREMENT_MIXED_PRECISION or KALMAN_UD
+#endif
+
+#if KALMAN_UD && KALMAN_MEASUREMENT_MIXED_PRECISION
+#error KALMAN_MEASUREMENT_MIXED_PRECISION cannot be used with a filter created with KALMAN_UD, which has no residual covariance to factor
+#endif
+
+// the UD correction processes the measurements one at a time and needs neither S nor HxP
+#if KALMAN_UD && !KALMAN_MEASUREMENT_SEQUENTIAL
+#undef KALMAN_MEASUREMENT_SEQUENTIAL
+#define KALMAN_MEASUREMENT_SEQUENTIAL 1
+#endif
+
 #pragma message("** Instantiating Kalman filter \"" STRINGIFY(KALMAN_NAME) "\" measurement \"" STRINGIFY(KALMAN_MEASUREMENT_NAME) "\" with " STRINGIFY(KALMAN_NUM_MEASUREMENTS) " measured outputs")
 
 #if MEASUREMENT_FORCE_NEW_BUFFERS
 #pragma message("MEASUREMENT_FORCE_NEW_BUFFERS was set. Forcing separate auxiliary buffers.")
 #endif
 
+#if KALMAN_MEASUREMENT_SEQUENTIAL
+#pragma message("KALMAN_MEASUREMENT_SEQUENTIAL was set. Using sequential scalar updates.")
+#endif
+
+#if KALMAN_MEASUREMENT_MIXED_PRECISION
+#pragma message("KALMAN_MEASUREMENT_MIXED_PRECISION was set. Calculating the gain in double precision.")
+#endif
+
+#if KALMAN_MEASUREMENT_STEADY_STATE
+#pragma message("KALMAN_MEASUREMENT_STEADY_STATE was set. Freezing the gain once it has converged.")
+#endif
+
 /************************************************************************/
 /* Prepare dimensions                                                   */
 /************************************************************************/
@@ -124,21 +200,24 @@
 #define __KALMAN_maux_COLS      1
 #define __USE_BUFFER_AUX        ((__KALMAN_maux_ROWS * __KALMAN_maux_COLS) <= __KALMAN_aux_size)
 
-// inverted S buffer
-#define __KALMAN_Sinv_ROWS      __KALMAN_S_ROWS
-#define __KALMAN_Sinv_COLS      __KALMAN_S_COLS
-
 // temporary HxP buffer
 #define __KALMAN_tempHP_ROWS    __KALMAN_H_ROWS
 #define __KALMAN_tempHP_COLS    __KALMAN_H_COLS
 
-// temporary PxH' buffer
-#define __KALMAN_tempPHt_ROWS    __KALMAN_H_COLS // [sic]
-#define __KALMAN_tempPHt_COLS    __KALMAN_H_ROWS // [sic]
+// double precision workspace, S and one row of K
+#define __KALMAN_wide_ROWS      KALMAN_NUM_MEASUREMENTS
+#define __KALMAN_wide_COLS      (KALMAN_NUM_MEASUREMENTS + 1)
+
+// square root correction pre-array [sqrt(R) H*L; 0 L]
+#define __KALMAN_msqrt_ROWS     (KALMAN_NUM_MEASUREMENTS + KALMAN_NUM_STATES)
+#define __KALMAN_msqrt_COLS     (KALMAN_NUM_MEASUREMENTS + KALMAN_NUM_STATES)
 
-// temporary Kx(HxP) buffer
-#define __KALMAN_tempKHP_ROWS   __KALMAN_P_ROWS
-#define __KALMAN_tempKHP_COLS   __KALMAN_P_COLS
+// precision of the residual covariance and gain calculation
+#if KALMAN_MEASUREMENT_MIXED_PRECISION
+#define __KALMAN_gain_t         matrix_wide_t
+#else
+#define __KALMAN_gain_t         matrix_data_t
+#endif
 
 /************************************************************************/
 /* Name macro                                                           */
@@ -164,6 +243,8 @@
 /* Construct Kalman filter measurement buffers                          */
 /************************************************************************/
 
+#include <assert.h>
+#include <math.h>
 #include "compiler.h"
 #include "matrix.h"
 #include "kalman.h"
@@ -188,8 +269,13 @@ static matrix_data_t __KALMAN_BUFFER_z[__KALMAN_z_ROWS * __KALMAN_z_COLS];
 #pragma message("Creating Kalman measurement K buffer: " STRINGIFY(__KALMAN_BUFFER_K))
 static matrix_data_t __KALMAN_BUFFER_K[__KALMAN_K_ROWS * __KALMAN_K_COLS];
 
+#if !KALMAN_MEASUREMENT_SEQUENTIAL
 #pragma message("Creating Kalman measurement S buffer: " STRINGIFY(__KALMAN_BUFFER_S))
 static matrix_data_t __KALMAN_BUFFER_S[__KALMAN_S_ROWS * __KALMAN_S_COLS];
+#else
+#undef __KALMAN_BUFFER_S
+#define __KALMAN_BUFFER_S   ((matrix_data_t*)0)
+#endif
 
 #pragma message("Creating Kalman measurement y buffer: " STRINGIFY(__KALMAN_BUFFER_y))
 static matrix_data_t __KALMAN_BUFFER_y[__KALMAN_y_ROWS * __KALMAN_y_COLS];
@@ -214,58 +300,45 @@ static matrix_data_t __KALMAN_BUFFER_maux[__KALMAN_maux_size];
 
 #endif
 
-// create buffer for inverted s
-#define __KALMAN_Sinv_size      (__KALMAN_Sinv_ROWS * __KALMAN_Sinv_COLS)
-
-#if __KALMAN_Sinv_size <= __KALMAN_tempPBQ_size && !MEASUREMENT_FORCE_NEW_BUFFERS
-
-#define __KALMAN_BUFFER_Sinv  __KALMAN_BUFFER_tempPBQ
-#pragma message("Re-using Kalman filter temporary P/BQ buffer for temporary S-inverted buffer: " STRINGIFY(__KALMAN_BUFFER_Sinv))
-
-#else
-
-#define __KALMAN_BUFFER_Sinv     KALMAN_MEASUREMENT_BUFFER_NAME(Sinv)
-#pragma message("Creating Kalman measurement temporary S-inverted buffer: " STRINGIFY(__KALMAN_BUFFER_Sinv))
-static matrix_data_t __KALMAN_BUFFER_Sinv[__KALMAN_Sinv_size];
-
-#endif
-
 // create buffer for HxP
 #define __KALMAN_tempHP_size    (__KALMAN_tempHP_ROWS * __KALMAN_tempHP_COLS)
 
+#if !KALMAN_MEASUREMENT_SEQUENTIAL
+
 #define __KALMAN_BUFFER_tempHP  KALMAN_MEASUREMENT_BUFFER_NAME(tempHP)
 #pragma message("Creating Kalman measurement temporary HxP buffer: " STRINGIFY(__KALMAN_BUFFER_tempHP))
 static matrix_data_t __KALMAN_BUFFER_tempHP[__KALMAN_tempHP_size];
 
-// create buffer for PxH'
-#define __KALMAN_tempPHt_size    (__KALMAN_tempPHt_ROWS * __KALMAN_tempPHt_COLS)
+#else
 
-#if !MEASUREMENT_FORCE_NEW_BUFFERS
+#define __KALMAN_BUFFER_tempHP  ((matrix_data_t*)0)
 
-#define __KALMAN_BUFFER_tempPHt  __KALMAN_BUFFER_tempHP
-#pragma message("Re-using Kalman measurement temporary HxP for temporary PxH' buffer: " STRINGIFY(__KALMAN_BUFFER_tempPHt))
+#endif
 
-#else
+// create double precision workspace
+#if KALMAN_MEASUREMENT_MIXED_PRECISION
 
-#define __KALMAN_BUFFER_tempPHt  KALMAN_MEASUREMENT_BUFFER_NAME(tempPHt)
-#pragma message("Creating Kalman measurement temporary PxH' buffer: " STRINGIFY(__KALMAN_BUFFER_tempPHt))           // TODO: reuse HxP buffer!
-static matrix_data_t __KALMAN_BUFFER_tempPHt[__KALMAN_tempPHt_size];
+#define __KALMAN_BUFFER_wide    KALMAN_MEASUREMENT_BUFFER_NAME(wide)
+#pragma message("Creating Kalman measurement double precision buffer: " STRINGIFY(__KALMAN_BUFFER_wide))
+static matrix_wide_t __KALMAN_BUFFER_wide[__KALMAN_wide_ROWS * __KALMAN_wide_COLS];
 
 #endif
 
-// create Kx(HxP) buffer
-#define __KALMAN_tempKHP_size    (__KALMAN_tempKHP_ROWS * __KALMAN_tempKHP_COLS)
+// create previous gain buffer
+#if KALMAN_MEASUREMENT_STEADY_STATE
 
-#if (__KALMAN_tempKHP_size <= __KALMAN_tempPBQ_size) && !MEASUREMENT_FORCE_NEW_BUFFERS
+#define __KALMAN_BUFFER_Kprev   KALMAN_MEASUREMENT_BUFFER_NAME(Kprev)
+#pragma message("Creating Kalman measurement previous gain buffer: " STRINGIFY(__KALMAN_BUFFER_Kprev))
+static matrix_data_t __KALMAN_BUFFER_Kprev[__KALMAN_K_ROWS * __KALMAN_K_COLS];
 
-#define __KALMAN_BUFFER_tempKHP     __KALMAN_BUFFER_tempPBQ
-#pragma message("Re-using Kalman filter temporary P/BQ buffer for measurement temporary Kx(HxP)  buffer: " STRINGIFY(__KALMAN_BUFFER_tempKHP))
+#endif
 
-#else
+// create square root work array
+#if KALMAN_SQRT
 
-#define __KALMAN_BUFFER_tempKHP  KALMAN_MEASUREMENT_BUFFER_NAME(tempKHP)
-#pragma message("Creating Kalman measurement temporary Kx(HxP) buffer: " STRINGIFY(__KALMAN_BUFFER_tempKHP))
-static matrix_data_t __KALMAN_BUFFER_tempKHP[__KALMAN_tempKHP_size];
+#define __KALMAN_BUFFER_msqrt   KALMAN_MEASUREMENT_BUFFER_NAME(sqrt)
+#pragma message("Creating Kalman measurement square root work buffer: " STRINGIFY(__KALMAN_BUFFER_msqrt))
+static matrix_data_t __KALMAN_BUFFER_msqrt[__KALMAN_msqrt_ROWS * __KALMAN_msqrt_COLS];
 
 #endif
 
@@ -289,21 +362,375 @@ static kalman_measurement_t* KALMAN_MEASUREMENT_FUNCTION_NAME(init)()
     for (i = 0; i < __KALMAN_H_ROWS * __KALMAN_H_COLS; ++i) { __KALMAN_BUFFER_H[i] = 0; }
     for (i = 0; i < __KALMAN_R_ROWS * __KALMAN_R_COLS; ++i) { __KALMAN_BUFFER_R[i] = 0; }
     for (i = 0; i < __KALMAN_y_ROWS * __KALMAN_y_COLS; ++i) { __KALMAN_BUFFER_y[i] = 0; }
+#if !KALMAN_MEASUREMENT_SEQUENTIAL
     for (i = 0; i < __KALMAN_S_ROWS * __KALMAN_S_COLS; ++i) { __KALMAN_BUFFER_S[i] = 0; }
+#endif
     for (i = 0; i < __KALMAN_K_ROWS * __KALMAN_K_COLS; ++i) { __KALMAN_BUFFER_K[i] = 0; }
 
     kalman_measurement_initialize(&KALMAN_MEASUREMENT_BASENAME, KALMAN_NUM_STATES, KALMAN_NUM_MEASUREMENTS, __KALMAN_BUFFER_H, __KALMAN_BUFFER_z, __KALMAN_BUFFER_R, 
                                   __KALMAN_BUFFER_y, __KALMAN_BUFFER_S, __KALMAN_BUFFER_K,
-                                  __KALMAN_BUFFER_maux, __KALMAN_BUFFER_Sinv, __KALMAN_BUFFER_tempHP, __KALMAN_BUFFER_tempPHt, __KALMAN_BUFFER_tempKHP);
+                                  __KALMAN_BUFFER_maux, __KALMAN_BUFFER_tempHP);
+#if KALMAN_MEASUREMENT_MIXED_PRECISION
+    kalman_measurement_set_mixed_precision(&KALMAN_MEASUREMENT_BASENAME, __KALMAN_BUFFER_wide);
+#endif
     return &KALMAN_MEASUREMENT_BASENAME;
 }
 
+#if KALMAN_SQRT
+
+#pragma message ("Creating Kalman measurement square root enabling function: " STRINGIFY(KALMAN_MEASUREMENT_FUNCTION_NAME(enable_sqrt()) ))
+
+/*!
+* \brief Replaces R by its Cholesky factor for the correction of the filter in square root form.
+* \return Zero in case of success, nonzero if R is not positive definite.
+*
+* Must be called once after R has been set.
+*/
+UNUSED static int KALMAN_MEASUREMENT_FUNCTION_NAME(enable_sqrt)()
+{
+    return kalman_measurement_enable_sqrt(&KALMAN_MEASUREMENT_BASENAME, __KALMAN_BUFFER_msqrt);
+}
+
+#endif
+
+#if KALMAN_MEASUREMENT_STEADY_STATE
+
+#pragma message ("Creating Kalman measurement steady state enabling function: " STRINGIFY(KALMAN_MEASUREMENT_FUNCTION_NAME(enable_steady_state()) ))
+
+/*!
+* \brief Enables the steady state detection of the Kalman gain.
+* \param[in] tolerance The largest absolute change of any gain element between two corrections that counts as converged
+*
+* Call \c kalman_steady_state_reset() after changing A, B, Q, H or R.
+*/
+UNUSED static void KALMAN_MEASUREMENT_FUNCTION_NAME(enable_steady_state)(matrix_data_t tolerance)
+{
+    kalman_measurement_enable_steady_state(&KALMAN_MEASUREMENT_BASENAME, __KALMAN_BUFFER_Kprev, tolerance);
+}
+
+#endif
+
+#if !KALMAN_MEASUREMENT_SEQUENTIAL
+
+#pragma message ("Creating Kalman measurement fixed-size correction function: " STRINGIFY(KALMAN_MEASUREMENT_FUNCTION_NAME(correct()) ))
+
+/*!
+* \brief Performs the measurement update step using the compile time filter and measurement dimensions.
+*
+* This is equivalent to calling \c kalman_correct() on the filter and measurement structures.
+* If the filter is in square root form, the steady state detection is enabled, the gain is frozen
+* (e.g. by \c kalman_dare_solve()) or the covariance is frozen by another measurement, \c kalman_correct() is used instead.
+*/
+UNUSED static void KALMAN_MEASUREMENT_FUNCTION_NAME(correct)()
+{
+    int i, j, k;
+    matrix_data_t *RESTRICT const HP = __KALMAN_BUFFER_tempHP;
+#if KALMAN_MEASUREMENT_MIXED_PRECISION
+    matrix_wide_t *RESTRICT const L = __KALMAN_BUFFER_wide;
+#else
+    matrix_data_t *RESTRICT const L = __KALMAN_BUFFER_S;
+#endif
+
+#if KALMAN_SQRT
+    if (KALMAN_STRUCT_NAME.temporary.sqrt_work != (matrix_data_t*)0)
+    {
+        kalman_correct(&KALMAN_STRUCT_NAME, &KALMAN_MEASUREMENT_BASENAME);
+        return;
+    }
+#endif
+
+    // the gain or the covariance is frozen, or the convergence of the gain is being detected
+    if (KALMAN_MEASUREMENT_BASENAME.steady_state.frozen || KALMAN_MEASUREMENT_BASENAME.steady_state.K_previous != (matrix_data_t*)0
+        || KALMAN_STRUCT_NAME.covariance_frozen)
+    {
+        kalman_correct(&KALMAN_STRUCT_NAME, &KALMAN_MEASUREMENT_BASENAME);
+        return;
+    }
+
+    /************************************************************************/
+    /* Calculate innovation and residual covariance                         */
+    /* y = z - H*x                                                          */
+    /* S = H*P*H' + R                                                       */
+    /************************************************************************/
+
+    // y = z - H*x
+    for (i = 0; i < KALMAN_NUM_MEASUREMENTS; ++i)
+    {
+        matrix_data_t total = 0;
+        for (k = 0; k < KALMAN_NUM_STATES; ++k)
+        {
+            total += __KALMAN_BUFFER_H[i * KALMAN_NUM_STATES + k] * __KALMAN_BUFFER_x[k];
+        }
+        __KALMAN_BUFFER_y[i] = __KALMAN_BUFFER_z[i] - total;
+    }
+
+    // HP = H*P
+    for (i = 0; i < KALMAN_NUM_MEASUREMENTS; ++i)
+    {
+        for (j = 0; j < KALMAN_NUM_STATES; ++j)
+        {
+            matrix_data_t total = 0;
+            for (k = 0; k < KALMAN_NUM_STATES; ++k)
+            {
+                total += __KALMAN_BUFFER_H[i * KALMAN_NUM_STATES + k] * __KALMAN_BUFFER_P[k * KALMAN_NUM_STATES + j];
+            }
+            HP[i * KALMAN_NUM_STATES + j] = total;
+        }
+    }
+
+    // S = HP*H' + R
+    for (i = 0; i < KALMAN_NUM_MEASUREMENTS; ++i)
+    {
+        for (j = 0; j < KALMAN_NUM_MEASUREMENTS; ++j)
+        {
+            __KALMAN_gain_t total = __KALMAN_BUFFER_R[i * KALMAN_NUM_MEASUREMENTS + j];
+            for (k = 0; k < KALMAN_NUM_STATES; ++k)
+            {
+                total += (__KALMAN_gain_t)HP[i * KALMAN_NUM_STATES + k] * __KALMAN_BUFFER_H[j * KALMAN_NUM_STATES + k];
+            }
+            L[i * KALMAN_NUM_MEASUREMENTS + j] = total;
+        }
+    }
+
+    /************************************************************************/
+    /* Calculate Kalman gain                                                */
+    /* K = P*H' * S^-1                                                      */
+    /************************************************************************/
+
+    // S = L*L' (in place, lower triangle only)
+    for (i = 0; i < KALMAN_NUM_MEASUREMENTS; ++i)
+    {
+        for (j = 0; j <= i; ++j)
+        {
+            __KALMAN_gain_t sum = L[i * KALMAN_NUM_MEASUREMENTS + j];
+            for (k = 0; k < j; ++k)
+            {
+                sum -= L[i * KALMAN_NUM_MEASUREMENTS + k] * L[j * KALMAN_NUM_MEASUREMENTS + k];
+            }
+
+            if (i == j)
+            {
+                L[i * KALMAN_NUM_MEASUREMENTS + i] = (__KALMAN_gain_t)sqrt(sum);
+            }
+            else
+            {
+                L[i * KALMAN_NUM_MEASUREMENTS + j] = sum / L[j * KALMAN_NUM_MEASUREMENTS + j];
+            }
+        }
+
+        // zero the top right corner
+        for (j = i + 1; j < KALMAN_NUM_MEASUREMENTS; ++j)
+        {
+            L[i * KALMAN_NUM_MEASUREMENTS + j] = 0;
+        }
+    }
+
+#if KALMAN_MEASUREMENT_MIXED_PRECISION
+    // S holds the rounded factor, as with kalman_correct()
+    for (i = 0; i < KALMAN_NUM_MEASUREMENTS * KALMAN_NUM_MEASUREMENTS; ++i)
+    {
+        __KALMAN_BUFFER_S[i] = (matrix_data_t)L[i];
+    }
+#endif
+
+    // K = (HP)' * (L*L')^-1, since P is symmetric; each row of K solves L*L'*k' = HP(:,i)
+    for (i = 0; i < KALMAN_NUM_STATES; ++i)
+    {
+#if KALMAN_MEASUREMENT_MIXED_PRECISION
+        matrix_wide_t *RESTRICT const krow = &__KALMAN_BUFFER_wide[KALMAN_NUM_MEASUREMENTS * KALMAN_NUM_MEASUREMENTS];
+#else
+        matrix_data_t *RESTRICT const krow = &__KALMAN_BUFFER_K[i * KALMAN_NUM_MEASUREMENTS];
+#endif
+
+        // forward substitution: L*t = HP(:,i)
+        for (j = 0; j < KALMAN_NUM_MEASUREMENTS; ++j)
+        {
+            __KALMAN_gain_t sum = HP[j * KALMAN_NUM_STATES + i];
+            for (k = 0; k < j; ++k)
+            {
+                sum -= L[j * KALMAN_NUM_MEASUREMENTS + k] * krow[k];
+            }
+            krow[j] = sum / L[j * KALMAN_NUM_MEASUREMENTS + j];
+        }
+
+        // back substitution: L'*k' = t
+        for (j = KALMAN_NUM_MEASUREMENTS - 1; j >= 0; --j)
+        {
+            __KALMAN_gain_t sum = krow[j];
+            for (k = j + 1; k < KALMAN_NUM_MEASUREMENTS; ++k)
+            {
+                sum -= L[k * KALMAN_NUM_MEASUREMENTS + j] * krow[k];
+            }
+            krow[j] = sum / L[j * KALMAN_NUM_MEASUREMENTS + j];
+        }
+
+#if KALMAN_MEASUREMENT_MIXED_PRECISION
+        // round the gain
+        for (j = 0; j < KALMAN_NUM_MEASUREMENTS; ++j)
+        {
+            __KALMAN_BUFFER_K[i * KALMAN_NUM_MEASUREMENTS + j] = (matrix_data_t)krow[j];
+        }
+#endif
+    }
+
+    /************************************************************************/
+    /* Correct state prediction                                             */
+    /* x = x + K*y                                                          */
+    /************************************************************************/
+
+    for (i = 0; i < KALMAN_NUM_STATES; ++i)
+    {
+        matrix_data_t total = 0;
+        for (k = 0; k < KALMAN_NUM_MEASUREMENTS; ++k)
+        {
+            total += __KALMAN_BUFFER_K[i * KALMAN_NUM_MEASUREMENTS + k] * __KALMAN_BUFFER_y[k];
+        }
+        __KALMAN_BUFFER_x[i] += total;
+    }
+
+    /************************************************************************/
+    /* Correct state covariances                                            */
+    /* P = P - K*(H*P)                                                      */
+    /************************************************************************/
+
+    for (i = 0; i < KALMAN_NUM_STATES; ++i)
+    {
+        for (k = 0; k < KALMAN_NUM_MEASUREMENTS; ++k)
+        {
+            const matrix_data_t gain = __KALMAN_BUFFER_K[i * KALMAN_NUM_MEASUREMENTS + k];
+            for (j = 0; j < KALMAN_NUM_STATES; ++j)
+            {
+                __KALMAN_BUFFER_P[i * KALMAN_NUM_STATES + j] -= gain * HP[k * KALMAN_NUM_STATES + j];
+            }
+        }
+    }
+}
+
+#else
+
+#pragma message ("Creating Kalman measurement fixed-size sequential correction function: " STRINGIFY(KALMAN_MEASUREMENT_FUNCTION_NAME(correct()) ))
+
+/*!
+* \brief Performs the measurement update step as a sequence of scalar updates using the compile time filter and measurement dimensions.
+*
+* This is equivalent to calling \c kalman_correct_sequential() on the filter and measurement structures.
+* The covariance must not be frozen at steady state.
+*/
+UNUSED static void KALMAN_MEASUREMENT_FUNCTION_NAME(correct)()
+{
+    assert(!KALMAN_STRUCT_NAME.covariance_frozen);
+
+#if KALMAN_UD
+    kalman_correct_sequential(&KALMAN_STRUCT_NAME, &KALMAN_MEASUREMENT_BASENAME);
+#else
+    int i, r, c;
+    matrix_data_t *RESTRICT const PHt = __KALMAN_BUFFER_maux;
+
+    for (i = 0; i < KALMAN_NUM_MEASUREMENTS; ++i)
+    {
+        const matrix_data_t *RESTRICT const h = &__KALMAN_BUFFER_H[i * KALMAN_NUM_STATES];
+        matrix_data_t s = __KALMAN_BUFFER_R[i * KALMAN_NUM_MEASUREMENTS + i];
+        matrix_data_t hx = 0;
+        matrix_data_t inv_s;
+
+        // PHt = P*h', s = h*P*h' + r, hx = h*x
+        for (r = 0; r < KALMAN_NUM_STATES; ++r)
+        {
+            matrix_data_t total = 0;
+            for (c = 0; c < KALMAN_NUM_STATES; ++c)
+            {
+                total += __KALMAN_BUFFER_P[r * KALMAN_NUM_STATES + c] * h[c];
+            }
+            PHt[r] = total;
+            s += h[r] * total;
+            hx += h[r] * __KALMAN_BUFFER_x[r];
+        }
+
+        // y = z - h*x
+        __KALMAN_BUFFER_y[i] = __KALMAN_BUFFER_z[i] - hx;
+
+        // k = P*h' / s, x = x + k*y
+        inv_s = (matrix_data_t)1.0 / s;
+        for (r = 0; r < KALMAN_NUM_STATES; ++r)
+        {
+            const matrix_data_t gain = PHt[r] * inv_s;
+            __KALMAN_BUFFER_K[r * KALMAN_NUM_MEASUREMENTS + i] = gain;
+            __KALMAN_BUFFER_x[r] += gain * __KALMAN_BUFFER_y[i];
+        }
+
+        // P = P - k*(h*P), lower triangle mirrored
+        for (r = 0; r < KALMAN_NUM_STATES; ++r)
+        {
+            const matrix_data_t gain = __KALMAN_BUFFER_K[r * KALMAN_NUM_MEASUREMENTS + i];
+            for (c = 0; c < r; ++c)
+            {
+                __KALMAN_BUFFER_P[r * KALMAN_NUM_STATES + c] -= gain * PHt[c];
+                __KALMAN_BUFFER_P[c * KALMAN_NUM_STATES + r] = __KALMAN_BUFFER_P[r * KALMAN_NUM_STATES + c];
+            }
+            __KALMAN_BUFFER_P[r * KALMAN_NUM_STATES + r] -= gain * PHt[r];
+        }
+    }
+#endif
+}
+
+#endif
+
+/************************************************************************/
+/* Construct fixed-point Kalman filter measurement                      */
+/************************************************************************/
+
+#ifdef KALMAN_Q_FRACTION_BITS
+
+#define __KALMAN_BUFFER_Hq      KALMAN_MEASUREMENT_BUFFER_NAME(Hq)
+#define __KALMAN_BUFFER_Rq      KALMAN_MEASUREMENT_BUFFER_NAME(Rq)
+#define __KALMAN_BUFFER_zq      KALMAN_MEASUREMENT_BUFFER_NAME(zq)
+#define __KALMAN_BUFFER_Kq      KALMAN_MEASUREMENT_BUFFER_NAME(Kq)
+#define __KALMAN_BUFFER_Sq      KALMAN_MEASUREMENT_BUFFER_NAME(Sq)
+#define __KALMAN_BUFFER_yq      KALMAN_MEASUREMENT_BUFFER_NAME(yq)
+#define __KALMAN_BUFFER_tempHPq KALMAN_MEASUREMENT_BUFFER_NAME(tempHPq)
+
+#pragma message("Creating fixed-point Kalman measurement buffers: " STRINGIFY(__KALMAN_BUFFER_Hq) ", " STRINGIFY(__KALMAN_BUFFER_Rq) ", " STRINGIFY(__KALMAN_BUFFER_zq))
+static matrix_q_data_t __KALMAN_BUFFER_Hq[__KALMAN_H_ROWS * __KALMAN_H_COLS];
+static matrix_q_data_t __KALMAN_BUFFER_Rq[__KALMAN_R_ROWS * __KALMAN_R_COLS];
+static matrix_q_data_t __KALMAN_BUFFER_zq[__KALMAN_z_ROWS * __KALMAN_z_COLS];
+
+#pragma message("Creating fixed-point Kalman measurement buffers: " STRINGIFY(__KALMAN_BUFFER_Kq) ", " STRINGIFY(__KALMAN_BUFFER_Sq) ", " STRINGIFY(__KALMAN_BUFFER_yq) ", " STRINGIFY(__KALMAN_BUFFER_tempHPq))
+static matrix_q_data_t __KALMAN_BUFFER_Kq[__KALMAN_K_ROWS * __KALMAN_K_COLS];
+static matrix_q_data_t __KALMAN_BUFFER_Sq[__KALMAN_S_ROWS * __KALMAN_S_COLS];
+static matrix_q_data_t __KALMAN_BUFFER_yq[__KALMAN_y_ROWS * __KALMAN_y_COLS];
+static matrix_q_data_t __KALMAN_BUFFER_tempHPq[__KALMAN_tempHP_ROWS * __KALMAN_tempHP_COLS];
+
+#pragma message("Creating fixed-point Kalman measurement structure: " STRINGIFY(KALMAN_MEASUREMENT_FUNCTION_NAME(q)))
+static kalman_q_measurement_t KALMAN_MEASUREMENT_FUNCTION_NAME(q);
+
+#pragma message ("Creating fixed-point Kalman measurement initialization function: " STRINGIFY(KALMAN_MEASUREMENT_FUNCTION_NAME(init_q()) ))
+
+/*!
+* \brief Initializes the fixed-point Kalman Filter measurement from the floating point measurement
+* \return Pointer to the fixed-point measurement.
+*
+* Must be called after the floating point measurement has been initialized and H and R have been set.
+*/
+UNUSED static kalman_q_measurement_t* KALMAN_MEASUREMENT_FUNCTION_NAME(init_q)()
+{
+    kalman_q_measurement_initialize(&KALMAN_MEASUREMENT_FUNCTION_NAME(q), KALMAN_NUM_STATES, KALMAN_NUM_MEASUREMENTS, KALMAN_Q_FRACTION_BITS,
+                                    __KALMAN_BUFFER_Hq, __KALMAN_BUFFER_zq, __KALMAN_BUFFER_Rq,
+                                    __KALMAN_BUFFER_yq, __KALMAN_BUFFER_Sq, __KALMAN_BUFFER_Kq, __KALMAN_BUFFER_tempHPq);
+    kalman_q_measurement_from_float(&KALMAN_MEASUREMENT_BASENAME, &KALMAN_MEASUREMENT_FUNCTION_NAME(q));
+    return &KALMAN_MEASUREMENT_FUNCTION_NAME(q);
+}
+
+#endif
+
 /************************************************************************/
 /* Clean up                                                             */
 /************************************************************************/
 
 #undef KALMAN_MEASUREMENT_NAME
 #undef KALMAN_NUM_MEASUREMENTS
+#undef KALMAN_MEASUREMENT_SEQUENTIAL
+#undef KALMAN_MEASUREMENT_MIXED_PRECISION
+#undef KALMAN_MEASUREMENT_STEADY_STATE
 
 #undef KALMAN_MEASUREMENT_BASENAME_HELPER2
 #undef KALMAN_MEASUREMENT_BASENAME_HELPER
@@ -330,12 +757,6 @@ static kalman_measurement_t* KALMAN_MEASUREMENT_FUNCTION_NAME(init)()
 
 // TODO: instead of cleaning up the temporary buffers here, clean them up in kalman_factory_cleanup.h. This way, the largest buffers can be reused in other measurement definitions.
 
-#undef __KALMAN_tempKHP_ROWS
-#undef __KALMAN_tempKHP_COLS
-
-#undef __KALMAN_tempPHt_ROWS
-#undef __KALMAN_tempPHt_COLS
-
 #undef __KALMAN_tempHP_ROWS
 #undef __KALMAN_tempHP_COLS
 
@@ -343,17 +764,27 @@ static kalman_measurement_t* KALMAN_MEASUREMENT_FUNCTION_NAME(init)()
 #undef __KALMAN_maux_COLS
 #undef __USE_BUFFER_AUX
 
-#undef __KALMAN_tempKHP_size
-#undef __KALMAN_BUFFER_tempKHP
-
 #undef __KALMAN_BUFFER_tempHP
 #undef __KALMAN_tempHP_size
 
-#undef __KALMAN_BUFFER_tempPHt
-#undef __KALMAN_tempPHt_size
-
-#undef __KALMAN_BUFFER_Sinv
-#undef __KALMAN_Sinv_size
-
 #undef __KALMAN_BUFFER_maux
 #undef __KALMAN_maux_size
+
+#undef __KALMAN_BUFFER_wide
+#undef __KALMAN_wide_ROWS
+#undef __KALMAN_wide_COLS
+#undef __KALMAN_gain_t
+
+#undef __KALMAN_BUFFER_Kprev
+
+#undef __KALMAN_BUFFER_msqrt
+#undef __KALMAN_msqrt_ROWS
+#undef __KALMAN_msqrt_COLS
+
+#undef __KALMAN_BUFFER_Hq
+#undef __KALMAN_BUFFER_Rq
+#undef __KALMAN_BUFFER_zq
+#undef __KALMAN_BUFFER_Kq
+#undef __KALMAN_BUFFER_Sq
+#undef __KALMAN_BUFFER_yq
+#undef __KALMAN_BUFFER_tempHPq
@@ -0,0 +1,110 @@
+#ifndef KALMAN_FIXED_LAG_H_
+#define KALMAN_FIXED_LAG_H_
+
+#include <stdint.h>
+#include "compiler.h"
+#include "matrix.h"
+#include "kalman.h"
+
+/*!
+* \brief A lagged copy of the state.
+*/
+typedef struct
+{
+    /*!
+    * \brief Smoothed state of the lagged time step (number of states x \c 1)
+    */
+    matrix_t x;
+
+    /*!
+    * \brief Cross covariance of the lagged and the current state (number of states x number of states)
+    */
+    matrix_t P;
+
+} kalman_fixed_lag_entry_t;
+
+/*!
+* \brief Fixed-lag smoother keeping the estimates of the last {\ref lag} time steps up to date.
+*
+* This is the filter with its state augmented by lagged copies of itself. The augmented covariance is
+* never formed: the lagged copies do not evolve and are never measured, so only the cross covariances
+* between every lagged copy and the current state are required, and the correction of a lagged copy
+* follows from the innovation and gain of the current state.
+*
+* \see kalman_fixed_lag_initialize
+*/
+typedef struct
+{
+    /*!
+    * \brief The lagged copies in a ring buffer
+    */
+    kalman_fixed_lag_entry_t *entries;
+
+    /*!
+    * \brief The number of lagged copies, i.e. the lag in time steps
+    */
+    uint_fast8_t lag;
+
+    /*!
+    * \brief The number of valid lagged copies
+    */
+    uint_fast8_t count;
+
+    /*!
+    * \brief The index of the copy with a lag of one time step
+    */
+    uint_fast8_t head;
+
+} kalman_fixed_lag_t;
+
+/*!
+* \brief Initializes a fixed-lag smoother.
+* \param[in] kfl The smoother to initialize
+* \param[in] num_states The number of state variables
+* \param[in] entries The lagged copies ({\ref lag})
+* \param[in] lag The lag in time steps (\c 1 or more)
+* \param[in] buffer The buffer for the lagged copies ({\ref lag} x ({\ref num_states} + {\ref num_states} x {\ref num_states}))
+*/
+void kalman_fixed_lag_initialize(kalman_fixed_lag_t *kfl, uint_fast8_t num_states, kalman_fixed_lag_entry_t *entries, uint_fast8_t lag,
+                                 matrix_data_t *buffer) COLD;
+
+/*!
+* \brief Discards all lagged copies, e.g. after the filter has been reset.
+* \param[in] kfl The smoother to clear
+*/
+void kalman_fixed_lag_clear(kalman_fixed_lag_t *kfl) COLD;
+
+/*!
+* \brief Performs the time update / prediction step of the filter and shifts the lagged copies.
+* \param[in] kf The Kalman Filter structure to predict with; must propagate the full covariance
+* \param[in] kfl The smoother
+*
+* The current state becomes the copy with a lag of one, the oldest copy is dropped and the filter is
+* predicted with {\ref kalman_predict}. All cross covariances are propagated with A, one row vector
+* product per row, which uses the sparsity pattern of A if the filter has one: with n states and a
+* lag of L this costs L * n * nnz(A) multiplications, i.e. O(L*n^2) for kinematic models and
+* O(L*n^3) for a dense A.
+*/
+void kalman_fixed_lag_predict(kalman_t *kf, kalman_fixed_lag_t *kfl) HOT;
+
+/*!
+* \brief Performs the measurement update step of the filter and corrects the lagged copies.
+* \param[in] kf The Kalman Filter structure to correct; must propagate the full covariance, which must not be frozen at steady state
+* \param[in] kfm The measurement to correct with; must not be frozen at steady state or use mixed precision
+* \param[in] kfl The smoother
+*
+* The filter is corrected with {\ref kalman_correct}, and the innovation and factored residual covariance
+* it leaves behind correct every lagged copy with its gain K_i = P_i*H'*S^-1. With m measurements, each
+* copy costs 2 * m * n^2 multiplications instead of the (L*n)^2 * m of the augmented filter.
+*/
+void kalman_fixed_lag_correct(kalman_t *kf, kalman_measurement_t *kfm, kalman_fixed_lag_t *kfl) HOT;
+
+/*!
+* \brief Gets the smoothed state of a past time step.
+* \param[in] kfl The smoother
+* \param[in] lag The age of the time step (\c 1 to {\ref lag})
+* \return The smoothed state, or null if fewer than {\ref lag} time steps have been predicted yet.
+*/
+const matrix_t* kalman_fixed_lag_state(const kalman_fixed_lag_t *kfl, uint_fast8_t lag);
+
+#endif
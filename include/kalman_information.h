@@ -0,0 +1,112 @@
+#ifndef KALMAN_INFORMATION_H_
+#define KALMAN_INFORMATION_H_
+
+#include <stdint.h>
+#include "compiler.h"
+#include "matrix.h"
+#include "kalman.h"
+
+/*!
+* \brief Information form of the Kalman filter state, i.e. Y = P^-1 and y = P^-1 * x.
+*
+* In information form, a measurement update is the addition of H'*R^-1*H to Y and H'*R^-1*z to y,
+* so its cost grows linearly with the number of measured outputs and no residual covariance has to be
+* inverted. This pays off when a measurement has many more rows than the filter has states. Since the
+* updates are additive, measurement blocks can be accumulated independently (e.g. on different threads)
+* into cleared partial structures and merged afterwards.
+*
+* The prediction is carried out in covariance form: convert with {\ref kalman_information_to_filter},
+* call {\ref kalman_predict} and convert back with {\ref kalman_information_from_filter}. Both conversions
+* cost one n x n inversion, independent of the number of measurements.
+*
+* \see kalman_information_initialize
+*/
+typedef struct
+{
+    /*!
+    * \brief Information matrix Y = P^-1
+    */
+    matrix_t Y;
+
+    /*!
+    * \brief Information vector y = P^-1 * x
+    */
+    matrix_t y;
+
+    /*!
+    * \brief Temporary variables.
+    */
+    struct
+    {
+        /*!
+        * \brief Y-sized temporary matrix (number of states x number of states) holding the Cholesky factor during conversions
+        */
+        matrix_t factor;
+
+    } temporary;
+
+} kalman_information_t;
+
+/*!
+* \brief Initializes an information form structure.
+* \param[in] kfi The structure to initialize
+* \param[in] num_states The number of state variables
+* \param[in] Y The information matrix ({\ref num_states} x {\ref num_states})
+* \param[in] y The information vector ({\ref num_states} x \c 1)
+* \param[in] temp_factor The temporary matrix for the Cholesky factor ({\ref num_states} x {\ref num_states}),
+*            only required by {\ref kalman_information_from_filter} and {\ref kalman_information_to_filter}
+*/
+void kalman_information_initialize(kalman_information_t *kfi, uint_fast8_t num_states, matrix_data_t *Y, matrix_data_t *y, matrix_data_t *temp_factor) COLD;
+
+/*!
+* \brief Converts the state and covariance of a filter into information form.
+* \param[in] kf The filter to read x and P from; must propagate the full covariance
+* \param[out] kfi The information form structure
+* \return Zero in case of success, nonzero if P is not positive definite.
+*/
+int kalman_information_from_filter(const kalman_t *kf, kalman_information_t *kfi);
+
+/*!
+* \brief Converts the information form back into the state and covariance of a filter.
+* \param[in] kfi The information form structure
+* \param[out] kf The filter to write x and P to; must propagate the full covariance
+* \return Zero in case of success, nonzero if Y is not positive definite.
+*/
+int kalman_information_to_filter(kalman_information_t *kfi, kalman_t *kf);
+
+/*!
+* \brief Clears the information matrix and vector, e.g. of a partial structure prior to accumulation.
+* \param[in] kfi The information form structure
+*/
+void kalman_information_clear(kalman_information_t *kfi);
+
+/*!
+* \brief Adds a partial information matrix and vector, such that Y = Y + Y_partial and y = y + y_partial.
+* \param[in] kfi The information form structure to add to
+* \param[in] partial The partial information, e.g. accumulated from a block of measurements
+*/
+void kalman_information_merge(kalman_information_t *kfi, const kalman_information_t *partial);
+
+/*!
+* \brief Performs the measurement update in information form with a diagonal measurement covariance.
+* \param[in] kfi The information form structure to correct
+* \param[in] kfm The measurement providing H, R and z; R must be diagonal, off-diagonal entries are ignored.
+*
+* Adds H'*R^-1*H to Y and H'*R^-1*z to y at a cost of O(m*n^2). The measurement is not modified,
+* so different measurements may be accumulated into different structures concurrently.
+*/
+void kalman_information_correct_diagonal(kalman_information_t *kfi, const kalman_measurement_t *kfm) HOT;
+
+/*!
+* \brief Performs the measurement update in information form with a full measurement covariance.
+* \param[in] kfi The information form structure to correct
+* \param[in] kfm The measurement providing H, R and z
+* \return Zero in case of success, nonzero if R is not positive definite.
+*
+* R is factored into L*L' and H and z are whitened, i.e. replaced by L^-1*H and L^-1*z, before
+* the accumulation. The factor is stored in the measurement's S, the whitened H in its temporary HP
+* and the whitened z in its y.
+*/
+int kalman_information_correct(kalman_information_t *kfi, kalman_measurement_t *kfm) HOT;
+
+#endif
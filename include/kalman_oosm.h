@@ -0,0 +1,297 @@
+#ifndef KALMAN_OOSM_H_
+#define KALMAN_OOSM_H_
+
+#include <stdint.h>
+#include "compiler.h"
+#include "matrix.h"
+#include "kalman.h"
+
+/*!
+* \brief A measurement applied at a checkpoint, kept for replays.
+*/
+typedef struct
+{
+    /*!
+    * \brief The measurement structure; its H and R are reused on replay
+    */
+    kalman_measurement_t *kfm;
+
+    /*!
+    * \brief Copy of the measurement vector (number of measurements x \c 1)
+    */
+    matrix_t z;
+
+} kalman_oosm_log_t;
+
+/*!
+* \brief The filter at one time step.
+*/
+typedef struct
+{
+    /*!
+    * \brief The time stamp of the time step, in user defined units
+    */
+    uint_fast32_t timestamp;
+
+    /*!
+    * \brief The sequence number of the checkpoint
+    */
+    uint_fast32_t sequence;
+
+    /*!
+    * \brief State transition matrix that led into the time step (number of states x number of states)
+    */
+    matrix_t A;
+
+    /*!
+    * \brief A priori state (number of states x \c 1)
+    */
+    matrix_t x_predicted;
+
+    /*!
+    * \brief A priori covariance (number of states x number of states)
+    */
+    matrix_t P_predicted;
+
+    /*!
+    * \brief A posteriori state (number of states x \c 1)
+    */
+    matrix_t x;
+
+    /*!
+    * \brief A posteriori covariance (number of states x number of states)
+    */
+    matrix_t P;
+
+    /*!
+    * \brief The measurements applied at the time step
+    */
+    kalman_oosm_log_t *log;
+
+    /*!
+    * \brief The number of logged measurements
+    */
+    uint_fast8_t log_count;
+
+    /*!
+    * \brief Nonzero if more measurements were applied than could be logged
+    */
+    uint_fast8_t log_overflow;
+
+} kalman_oosm_checkpoint_t;
+
+/*!
+* \brief Out-of-sequence measurement handling over a ring buffer of checkpoints.
+*
+* Every prediction opens a timestamped checkpoint and every in-sequence correction updates it and logs
+* its measurement vector. A measurement that arrives late is applied at the newest checkpoint not later
+* than its time stamp, either by replaying the filter from there or by a one-step correction of the
+* current state through the retrodicted state at that checkpoint.
+*
+* \see kalman_oosm_initialize
+*/
+typedef struct
+{
+    /*!
+    * \brief The checkpoints
+    */
+    kalman_oosm_checkpoint_t *checkpoints;
+
+    /*!
+    * \brief The number of checkpoints in the ring
+    */
+    uint_fast16_t capacity;
+
+    /*!
+    * \brief The number of valid checkpoints
+    */
+    uint_fast16_t count;
+
+    /*!
+    * \brief The index of the checkpoint the next prediction is written to
+    */
+    uint_fast16_t head;
+
+    /*!
+    * \brief The number of logged measurements per checkpoint
+    */
+    uint_fast8_t log_capacity;
+
+    /*!
+    * \brief The largest number of measurements of a logged measurement structure
+    */
+    uint_fast8_t max_measurements;
+
+    /*!
+    * \brief The sequence number of the next checkpoint
+    */
+    uint_fast32_t sequence;
+
+    /*!
+    * \brief Checkpoints whose a posteriori values lack a retrodicted measurement, by sequence number.
+    *
+    * A replay starting at one of them would lose that measurement, so these are corrected by retrodiction.
+    */
+    struct
+    {
+        /*!
+        * \brief The first stale checkpoint
+        */
+        uint_fast32_t begin;
+
+        /*!
+        * \brief The first checkpoint past the stale ones; equal to {\ref begin} if there are none
+        */
+        uint_fast32_t end;
+
+    } stale;
+
+    /*!
+    * \brief The cost of out-of-sequence corrections.
+    */
+    struct
+    {
+        /*!
+        * \brief The number of checkpoints passed by the last out-of-sequence correction
+        */
+        uint_fast16_t steps;
+
+        /*!
+        * \brief The number of logged corrections re-run by the last out-of-sequence correction
+        */
+        uint_fast16_t corrections;
+
+        /*!
+        * \brief The number of out-of-sequence corrections carried out by replaying
+        */
+        uint_fast32_t replays;
+
+        /*!
+        * \brief The number of out-of-sequence corrections carried out by retrodiction
+        */
+        uint_fast32_t retrodictions;
+
+    } cost;
+
+    /*!
+    * \brief Temporary variables.
+    */
+    struct
+    {
+        /*!
+        * \brief Cholesky factor of the a priori covariance (number of states x number of states)
+        */
+        matrix_t factor;
+
+        /*!
+        * \brief Smoother gain C (number of states x number of states)
+        */
+        matrix_t gain;
+
+        /*!
+        * \brief Matrix product or covariance difference (number of states x number of states)
+        */
+        matrix_t product;
+
+        /*!
+        * \brief Retrodicted covariance (number of states x number of states)
+        */
+        matrix_t P;
+
+        /*!
+        * \brief Cross covariance of the retrodicted and the current state (number of states x number of states)
+        */
+        matrix_t cross;
+
+        /*!
+        * \brief Retrodicted state (number of states x \c 1)
+        */
+        matrix_t x;
+
+        /*!
+        * \brief State difference (number of states x \c 1)
+        */
+        matrix_t difference;
+
+        /*!
+        * \brief Auxiliary vector that can hold a row of P (number of states)
+        */
+        matrix_data_t *aux;
+
+    } temporary;
+
+} kalman_oosm_t;
+
+/*!
+* \brief Initializes out-of-sequence measurement handling.
+* \param[in] oosm The structure to initialize
+* \param[in] num_states The number of state variables
+* \param[in] checkpoints The checkpoints ({\ref capacity})
+* \param[in] capacity The number of checkpoints (\c 2 or more)
+* \param[in] buffer The buffer for the checkpoint matrices ({\ref capacity} x (2 x {\ref num_states} + 3 x {\ref num_states} x {\ref num_states}))
+* \param[in] log The measurement logs ({\ref capacity} x {\ref log_capacity})
+* \param[in] log_capacity The number of logged measurements per checkpoint (\c 1 or more)
+* \param[in] log_buffer The buffer for the logged measurement vectors ({\ref capacity} x {\ref log_capacity} x {\ref max_measurements})
+* \param[in] max_measurements The largest number of measurements of any logged measurement structure
+* \param[in] temp The temporary buffer (5 x {\ref num_states} x {\ref num_states} + 3 x {\ref num_states})
+*/
+void kalman_oosm_initialize(kalman_oosm_t *oosm, uint_fast8_t num_states, kalman_oosm_checkpoint_t *checkpoints, uint_fast16_t capacity,
+                            matrix_data_t *buffer, kalman_oosm_log_t *log, uint_fast8_t log_capacity, matrix_data_t *log_buffer,
+                            uint_fast8_t max_measurements, matrix_data_t *temp) COLD;
+
+/*!
+* \brief Discards all checkpoints, e.g. after the filter has been reset.
+* \param[in] oosm The structure to clear
+*/
+void kalman_oosm_clear(kalman_oosm_t *oosm) COLD;
+
+/*!
+* \brief Opens a checkpoint after a prediction.
+* \param[in] oosm The structure
+* \param[in] kf The filter that has just been predicted; must propagate the full covariance
+* \param[in] timestamp The time stamp of the predicted time step, later than that of the previous checkpoint
+*
+* Must be called after every prediction of the filter, including the first one.
+*/
+void kalman_oosm_record_prediction(kalman_oosm_t *oosm, const kalman_t *kf, uint_fast32_t timestamp) HOT;
+
+/*!
+* \brief Updates the newest checkpoint after an in-sequence correction and logs the measurement.
+* \param[in] oosm The structure
+* \param[in] kf The filter that has just been corrected; must propagate the full covariance
+* \param[in] kfm The measurement the filter has just been corrected with
+*/
+void kalman_oosm_record_correction(kalman_oosm_t *oosm, const kalman_t *kf, kalman_measurement_t *kfm) HOT;
+
+/*!
+* \brief Applies a measurement that may be older than the current time step.
+* \param[in] kf The Kalman Filter structure to correct; must propagate the full covariance
+* \param[in] kfm The measurement to correct with; z must be set
+* \param[in] oosm The structure
+* \param[in] timestamp The time stamp of the measurement
+* \param[in] max_replay The largest number of checkpoints to replay
+* \return Zero in case of success, nonzero if the measurement is older than the oldest checkpoint or a covariance
+*         is not positive definite.
+*
+* The measurement is applied at the newest checkpoint with a time stamp not later than {\ref timestamp}, i.e. it is
+* quantized to the time steps of the filter. A measurement of the newest checkpoint is an ordinary correction.
+*
+* Up to {\ref max_replay} checkpoints back, the filter is replayed: the measurement corrects the checkpoint, and the
+* change of its a posteriori values is propagated to the newer checkpoints with their A, re-running their logged
+* corrections with the H and R their measurement structures have at the time of the replay. This is exact and
+* leaves all checkpoints consistent, but costs one propagation per checkpoint and one correction per logged
+* measurement. Note that the measurement vectors of the logged structures are overwritten; that of {\ref kfm} is
+* restored afterwards. The late measurement is logged at its checkpoint, so a replay also requires room in that log.
+*
+* Further back, or if the logs needed by a replay overflowed, the measurement is retrodicted: a Rauch-Tung-Striebel
+* backward pass from the newest checkpoint yields the smoothed state at the checkpoint and its cross covariance with
+* the current state, which correct the current state in a single step. This costs one Cholesky decomposition and a
+* few n x n products per checkpoint and uses the S and K buffers of the measurement; neither the measurement nor the
+* covariance of the filter must be frozen at steady state. Only the current state and the newest checkpoint are
+* corrected, so the older checkpoints are stale until they leave the ring, and replays starting at them are avoided.
+*
+* The checkpoints passed and corrections re-run are reported in {\ref cost}.
+*/
+int kalman_oosm_correct(kalman_t *kf, kalman_measurement_t *kfm, kalman_oosm_t *oosm, uint_fast32_t timestamp, uint_fast16_t max_replay) HOT;
+
+#endif
@@ -0,0 +1,204 @@
+#ifndef KALMAN_POOL_H_
+#define KALMAN_POOL_H_
+
+#include <stdint.h>
+#include "compiler.h"
+#include "kalman.h"
+
+/**
+* \def KALMAN_HAVE_POOL Set to nonzero if the thread pool is available.
+*
+* The pool requires POSIX threads and the GCC atomic builtins. Define KALMAN_DISABLE_POOL to leave it out.
+*/
+#if !defined(KALMAN_DISABLE_POOL) && defined(__GNUC__) && (defined(__unix__) || defined(__APPLE__))
+#define KALMAN_HAVE_POOL 1
+#else
+#define KALMAN_HAVE_POOL 0
+#endif
+
+#if KALMAN_HAVE_POOL
+
+#include <pthread.h>
+
+/**
+* \def KALMAN_POOL_CACHE_LINE The cache line size used to keep the workers' queues apart.
+*/
+#ifndef KALMAN_POOL_CACHE_LINE
+#define KALMAN_POOL_CACHE_LINE 64
+#endif
+
+/*!
+* \brief A filter owned by the pool together with its measurements.
+*
+* Every filter MUST have its own buffers, i.e. no two entries may share a state, covariance or
+* temporary buffer; read-only matrices (e.g. A or H) may be shared. A filter and all of its
+* measurements are always processed by the same thread, so measurements may reuse the filter's buffers.
+*/
+typedef struct
+{
+    /*!
+    * \brief The filter
+    */
+    kalman_t *filter;
+
+    /*!
+    * \brief The measurements of the filter
+    */
+    kalman_measurement_t **measurements;
+
+    /*!
+    * \brief The number of measurements (at most 32)
+    */
+    uint_fast8_t num_measurements;
+
+    /*!
+    * \brief Bit mask of the measurements that arrived since the last tick
+    *
+    * Bit \c i selects measurement \c i. The mask is cleared once the filter has been corrected.
+    * \see kalman_pool_mark_measurement
+    */
+    uint32_t pending;
+
+} kalman_pool_entry_t;
+
+/*!
+* \brief A worker thread and the range of entries it still has to process.
+*/
+typedef struct
+{
+    /*!
+    * \brief The remaining range of entry indices, packed as tick (16 bits), begin and end (24 bits each)
+    *
+    * The owner takes entries from the front while other workers steal half of the remainder from the back;
+    * both update the range with a single compare-and-swap.
+    */
+    uint64_t range __attribute__((aligned(KALMAN_POOL_CACHE_LINE)));
+
+    /*!
+    * \brief The thread
+    */
+    pthread_t thread;
+
+    /*!
+    * \brief The index of this worker in the pool
+    */
+    uint_fast16_t index;
+
+    /*!
+    * \brief The pool this worker belongs to
+    */
+    struct kalman_pool_s *pool;
+
+} kalman_pool_worker_t;
+
+/*!
+* \brief Thread pool that predicts and corrects a population of filters once per tick.
+*
+* Each tick, every filter is predicted and then corrected with each of its pending measurements.
+* The filters are split evenly across the workers; a worker that runs out of filters steals from
+* the others, which balances the load when the number of pending measurements varies.
+*
+* \see kalman_pool_tick
+* \see kalman_pool_wait
+*/
+typedef struct kalman_pool_s
+{
+    /*!
+    * \brief The filters
+    */
+    kalman_pool_entry_t *entries;
+
+    /*!
+    * \brief The number of filters
+    */
+    uint_fast32_t count;
+
+    /*!
+    * \brief The workers
+    */
+    kalman_pool_worker_t *workers;
+
+    /*!
+    * \brief The number of workers
+    */
+    uint_fast16_t num_workers;
+
+    /*!
+    * \brief The number of filters processed in the current tick
+    */
+    uint_fast32_t completed;
+
+    /*!
+    * \brief The current tick, incremented to wake the workers
+    */
+    uint_fast32_t generation;
+
+    /*!
+    * \brief Nonzero if the workers shall exit
+    */
+    int shutdown;
+
+    /*!
+    * \brief Guards {\ref generation} and {\ref shutdown} and the two conditions
+    */
+    pthread_mutex_t lock;
+
+    /*!
+    * \brief Signalled when a tick starts
+    */
+    pthread_cond_t start;
+
+    /*!
+    * \brief Signalled when all filters of the tick have been processed
+    */
+    pthread_cond_t done;
+
+} kalman_pool_t;
+
+/*!
+* \brief Initializes the pool and starts the worker threads.
+* \param[in] pool The pool to initialize
+* \param[in] entries The filters ({\ref count} entries), each with at most 32 measurements
+* \param[in] count The number of filters (less than 2^24)
+* \param[in] workers The worker buffer ({\ref num_workers} entries)
+* \param[in] num_workers The number of worker threads to start
+* \return Zero in case of success, nonzero if the threads could not be started.
+*/
+int kalman_pool_initialize(kalman_pool_t *pool, kalman_pool_entry_t *entries, uint_fast32_t count,
+                           kalman_pool_worker_t *workers, uint_fast16_t num_workers) COLD;
+
+/*!
+* \brief Stops and joins the worker threads.
+* \param[in] pool The pool to destroy
+*
+* Must not be called while a tick is in progress.
+*/
+void kalman_pool_destroy(kalman_pool_t *pool) COLD;
+
+/*!
+* \brief Marks a measurement of a filter as arrived, so that it is used for correction in the next tick.
+* \param[in] pool The pool
+* \param[in] filter The index of the filter
+* \param[in] measurement The index of the measurement of that filter
+*
+* Must not be called while a tick is in progress.
+*/
+void kalman_pool_mark_measurement(kalman_pool_t *pool, uint_fast32_t filter, uint_fast8_t measurement);
+
+/*!
+* \brief Starts a tick, i.e. the prediction and correction of all filters, and returns immediately.
+* \param[in] pool The pool
+*
+* The filters and measurements must not be accessed until {\ref kalman_pool_wait} returned.
+*/
+void kalman_pool_tick(kalman_pool_t *pool) HOT;
+
+/*!
+* \brief Waits for the current tick to complete.
+* \param[in] pool The pool
+*/
+void kalman_pool_wait(kalman_pool_t *pool) HOT;
+
+#endif
+
+#endif
@@ -0,0 +1,198 @@
+#ifndef KALMAN_Q_H_
+#define KALMAN_Q_H_
+
+#include <stdint.h>
+#include "compiler.h"
+#include "matrix_q.h"
+#include "kalman.h"
+
+/*!
+* \brief Fixed-point Kalman Filter structure
+*
+* Mirrors {\ref kalman_t} for targets without a floating point unit. All matrices of a filter and
+* its measurements share the same number of fractional bits, which must leave enough integer bits
+* for the largest state, covariance and gain values; every kernel saturates rather than wraps around.
+*
+* \see kalman_q_measurement_t
+*/
+typedef struct
+{
+    /*!
+    * \brief State vector
+    */
+    matrix_q_t x;
+
+    /*!
+    * \brief System matrix
+    * \see P
+    */
+    matrix_q_t A;
+
+    /*!
+    * \brief System covariance matrix
+    * \see A
+    */
+    matrix_q_t P;
+
+    /*!
+    * \brief Input matrix
+    * \see Q
+    */
+    matrix_q_t B;
+
+    /*!
+    * \brief Input covariance/uncertainty matrix
+    * \see B
+    */
+    matrix_q_t Q;
+
+    /*!
+    * \brief Temporary variables.
+    */
+    struct
+    {
+        /*!
+        * \brief x-sized temporary vector
+        * \see x
+        */
+        matrix_q_t predicted_x;
+
+        /*!
+        * \brief P-sized temporary matrix (number of states x number of states)
+        *
+        * Holds A*P and, if inputs are used, BQ*B' during the prediction.
+        */
+        matrix_q_t AP;
+
+        /*!
+        * \brief BxQ-sized temporary matrix (number of states x number of inputs)
+        */
+        matrix_q_t BQ;
+
+    } temporary;
+
+} kalman_q_t;
+
+/*!
+* \brief Fixed-point Kalman Filter measurement structure
+* \see kalman_q_t
+*/
+typedef struct
+{
+    /*!
+    * \brief Measurement vector
+    */
+    matrix_q_t z;
+
+    /*!
+    * \brief Measurement transformation matrix
+    * \see R
+    */
+    matrix_q_t H;
+
+    /*!
+    * \brief Process noise covariance matrix
+    * \see H
+    */
+    matrix_q_t R;
+
+    /*!
+    * \brief Innovation vector
+    */
+    matrix_q_t y;
+
+    /*!
+    * \brief Residual covariance matrix; holds its lower triangular Cholesky factor after a correction
+    */
+    matrix_q_t S;
+
+    /*!
+    * \brief Kalman gain matrix
+    */
+    matrix_q_t K;
+
+    /*!
+    * \brief Temporary variables.
+    */
+    struct
+    {
+        /*!
+        * \brief H-Sized temporary matrix (number of measurements x number of states)
+        */
+        matrix_q_t HP;
+
+    } temporary;
+
+} kalman_q_measurement_t;
+
+/*!
+* \brief Initializes a fixed-point Kalman filter structure.
+* \param[in] kf The filter to initialize
+* \param[in] num_states The number of state variables
+* \param[in] num_inputs The number of input variables
+* \param[in] frac The number of fractional bits of all matrices
+* \param[in] A The state transition matrix ({\ref num_states} x {\ref num_states})
+* \param[in] x The state vector ({\ref num_states} x \c 1)
+* \param[in] B The input transition matrix ({\ref num_states} x {\ref num_inputs})
+* \param[in] P The state covariance matrix ({\ref num_states} x {\ref num_states})
+* \param[in] Q The input covariance matrix ({\ref num_inputs} x {\ref num_inputs})
+* \param[in] predictedX The temporary vector for the predicted x ({\ref num_states} x \c 1)
+* \param[in] temp_AP The temporary matrix for A*P ({\ref num_states} x {\ref num_states})
+* \param[in] temp_BQ The temporary matrix for BxQ ({\ref num_states} x {\ref num_inputs})
+*/
+void kalman_q_filter_initialize(kalman_q_t *kf, uint_fast8_t num_states, uint_fast8_t num_inputs, uint_fast8_t frac,
+                                matrix_q_data_t *A, matrix_q_data_t *x, matrix_q_data_t *B, matrix_q_data_t *P, matrix_q_data_t *Q,
+                                matrix_q_data_t *predictedX, matrix_q_data_t *temp_AP, matrix_q_data_t *temp_BQ) COLD;
+
+/*!
+* \brief Initializes a fixed-point Kalman filter measurement structure.
+* \param[in] kfm The measurement to initialize
+* \param[in] num_states The number of states
+* \param[in] num_measurements The number of measurements
+* \param[in] frac The number of fractional bits of all matrices
+* \param[in] H The measurement transformation matrix ({\ref num_measurements} x {\ref num_states})
+* \param[in] z The measurement vector ({\ref num_measurements} x \c 1)
+* \param[in] R The process noise / measurement uncertainty ({\ref num_measurements} x {\ref num_measurements})
+* \param[in] y The innovation ({\ref num_measurements} x \c 1)
+* \param[in] S The residual covariance ({\ref num_measurements} x {\ref num_measurements})
+* \param[in] K The Kalman gain ({\ref num_states} x {\ref num_measurements})
+* \param[in] temp_HP The temporary matrix for HxP ({\ref num_measurements} x {\ref num_states})
+*/
+void kalman_q_measurement_initialize(kalman_q_measurement_t *kfm, uint_fast8_t num_states, uint_fast8_t num_measurements, uint_fast8_t frac,
+                                     matrix_q_data_t *H, matrix_q_data_t *z, matrix_q_data_t *R,
+                                     matrix_q_data_t *y, matrix_q_data_t *S, matrix_q_data_t *K, matrix_q_data_t *temp_HP) COLD;
+
+/*!
+* \brief Converts the model and state of a floating point filter into a fixed-point filter.
+* \param[in] kf The floating point filter to read A, x, B, P and Q from
+* \param[out] kfq The fixed-point filter of the same dimensions
+*/
+void kalman_q_filter_from_float(const kalman_t *kf, kalman_q_t *kfq) COLD;
+
+/*!
+* \brief Converts a floating point measurement into a fixed-point measurement.
+* \param[in] kfm The floating point measurement to read H, R and z from
+* \param[out] kfmq The fixed-point measurement of the same dimensions
+*/
+void kalman_q_measurement_from_float(const kalman_measurement_t *kfm, kalman_q_measurement_t *kfmq) COLD;
+
+/*!
+* \brief Performs the time update / prediction step in fixed-point arithmetic.
+* \param[in] kf The Kalman Filter structure to predict with.
+*
+* \see kalman_predict
+*/
+void kalman_q_predict(kalman_q_t *kf) HOT;
+
+/*!
+* \brief Performs the measurement update step in fixed-point arithmetic.
+* \param[in] kf The Kalman Filter structure to correct.
+* \param[in] kfm The measurement to correct with.
+* \return Zero in case of success, nonzero if the residual covariance was not positive definite at
+*         the given precision, in which case x and P are left unchanged.
+*
+* \see kalman_correct
+*/
+int kalman_q_correct(kalman_q_t *kf, kalman_q_measurement_t *kfm) HOT;
+
+#endif
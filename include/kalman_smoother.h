@@ -0,0 +1,169 @@
+#ifndef KALMAN_SMOOTHER_H_
+#define KALMAN_SMOOTHER_H_
+
+#include <stdint.h>
+#include "compiler.h"
+#include "matrix.h"
+#include "kalman.h"
+
+/*!
+* \brief The filter history of one time step.
+*/
+typedef struct
+{
+    /*!
+    * \brief State transition matrix that led into the time step (number of states x number of states)
+    */
+    matrix_t A;
+
+    /*!
+    * \brief A priori state (number of states x \c 1)
+    */
+    matrix_t x_predicted;
+
+    /*!
+    * \brief A priori covariance (number of states x number of states)
+    */
+    matrix_t P_predicted;
+
+    /*!
+    * \brief A posteriori state (number of states x \c 1), equal to the a priori state without measurements
+    */
+    matrix_t x;
+
+    /*!
+    * \brief A posteriori covariance (number of states x number of states), equal to the a priori covariance without measurements
+    */
+    matrix_t P;
+
+} kalman_smoother_record_t;
+
+/*!
+* \brief Ring buffer of filter history for Rauch-Tung-Striebel smoothing.
+*
+* Every prediction opens a new record, overwriting the oldest one once the ring is full, and
+* every correction updates the a posteriori values of the newest record. Records are addressed
+* by their age from the oldest record in the ring, i.e. \c 0 to {\ref count} - \c 1.
+*
+* \see kalman_smoother_initialize
+*/
+typedef struct
+{
+    /*!
+    * \brief The records
+    */
+    kalman_smoother_record_t *records;
+
+    /*!
+    * \brief The number of records in the ring
+    */
+    uint_fast16_t capacity;
+
+    /*!
+    * \brief The number of valid records
+    */
+    uint_fast16_t count;
+
+    /*!
+    * \brief The index of the record the next prediction is written to
+    */
+    uint_fast16_t head;
+
+    /*!
+    * \brief Temporary variables.
+    */
+    struct
+    {
+        /*!
+        * \brief Cholesky factor of the a priori covariance (number of states x number of states)
+        */
+        matrix_t factor;
+
+        /*!
+        * \brief Smoother gain C (number of states x number of states)
+        */
+        matrix_t gain;
+
+        /*!
+        * \brief Matrix product (number of states x number of states)
+        */
+        matrix_t product;
+
+        /*!
+        * \brief Smoothed covariance of the later time step (number of states x number of states)
+        */
+        matrix_t P;
+
+        /*!
+        * \brief Smoothed state of the later time step (number of states x \c 1)
+        */
+        matrix_t x;
+
+        /*!
+        * \brief State difference (number of states x \c 1)
+        */
+        matrix_t difference;
+
+        /*!
+        * \brief Auxiliary vector that can hold a row of P (number of states)
+        */
+        matrix_data_t *aux;
+
+    } temporary;
+
+} kalman_smoother_t;
+
+/*!
+* \brief Initializes a smoother.
+* \param[in] ks The smoother to initialize
+* \param[in] num_states The number of state variables
+* \param[in] records The records ({\ref capacity})
+* \param[in] capacity The number of records (\c 2 or more)
+* \param[in] buffer The buffer for the recorded matrices ({\ref capacity} x (2 x {\ref num_states} + 3 x {\ref num_states} x {\ref num_states}))
+* \param[in] temp The temporary buffer (4 x {\ref num_states} x {\ref num_states} + 3 x {\ref num_states})
+*/
+void kalman_smoother_initialize(kalman_smoother_t *ks, uint_fast8_t num_states, kalman_smoother_record_t *records, uint_fast16_t capacity,
+                                matrix_data_t *buffer, matrix_data_t *temp) COLD;
+
+/*!
+* \brief Discards all records, e.g. after the filter has been reset.
+* \param[in] ks The smoother to clear
+*/
+void kalman_smoother_clear(kalman_smoother_t *ks) COLD;
+
+/*!
+* \brief Records the a priori state, covariance and transition after a prediction.
+* \param[in] ks The smoother
+* \param[in] kf The filter that has just been predicted; must propagate the full covariance
+*
+* Must be called after every {\ref kalman_predict} of the filter, including the first one.
+*/
+void kalman_smoother_record_prediction(kalman_smoother_t *ks, const kalman_t *kf) HOT;
+
+/*!
+* \brief Records the a posteriori state and covariance after a correction.
+* \param[in] ks The smoother
+* \param[in] kf The filter that has just been corrected; must propagate the full covariance
+*
+* Must be called after the corrections of a time step; several corrections of the same time step
+* only need to be recorded once, after the last one.
+*/
+void kalman_smoother_record_correction(kalman_smoother_t *ks, const kalman_t *kf) HOT;
+
+/*!
+* \brief Runs the Rauch-Tung-Striebel backward pass over a window of records.
+* \param[in] ks The smoother
+* \param[in] first The age of the first record of the window
+* \param[in] length The number of records of the window (\c 1 or more)
+* \param[out] x The smoothed states ({\ref length} x {\ref num_states}), oldest first
+* \param[out] P The smoothed covariances ({\ref length} x {\ref num_states} x {\ref num_states}), oldest first; may be null
+* \return Zero in case of success, nonzero if an a priori covariance is not positive definite.
+*
+* The window is smoothed with the measurements up to its last record, which keeps its a posteriori values:
+* x_s[k] = x[k] + C_k*(x_s[k+1] - x_predicted[k+1]) and P_s[k] = P[k] + C_k*(P_s[k+1] - P_predicted[k+1])*C_k'
+* with C_k = P[k]*A[k+1]'*P_predicted[k+1]^-1. Each step costs one Cholesky decomposition and a few n x n products.
+* The records are left unchanged, so any number of (overlapping) windows can be smoothed.
+*/
+int kalman_smoother_smooth(kalman_smoother_t *ks, uint_fast16_t first, uint_fast16_t length, matrix_data_t *x, matrix_data_t *P) HOT;
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef KALMAN_STACKED_H_
+#define KALMAN_STACKED_H_
+
+#include <stdint.h>
+#include "compiler.h"
+#include "matrix.h"
+#include "kalman.h"
+
+/*!
+* \brief Several measurements of a filter that are corrected as one.
+*
+* The measurements are stacked into a single measurement with the rows of their H and z one below
+* the other and their R as the diagonal blocks of a block diagonal R, i.e. the measurements must be
+* independent of each other. A correction with the stack forms H*P, S and K once and updates P once,
+* instead of once per measurement.
+*
+* \see kalman_stack_initialize
+* \see kalman_correct_stacked
+*/
+typedef struct
+{
+    /*!
+    * \brief The stacked measurements, in the order of their rows
+    */
+    kalman_measurement_t **measurements;
+
+    /*!
+    * \brief The number of stacked measurements
+    */
+    uint_fast8_t count;
+
+    /*!
+    * \brief The largest number of stacked rows, i.e. the size of the buffers
+    */
+    uint_fast8_t capacity;
+
+    /*!
+    * \brief Stacked innovation vector (stacked rows x \c 1)
+    */
+    matrix_t y;
+
+    /*!
+    * \brief Stacked residual covariance matrix, holding its Cholesky factor after a correction (stacked rows x stacked rows)
+    */
+    matrix_t S;
+
+    /*!
+    * \brief Stacked Kalman gain matrix (number of states x stacked rows)
+    */
+    matrix_t K;
+
+    /*!
+    * \brief Nonzero once K was calculated against a covariance frozen at steady state; the correction then only updates x
+    *
+    * Cleared whenever the stacked measurements change.
+    */
+    uint_fast8_t frozen;
+
+    /*!
+    * \brief Temporary variables.
+    */
+    struct
+    {
+        /*!
+        * \brief Auxiliary array for matrix multiplication (number of states)
+        *
+        * This auxiliary field MUST NOT be aliased with temporary HP.
+        */
+        matrix_data_t *aux;
+
+        /*!
+        * \brief Stacked H*P (stacked rows x number of states)
+        */
+        matrix_t HP;
+
+    } temporary;
+
+} kalman_stack_t;
+
+/*!
+* \brief Initializes an empty measurement stack.
+* \param[in] stack The stack to initialize
+* \param[in] num_states The number of state variables
+* \param[in] measurements The array of stacked measurements ({\ref capacity})
+* \param[in] capacity The largest number of stacked rows (\c 1 or more)
+* \param[in] y The stacked innovation vector ({\ref capacity} x \c 1)
+* \param[in] S The stacked residual covariance matrix ({\ref capacity} x {\ref capacity})
+* \param[in] K The stacked Kalman gain matrix ({\ref num_states} x {\ref capacity})
+* \param[in] aux The auxiliary buffer ({\ref num_states})
+* \param[in] temp_HP The temporary stacked H*P ({\ref capacity} x {\ref num_states})
+*/
+void kalman_stack_initialize(kalman_stack_t *stack, uint_fast8_t num_states, kalman_measurement_t **measurements, uint_fast8_t capacity,
+                             matrix_data_t *y, matrix_data_t *S, matrix_data_t *K, matrix_data_t *aux, matrix_data_t *temp_HP) COLD;
+
+/*!
+* \brief Removes all measurements from the stack.
+* \param[in] stack The stack to clear
+*/
+void kalman_stack_clear(kalman_stack_t *stack) COLD;
+
+/*!
+* \brief Appends a measurement to the stack.
+* \param[in] stack The stack
+* \param[in] kfm The measurement to append; its rows must fit into the remaining capacity
+*
+* The measurement must be independent of the measurements already stacked, i.e. their errors must be
+* uncorrelated; only its H, R and z are used by the correction.
+*/
+void kalman_stack_add(kalman_stack_t *stack, kalman_measurement_t *kfm) COLD;
+
+/*!
+* \brief Performs the measurement update step with all stacked measurements at once.
+* \param[in] kf The Kalman Filter structure to correct; must propagate the full covariance
+* \param[in] stack The stack of measurements to correct with; their z must be set
+*
+* The result is that of {\ref kalman_correct} with one measurement after the other, but the covariance
+* is read and written once: the stacked H*P is formed from the rows of every H against the same P,
+* the off-diagonal blocks of S couple the measurements through P, and P is downdated once with the
+* stacked gain. With k stacked measurements, P is traversed by one product and one downdate instead of
+* k of each, at the cost of factoring one S of the summed size instead of k smaller ones.
+*
+* After the call, the y of every stacked measurement holds its innovation against the predicted state.
+* Their S and K as well as their steady state detection are neither used nor changed.
+*
+* While the covariance of the filter is frozen at steady state (see {\ref kalman_measurement_enable_steady_state}),
+* P is left unchanged: the stacked gain is calculated once against the frozen P and then only x is corrected,
+* until the covariance is no longer frozen or the stack changes.
+*/
+void kalman_correct_stacked(kalman_t *kf, kalman_stack_t *stack) HOT;
+
+#endif
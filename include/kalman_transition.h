@@ -0,0 +1,175 @@
+#ifndef KALMAN_TRANSITION_H_
+#define KALMAN_TRANSITION_H_
+
+#include <stdint.h>
+#include "compiler.h"
+#include "matrix.h"
+#include "kalman.h"
+
+/*!
+* \brief A cached transition of the filter over a longer interval.
+*
+* Applying the transition is equivalent to the whole interval of single predictions:
+* x = A*x and P = A*P*A' + Q.
+*/
+typedef struct
+{
+    /*!
+    * \brief The key of the interval, or zero if the entry is unused
+    */
+    uint_fast32_t key;
+
+    /*!
+    * \brief The value of the cache clock at the last use, for least recently used eviction
+    */
+    uint_fast32_t last_used;
+
+    /*!
+    * \brief State transition matrix over the interval (number of states x number of states)
+    */
+    matrix_t A;
+
+    /*!
+    * \brief Process noise accumulated over the interval (number of states x number of states)
+    */
+    matrix_t Q;
+
+} kalman_transition_t;
+
+/*!
+* \brief Discretizes the model over a time step.
+* \param[in] dt The time step
+* \param[out] A The state transition matrix over {\ref dt} (number of states x number of states)
+* \param[out] Q The process noise accumulated over {\ref dt} (number of states x number of states)
+* \param[in] context The context passed to {\ref kalman_transition_cache_set_model}
+*/
+typedef void (*kalman_discretize_t)(matrix_data_t dt, matrix_t *A, matrix_t *Q, void *context);
+
+/*!
+* \brief A small cache of transitions, evicting the least recently used entry.
+* \see kalman_transition_cache_initialize
+*/
+typedef struct
+{
+    /*!
+    * \brief The cache entries
+    */
+    kalman_transition_t *entries;
+
+    /*!
+    * \brief The number of cache entries
+    */
+    uint_fast8_t count;
+
+    /*!
+    * \brief The model discretization for time step keys, or null if the keys are step counts
+    */
+    kalman_discretize_t discretize;
+
+    /*!
+    * \brief The context passed to {\ref discretize}
+    */
+    void *context;
+
+    /*!
+    * \brief The time step quantum; time steps are rounded to a multiple of it to form the key
+    */
+    matrix_data_t resolution;
+
+    /*!
+    * \brief Incremented with every lookup
+    */
+    uint_fast32_t clock;
+
+    /*!
+    * \brief The number of lookups that found their entry
+    */
+    uint_fast32_t hits;
+
+    /*!
+    * \brief The number of lookups that had to build their entry
+    */
+    uint_fast32_t misses;
+
+    /*!
+    * \brief Temporary variables.
+    */
+    struct
+    {
+        /*!
+        * \brief Repeatedly squared transition matrix (number of states x number of states)
+        */
+        matrix_t A;
+
+        /*!
+        * \brief Process noise accumulated over the squared interval (number of states x number of states)
+        */
+        matrix_t Q;
+
+        /*!
+        * \brief Matrix product (number of states x number of states)
+        */
+        matrix_t product;
+
+    } temporary;
+
+} kalman_transition_cache_t;
+
+/*!
+* \brief Initializes a transition cache.
+* \param[in] cache The cache to initialize
+* \param[in] num_states The number of state variables
+* \param[in] entries The cache entries ({\ref count})
+* \param[in] count The number of cache entries
+* \param[in] buffer The buffer for the cached matrices (2 x {\ref count} x {\ref num_states} x {\ref num_states})
+* \param[in] temp The temporary buffer (3 x {\ref num_states} x {\ref num_states})
+*/
+void kalman_transition_cache_initialize(kalman_transition_cache_t *cache, uint_fast8_t num_states, kalman_transition_t *entries, uint_fast8_t count,
+                                        matrix_data_t *buffer, matrix_data_t *temp) COLD;
+
+/*!
+* \brief Invalidates all entries, e.g. after A, B or Q of the filter have changed.
+* \param[in] cache The cache to clear
+*/
+void kalman_transition_cache_clear(kalman_transition_cache_t *cache) COLD;
+
+/*!
+* \brief Keys the cache on time steps discretized by a model.
+* \param[in] cache The cache
+* \param[in] discretize The function providing A(dt) and Q(dt)
+* \param[in] context The context passed to {\ref discretize}
+* \param[in] resolution The time step quantum (greater than zero)
+*
+* Clears the cache. A cache keyed on time steps must not be used with {\ref kalman_predict_steps}.
+*/
+void kalman_transition_cache_set_model(kalman_transition_cache_t *cache, kalman_discretize_t discretize, void *context, matrix_data_t resolution) COLD;
+
+/*!
+* \brief Performs {\ref steps} prediction steps at the cost of a single one.
+* \param[in] kf The Kalman Filter structure to predict with; must propagate the full covariance
+* \param[in] cache The cache of transitions keyed on the number of steps
+* \param[in] steps The number of prediction steps (\c 1 or more)
+*
+* A gap of k ticks without measurements is equivalent to x = A^k*x and P = A^k*P*A^k' + Q_k with the
+* accumulated process noise Q_k = sum(A^i*B*Q*B'*A^i', i = 0..k-1). Both are built by repeated squaring,
+* i.e. in O(log k) matrix products, and cached for the next gap of the same length, which then costs
+* one propagation instead of k. A single step is passed on to {\ref kalman_predict}.
+*
+* The cache does not notice changes of A, B or Q; call {\ref kalman_transition_cache_clear} after changing them.
+*/
+void kalman_predict_steps(kalman_t *kf, kalman_transition_cache_t *cache, uint_fast16_t steps) HOT;
+
+/*!
+* \brief Predicts over a variable time step.
+* \param[in] kf The Kalman Filter structure to predict with; must propagate the full covariance
+* \param[in] cache The cache of transitions keyed on time steps, see {\ref kalman_transition_cache_set_model}
+* \param[in] dt The time step (\c 0 or more)
+*
+* The time step is rounded to the nearest multiple of the cache resolution, which serves as the key. Only if the
+* key is not cached, the model is asked for A and Q at the rounded time step, evicting the least recently used
+* entry; recurring sensor periods therefore cost a single propagation just like {\ref kalman_predict}.
+* Time steps that round to zero leave the filter unchanged. A and Q of the filter itself are not used.
+*/
+void kalman_predict_dt(kalman_t *kf, kalman_transition_cache_t *cache, matrix_data_t dt) HOT;
+
+#endif
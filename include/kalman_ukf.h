@@ -0,0 +1,120 @@
+#ifndef KALMAN_UKF_H_
+#define KALMAN_UKF_H_
+
+#include <stdint.h>
+#include "compiler.h"
+#include "matrix.h"
+#include "kalman.h"
+
+/*!
+* \brief Evaluates a nonlinear model for a whole batch of sigma points.
+* \param[in] sigma The sigma points (number of states x number of points), one point per column
+* \param[out] result The model outputs (number of outputs x number of points), one output per column
+* \param[in] context The user context passed through by the caller
+*
+* Both matrices are in structure-of-arrays layout: row i holds component i of all points contiguously,
+* so the model can be written as loops over the points that the compiler vectorizes.
+*/
+typedef void (*kalman_ukf_model_t)(const matrix_t *sigma, matrix_t *result, void *context);
+
+/*!
+* \brief Sigma point workspace of an unscented Kalman filter operating on a {\ref kalman_t}.
+*
+* The state x and covariance P stay in the filter, the process noise is B*Q*B' of the filter, and
+* R, z, y, S and K as well as the temporary HP are those of the measurement, so existing (factory
+* created) filters and measurements can be used as they are.
+*
+* \see kalman_ukf_initialize
+*/
+typedef struct
+{
+    /*!
+    * \brief Sigma points (number of states x (2 * number of states + 1)), one point per column
+    */
+    matrix_t sigma;
+
+    /*!
+    * \brief Propagated sigma points (number of states x (2 * number of states + 1))
+    */
+    matrix_t propagated;
+
+    /*!
+    * \brief Buffer for the predicted measurements (maximum number of measurements x (2 * number of states + 1))
+    */
+    matrix_data_t *measured;
+
+    /*!
+    * \brief Weights of the sigma points for the mean (2 * number of states + 1)
+    */
+    matrix_data_t *weights_mean;
+
+    /*!
+    * \brief Weights of the sigma points for the covariance (2 * number of states + 1)
+    */
+    matrix_data_t *weights_covariance;
+
+    /*!
+    * \brief Scale of the Cholesky factor columns, sqrt(n + lambda)
+    */
+    matrix_data_t gamma;
+
+    /*!
+    * \brief Temporary variables.
+    */
+    struct
+    {
+        /*!
+        * \brief Cholesky factor of P (number of states x number of states)
+        */
+        matrix_t factor;
+
+    } temporary;
+
+} kalman_ukf_t;
+
+/*!
+* \brief Initializes the sigma point workspace of an unscented Kalman filter.
+* \param[in] ukf The workspace to initialize
+* \param[in] num_states The number of state variables
+* \param[in] alpha The spread of the sigma points around the mean (\c 0 < {\ref alpha} <= \c 1)
+* \param[in] beta Prior knowledge of the distribution, \c 2 for Gaussians
+* \param[in] kappa Secondary scaling, usually \c 0
+* \param[in] sigma The sigma point buffer ({\ref num_states} x (2 * {\ref num_states} + 1))
+* \param[in] propagated The propagated sigma point buffer ({\ref num_states} x (2 * {\ref num_states} + 1))
+* \param[in] measured The predicted measurement buffer (maximum number of measurements x (2 * {\ref num_states} + 1))
+* \param[in] weights The weight buffer (2 x (2 * {\ref num_states} + 1))
+* \param[in] temp_factor The temporary matrix for the Cholesky factor ({\ref num_states} x {\ref num_states})
+*/
+void kalman_ukf_initialize(kalman_ukf_t *ukf, uint_fast8_t num_states, matrix_data_t alpha, matrix_data_t beta, matrix_data_t kappa,
+                           matrix_data_t *sigma, matrix_data_t *propagated, matrix_data_t *measured, matrix_data_t *weights,
+                           matrix_data_t *temp_factor) COLD;
+
+/*!
+* \brief Performs the time update / prediction step of an unscented Kalman filter.
+* \param[in] kf The Kalman Filter structure to predict with; must propagate the full covariance
+* \param[in] ukf The sigma point workspace
+* \param[in] f The process model, called once for all sigma points
+* \param[in] context The user context passed to the model
+* \return Zero in case of success, nonzero if P is not positive definite.
+*
+* The sigma points x and x +/- gamma * L_i are generated from the columns of the Cholesky factor
+* P = L*L', propagated, and x and P are rebuilt as their weighted mean and covariance plus B*Q*B'.
+*/
+int kalman_ukf_predict(kalman_t *kf, kalman_ukf_t *ukf, kalman_ukf_model_t f, void *context) HOT;
+
+/*!
+* \brief Performs the measurement update step of an unscented Kalman filter.
+* \param[in] kf The Kalman Filter structure to correct; must propagate the full covariance
+* \param[in] kfm The measurement to correct with; z and R must be set. H is not used.
+* \param[in] ukf The sigma point workspace
+* \param[in] h The measurement model, called once for all sigma points
+* \param[in] context The user context passed to the model
+* \return Zero in case of success, nonzero if P or the residual covariance S is not positive definite.
+*
+* S and the cross covariance are accumulated from the sigma point deviations; the cross covariance
+* takes the place of H*P in the temporary HP, so the gain and covariance update are those of
+* {\ref kalman_correct}. Not available for sequential measurements.
+*/
+int kalman_ukf_correct(kalman_t *kf, kalman_measurement_t *kfm, kalman_ukf_t *ukf, kalman_ukf_model_t h, void *context) HOT;
+
+#endif
@@ -11,10 +11,30 @@
 #define EXTERN_INLINE_MATRIX EXTERN_INLINE
 #endif
 
+/**
+* \def MATRIX_DATA_DOUBLE Set to nonzero to use double precision for all matrices.
+*
+* Single precision is the default; it halves the memory traffic and doubles the SIMD width.
+* Filters that only need double precision for the gain calculation should rather use the
+* mixed precision correction, see {\ref kalman_measurement_set_mixed_precision}.
+*/
+#ifndef MATRIX_DATA_DOUBLE
+#define MATRIX_DATA_DOUBLE 0
+#endif
+
 /**
 * Matrix data type definition.
 */
+#if MATRIX_DATA_DOUBLE
+typedef double matrix_data_t;
+#else
 typedef float matrix_data_t;
+#endif
+
+/**
+* Wide data type for the parts of a mixed precision computation that accumulate in double precision.
+*/
+typedef double matrix_wide_t;
 
 /**
 * \brief Matrix definition
@@ -36,6 +56,70 @@ typedef struct {
     matrix_data_t *data;
 } matrix_t;
 
+/**
+* \brief Sparsity pattern of a matrix, separating entries that are exactly one from general entries
+*
+* The column indices of each row are stored consecutively: first the unit entries, then the general
+* (nonzero, non-unit) entries. For row \c r, the unit entries are found at indices
+* <tt>offsets[2r] .. offsets[2r+1]-1</tt> of {\ref columns} and the general entries at
+* <tt>offsets[2r+1] .. offsets[2r+2]-1</tt>. The values of the general entries are read from the matrix itself,
+* so the pattern stays valid as long as no entry changes between zero, one and any other value.
+*
+* \see matrix_sparsity_analyze
+*/
+typedef struct {
+    /**
+    * \brief Number of rows
+    */
+    uint_fast8_t rows;
+
+    /**
+    * \brief Row offsets into {\see columns} (of size 2 x {\see rows} + 1)
+    */
+    uint_fast16_t *offsets;
+
+    /**
+    * \brief Column indices of the unit and general entries (of size {\see rows} x number of columns)
+    */
+    uint_fast8_t *columns;
+} matrix_sparsity_t;
+
+/**
+* \brief Kernel backends for the matrix multiplications
+*/
+typedef enum {
+    /**
+    * \brief Let the library pick the fastest backend supported by the CPU
+    */
+    MATRIX_BACKEND_AUTO = -1,
+
+    /**
+    * \brief Portable scalar kernels, always available
+    */
+    MATRIX_BACKEND_SCALAR = 0,
+
+    /**
+    * \brief AVX2/FMA kernels (x86 only)
+    */
+    MATRIX_BACKEND_AVX2_FMA = 1
+} matrix_backend_t;
+
+/**
+* \brief Selects the kernel backend used by the matrix multiplications.
+* \param[in] backend The backend to use, or {\ref MATRIX_BACKEND_AUTO} to pick the fastest one supported by the CPU.
+* \return The backend that is now active; this is {\ref MATRIX_BACKEND_SCALAR} if the requested one is not available.
+*
+* On GCC-compatible x86 builds the fastest backend is selected automatically at startup,
+* elsewhere the scalar kernels are used unless this function is called.
+*/
+matrix_backend_t matrix_select_backend(matrix_backend_t backend) COLD;
+
+/**
+* \brief Gets the kernel backend used by the matrix multiplications.
+* \return The active backend.
+*/
+matrix_backend_t matrix_get_backend() PURE;
+
 /**
 * \brief Initializes a matrix structure.
 * \param[in] mat The matrix to initialize
@@ -54,6 +138,16 @@ void matrix_init(matrix_t *const  mat, const uint_fast8_t rows, const uint_fast8
 */
 void matrix_invert_lower(const matrix_t *RESTRICT const lower, matrix_t *RESTRICT inverse) HOT;
 
+/**
+* \brief Triangularizes a wide matrix using Givens rotations, such that {\ref mat} = [L 0] * Q' for an orthogonal Q.
+* \param[in] mat The matrix ({\ref rows} x {\ref cols}, with {\ref cols} not less than {\ref rows}) to triangularize in place.
+*
+* On return, the leading {\ref rows} x {\ref rows} block holds the lower triangular L with a nonnegative diagonal and
+* all other entries are zero. Since L*L' = M*M', this yields the Cholesky factor of M*M' without forming the product,
+* which is the core operation of square root filtering. Entries that are already zero are not rotated.
+*/
+void matrix_triangularize_lower(const matrix_t *const mat) HOT;
+
 /*!
 * \brief Performs a matrix multiplication such that {\ref c} = {\ref x} * {\ref b}
 * \param[in] a Matrix A
@@ -118,6 +212,109 @@ void matrix_multadd_transb(const matrix_t *const a, const matrix_t *const b, con
 */
 void matrix_multscale_transb(const matrix_t *const a, const matrix_t *const b, register const matrix_data_t scale, const matrix_t *RESTRICT c) HOT;
 
+/*!
+* \brief Performs a matrix multiplication with transposed B such that {\ref c} = {\ref a} * {\ref b'}, where the result is known to be symmetric
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[in] c Resulting square matrix C (will be overwritten)
+*
+* Only the lower triangle of C is calculated and then mirrored, which roughly halves the cost of e.g. A*P*A'.
+*/
+void matrix_mult_transb_symmetric(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c) HOT;
+
+/*!
+* \brief Performs a matrix multiplication with transposed B and adds the result to {\ref c} such that {\ref c} = {\ref c} + {\ref a} * {\ref b'}, where the result is known to be symmetric
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[in] c Resulting symmetric matrix C (will be added to)
+*
+* Only the lower triangle of C is calculated and then mirrored; the upper triangle of C is not read.
+*/
+void matrix_multadd_transb_symmetric(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c) HOT;
+
+/*!
+* \brief Performs a matrix multiplication with transposed B and scales the result such that {\ref c} = {\ref a} * {\ref b'} * {\ref scale}, where the result is known to be symmetric
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[in] scale Scaling factor
+* \param[in] c Resulting square matrix C (will be overwritten)
+*
+* Only the lower triangle of C is calculated and then mirrored.
+*/
+void matrix_multscale_transb_symmetric(const matrix_t *const a, const matrix_t *const b, register const matrix_data_t scale, const matrix_t *RESTRICT c) HOT;
+
+/*!
+* \brief Performs the in-place covariance propagation {\ref p} = {\ref scale} * {\ref a} * {\ref p} * {\ref a'} + {\ref bq} * {\ref b'}
+* \param[in] a Square matrix A
+* \param[in] p Symmetric matrix P (will be overwritten)
+* \param[in] scale Scaling factor for A*P*A'
+* \param[in] bq Optional product B*Q; may be null
+* \param[in] b Optional matrix B; may be null if {\ref bq} is null
+* \param[in] aux Auxiliary vector that can hold a row of {\ref p}
+*
+* No intermediate matrix is required; only the lower triangle of the result is calculated and then mirrored.
+* The buffer of {\ref aux} MUST NOT be aliased with any of the matrices.
+*/
+void matrix_mult_abat(const matrix_t *const a, const matrix_t *RESTRICT p, register const matrix_data_t scale, const matrix_t *const bq, const matrix_t *const b, matrix_data_t *const aux) HOT;
+
+/*!
+* \brief Accumulates a weighted sum of outer products such that {\ref c} = {\ref c} + {\ref a} * diag({\ref w}) * {\ref b'}
+* \param[in] a Matrix A (rows x k)
+* \param[in] w The weights (k)
+* \param[in] b Matrix B (cols x k)
+* \param[in] c Resulting matrix C (rows x cols, will be added to)
+*
+* With the columns of A and B holding samples in structure-of-arrays layout (e.g. sigma point deviations),
+* this is the weighted sample (cross) covariance. If A and B are the same matrix, only the lower triangle
+* of C is calculated and then mirrored.
+*/
+void matrix_multadd_weighted_transb(const matrix_t *const a, const matrix_data_t *RESTRICT const w, const matrix_t *const b, const matrix_t *RESTRICT c) HOT;
+
+/*!
+* \brief Performs a matrix multiplication and subtracts the result from {\ref c} such that {\ref c} = {\ref c} - {\ref a} * {\ref b}, where the result is known to be symmetric
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[in] c Resulting symmetric matrix C (will be subtracted from)
+*
+* Only the lower triangle of C is calculated and then mirrored; no auxiliary buffer is required.
+*/
+void matrix_multsub_symmetric(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c) HOT;
+
+/*!
+* \brief Determines the sparsity pattern of a matrix.
+* \param[in] a The matrix to analyze
+* \param[in] sparsity The pattern to fill; its buffers must be set and large enough for {\ref a}
+* \return The number of multiplications per matrix/vector product, i.e. the number of general entries.
+*
+* Must be called again whenever an entry of {\ref a} changes between zero, one and any other value.
+*/
+uint_fast16_t matrix_sparsity_analyze(const matrix_t *const a, matrix_sparsity_t *const sparsity) COLD;
+
+/*!
+* \brief Performs a matrix multiplication such that {\ref c} = {\ref a} * {\ref x}, skipping the zero and unit entries of {\ref a}
+* \param[in] a Matrix A
+* \param[in] sparsity The sparsity pattern of {\ref a}
+* \param[in] x Vector x
+* \param[in] c Resulting vector C (will be overwritten)
+*
+* \see matrix_mult_rowvector
+*/
+void matrix_mult_rowvector_sparse(const matrix_t *RESTRICT const a, const matrix_sparsity_t *RESTRICT const sparsity, const matrix_t *RESTRICT const x, matrix_t *RESTRICT const c) HOT;
+
+/*!
+* \brief Performs the in-place covariance propagation {\ref p} = {\ref scale} * {\ref a} * {\ref p} * {\ref a'} + {\ref bq} * {\ref b'}, skipping the zero and unit entries of {\ref a}
+* \param[in] a Square matrix A
+* \param[in] sparsity The sparsity pattern of {\ref a}
+* \param[in] p Symmetric matrix P (will be overwritten)
+* \param[in] scale Scaling factor for A*P*A'
+* \param[in] bq Optional product B*Q; may be null
+* \param[in] b Optional matrix B; may be null if {\ref bq} is null
+* \param[in] aux Auxiliary vector that can hold a row of {\ref p}
+*
+* \see matrix_mult_abat
+*/
+void matrix_mult_abat_sparse(const matrix_t *const a, const matrix_sparsity_t *RESTRICT const sparsity, const matrix_t *RESTRICT p, register const matrix_data_t scale, const matrix_t *const bq, const matrix_t *const b, matrix_data_t *const aux) HOT;
+
 /*!
 * \brief Gets a matrix element
 * \param[in] mat The matrix to get from
@@ -0,0 +1,81 @@
+#ifndef MATRIX_AVX2_H_
+#define MATRIX_AVX2_H_
+
+#include "compiler.h"
+#include "matrix.h"
+
+/**
+* \def MATRIX_HAVE_AVX2 Set to nonzero if the AVX2/FMA kernels are compiled in.
+*
+* The kernels are built with per-function target attributes, so no special compiler flags
+* are required; the backend is only ever used after the CPU has been checked for support.
+* Define MATRIX_DISABLE_SIMD to force the scalar kernels only. The kernels are single precision,
+* so they are left out if MATRIX_DATA_DOUBLE is set.
+*/
+#if !defined(MATRIX_DISABLE_SIMD) && !MATRIX_DATA_DOUBLE && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MATRIX_HAVE_AVX2 1
+#else
+#define MATRIX_HAVE_AVX2 0
+#endif
+
+#if MATRIX_HAVE_AVX2
+
+/*!
+* \brief Determines whether the executing CPU supports AVX2 and FMA.
+* \return Nonzero if the AVX2/FMA kernels can be used.
+*/
+int matrix_avx2_supported() COLD;
+
+/*!
+* \brief AVX2/FMA version of {\ref matrix_mult}.
+*/
+void matrix_mult_avx2(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c, matrix_data_t *const baux) HOT;
+
+/*!
+* \brief AVX2/FMA version of {\ref matrix_mult_transb}.
+*/
+void matrix_mult_transb_avx2(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c) HOT;
+
+/*!
+* \brief AVX2/FMA version of {\ref matrix_multadd_transb}.
+*/
+void matrix_multadd_transb_avx2(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c) HOT;
+
+/*!
+* \brief AVX2/FMA version of {\ref matrix_multscale_transb}.
+*/
+void matrix_multscale_transb_avx2(const matrix_t *const a, const matrix_t *const b, register const matrix_data_t scale, const matrix_t *RESTRICT c) HOT;
+
+/*!
+* \brief AVX2/FMA version of {\ref matrix_mult_rowvector}.
+*/
+void matrix_mult_rowvector_avx2(const matrix_t *RESTRICT const a, const matrix_t *RESTRICT const x, matrix_t *RESTRICT const c) HOT;
+
+/*!
+* \brief AVX2/FMA version of {\ref matrix_multadd_rowvector}.
+*/
+void matrix_multadd_rowvector_avx2(const matrix_t *RESTRICT const a, const matrix_t *RESTRICT const x, matrix_t *RESTRICT const c) HOT;
+
+/*!
+* \brief AVX2/FMA version of {\ref matrix_mult_transb_symmetric}.
+*/
+void matrix_mult_transb_symmetric_avx2(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c) HOT;
+
+/*!
+* \brief AVX2/FMA version of {\ref matrix_multadd_transb_symmetric}.
+*/
+void matrix_multadd_transb_symmetric_avx2(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c) HOT;
+
+/*!
+* \brief AVX2/FMA version of {\ref matrix_multscale_transb_symmetric}.
+*/
+void matrix_multscale_transb_symmetric_avx2(const matrix_t *const a, const matrix_t *const b, register const matrix_data_t scale, const matrix_t *RESTRICT c) HOT;
+
+/*!
+* \brief AVX2/FMA version of {\ref matrix_mult_abat}.
+*/
+void matrix_mult_abat_avx2(const matrix_t *const a, const matrix_t *RESTRICT p, register const matrix_data_t scale, const matrix_t *const bq, const matrix_t *const b, matrix_data_t *const aux) HOT;
+
+#endif
+
+#endif
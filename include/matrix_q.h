@@ -0,0 +1,182 @@
+#ifndef MATRIX_Q_H_
+#define MATRIX_Q_H_
+
+#include <stdint.h>
+#include "compiler.h"
+#include "matrix.h"
+
+/**
+* Fixed-point matrix data type definition.
+*
+* Values are stored in two's complement Q format with a per-matrix number of fractional bits,
+* e.g. 15 fractional bits for Q16.15 or 31 for Q31. All kernels accumulate in 64 bit and
+* saturate instead of wrapping around, so no floating point unit is required.
+*/
+typedef int32_t matrix_q_data_t;
+
+/**
+* Accumulator type of the fixed-point kernels.
+*/
+typedef int64_t matrix_q_accum_t;
+
+/**
+* \def MATRIX_Q_MAX The largest fixed-point value
+*/
+#define MATRIX_Q_MAX            ((matrix_q_data_t)INT32_MAX)
+
+/**
+* \def MATRIX_Q_MIN The smallest fixed-point value
+*/
+#define MATRIX_Q_MIN            ((matrix_q_data_t)INT32_MIN)
+
+/**
+* \def MATRIX_Q_ONE Returns the representation of one with the given number of fractional bits (at most 30).
+*/
+#define MATRIX_Q_ONE(frac)      ((matrix_q_data_t)1 << (frac))
+
+/**
+* \brief Fixed-point matrix definition
+*/
+typedef struct {
+    /**
+    * \brief Number of rows
+    */
+    uint_fast8_t rows;
+
+    /**
+    * \brief Number of columns
+    */
+    uint_fast8_t cols;
+
+    /**
+    * \brief Number of fractional bits of every element
+    */
+    uint_fast8_t frac;
+
+    /**
+    * \brief Pointer to the data array of size {\see rows} x {\see cols}.
+    */
+    matrix_q_data_t *data;
+} matrix_q_t;
+
+/**
+* \brief Initializes a fixed-point matrix structure.
+* \param[in] mat The matrix to initialize
+* \param[in] rows The number of rows
+* \param[in] cols The number of columns
+* \param[in] frac The number of fractional bits (at most 31)
+* \param[in] buffer The data buffer (of size {\see rows} x {\see cols}).
+*/
+void matrix_q_init(matrix_q_t *const mat, const uint_fast8_t rows, const uint_fast8_t cols, const uint_fast8_t frac, matrix_q_data_t *const buffer);
+
+/**
+* \brief Converts a floating point matrix to fixed-point, saturating values out of range.
+* \param[in] mat The floating point matrix
+* \param[out] target The fixed-point matrix of the same dimensions
+*/
+void matrix_q_from_float(const matrix_t *RESTRICT const mat, matrix_q_t *RESTRICT const target) COLD;
+
+/**
+* \brief Converts a fixed-point matrix to floating point.
+* \param[in] mat The fixed-point matrix
+* \param[out] target The floating point matrix of the same dimensions
+*/
+void matrix_q_to_float(const matrix_q_t *RESTRICT const mat, matrix_t *RESTRICT const target) COLD;
+
+/*!
+* \brief Performs a matrix multiplication such that {\ref c} = {\ref a} * {\ref b}
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[out] c Resulting matrix C
+*/
+void matrix_q_mult(const matrix_q_t *const a, const matrix_q_t *const b, const matrix_q_t *RESTRICT c) HOT;
+
+/*!
+* \brief Performs a matrix multiplication with transposed B such that {\ref c} = {\ref a} * {\ref b'}
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[out] c Resulting matrix C
+*/
+void matrix_q_mult_transb(const matrix_q_t *const a, const matrix_q_t *const b, const matrix_q_t *RESTRICT c) HOT;
+
+/*!
+* \brief Performs a matrix multiplication such that {\ref c} = {\ref a} * {\ref x}
+* \param[in] a Matrix A
+* \param[in] x Vector x
+* \param[out] c Resulting vector C (will be overwritten)
+*/
+void matrix_q_mult_rowvector(const matrix_q_t *RESTRICT const a, const matrix_q_t *RESTRICT const x, matrix_q_t *RESTRICT const c) HOT;
+
+/*!
+* \brief Performs a matrix multiplication such that {\ref c} = {\ref c} + {\ref a} * {\ref x}
+* \param[in] a Matrix A
+* \param[in] x Vector x
+* \param[out] c Resulting vector C (will be added to)
+*/
+void matrix_q_multadd_rowvector(const matrix_q_t *RESTRICT const a, const matrix_q_t *RESTRICT const x, matrix_q_t *RESTRICT const c) HOT;
+
+/*!
+* \brief Performs a matrix multiplication such that {\ref c} = {\ref c} - {\ref a} * {\ref b}
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[out] c Resulting matrix C (will be subtracted from)
+*/
+void matrix_q_multsub(const matrix_q_t *RESTRICT const a, const matrix_q_t *RESTRICT const b, const matrix_q_t *RESTRICT c) HOT;
+
+/*!
+* \brief Adds two matrices in place, using {\ref a} = {\ref a} + {\ref b}
+* \param[in] a The matrix to add to, also the output.
+* \param[in] b The values to add.
+*/
+void matrix_q_add_inplace(const matrix_q_t *RESTRICT a, const matrix_q_t *RESTRICT const b) HOT;
+
+/*!
+* \brief Subtracts two matrices in place, using {\ref b} = {\ref a} - {\ref b}
+* \param[in] a The matrix to subtract from.
+* \param[in] b The values to subtract, also the output.
+*/
+void matrix_q_sub_inplace_b(const matrix_q_t *RESTRICT const a, const matrix_q_t *RESTRICT b) HOT;
+
+/*!
+* \brief Adds two accumulator values, saturating instead of wrapping around.
+* \param[in] a The first summand
+* \param[in] b The second summand
+* \return The saturated sum
+*/
+PURE UNUSED STATIC_INLINE matrix_q_accum_t matrix_q_accum_add(const matrix_q_accum_t a, const matrix_q_accum_t b)
+{
+    const matrix_q_accum_t sum = (matrix_q_accum_t)((uint64_t)a + (uint64_t)b);
+
+    // overflow iff both summands have the same sign and the sum has the other one
+    if (((a ^ sum) & (b ^ sum)) < 0)
+    {
+        return (a < 0) ? INT64_MIN : INT64_MAX;
+    }
+    return sum;
+}
+
+/*!
+* \brief Rescales an accumulator value by a power of two with rounding and saturates it to the fixed-point range.
+* \param[in] value The accumulator value
+* \param[in] shift The number of bits to shift to the right; negative values shift to the left
+* \return The saturated fixed-point value
+*/
+PURE UNUSED STATIC_INLINE matrix_q_data_t matrix_q_narrow(matrix_q_accum_t value, const int_fast8_t shift)
+{
+    if (shift > 0)
+    {
+        value = matrix_q_accum_add(value, (matrix_q_accum_t)1 << (shift - 1)) >> shift;
+    }
+    else if (shift < 0)
+    {
+        if (value > (INT64_MAX >> -shift)) return MATRIX_Q_MAX;
+        if (value < (INT64_MIN >> -shift)) return MATRIX_Q_MIN;
+        value = (matrix_q_accum_t)((uint64_t)value << -shift);
+    }
+
+    if (value > MATRIX_Q_MAX) return MATRIX_Q_MAX;
+    if (value < MATRIX_Q_MIN) return MATRIX_Q_MIN;
+    return (matrix_q_data_t)value;
+}
+
+#endif
@@ -4,6 +4,8 @@
 
 #define EXTERN_INLINE_MATRIX static INLINE
 #include "matrix.h"
+#include "matrix_q.h"
+#include "cholesky.h"
 
 /**
 * \brief Decomposes a matrix into lower triangular form using Cholesky decomposition.
@@ -68,3 +70,357 @@ int cholesky_decompose_lower(register const matrix_t *const mat)
 
     return 0;
 }
+
+/**
+* \brief Solves {\ref x} * (L*L') = {\ref b'} for {\ref x} using forward and back substitution.
+* \param[in] lower The lower triangular Cholesky factor L ({\ref n} x {\ref n}), as created by {\ref cholesky_decompose_lower}.
+* \param[in] b The right hand side B ({\ref n} x {\ref k}).
+* \param[out] x The solution X ({\ref k} x {\ref n}), i.e. X = B' * (L*L')^-1.
+*/
+void cholesky_solve_transb(const matrix_t *RESTRICT const lower, const matrix_t *RESTRICT const b, const matrix_t *RESTRICT x)
+{
+    int_fast16_t i, k;
+    uint_fast16_t r;
+    const uint_fast8_t n = lower->rows;
+    const uint_fast8_t bcols = b->cols;
+
+    const matrix_data_t *RESTRICT const t = lower->data;
+    const matrix_data_t *RESTRICT const bdata = b->data;
+
+    assert(lower->rows == lower->cols);
+    assert(b->rows == n);
+    assert(x->rows == bcols && x->cols == n);
+
+    for (r = 0; r < bcols; ++r)
+    {
+        matrix_data_t *RESTRICT const xrow = &x->data[r * n];
+
+        // solve L*u = b(:,r)
+        for (i = 0; i < n; ++i)
+        {
+            matrix_data_t sum = bdata[i * bcols + r];
+            for (k = 0; k < i; ++k)
+            {
+                sum -= t[i * n + k] * xrow[k];
+            }
+            xrow[i] = sum / t[i * n + i];
+        }
+
+        // solve L'*x(r,:)' = u
+        for (i = n - 1; i >= 0; --i)
+        {
+            matrix_data_t sum = xrow[i];
+            for (k = i + 1; k < n; ++k)
+            {
+                sum -= t[k * n + i] * xrow[k];
+            }
+            xrow[i] = sum / t[i * n + i];
+        }
+    }
+}
+
+/**
+* \brief Decomposes a double precision matrix into lower triangular form using Cholesky decomposition.
+* \param[in] t The {\ref n} x {\ref n} matrix to decompose in place into a lower triangular matrix.
+* \param[in] n The dimension of the matrix
+* \return Zero in case of success, nonzero if the matrix is not positive semi-definite.
+*/
+int cholesky_decompose_lower_wide(matrix_wide_t *RESTRICT const t, const uint_fast8_t n)
+{
+    uint_fast8_t i, j, k;
+
+    assert(t != (matrix_wide_t*)0);
+    assert(n > 0);
+
+    for (i = 0; i < n; ++i)
+    {
+        for (j = 0; j <= i; ++j)
+        {
+            matrix_wide_t sum = t[i * n + j];
+            for (k = 0; k < j; ++k)
+            {
+                sum -= t[i * n + k] * t[j * n + k];
+            }
+
+            if (i == j)
+            {
+                // is it positive-definite?
+                if (sum <= 0.0) return 1;
+                t[i * n + i] = sqrt(sum);
+            }
+            else
+            {
+                t[i * n + j] = sum / t[j * n + j];
+            }
+        }
+
+        // zero the top right corner
+        for (j = i + 1; j < n; ++j)
+        {
+            t[i * n + j] = 0.0;
+        }
+    }
+
+    return 0;
+}
+
+/**
+* \brief Solves {\ref x} * (L*L') = {\ref b'} for {\ref x} with a double precision factor L.
+* \param[in] lower The lower triangular Cholesky factor L ({\ref n} x {\ref n}), as created by {\ref cholesky_decompose_lower_wide}.
+* \param[in] b The right hand side B ({\ref n} x {\ref k}).
+* \param[out] x The solution X ({\ref k} x {\ref n}), i.e. X = B' * (L*L')^-1.
+* \param[in] aux Auxiliary buffer of {\ref n} elements holding a row of X during the substitution.
+*/
+void cholesky_solve_transb_wide(const matrix_wide_t *RESTRICT const lower, const matrix_t *RESTRICT const b, const matrix_t *RESTRICT x, matrix_wide_t *RESTRICT const aux)
+{
+    int_fast16_t i, k;
+    uint_fast16_t r;
+    const uint_fast8_t n = b->rows;
+    const uint_fast8_t bcols = b->cols;
+
+    const matrix_data_t *RESTRICT const bdata = b->data;
+
+    assert(x->rows == bcols && x->cols == n);
+
+    for (r = 0; r < bcols; ++r)
+    {
+        matrix_data_t *RESTRICT const xrow = &x->data[r * n];
+
+        // solve L*u = b(:,r)
+        for (i = 0; i < n; ++i)
+        {
+            matrix_wide_t sum = bdata[i * bcols + r];
+            for (k = 0; k < i; ++k)
+            {
+                sum -= lower[i * n + k] * aux[k];
+            }
+            aux[i] = sum / lower[i * n + i];
+        }
+
+        // solve L'*x(r,:)' = u
+        for (i = n - 1; i >= 0; --i)
+        {
+            matrix_wide_t sum = aux[i];
+            for (k = i + 1; k < n; ++k)
+            {
+                sum -= lower[k * n + i] * aux[k];
+            }
+            aux[i] = sum / lower[i * n + i];
+        }
+
+        for (i = 0; i < n; ++i)
+        {
+            xrow[i] = (matrix_data_t)aux[i];
+        }
+    }
+}
+
+/**
+* \brief Calculates the integer square root, i.e. the largest integer whose square is not greater than the value.
+* \param[in] value The value
+* \return The integer square root
+*/
+static uint32_t cholesky_isqrt(uint64_t value)
+{
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    // highest power of four not greater than the value
+    while (bit > value) bit >>= 2;
+
+    while (bit != 0)
+    {
+        if (value >= root + bit)
+        {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint32_t)root;
+}
+
+/**
+* \brief Decomposes a fixed-point matrix into lower triangular form using Cholesky decomposition.
+* \param[in] mat The matrix to decompose in place into a lower triangular matrix.
+* \return Zero in case of success, nonzero if the matrix is not positive semi-definite.
+*/
+int cholesky_decompose_lower_q(const matrix_q_t *const mat)
+{
+    uint_fast8_t i, j, k;
+    const uint_fast8_t n = mat->rows;
+    const uint_fast8_t frac = mat->frac;
+    matrix_q_data_t *const t = mat->data;
+
+    assert(mat != (matrix_q_t*)0);
+    assert(mat->rows == mat->cols);
+    assert(mat->rows > 0);
+
+    for (i = 0; i < n; ++i)
+    {
+        for (j = i; j < n; ++j)
+        {
+            // sum with twice the fractional bits
+            matrix_q_accum_t sum = (matrix_q_accum_t)t[i * n + j] * ((matrix_q_accum_t)1 << frac);
+            for (k = 0; k < i; ++k)
+            {
+                sum = matrix_q_accum_add(sum, -(matrix_q_accum_t)t[i * n + k] * t[j * n + k]);
+            }
+
+            if (i == j)
+            {
+                // is it positive-definite?
+                if (sum <= 0) return 1;
+
+                // the square root halves the fractional bits
+                t[i * n + i] = matrix_q_narrow(cholesky_isqrt((uint64_t)sum), 0);
+                if (t[i * n + i] == 0) return 1;
+            }
+            else
+            {
+                t[j * n + i] = matrix_q_narrow(sum / t[i * n + i], 0);
+            }
+        }
+    }
+
+    // zero the top right corner.
+    for (i = 0; i < n; ++i)
+    {
+        for (j = i + 1; j < n; ++j)
+        {
+            t[i * n + j] = 0;
+        }
+    }
+
+    return 0;
+}
+
+/**
+* \brief Solves {\ref x} * (L*L') = {\ref b'} for {\ref x} in fixed-point arithmetic.
+* \param[in] lower The lower triangular Cholesky factor L ({\ref n} x {\ref n}), as created by {\ref cholesky_decompose_lower_q}.
+* \param[in] b The right hand side B ({\ref n} x {\ref k}).
+* \param[out] x The solution X ({\ref k} x {\ref n}), i.e. X = B' * (L*L')^-1.
+*/
+void cholesky_solve_transb_q(const matrix_q_t *RESTRICT const lower, const matrix_q_t *RESTRICT const b, const matrix_q_t *RESTRICT x)
+{
+    int_fast16_t i, k;
+    uint_fast16_t r;
+    const uint_fast8_t n = lower->rows;
+    const uint_fast8_t bcols = b->cols;
+    const uint_fast8_t lfrac = lower->frac;
+
+    // the sums carry the fractional bits of L and X
+    const uint_fast8_t bshift = lower->frac + x->frac - b->frac;
+
+    const matrix_q_data_t *RESTRICT const t = lower->data;
+    const matrix_q_data_t *RESTRICT const bdata = b->data;
+
+    assert(lower->rows == lower->cols);
+    assert(b->rows == n);
+    assert(x->rows == bcols && x->cols == n);
+    assert(lower->frac + x->frac >= b->frac);
+
+    for (r = 0; r < bcols; ++r)
+    {
+        matrix_q_data_t *RESTRICT const xrow = &x->data[r * n];
+
+        // solve L*u = b(:,r)
+        for (i = 0; i < n; ++i)
+        {
+            matrix_q_accum_t sum = (matrix_q_accum_t)bdata[i * bcols + r] * ((matrix_q_accum_t)1 << bshift);
+            for (k = 0; k < i; ++k)
+            {
+                sum = matrix_q_accum_add(sum, -(matrix_q_accum_t)t[i * n + k] * xrow[k]);
+            }
+            xrow[i] = matrix_q_narrow(sum / t[i * n + i], 0);
+        }
+
+        // solve L'*x(r,:)' = u
+        for (i = n - 1; i >= 0; --i)
+        {
+            matrix_q_accum_t sum = (matrix_q_accum_t)xrow[i] * ((matrix_q_accum_t)1 << lfrac);
+            for (k = i + 1; k < n; ++k)
+            {
+                sum = matrix_q_accum_add(sum, -(matrix_q_accum_t)t[k * n + i] * xrow[k]);
+            }
+            xrow[i] = matrix_q_narrow(sum / t[i * n + i], 0);
+        }
+    }
+}
+
+/**
+* \brief Decomposes a symmetric matrix into U*D*U' with unit upper triangular U and diagonal D.
+* \param[in] mat The symmetric matrix ({\ref n} x {\ref n}); only the upper triangle is read.
+* \param[out] ud The packed factors ({\ref n} * ({\ref n} + 1) / 2).
+* \return Zero in case of success, nonzero if the matrix is not positive definite.
+*/
+int cholesky_decompose_udu(const matrix_t *RESTRICT const mat, matrix_data_t *RESTRICT const ud)
+{
+    int_fast16_t i, j, k;
+    const uint_fast8_t n = mat->rows;
+    const matrix_data_t *RESTRICT const p = mat->data;
+
+    assert(mat->rows == mat->cols);
+
+    // columns are determined from the last to the first
+    for (j = n - 1; j >= 0; --j)
+    {
+        matrix_data_t d = p[j * n + j];
+        for (k = j + 1; k < n; ++k)
+        {
+            const matrix_data_t u = ud[cholesky_packed_index(j, k)];
+            d -= ud[cholesky_packed_index(k, k)] * u * u;
+        }
+
+        if (d <= 0) return 1;
+        ud[cholesky_packed_index(j, j)] = d;
+
+        for (i = 0; i < j; ++i)
+        {
+            matrix_data_t sum = p[i * n + j];
+            for (k = j + 1; k < n; ++k)
+            {
+                sum -= ud[cholesky_packed_index(k, k)] * ud[cholesky_packed_index(i, k)] * ud[cholesky_packed_index(j, k)];
+            }
+            ud[cholesky_packed_index(i, j)] = sum / d;
+        }
+    }
+
+    return 0;
+}
+
+/**
+* \brief Recomposes a symmetric matrix from its packed U*D*U' factors.
+* \param[in] ud The packed factors, as created by {\ref cholesky_decompose_udu}.
+* \param[out] mat The symmetric matrix ({\ref n} x {\ref n}).
+*/
+void cholesky_compose_udu(const matrix_data_t *RESTRICT const ud, const matrix_t *RESTRICT const mat)
+{
+    uint_fast8_t i, j, k;
+    const uint_fast8_t n = mat->rows;
+    matrix_data_t *RESTRICT const p = mat->data;
+
+    assert(mat->rows == mat->cols);
+
+    // P(i,j) = sum over k >= j of U(i,k)*D(k)*U(j,k), with U(k,k) = 1
+    for (j = 0; j < n; ++j)
+    {
+        for (i = 0; i <= j; ++i)
+        {
+            const matrix_data_t d = ud[cholesky_packed_index(j, j)];
+            matrix_data_t total = (i == j) ? d : ud[cholesky_packed_index(i, j)] * d;
+
+            for (k = j + 1; k < n; ++k)
+            {
+                total += ud[cholesky_packed_index(i, k)] * ud[cholesky_packed_index(k, k)] * ud[cholesky_packed_index(j, k)];
+            }
+
+            p[i * n + j] = p[j * n + i] = total;
+        }
+    }
+}
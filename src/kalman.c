@@ -1,5 +1,6 @@
 #include <stdint.h>
 #include <assert.h>
+#include <math.h>
 
 #include "cholesky.h"
 
@@ -20,12 +21,11 @@
 * \param[in] Q The input covariance matrix ({\ref num_inputs} x {\ref num_inputs})
 * \param[in] aux The auxiliary buffer (length {\ref num_states} or {\ref num_inputs}, whichever is greater)
 * \param[in] predictedX The temporary vector for predicted X ({\ref num_states} x \c 1)
-* \param[in] temp_P The temporary matrix for P calculation ({\ref num_states} x {\ref num_states})
 * \param[in] temp_BQ The temporary matrix for BQ calculation ({\ref num_states} x {\ref num_inputs})
 */
 void kalman_filter_initialize(kalman_t *kf, uint_fast8_t num_states, uint_fast8_t num_inputs, matrix_data_t *A, matrix_data_t *x,
     matrix_data_t *B, matrix_data_t *u, matrix_data_t *P, matrix_data_t *Q,
-    matrix_data_t *aux, matrix_data_t *predictedX, matrix_data_t *temp_P, matrix_data_t *temp_BQ)
+    matrix_data_t *aux, matrix_data_t *predictedX, matrix_data_t *temp_BQ)
 {
     matrix_init(&kf->A, num_states, num_states, A);
     matrix_init(&kf->P, num_states, num_states, P);
@@ -41,11 +41,154 @@ void kalman_filter_initialize(kalman_t *kf, uint_fast8_t num_states, uint_fast8_
     // set predicted x vector
     matrix_init(&kf->temporary.predicted_x, num_states, 1, predictedX);
 
-    // set temporary P matrix
-    matrix_init(&kf->temporary.P, num_states, num_states, temp_P);
-
     // set temporary BQ matrix
     matrix_init(&kf->temporary.BQ, num_states, num_inputs, temp_BQ);
+
+    // A is dense until told otherwise
+    kf->A_sparsity.rows = num_states;
+    kf->A_sparsity.offsets = (uint_fast16_t*)0;
+    kf->A_sparsity.columns = (uint_fast8_t*)0;
+
+    // propagate the covariance
+    kf->covariance_frozen = 0;
+
+    // full covariance until told otherwise
+    kf->temporary.sqrt_work = (matrix_data_t*)0;
+    kf->temporary.ud_work = (matrix_data_t*)0;
+}
+
+/*!
+* \brief Enables the sparse prediction by determining the sparsity pattern of the system matrix A.
+* \param[in] kf The Kalman Filter structure
+* \param[in] offsets The buffer for the row offsets (length 2 * {\ref num_states} + 1), or null to disable the sparse prediction
+* \param[in] columns The buffer for the column indices (length {\ref num_states} x {\ref num_states})
+* \return The number of multiplications per row vector product with A
+*/
+uint_fast16_t kalman_filter_set_sparsity(kalman_t *kf, uint_fast16_t *offsets, uint_fast8_t *columns)
+{
+    kf->A_sparsity.offsets = offsets;
+    kf->A_sparsity.columns = columns;
+
+    if (offsets == (uint_fast16_t*)0)
+    {
+        return (uint_fast16_t)kf->A.rows * kf->A.cols;
+    }
+
+    return matrix_sparsity_analyze(&kf->A, &kf->A_sparsity);
+}
+
+/*!
+* \brief Refreshes the sparsity pattern of the system matrix A after its entries changed.
+* \param[in] kf The Kalman Filter structure
+*/
+void kalman_filter_update_sparsity(kalman_t *kf)
+{
+    if (kf->A_sparsity.offsets != (uint_fast16_t*)0)
+    {
+        matrix_sparsity_analyze(&kf->A, &kf->A_sparsity);
+    }
+}
+
+/*!
+* \brief Switches the filter to square root form, i.e. to propagating the lower triangular Cholesky factor of P.
+* \param[in] kf The Kalman Filter structure
+* \param[in] work The work array ({\ref num_states} x ({\ref num_states} + {\ref num_inputs}))
+* \return Zero in case of success, nonzero if P or Q is not positive definite, in which case neither is changed.
+*/
+int kalman_filter_enable_sqrt(kalman_t *kf, matrix_data_t *work)
+{
+    uint_fast8_t i, j;
+    const uint_fast8_t n = kf->P.rows;
+    const uint_fast8_t l = kf->B.cols;
+    matrix_data_t *RESTRICT const Q = kf->Q.data;
+    matrix_t factor;
+
+    assert(work != (matrix_data_t*)0);
+    assert(kf->temporary.ud_work == (matrix_data_t*)0);
+
+    // P is factored in the work array, so that a failure leaves the filter unchanged
+    matrix_init(&factor, n, n, work);
+    matrix_copy(&kf->P, &factor);
+    if (cholesky_decompose_lower(&factor) != 0) return 1;
+
+    // Q is factored in place; a failed decomposition has only overwritten the diagonal and lower triangle
+    if (l > 0)
+    {
+        matrix_data_t *RESTRICT const diagonal = &work[(uint_fast16_t)n * n];
+        for (i = 0; i < l; ++i) { diagonal[i] = Q[i * l + i]; }
+
+        if (cholesky_decompose_lower(&kf->Q) != 0)
+        {
+            for (i = 0; i < l; ++i)
+            {
+                for (j = 0; j < i; ++j) { Q[i * l + j] = Q[j * l + i]; }
+                Q[i * l + i] = diagonal[i];
+            }
+            return 1;
+        }
+    }
+
+    matrix_copy(&factor, &kf->P);
+
+    kf->temporary.sqrt_work = work;
+    return 0;
+}
+
+/*!
+* \brief Switches the filter to UD form, i.e. to propagating P = U*D*U' with unit upper triangular U and diagonal D.
+* \param[in] kf The Kalman Filter structure
+* \param[in] P The initial state covariance ({\ref num_states} x {\ref num_states}); may be the filter's own P.
+* \param[in] work The work array (({\ref num_states} + 1) x ({\ref num_states} + {\ref num_inputs}))
+* \return Zero in case of success, nonzero if P or Q is not positive definite, in which case neither is changed.
+*/
+int kalman_filter_enable_ud(kalman_t *kf, const matrix_t *P, matrix_data_t *work)
+{
+    uint_fast16_t i;
+    const uint_fast8_t n = kf->P.rows;
+    const uint_fast8_t l = kf->B.cols;
+
+    const uint_fast16_t packed_P = ((uint_fast16_t)n * (n + 1)) / 2;
+    const uint_fast16_t packed_Q = ((uint_fast16_t)l * (l + 1)) / 2;
+    matrix_data_t *RESTRICT const ud_Q = &work[packed_P];
+
+    assert(work != (matrix_data_t*)0);
+    assert(P->rows == n && P->cols == n);
+    assert(kf->temporary.sqrt_work == (matrix_data_t*)0);
+
+    // the work array holds both packed factors, so that a failure leaves the filter unchanged
+    assert(packed_P + packed_Q <= (uint_fast16_t)(n + 1) * (n + l));
+
+    if (cholesky_decompose_udu(P, work) != 0) return 1;
+    if (l > 0 && cholesky_decompose_udu(&kf->Q, ud_Q) != 0) return 1;
+
+    for (i = 0; i < packed_P; ++i) { kf->P.data[i] = work[i]; }
+    for (i = 0; i < packed_Q; ++i) { kf->Q.data[i] = ud_Q[i]; }
+
+    kf->temporary.ud_work = work;
+    return 0;
+}
+
+/*!
+* \brief Gets the state covariance matrix, regardless of whether the filter is in square root or UD form.
+* \param[in] kf The Kalman Filter structure
+* \param[out] P The state covariance ({\ref num_states} x {\ref num_states}), must not be aliased with the filter's P
+*/
+void kalman_filter_get_covariance(const kalman_t *kf, matrix_t *P)
+{
+    if (kf->temporary.sqrt_work != (matrix_data_t*)0)
+    {
+        // P = L*L'
+        matrix_mult_transb(&kf->P, &kf->P, P);
+    }
+    else if (kf->temporary.ud_work != (matrix_data_t*)0)
+    {
+        // P = U*D*U'
+        cholesky_compose_udu(kf->P.data, P);
+    }
+    else
+    {
+        matrix_copy(&kf->P, P);
+    }
 }
 
 
@@ -61,14 +204,11 @@ void kalman_filter_initialize(kalman_t *kf, uint_fast8_t num_states, uint_fast8_
 * \param[in] S The residual covariance ({\ref num_measurements} x {\ref num_measurements})
 * \param[in] K The Kalman gain ({\ref num_states} x {\ref num_measurements})
 * \param[in] aux The auxiliary buffer (length {\ref num_states} or {\ref num_measurements}, whichever is greater)
-* \param[in] S_inv The temporary matrix for the inverted residual covariance  ({\ref num_measurements} x {\ref num_measurements})
 * \param[in] temp_HP The temporary matrix for HxP ({\ref num_measurements} x {\ref num_states})
-* \param[in] temp_PHt The temporary matrix for PxH' ({\ref num_states} x {\ref num_measurements})
-* \param[in] temp_KHP The temporary matrix for KxHxP ({\ref num_states} x {\ref num_states})
 */
 void kalman_measurement_initialize(kalman_measurement_t *kfm, uint_fast8_t num_states, uint_fast8_t num_measurements, matrix_data_t *H, matrix_data_t *z, matrix_data_t *R,
     matrix_data_t *y, matrix_data_t *S, matrix_data_t *K,
-    matrix_data_t *aux, matrix_data_t *S_inv, matrix_data_t *temp_HP, matrix_data_t *temp_PHt, matrix_data_t *temp_KHP)
+    matrix_data_t *aux, matrix_data_t *temp_HP)
 {
     matrix_init(&kfm->H, num_measurements, num_states, H);
     matrix_init(&kfm->R, num_measurements, num_measurements, R);
@@ -81,17 +221,101 @@ void kalman_measurement_initialize(kalman_measurement_t *kfm, uint_fast8_t num_s
     // set auxiliary vector
     kfm->temporary.aux = aux;
 
-    // set inverted S matrix
-    matrix_init(&kfm->temporary.S_inv, num_measurements, num_measurements, S_inv);
-
     // set temporary HxP matrix
     matrix_init(&kfm->temporary.HP, num_measurements, num_states, temp_HP);
 
-    // set temporary PxH' matrix
-    matrix_init(&kfm->temporary.PHt, num_states, num_measurements, temp_PHt);
+    // single precision gain by default
+    kfm->temporary.wide = (matrix_wide_t*)0;
+
+    // full covariance correction by default
+    kfm->temporary.sqrt_work = (matrix_data_t*)0;
 
-    // set temporary KxHxP matrix
-    matrix_init(&kfm->temporary.KHP, num_states, num_states, temp_KHP);
+    // no steady state detection by default
+    kfm->steady_state.K_previous = (matrix_data_t*)0;
+    kfm->steady_state.tolerance = 0;
+    kfm->steady_state.frozen = 0;
+    kfm->steady_state.updates = 0;
+}
+
+/*!
+* \brief Enables or disables the mixed precision correction of a measurement.
+* \param[in] kfm The Kalman Filter measurement structure
+* \param[in] wide The double precision workspace ({\ref num_measurements} x ({\ref num_measurements} + 1)), or null to disable
+*/
+void kalman_measurement_set_mixed_precision(kalman_measurement_t *kfm, matrix_wide_t *wide)
+{
+    kfm->temporary.wide = wide;
+}
+
+/*!
+* \brief Enables the steady state detection of the Kalman gain.
+* \param[in] kfm The Kalman Filter measurement structure
+* \param[in] K_previous The buffer for the previous gain ({\ref num_states} x {\ref num_measurements}), or null to disable
+* \param[in] tolerance The largest absolute change of any gain element between two corrections that counts as converged
+*/
+void kalman_measurement_enable_steady_state(kalman_measurement_t *kfm, matrix_data_t *K_previous, matrix_data_t tolerance)
+{
+    assert(tolerance >= 0);
+
+    kfm->steady_state.K_previous = K_previous;
+    kfm->steady_state.tolerance = tolerance;
+    kfm->steady_state.frozen = 0;
+    kfm->steady_state.updates = 0;
+}
+
+/*!
+* \brief Leaves steady state, e.g. after A, B, Q, H or R have changed.
+* \param[in] kf The Kalman Filter structure
+* \param[in] kfm The Kalman Filter measurement structure
+*/
+void kalman_steady_state_reset(kalman_t *kf, kalman_measurement_t *kfm)
+{
+    kf->covariance_frozen = 0;
+    kfm->steady_state.frozen = 0;
+    kfm->steady_state.updates = 0;
+}
+
+/*!
+* \brief Compares the gain of a full correction against the previous one and freezes it once converged.
+* \param[in] kf The Kalman Filter structure
+* \param[in] kfm The Kalman Filter measurement structure with the steady state detection enabled
+*/
+static void kalman_steady_state_detect(kalman_t *kf, kalman_measurement_t *kfm)
+{
+    uint_fast16_t i;
+    const uint_fast16_t count = kfm->K.rows * kfm->K.cols;
+    const matrix_data_t *RESTRICT const K = kfm->K.data;
+    matrix_data_t *RESTRICT const K_previous = kfm->steady_state.K_previous;
+    uint_fast8_t converged = (kfm->steady_state.updates > 0);
+
+    for (i = 0; i < count; ++i)
+    {
+        if (fabs(K[i] - K_previous[i]) > kfm->steady_state.tolerance) converged = 0;
+        K_previous[i] = K[i];
+    }
+
+    ++kfm->steady_state.updates;
+    if (converged)
+    {
+        kfm->steady_state.frozen = 1;
+        kf->covariance_frozen = 1;
+    }
+}
+
+/*!
+* \brief Prepares a measurement for the correction of a filter in square root form.
+* \param[in] kfm The Kalman Filter measurement structure
+* \param[in] work The work array (({\ref num_measurements} + {\ref num_states}) x ({\ref num_measurements} + {\ref num_states}))
+* \return Zero in case of success, nonzero if R is not positive definite.
+*/
+int kalman_measurement_enable_sqrt(kalman_measurement_t *kfm, matrix_data_t *work)
+{
+    assert(work != (matrix_data_t*)0);
+
+    if (cholesky_decompose_lower(&kfm->R) != 0) return 1;
+
+    kfm->temporary.sqrt_work = work;
+    return 0;
 }
 
 /*!
@@ -113,15 +337,177 @@ void kalman_predict_x(register kalman_t *const kf)
     /************************************************************************/
 
     // x = A*x
-    matrix_mult_rowvector(A, x, xpredicted);
+    if (kf->A_sparsity.offsets != (uint_fast16_t*)0)
+    {
+        matrix_mult_rowvector_sparse(A, &kf->A_sparsity, x, xpredicted);
+    }
+    else
+    {
+        matrix_mult_rowvector(A, x, xpredicted);
+    }
     matrix_copy(xpredicted, x);
 }
 
 /*!
-* \brief Performs the time update / prediction step of only the state covariance matrix
+* \brief Propagates the lower triangular factor L of the state covariance such that L*L' = A*L*L'*A' * scale^2 + B*Q*B'
+* \param[in] kf The Kalman Filter structure in square root form to predict with.
+* \param[in] scale The scaling factor for A*L
+*
+* The pre-array [A*L*scale, B*sqrt(Q)] is triangularized with Givens rotations; its lower triangular
+* part is the new factor.
+*/
+static void kalman_propagate_sqrt(register kalman_t *const kf, const matrix_data_t scale)
+{
+    uint_fast8_t i, j, k;
+    const uint_fast8_t n = kf->P.rows;
+    const uint_fast8_t l = kf->B.cols;
+    const uint_fast8_t w = n + l;
+
+    const matrix_data_t *RESTRICT const A = kf->A.data;
+    const matrix_data_t *RESTRICT const B = kf->B.data;
+    const matrix_data_t *RESTRICT const Qs = kf->Q.data;
+    matrix_data_t *RESTRICT const L = kf->P.data;
+    matrix_data_t *RESTRICT const M = kf->temporary.sqrt_work;
+    matrix_t pre;
+
+    // M = [A*L*scale, B*sqrt(Q)], exploiting the zeros of both factors
+    for (i = 0; i < n; ++i)
+    {
+        for (j = 0; j < n; ++j)
+        {
+            matrix_data_t total = 0;
+            for (k = j; k < n; ++k)
+            {
+                total += A[i * n + k] * L[k * n + j];
+            }
+            M[i * w + j] = total * scale;
+        }
+
+        for (j = 0; j < l; ++j)
+        {
+            matrix_data_t total = 0;
+            for (k = j; k < l; ++k)
+            {
+                total += B[i * l + k] * Qs[k * l + j];
+            }
+            M[i * w + n + j] = total;
+        }
+    }
+
+    // M = [L 0] * Q'
+    matrix_init(&pre, n, w, M);
+    matrix_triangularize_lower(&pre);
+
+    for (i = 0; i < n; ++i)
+    {
+        for (j = 0; j < n; ++j)
+        {
+            L[i * n + j] = (j <= i) ? M[i * w + j] : 0;
+        }
+    }
+}
+
+/*!
+* \brief Propagates the UD factors of the state covariance such that U*D*U' = A*U*D*U'*A' * scale + B*Q*B'
+* \param[in] kf The Kalman Filter structure in UD form to predict with.
+* \param[in] scale The scaling factor for A*U*D*U'*A'
+*
+* Thornton's modified weighted Gram-Schmidt orthogonalization of the rows of W = [A*U, B*Uq] with
+* respect to the weights [D*scale, Dq], where Q = Uq*Dq*Uq'.
+*/
+static void kalman_propagate_ud(register kalman_t *const kf, const matrix_data_t scale)
+{
+    int_fast16_t i, j, k;
+    const uint_fast8_t n = kf->P.rows;
+    const uint_fast8_t l = kf->B.cols;
+    const uint_fast8_t w = n + l;
+
+    const matrix_data_t *RESTRICT const A = kf->A.data;
+    const matrix_data_t *RESTRICT const B = kf->B.data;
+    const matrix_data_t *RESTRICT const qd = kf->Q.data;
+    matrix_data_t *RESTRICT const ud = kf->P.data;
+    matrix_data_t *RESTRICT const W = kf->temporary.ud_work;
+    matrix_data_t *RESTRICT const Dw = &W[n * w];
+
+    // W = [A*U, B*Uq], using the implied unit diagonals
+    for (i = 0; i < n; ++i)
+    {
+        for (j = 0; j < n; ++j)
+        {
+            matrix_data_t total = A[i * n + j];
+            for (k = 0; k < j; ++k)
+            {
+                total += A[i * n + k] * ud[cholesky_packed_index(k, j)];
+            }
+            W[i * w + j] = total;
+        }
+
+        for (j = 0; j < l; ++j)
+        {
+            matrix_data_t total = B[i * l + j];
+            for (k = 0; k < j; ++k)
+            {
+                total += B[i * l + k] * qd[cholesky_packed_index(k, j)];
+            }
+            W[i * w + n + j] = total;
+        }
+    }
+
+    // Dw = [D*scale, Dq]
+    for (j = 0; j < n; ++j) { Dw[j] = ud[cholesky_packed_index(j, j)] * scale; }
+    for (j = 0; j < l; ++j) { Dw[n + j] = qd[cholesky_packed_index(j, j)]; }
+
+    // orthogonalize the rows from the last to the first
+    for (k = n - 1; k >= 0; --k)
+    {
+        const matrix_data_t *RESTRICT const wk = &W[k * w];
+        matrix_data_t sigma = 0;
+
+        for (j = 0; j < w; ++j)
+        {
+            sigma += Dw[j] * wk[j] * wk[j];
+        }
+        ud[cholesky_packed_index(k, k)] = sigma;
+
+        // a row without weight, e.g. of a state the transition resets, leaves nothing to project out
+        if (sigma <= 0)
+        {
+            for (i = 0; i < k; ++i) { ud[cholesky_packed_index(i, k)] = 0; }
+            continue;
+        }
+
+        for (i = 0; i < k; ++i)
+        {
+            matrix_data_t *RESTRICT const wi = &W[i * w];
+            matrix_data_t total = 0;
+            matrix_data_t u;
+
+            for (j = 0; j < w; ++j)
+            {
+                total += Dw[j] * wi[j] * wk[j];
+            }
+
+            u = total / sigma;
+            ud[cholesky_packed_index(i, k)] = u;
+
+            for (j = 0; j < w; ++j)
+            {
+                wi[j] -= u * wk[j];
+            }
+        }
+    }
+}
+
+/*!
+* \brief Propagates the state covariance such that P = A*P*A' * scale + B*Q*B'
 * \param[in] kf The Kalman Filter structure to predict with.
+* \param[in] scale The scaling factor for A*P*A'
+*
+* The product is formed in place without a P-sized temporary and only the lower
+* triangle of the symmetric result is calculated. If a sparsity pattern of A is set,
+* the zero and unit entries of A are skipped.
 */
-void kalman_predict_Q(register kalman_t *const kf)
+static void kalman_propagate_covariance(register kalman_t *const kf, const matrix_data_t scale)
 {
     // matrices and vectors
     const matrix_t *RESTRICT const A = &kf->A;
@@ -130,23 +516,38 @@ void kalman_predict_Q(register kalman_t *const kf)
 
     // temporaries
     matrix_data_t *RESTRICT const aux = kf->temporary.aux;
-    matrix_t *RESTRICT const P_temp = &kf->temporary.P;
-    matrix_t *RESTRICT const BQ_temp = &kf->temporary.BQ;
+    const matrix_t *RESTRICT BQ = (matrix_t*)0;
 
-    /************************************************************************/
-    /* Predict next covariance using system dynamics and input              */
-    /* P = A*P*A' + B*Q*B'                                                  */
-    /************************************************************************/
+    // the covariance is at steady state
+    if (kf->covariance_frozen) return;
 
-    // P = A*P*A'
-    matrix_mult(A, P, P_temp, aux);                 // temp = A*P
-    matrix_mult_transb(P_temp, A, P);               // P = temp*A'
+    // propagate the factors instead
+    if (kf->temporary.sqrt_work != (matrix_data_t*)0)
+    {
+        kalman_propagate_sqrt(kf, (matrix_data_t)sqrt(scale));
+        return;
+    }
+    if (kf->temporary.ud_work != (matrix_data_t*)0)
+    {
+        kalman_propagate_ud(kf, scale);
+        return;
+    }
 
-    // P = P + B*Q*B'
-    if (kf->B.rows > 0)
+    // temp = B*Q
+    if (kf->B.cols > 0)
     {
-        matrix_mult(B, &kf->Q, BQ_temp, aux);       // temp = B*Q
-        matrix_multadd_transb(BQ_temp, B, P);       // P += temp*B'
+        matrix_mult(B, &kf->Q, &kf->temporary.BQ, aux);
+        BQ = &kf->temporary.BQ;
+    }
+
+    // P = A*P*A' * scale + temp*B'
+    if (kf->A_sparsity.offsets != (uint_fast16_t*)0)
+    {
+        matrix_mult_abat_sparse(A, &kf->A_sparsity, P, scale, BQ, B, aux);
+    }
+    else
+    {
+        matrix_mult_abat(A, P, scale, BQ, B, aux);
     }
 }
 
@@ -154,18 +555,22 @@ void kalman_predict_Q(register kalman_t *const kf)
 * \brief Performs the time update / prediction step of only the state covariance matrix
 * \param[in] kf The Kalman Filter structure to predict with.
 */
-void kalman_predict_Q_tuned(register kalman_t *const kf, matrix_data_t lambda)
+void kalman_predict_Q(register kalman_t *const kf)
 {
-    // matrices and vectors
-    const matrix_t *RESTRICT const A = &kf->A;
-    const matrix_t *RESTRICT const B = &kf->B;
-    matrix_t *RESTRICT const P = &kf->P;
+    /************************************************************************/
+    /* Predict next covariance using system dynamics and input              */
+    /* P = A*P*A' + B*Q*B'                                                  */
+    /************************************************************************/
 
-    // temporaries
-    matrix_data_t *RESTRICT const aux = kf->temporary.aux;
-    matrix_t *RESTRICT const P_temp = &kf->temporary.P;
-    matrix_t *RESTRICT const BQ_temp = &kf->temporary.BQ;
+    kalman_propagate_covariance(kf, 1);
+}
 
+/*!
+* \brief Performs the time update / prediction step of only the state covariance matrix
+* \param[in] kf The Kalman Filter structure to predict with.
+*/
+void kalman_predict_Q_tuned(register kalman_t *const kf, matrix_data_t lambda)
+{
     /************************************************************************/
     /* Predict next covariance using system dynamics and input              */
     /* P = A*P*A' * 1/lambda^2 + B*Q*B'                                     */
@@ -174,23 +579,226 @@ void kalman_predict_Q_tuned(register kalman_t *const kf, matrix_data_t lambda)
     // lambda = 1/lambda^2
     lambda = (matrix_data_t)1.0 / (lambda * lambda); // TODO: This should be precalculated, e.g. using kalman_set_lambda(...);
 
-    // P = A*P*A'
-    matrix_mult(A, P, P_temp, aux);                 // temp = A*P
-    matrix_multscale_transb(P_temp, A, lambda, P);   // P = temp*A' * 1/(lambda^2)
+    kalman_propagate_covariance(kf, lambda);
+}
 
-    // P = P + B*Q*B'
-    if (kf->B.rows > 0)
+/*!
+* \brief Calculates the Kalman gain K = (H*P)' * S^-1 with S accumulated, factored and substituted in double precision.
+* \param[in] kfm The measurement whose temporary HP holds H*P.
+*/
+static void kalman_gain_mixed(kalman_measurement_t *kfm)
+{
+    uint_fast8_t i, j, k;
+    const uint_fast8_t m = kfm->H.rows;
+    const uint_fast8_t n = kfm->H.cols;
+
+    const matrix_data_t *RESTRICT const H = kfm->H.data;
+    const matrix_data_t *RESTRICT const R = kfm->R.data;
+    const matrix_data_t *RESTRICT const HP = kfm->temporary.HP.data;
+    matrix_data_t *RESTRICT const S = kfm->S.data;
+    matrix_wide_t *RESTRICT const L = kfm->temporary.wide;
+
+    // S = H*P*H' + R, lower triangle
+    for (i = 0; i < m; ++i)
     {
-        matrix_mult(B, &kf->Q, BQ_temp, aux);       // temp = B*Q
-        matrix_multadd_transb(BQ_temp, B, P);        // P += temp*B'
+        for (j = 0; j <= i; ++j)
+        {
+            matrix_wide_t total = R[i * m + j];
+            for (k = 0; k < n; ++k)
+            {
+                total += (matrix_wide_t)HP[i * n + k] * H[j * n + k];
+            }
+            L[i * m + j] = total;
+        }
+    }
+
+    // K = (H*P)' * S^-1
+    cholesky_decompose_lower_wide(L, m);
+    cholesky_solve_transb_wide(L, &kfm->temporary.HP, &kfm->K, &L[m * m]);
+
+    for (i = 0; i < m * m; ++i)
+    {
+        S[i] = (matrix_data_t)L[i];
     }
 }
 
 /*!
-* \brief Performs the measurement update step.
+* \brief Performs the measurement update step of a filter in square root form as a triangular array update.
 * \param[in] kf The Kalman Filter structure to correct.
+* \param[in] kfm The measurement to correct with, holding the innovation in y.
+*
+* The pre-array [sqrt(R) H*L; 0 L] is triangularized into [sqrt(S) 0; K*sqrt(S) L+],
+* where L+ is the factor of the corrected covariance.
 */
-void kalman_correct(kalman_t *kf, kalman_measurement_t *kfm)
+static void kalman_correct_sqrt(kalman_t *kf, kalman_measurement_t *kfm)
+{
+    int_fast16_t i, j, k;
+    const uint_fast8_t n = kf->P.rows;
+    const uint_fast8_t m = kfm->H.rows;
+    const uint_fast8_t w = m + n;
+
+    const matrix_data_t *RESTRICT const H = kfm->H.data;
+    const matrix_data_t *RESTRICT const Rs = kfm->R.data;
+    matrix_data_t *RESTRICT const L = kf->P.data;
+    matrix_data_t *RESTRICT const Ss = kfm->S.data;
+    matrix_data_t *RESTRICT const K = kfm->K.data;
+    matrix_data_t *RESTRICT const M = kfm->temporary.sqrt_work;
+    matrix_t pre;
+
+    assert(M != (matrix_data_t*)0);
+
+    // M = [sqrt(R) H*L; 0 L]
+    for (i = 0; i < m; ++i)
+    {
+        for (j = 0; j < m; ++j)
+        {
+            M[i * w + j] = Rs[i * m + j];
+        }
+
+        for (j = 0; j < n; ++j)
+        {
+            matrix_data_t total = 0;
+            for (k = j; k < n; ++k)
+            {
+                total += H[i * n + k] * L[k * n + j];
+            }
+            M[i * w + m + j] = total;
+        }
+    }
+
+    for (i = 0; i < n; ++i)
+    {
+        for (j = 0; j < m; ++j)
+        {
+            M[(m + i) * w + j] = 0;
+        }
+
+        for (j = 0; j < n; ++j)
+        {
+            M[(m + i) * w + m + j] = L[i * n + j];
+        }
+    }
+
+    // M = [sqrt(S) 0; K*sqrt(S) L+]
+    matrix_init(&pre, w, w, M);
+    matrix_triangularize_lower(&pre);
+
+    for (i = 0; i < m; ++i)
+    {
+        for (j = 0; j < m; ++j)
+        {
+            Ss[i * m + j] = M[i * w + j];
+        }
+    }
+
+    // K = (K*sqrt(S)) * sqrt(S)^-1; each row solves k*sqrt(S) = kb by back substitution
+    for (i = 0; i < n; ++i)
+    {
+        const matrix_data_t *RESTRICT const kb = &M[(m + i) * w];
+        matrix_data_t *RESTRICT const krow = &K[i * m];
+
+        for (j = m - 1; j >= 0; --j)
+        {
+            matrix_data_t sum = kb[j];
+            for (k = j + 1; k < m; ++k)
+            {
+                sum -= krow[k] * Ss[k * m + j];
+            }
+            krow[j] = sum / Ss[j * m + j];
+        }
+
+        // L = L+
+        for (j = 0; j < n; ++j)
+        {
+            L[i * n + j] = (j <= i) ? M[(m + i) * w + m + j] : 0;
+        }
+    }
+
+    // x = x + K*y
+    matrix_multadd_rowvector(&kfm->K, &kfm->y, &kf->x);
+}
+
+/*!
+* \brief Performs the measurement update step of a filter in UD form as a sequence of Bierman scalar updates.
+* \param[in] kf The Kalman Filter structure to correct.
+* \param[in] kfm The measurement to correct with. R must be diagonal.
+*/
+static void kalman_correct_ud(kalman_t *kf, kalman_measurement_t *kfm)
+{
+    uint_fast8_t i, j, k;
+    const uint_fast8_t n = kf->P.rows;
+    const uint_fast8_t m = kfm->H.rows;
+
+    matrix_data_t *RESTRICT const ud = kf->P.data;
+    matrix_data_t *RESTRICT const x = kf->x.data;
+    const matrix_data_t *RESTRICT const H = kfm->H.data;
+    const matrix_data_t *RESTRICT const R = kfm->R.data;
+    const matrix_data_t *RESTRICT const z = kfm->z.data;
+    matrix_data_t *RESTRICT const K = kfm->K.data;
+    matrix_data_t *RESTRICT const y = kfm->y.data;
+
+    // temporaries
+    matrix_data_t *RESTRICT const f = kf->temporary.ud_work;
+    matrix_data_t *RESTRICT const b = &f[n];
+
+    for (i = 0; i < m; ++i)
+    {
+        const matrix_data_t *RESTRICT const h = &H[i * n];
+        matrix_data_t alpha = R[i * m + i];
+        matrix_data_t hx = 0;
+
+        // f = U'*h', hx = h*x
+        for (j = 0; j < n; ++j)
+        {
+            matrix_data_t total = h[j];
+            for (k = 0; k < j; ++k)
+            {
+                total += ud[cholesky_packed_index(k, j)] * h[k];
+            }
+            f[j] = total;
+            hx += h[j] * x[j];
+        }
+
+        // y = z - h*x
+        y[i] = z[i] - hx;
+
+        // update D and U column by column while accumulating the unscaled gain b = U*D*f
+        for (j = 0; j < n; ++j)
+        {
+            const matrix_data_t d = ud[cholesky_packed_index(j, j)];
+            const matrix_data_t v = d * f[j];
+            const matrix_data_t beta = alpha;
+            matrix_data_t lambda;
+
+            alpha += f[j] * v;
+            lambda = -f[j] / beta;
+            ud[cholesky_packed_index(j, j)] = d * beta / alpha;
+
+            b[j] = v;
+            for (k = 0; k < j; ++k)
+            {
+                const matrix_data_t u = ud[cholesky_packed_index(k, j)];
+                ud[cholesky_packed_index(k, j)] = u + b[k] * lambda;
+                b[k] += u * v;
+            }
+        }
+
+        // k = b / alpha, x = x + k*y
+        for (j = 0; j < n; ++j)
+        {
+            const matrix_data_t gain = b[j] / alpha;
+            K[j * m + i] = gain;
+            x[j] += gain * y[i];
+        }
+    }
+}
+
+/*!
+* \brief Performs the measurement update step with the innovation y already calculated.
+* \param[in] kf The Kalman Filter structure to correct.
+* \param[in] kfm The measurement to correct with, holding the innovation in y.
+*/
+void kalman_correct_innovation(kalman_t *kf, kalman_measurement_t *kfm)
 {
     matrix_t *RESTRICT const P = &kf->P;
     const matrix_t *RESTRICT const H = &kfm->H;
@@ -201,37 +809,59 @@ void kalman_correct(kalman_t *kf, kalman_measurement_t *kfm)
 
     // temporaries
     matrix_data_t *RESTRICT const aux = kfm->temporary.aux;
-    matrix_t *RESTRICT const Sinv = &kfm->temporary.S_inv;
     matrix_t *RESTRICT const temp_HP = &kfm->temporary.HP;
-    matrix_t *RESTRICT const temp_KHP = &kfm->temporary.KHP;
-    matrix_t *RESTRICT const temp_PHt = &kfm->temporary.PHt;
 
-    /************************************************************************/
-    /* Calculate innovation and residual covariance                         */
-    /* y = z - H*x                                                          */
-    /* S = H*P*H' + R                                                       */
-    /************************************************************************/
+    // the scalar updates of the UD factors need the innovation against the partially corrected state
+    assert(kf->temporary.ud_work == (matrix_data_t*)0);
 
-    // y = z - H*x
-    matrix_mult_rowvector(H, x, y);
-    matrix_sub_inplace_b(&kfm->z, y);
+    // at steady state, only the state is corrected with the frozen gain
+    if (kfm->steady_state.frozen)
+    {
+        if (kf->covariance_frozen)
+        {
+            matrix_multadd_rowvector(K, y, x);
+            return;
+        }
+
+        // the filter has left steady state, so the gain is calculated again
+        kfm->steady_state.frozen = 0;
+        kfm->steady_state.updates = 0;
+    }
+
+    // the factor is updated as a whole
+    if (kf->temporary.sqrt_work != (matrix_data_t*)0)
+    {
+        kalman_correct_sqrt(kf, kfm);
+        return;
+    }
 
-    // S = H*P*H' + R
-    matrix_mult(H, P, temp_HP, aux);            // temp = H*P
-    matrix_mult_transb(temp_HP, H, S);          // S = temp*H'
-    matrix_add_inplace(S, &kfm->R);             // S += R
+    // temp = H*P
+    matrix_mult(H, P, temp_HP, aux);
 
     /************************************************************************/
-    /* Calculate Kalman gain                                                */
+    /* Calculate residual covariance and Kalman gain                        */
+    /* S = H*P*H' + R                                                       */
     /* K = P*H' * S^-1                                                      */
+    /*                                                                      */
+    /* S is never inverted; since P is symmetric, P*H' = (H*P)' and K is   */
+    /* found by substituting against the Cholesky factor of S.             */
     /************************************************************************/
 
-    // K = P*H' * S^-1
-    cholesky_decompose_lower(S);
-    matrix_invert_lower(S, Sinv);               // Sinv = S^-1
-    // NOTE that to allow aliasing of Sinv and temp_PHt, a copy must be performed here
-    matrix_mult_transb(P, H, temp_PHt);         // temp = P*H'
-    matrix_mult(temp_PHt, Sinv, K, aux);        // K = temp*Sinv
+    if (kfm->temporary.wide != (matrix_wide_t*)0)
+    {
+        // S and K in double precision
+        kalman_gain_mixed(kfm);
+    }
+    else
+    {
+        // S = H*P*H' + R
+        matrix_mult_transb_symmetric(temp_HP, H, S);    // S = temp*H', lower triangle mirrored
+        matrix_add_inplace(S, &kfm->R);             // S += R
+
+        // K = (H*P)' * S^-1
+        cholesky_decompose_lower(S);                // S = L*L'
+        cholesky_solve_transb(S, temp_HP, K);       // K*L*L' = temp'
+    }
 
     /************************************************************************/
     /* Correct state prediction                                             */
@@ -241,6 +871,13 @@ void kalman_correct(kalman_t *kf, kalman_measurement_t *kfm)
     // x = x + K*y
     matrix_multadd_rowvector(K, y, x);
 
+    // another measurement froze the covariance, so this gain is frozen as well
+    if (kf->covariance_frozen)
+    {
+        kfm->steady_state.frozen = 1;
+        return;
+    }
+
     /************************************************************************/
     /* Correct state covariances                                            */
     /* P = (I-K*H) * P                                                      */
@@ -248,7 +885,124 @@ void kalman_correct(kalman_t *kf, kalman_measurement_t *kfm)
     /************************************************************************/
 
     // P = P - K*(H*P)
-    matrix_mult(H, P, temp_HP, aux);            // temp_HP = H*P
-    matrix_mult(K, temp_HP, temp_KHP, aux);     // temp_KHP = K*temp_HP
-    matrix_sub(P, temp_KHP, P);                 // P -= temp_KHP
+    matrix_multsub_symmetric(K, temp_HP, P);    // P -= K*temp_HP
+
+    // freeze the gain once it has converged
+    if (kfm->steady_state.K_previous != (matrix_data_t*)0)
+    {
+        kalman_steady_state_detect(kf, kfm);
+    }
+}
+
+/*!
+* \brief Performs the measurement update step.
+* \param[in] kf The Kalman Filter structure to correct.
+* \param[in] kfm The measurement to correct with.
+*/
+void kalman_correct(kalman_t *kf, kalman_measurement_t *kfm)
+{
+    // the UD factors are updated one measurement at a time
+    if (kf->temporary.ud_work != (matrix_data_t*)0)
+    {
+        kalman_correct_ud(kf, kfm);
+        return;
+    }
+
+    /************************************************************************/
+    /* Calculate innovation                                                 */
+    /* y = z - H*x                                                          */
+    /************************************************************************/
+
+    // y = z - H*x
+    matrix_mult_rowvector(&kfm->H, &kf->x, &kfm->y);
+    matrix_sub_inplace_b(&kfm->z, &kfm->y);
+
+    kalman_correct_innovation(kf, kfm);
+}
+
+/*!
+* \brief Performs the measurement update step as a sequence of scalar updates.
+* \param[in] kf The Kalman Filter structure to correct.
+* \param[in] kfm The measurement to correct with. R must be diagonal.
+*/
+void kalman_correct_sequential(kalman_t *kf, kalman_measurement_t *kfm)
+{
+    uint_fast8_t i, r, c;
+    const uint_fast8_t n = kf->P.rows;
+    const uint_fast8_t m = kfm->H.rows;
+
+    matrix_data_t *RESTRICT const P = kf->P.data;
+    matrix_data_t *RESTRICT const x = kf->x.data;
+    const matrix_data_t *RESTRICT const H = kfm->H.data;
+    const matrix_data_t *RESTRICT const R = kfm->R.data;
+    const matrix_data_t *RESTRICT const z = kfm->z.data;
+    matrix_data_t *RESTRICT const K = kfm->K.data;
+    matrix_data_t *RESTRICT const y = kfm->y.data;
+
+    // temporaries
+    matrix_data_t *RESTRICT const PHt = kfm->temporary.aux;
+
+    assert(kfm->H.cols == n);
+    assert(kfm->K.rows == n && kfm->K.cols == m);
+    assert(kf->temporary.sqrt_work == (matrix_data_t*)0);
+    assert(kfm->steady_state.K_previous == (matrix_data_t*)0 && !kfm->steady_state.frozen);
+    assert(!kf->covariance_frozen);
+
+    if (kf->temporary.ud_work != (matrix_data_t*)0)
+    {
+        kalman_correct_ud(kf, kfm);
+        return;
+    }
+
+    /************************************************************************/
+    /* With a diagonal R, the measurements are independent and can be      */
+    /* processed one at a time. Each scalar update only needs the column   */
+    /* P*h' and results in a rank-1 downdate of P; neither S nor its       */
+    /* factorization are required.                                          */
+    /************************************************************************/
+
+    for (i = 0; i < m; ++i)
+    {
+        const matrix_data_t *RESTRICT const h = &H[i * n];
+        matrix_data_t s = R[i * m + i];
+        matrix_data_t hx = 0;
+        matrix_data_t inv_s;
+
+        // PHt = P*h', s = h*P*h' + r, hx = h*x
+        for (r = 0; r < n; ++r)
+        {
+            matrix_data_t total = 0;
+            for (c = 0; c < n; ++c)
+            {
+                total += P[r * n + c] * h[c];
+            }
+            PHt[r] = total;
+            s += h[r] * total;
+            hx += h[r] * x[r];
+        }
+
+        // y = z - h*x
+        y[i] = z[i] - hx;
+
+        // k = P*h' / s, x = x + k*y
+        inv_s = (matrix_data_t)1.0 / s;
+        for (r = 0; r < n; ++r)
+        {
+            const matrix_data_t gain = PHt[r] * inv_s;
+            K[r * m + i] = gain;
+            x[r] += gain * y[i];
+        }
+
+        // P = P - k*(h*P), lower triangle mirrored
+        for (r = 0; r < n; ++r)
+        {
+            const matrix_data_t gain = K[r * m + i];
+            for (c = 0; c < r; ++c)
+            {
+                P[r * n + c] -= gain * PHt[c];
+                P[c * n + r] = P[r * n + c];
+            }
+            P[r * n + r] -= gain * PHt[r];
+        }
+    }
 }
@@ -0,0 +1,471 @@
+#include <stdint.h>
+#include <assert.h>
+#include <math.h>
+
+#define EXTERN_INLINE_MATRIX static INLINE
+#define EXTERN_INLINE_KALMAN static INLINE
+#include "kalman_bank.h"
+
+/*!
+* \brief Initializes a Kalman filter bank.
+* \param[in] bank The bank to initialize
+* \param[in] count The number of filters in the bank
+* \param[in] model The filter providing the shared A, B and Q matrices and the dimensions
+* \param[in] measurement The measurement providing the shared H and R matrices
+* \param[in] x The interleaved state vectors ({\ref num_states} x {\ref count})
+* \param[in] P The interleaved state covariances ({\ref num_states} * {\ref num_states} x {\ref count})
+* \param[in] z The interleaved measurement vectors ({\ref num_measurements} x {\ref count})
+* \param[in] y The interleaved innovation vectors ({\ref num_measurements} x {\ref count})
+* \param[in] S The interleaved residual covariances ({\ref num_measurements} * {\ref num_measurements} x {\ref count})
+* \param[in] K The interleaved Kalman gains ({\ref num_states} * {\ref num_measurements} x {\ref count})
+* \param[in] work The interleaved work buffer (MAX({\ref num_states}, {\ref num_measurements}) * {\ref num_states} x {\ref count})
+* \param[in] mask The mask buffer (length {\ref count})
+*/
+void kalman_bank_initialize(kalman_bank_t *bank, uint_fast16_t count, kalman_t *model, kalman_measurement_t *measurement,
+    matrix_data_t *x, matrix_data_t *P, matrix_data_t *z, matrix_data_t *y, matrix_data_t *S, matrix_data_t *K,
+    matrix_data_t *work, matrix_data_t *mask)
+{
+    uint_fast16_t f;
+
+    assert(count > 0);
+    assert(measurement->H.cols == model->A.rows);
+
+    bank->count = count;
+    bank->model = model;
+    bank->measurement = measurement;
+
+    bank->x = x;
+    bank->P = P;
+    bank->z = z;
+    bank->y = y;
+    bank->S = S;
+    bank->K = K;
+
+    // set temporaries
+    bank->temporary.work = work;
+    bank->temporary.mask = mask;
+
+    // start all filters from the model
+    for (f = 0; f < count; ++f)
+    {
+        kalman_bank_set_filter(bank, f, model);
+    }
+}
+
+/*!
+* \brief Copies the state vector and covariance of a single filter into the bank.
+* \param[in] bank The bank
+* \param[in] index The index of the filter in the bank
+* \param[in] kf The filter to copy x and P from
+*/
+void kalman_bank_set_filter(kalman_bank_t *bank, uint_fast16_t index, const kalman_t *kf)
+{
+    uint_fast16_t e;
+    const uint_fast16_t N = bank->count;
+    const uint_fast8_t n = bank->model->A.rows;
+
+    assert(index < N);
+    assert(kf->P.rows == n);
+
+    for (e = 0; e < n; ++e)
+    {
+        bank->x[e * N + index] = kf->x.data[e];
+    }
+
+    for (e = 0; e < (uint_fast16_t)n * n; ++e)
+    {
+        bank->P[e * N + index] = kf->P.data[e];
+    }
+}
+
+/*!
+* \brief Copies the state vector and covariance of a single filter out of the bank.
+* \param[in] bank The bank
+* \param[in] index The index of the filter in the bank
+* \param[out] kf The filter to copy x and P to
+*/
+void kalman_bank_get_filter(const kalman_bank_t *bank, uint_fast16_t index, kalman_t *kf)
+{
+    uint_fast16_t e;
+    const uint_fast16_t N = bank->count;
+    const uint_fast8_t n = bank->model->A.rows;
+
+    assert(index < N);
+    assert(kf->P.rows == n);
+
+    for (e = 0; e < n; ++e)
+    {
+        kf->x.data[e] = bank->x[e * N + index];
+    }
+
+    for (e = 0; e < (uint_fast16_t)n * n; ++e)
+    {
+        kf->P.data[e] = bank->P[e * N + index];
+    }
+}
+
+/*!
+* \brief Performs the time update / prediction step for all filters in the bank.
+* \param[in] bank The bank to predict with.
+*/
+void kalman_bank_predict(kalman_bank_t *bank)
+{
+    uint_fast8_t i, j, k, l;
+    uint_fast16_t f;
+
+    const uint_fast16_t N = bank->count;
+    kalman_t *const model = bank->model;
+    const uint_fast8_t n = model->A.rows;
+    const uint_fast8_t inputs = model->B.cols;
+
+    // matrices and vectors
+    const matrix_data_t *RESTRICT const A = model->A.data;
+    const matrix_data_t *RESTRICT const B = model->B.data;
+    const matrix_data_t *RESTRICT const BQ = model->temporary.BQ.data;
+    matrix_data_t *RESTRICT const x = bank->x;
+    matrix_data_t *RESTRICT const P = bank->P;
+
+    // temporaries
+    matrix_data_t *RESTRICT const work = bank->temporary.work;
+
+    /************************************************************************/
+    /* Predict next state using system dynamics                             */
+    /* x = A*x                                                              */
+    /************************************************************************/
+
+    for (i = 0; i < n; ++i)
+    {
+        matrix_data_t *RESTRICT const xt = &work[i * N];
+        for (f = 0; f < N; ++f) xt[f] = 0;
+
+        for (k = 0; k < n; ++k)
+        {
+            const matrix_data_t a = A[i * n + k];
+            const matrix_data_t *RESTRICT const xk = &x[k * N];
+            if (a == 0) continue;
+
+            for (f = 0; f < N; ++f) xt[f] += a * xk[f];
+        }
+    }
+
+    for (f = 0; f < (uint_fast16_t)n * N; ++f)
+    {
+        x[f] = work[f];
+    }
+
+    /************************************************************************/
+    /* Predict next covariance using system dynamics and input              */
+    /* P = A*P*A' + B*Q*B'                                                  */
+    /************************************************************************/
+
+    // work = A*P
+    for (i = 0; i < n; ++i)
+    {
+        for (j = 0; j < n; ++j)
+        {
+            matrix_data_t *RESTRICT const w = &work[(i * n + j) * N];
+            for (f = 0; f < N; ++f) w[f] = 0;
+
+            for (k = 0; k < n; ++k)
+            {
+                const matrix_data_t a = A[i * n + k];
+                const matrix_data_t *RESTRICT const p = &P[(k * n + j) * N];
+                if (a == 0) continue;
+
+                for (f = 0; f < N; ++f) w[f] += a * p[f];
+            }
+        }
+    }
+
+    // B*Q is shared by all filters
+    if (inputs > 0)
+    {
+        matrix_mult(&model->B, &model->Q, &model->temporary.BQ, model->temporary.aux);
+    }
+
+    // P = work*A' + BQ*B', lower triangle mirrored
+    for (i = 0; i < n; ++i)
+    {
+        for (j = 0; j <= i; ++j)
+        {
+            matrix_data_t *RESTRICT const p = &P[(i * n + j) * N];
+
+            matrix_data_t g = 0;
+            for (l = 0; l < inputs; ++l)
+            {
+                g += BQ[i * inputs + l] * B[j * inputs + l];
+            }
+
+            for (f = 0; f < N; ++f) p[f] = g;
+
+            for (k = 0; k < n; ++k)
+            {
+                const matrix_data_t a = A[j * n + k];
+                const matrix_data_t *RESTRICT const w = &work[(i * n + k) * N];
+                if (a == 0) continue;
+
+                for (f = 0; f < N; ++f) p[f] += w[f] * a;
+            }
+
+            if (j != i)
+            {
+                matrix_data_t *RESTRICT const pt = &P[(j * n + i) * N];
+                for (f = 0; f < N; ++f) pt[f] = p[f];
+            }
+        }
+    }
+}
+
+/*!
+* \brief Decomposes interleaved symmetric matrices into lower triangular form using Cholesky decomposition.
+* \param[in] mat The interleaved matrices ({\ref n} * {\ref n} x {\ref count}) to decompose in place.
+* \param[in] n The dimension of each matrix
+* \param[in] count The number of interleaved matrices
+* \param[out] mask Set to one for each matrix that was decomposed and to zero for each matrix that is not positive definite.
+* \return The number of matrices that were not positive definite.
+*/
+uint_fast16_t kalman_bank_cholesky_decompose_lower(matrix_data_t *RESTRICT const mat, const uint_fast8_t n, const uint_fast16_t count, matrix_data_t *RESTRICT const mask)
+{
+    uint_fast8_t i, j, k;
+    uint_fast16_t f, failed = 0;
+    const uint_fast16_t N = count;
+
+    for (f = 0; f < N; ++f) mask[f] = 1;
+
+    for (j = 0; j < n; ++j)
+    {
+        matrix_data_t *RESTRICT const d = &mat[(j * n + j) * N];
+
+        // l_jj = sqrt(a_jj - sum_k l_jk^2)
+        for (k = 0; k < j; ++k)
+        {
+            const matrix_data_t *RESTRICT const l = &mat[(j * n + k) * N];
+            for (f = 0; f < N; ++f) d[f] -= l[f] * l[f];
+        }
+
+        // a failing matrix continues with a unit pivot so that the others are unaffected
+        for (f = 0; f < N; ++f)
+        {
+            const int positive = d[f] > 0;
+            mask[f] = positive ? mask[f] : 0;
+            d[f] = positive ? (matrix_data_t)sqrt(d[f]) : 1;
+        }
+
+        // l_ij = (a_ij - sum_k l_ik*l_jk) / l_jj
+        for (i = j + 1; i < n; ++i)
+        {
+            matrix_data_t *RESTRICT const e = &mat[(i * n + j) * N];
+            for (k = 0; k < j; ++k)
+            {
+                const matrix_data_t *RESTRICT const li = &mat[(i * n + k) * N];
+                const matrix_data_t *RESTRICT const lj = &mat[(j * n + k) * N];
+                for (f = 0; f < N; ++f) e[f] -= li[f] * lj[f];
+            }
+
+            for (f = 0; f < N; ++f) e[f] /= d[f];
+        }
+    }
+
+    for (f = 0; f < N; ++f)
+    {
+        failed += (mask[f] == 0);
+    }
+
+    return failed;
+}
+
+/*!
+* \brief Performs the measurement update step for all filters in the bank.
+* \param[in] bank The bank to correct.
+* \return The number of filters whose residual covariance was not positive definite.
+*/
+uint_fast16_t kalman_bank_correct(kalman_bank_t *bank)
+{
+    uint_fast8_t i, j, k;
+    uint_fast16_t f, failed;
+
+    const uint_fast16_t N = bank->count;
+    const uint_fast8_t n = bank->model->A.rows;
+    const uint_fast8_t m = bank->measurement->H.rows;
+
+    // matrices and vectors
+    const matrix_data_t *RESTRICT const H = bank->measurement->H.data;
+    const matrix_data_t *RESTRICT const R = bank->measurement->R.data;
+    matrix_data_t *RESTRICT const x = bank->x;
+    matrix_data_t *RESTRICT const P = bank->P;
+    const matrix_data_t *RESTRICT const z = bank->z;
+    matrix_data_t *RESTRICT const y = bank->y;
+    matrix_data_t *RESTRICT const S = bank->S;
+    matrix_data_t *RESTRICT const K = bank->K;
+
+    // temporaries
+    matrix_data_t *RESTRICT const HP = bank->temporary.work;
+    matrix_data_t *RESTRICT const mask = bank->temporary.mask;
+
+    /************************************************************************/
+    /* Calculate innovation and residual covariance                         */
+    /* y = z - H*x                                                          */
+    /* S = H*P*H' + R                                                       */
+    /************************************************************************/
+
+    // y = z - H*x
+    for (i = 0; i < m; ++i)
+    {
+        matrix_data_t *RESTRICT const yi = &y[i * N];
+        const matrix_data_t *RESTRICT const zi = &z[i * N];
+        for (f = 0; f < N; ++f) yi[f] = zi[f];
+
+        for (k = 0; k < n; ++k)
+        {
+            const matrix_data_t h = H[i * n + k];
+            const matrix_data_t *RESTRICT const xk = &x[k * N];
+            if (h == 0) continue;
+
+            for (f = 0; f < N; ++f) yi[f] -= h * xk[f];
+        }
+    }
+
+    // HP = H*P
+    for (i = 0; i < m; ++i)
+    {
+        for (j = 0; j < n; ++j)
+        {
+            matrix_data_t *RESTRICT const w = &HP[(i * n + j) * N];
+            for (f = 0; f < N; ++f) w[f] = 0;
+
+            for (k = 0; k < n; ++k)
+            {
+                const matrix_data_t h = H[i * n + k];
+                const matrix_data_t *RESTRICT const p = &P[(k * n + j) * N];
+                if (h == 0) continue;
+
+                for (f = 0; f < N; ++f) w[f] += h * p[f];
+            }
+        }
+    }
+
+    // S = HP*H' + R, lower triangle only
+    for (i = 0; i < m; ++i)
+    {
+        for (j = 0; j <= i; ++j)
+        {
+            matrix_data_t *RESTRICT const s = &S[(i * m + j) * N];
+            const matrix_data_t r = R[i * m + j];
+            for (f = 0; f < N; ++f) s[f] = r;
+
+            for (k = 0; k < n; ++k)
+            {
+                const matrix_data_t h = H[j * n + k];
+                const matrix_data_t *RESTRICT const w = &HP[(i * n + k) * N];
+                if (h == 0) continue;
+
+                for (f = 0; f < N; ++f) s[f] += w[f] * h;
+            }
+        }
+    }
+
+    /************************************************************************/
+    /* Calculate Kalman gain                                                */
+    /* K = P*H' * S^-1                                                      */
+    /************************************************************************/
+
+    // S = L*L'
+    failed = kalman_bank_cholesky_decompose_lower(S, m, N, mask);
+
+    // K = (HP)' * (L*L')^-1; each row of K solves L*L'*k' = HP(:,i)
+    for (i = 0; i < n; ++i)
+    {
+        // forward substitution: L*t = HP(:,i)
+        for (j = 0; j < m; ++j)
+        {
+            matrix_data_t *RESTRICT const kij = &K[(i * m + j) * N];
+            const matrix_data_t *RESTRICT const hp = &HP[(j * n + i) * N];
+            for (f = 0; f < N; ++f) kij[f] = hp[f];
+
+            for (k = 0; k < j; ++k)
+            {
+                const matrix_data_t *RESTRICT const l = &S[(j * m + k) * N];
+                const matrix_data_t *RESTRICT const kik = &K[(i * m + k) * N];
+                for (f = 0; f < N; ++f) kij[f] -= l[f] * kik[f];
+            }
+
+            {
+                const matrix_data_t *RESTRICT const d = &S[(j * m + j) * N];
+                for (f = 0; f < N; ++f) kij[f] /= d[f];
+            }
+        }
+
+        // back substitution: L'*k' = t
+        for (j = m; j-- > 0; )
+        {
+            matrix_data_t *RESTRICT const kij = &K[(i * m + j) * N];
+
+            for (k = j + 1; k < m; ++k)
+            {
+                const matrix_data_t *RESTRICT const l = &S[(k * m + j) * N];
+                const matrix_data_t *RESTRICT const kik = &K[(i * m + k) * N];
+                for (f = 0; f < N; ++f) kij[f] -= l[f] * kik[f];
+            }
+
+            {
+                const matrix_data_t *RESTRICT const d = &S[(j * m + j) * N];
+                for (f = 0; f < N; ++f) kij[f] /= d[f];
+            }
+        }
+    }
+
+    // filters without a valid factorization are not corrected
+    if (failed > 0)
+    {
+        uint_fast16_t e;
+        for (e = 0; e < (uint_fast16_t)n * m; ++e)
+        {
+            matrix_data_t *RESTRICT const kij = &K[e * N];
+            for (f = 0; f < N; ++f) kij[f] = (mask[f] != 0) ? kij[f] : 0;
+        }
+    }
+
+    /************************************************************************/
+    /* Correct state prediction                                             */
+    /* x = x + K*y                                                          */
+    /************************************************************************/
+
+    for (i = 0; i < n; ++i)
+    {
+        matrix_data_t *RESTRICT const xi = &x[i * N];
+        for (k = 0; k < m; ++k)
+        {
+            const matrix_data_t *RESTRICT const kik = &K[(i * m + k) * N];
+            const matrix_data_t *RESTRICT const yk = &y[k * N];
+            for (f = 0; f < N; ++f) xi[f] += kik[f] * yk[f];
+        }
+    }
+
+    /************************************************************************/
+    /* Correct state covariances                                            */
+    /* P = P - K*(H*P)                                                      */
+    /************************************************************************/
+
+    for (i = 0; i < n; ++i)
+    {
+        for (j = 0; j <= i; ++j)
+        {
+            matrix_data_t *RESTRICT const p = &P[(i * n + j) * N];
+
+            for (k = 0; k < m; ++k)
+            {
+                const matrix_data_t *RESTRICT const kik = &K[(i * m + k) * N];
+                const matrix_data_t *RESTRICT const w = &HP[(k * n + j) * N];
+                for (f = 0; f < N; ++f) p[f] -= kik[f] * w[f];
+            }
+
+            if (j != i)
+            {
+                matrix_data_t *RESTRICT const pt = &P[(j * n + i) * N];
+                for (f = 0; f < N; ++f) pt[f] = p[f];
+            }
+        }
+    }
+
+    return failed;
+}
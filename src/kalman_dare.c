@@ -0,0 +1,242 @@
+#include <stdint.h>
+#include <assert.h>
+#include <math.h>
+
+#define EXTERN_INLINE_MATRIX static INLINE
+#define EXTERN_INLINE_KALMAN static INLINE
+#include "cholesky.h"
+#include "kalman_dare.h"
+
+/*!
+* \brief Reduces the augmented matrix [W | B] to [I | W^-1*B] by Gauss-Jordan elimination with partial pivoting.
+* \param[in] aug The augmented matrix ({\ref n} x {\ref cols}), reduced in place
+* \param[in] n The order of W
+* \param[in] cols The number of columns of the augmented matrix
+* \return Zero in case of success, nonzero if W is singular.
+*/
+static int kalman_dare_gauss_jordan(matrix_data_t *RESTRICT const aug, const uint_fast8_t n, const uint_fast16_t cols)
+{
+    uint_fast8_t i, r;
+    uint_fast16_t c;
+
+    for (i = 0; i < n; ++i)
+    {
+        matrix_data_t *RESTRICT const pivot_row = &aug[i * cols];
+        uint_fast8_t pivot = i;
+        matrix_data_t inv_pivot;
+
+        // find the largest element in the column
+        for (r = i + 1; r < n; ++r)
+        {
+            if (fabs(aug[r * cols + i]) > fabs(aug[pivot * cols + i])) pivot = r;
+        }
+        if (aug[pivot * cols + i] == 0) return 1;
+
+        // swap it into place
+        if (pivot != i)
+        {
+            matrix_data_t *RESTRICT const other = &aug[pivot * cols];
+            for (c = i; c < cols; ++c)
+            {
+                const matrix_data_t temp = pivot_row[c];
+                pivot_row[c] = other[c];
+                other[c] = temp;
+            }
+        }
+
+        // normalize the pivot row
+        inv_pivot = (matrix_data_t)1.0 / pivot_row[i];
+        for (c = i; c < cols; ++c) { pivot_row[c] *= inv_pivot; }
+
+        // eliminate the column from all other rows
+        for (r = 0; r < n; ++r)
+        {
+            matrix_data_t *RESTRICT const row = &aug[r * cols];
+            const matrix_data_t factor = row[i];
+            if (r == i || factor == 0) continue;
+
+            for (c = i; c < cols; ++c) { row[c] -= factor * pivot_row[c]; }
+        }
+    }
+
+    return 0;
+}
+
+/*!
+* \brief Solves the discrete algebraic Riccati equation and installs the steady state into the filter.
+* \param[in] kf The filter providing A, B and Q; receives the steady state a posteriori covariance in P
+* \param[in] kfm The measurement providing H and R; receives the steady state gain in K
+* \param[in] work The work buffer (6 x {\ref num_states} x {\ref num_states})
+* \param[in] tolerance The relative change of the a priori covariance between two doubling steps that counts as converged
+* \return Zero in case of success, nonzero if R is not positive definite, a doubling step is singular
+*         or the solution did not converge within {\ref KALMAN_DARE_MAX_ITERATIONS} steps.
+*/
+int kalman_dare_solve(kalman_t *kf, kalman_measurement_t *kfm, matrix_data_t *work, matrix_data_t tolerance)
+{
+    uint_fast8_t i, j, k, iteration;
+    uint_fast16_t index;
+    uint_fast8_t converged = 0;
+    const uint_fast8_t n = kf->A.rows;
+    const uint_fast16_t nn = (uint_fast16_t)n * n;
+    const uint_fast16_t w = 3 * (uint_fast16_t)n;
+
+    // work buffer layout: A_k, G_k, [W | A_k | G_k] and one product
+    matrix_data_t *RESTRICT const Ak = work;
+    matrix_data_t *RESTRICT const Gk = &work[nn];
+    matrix_data_t *RESTRICT const aug = &work[2 * nn];
+    matrix_data_t *RESTRICT const T = &work[5 * nn];
+
+    // the a priori covariance X_k is iterated in P
+    matrix_data_t *RESTRICT const X = kf->P.data;
+    const matrix_data_t *RESTRICT const A = kf->A.data;
+    matrix_t G;
+
+    assert(kf->temporary.sqrt_work == (matrix_data_t*)0 && kf->temporary.ud_work == (matrix_data_t*)0);
+    assert(kfm->H.cols == n);
+    assert(kfm->S.data != (matrix_data_t*)0 && kfm->temporary.HP.data != (matrix_data_t*)0);
+    assert(tolerance >= 0);
+
+    /************************************************************************/
+    /* Initial values                                                       */
+    /* A_0 = A', G_0 = H'*R^-1*H, X_0 = B*Q*B'                              */
+    /************************************************************************/
+
+    // R = L*L'
+    matrix_copy(&kfm->R, &kfm->S);
+    if (cholesky_decompose_lower(&kfm->S) != 0) return 1;
+
+    // G_0 = (H'*R^-1)*H, holding H'*R^-1 in K for the moment
+    cholesky_solve_transb(&kfm->S, &kfm->H, &kfm->K);
+    matrix_init(&G, n, n, Gk);
+    matrix_mult(&kfm->K, &kfm->H, &G, kfm->temporary.aux);
+
+    // X_0 = B*Q*B'
+    if (kf->B.cols > 0)
+    {
+        matrix_mult(&kf->B, &kf->Q, &kf->temporary.BQ, kf->temporary.aux);
+        matrix_mult_transb_symmetric(&kf->temporary.BQ, &kf->B, &kf->P);
+    }
+    else
+    {
+        for (index = 0; index < nn; ++index) { X[index] = 0; }
+    }
+
+    // A_0 = A'
+    for (i = 0; i < n; ++i)
+    {
+        for (j = 0; j < n; ++j) { Ak[i * n + j] = A[j * n + i]; }
+    }
+
+    /************************************************************************/
+    /* Doubling steps                                                       */
+    /************************************************************************/
+
+    for (iteration = 0; iteration < KALMAN_DARE_MAX_ITERATIONS; ++iteration)
+    {
+        matrix_data_t change = 0, magnitude = 0;
+
+        // [W | A_k | G_k] with W = I + G_k*X_k
+        for (i = 0; i < n; ++i)
+        {
+            for (j = 0; j < n; ++j)
+            {
+                matrix_data_t total = (i == j) ? (matrix_data_t)1.0 : (matrix_data_t)0.0;
+                for (k = 0; k < n; ++k) { total += Gk[i * n + k] * X[k * n + j]; }
+
+                aug[i * w + j] = total;
+                aug[i * w + n + j] = Ak[i * n + j];
+                aug[i * w + 2 * n + j] = Gk[i * n + j];
+            }
+        }
+
+        // [I | W^-1*A_k | W^-1*G_k]
+        if (kalman_dare_gauss_jordan(aug, n, w) != 0) return 1;
+
+        // X_k+1 = X_k + A_k'*(X_k*W^-1*A_k), lower triangle mirrored
+        for (i = 0; i < n; ++i)
+        {
+            for (j = 0; j < n; ++j)
+            {
+                matrix_data_t total = 0;
+                for (k = 0; k < n; ++k) { total += X[i * n + k] * aug[k * w + n + j]; }
+                T[i * n + j] = total;
+            }
+        }
+        for (i = 0; i < n; ++i)
+        {
+            for (j = 0; j <= i; ++j)
+            {
+                matrix_data_t delta = 0;
+                for (k = 0; k < n; ++k) { delta += Ak[k * n + i] * T[k * n + j]; }
+
+                X[i * n + j] += delta;
+                X[j * n + i] = X[i * n + j];
+
+                if (fabs(delta) > change) change = (matrix_data_t)fabs(delta);
+                if (fabs(X[i * n + j]) > magnitude) magnitude = (matrix_data_t)fabs(X[i * n + j]);
+            }
+        }
+
+        // G_k+1 = G_k + A_k*(W^-1*G_k*A_k'), lower triangle mirrored
+        for (i = 0; i < n; ++i)
+        {
+            for (j = 0; j < n; ++j)
+            {
+                matrix_data_t total = 0;
+                for (k = 0; k < n; ++k) { total += aug[i * w + 2 * n + k] * Ak[j * n + k]; }
+                T[i * n + j] = total;
+            }
+        }
+        for (i = 0; i < n; ++i)
+        {
+            for (j = 0; j <= i; ++j)
+            {
+                matrix_data_t total = 0;
+                for (k = 0; k < n; ++k) { total += Ak[i * n + k] * T[k * n + j]; }
+
+                Gk[i * n + j] += total;
+                Gk[j * n + i] = Gk[i * n + j];
+            }
+        }
+
+        // A_k+1 = A_k*(W^-1*A_k)
+        for (i = 0; i < n; ++i)
+        {
+            for (j = 0; j < n; ++j)
+            {
+                matrix_data_t total = 0;
+                for (k = 0; k < n; ++k) { total += Ak[i * n + k] * aug[k * w + n + j]; }
+                T[i * n + j] = total;
+            }
+        }
+        for (index = 0; index < nn; ++index) { Ak[index] = T[index]; }
+
+        if (change <= tolerance * magnitude)
+        {
+            converged = 1;
+            break;
+        }
+    }
+
+    if (!converged) return 1;
+
+    /************************************************************************/
+    /* Steady state gain and a posteriori covariance                        */
+    /* K = X*H' * (H*X*H' + R)^-1                                           */
+    /* P = X - K*(H*X)                                                      */
+    /************************************************************************/
+
+    matrix_mult(&kfm->H, &kf->P, &kfm->temporary.HP, kfm->temporary.aux);
+    matrix_mult_transb_symmetric(&kfm->temporary.HP, &kfm->H, &kfm->S);
+    matrix_add_inplace(&kfm->S, &kfm->R);
+
+    if (cholesky_decompose_lower(&kfm->S) != 0) return 1;
+    cholesky_solve_transb(&kfm->S, &kfm->temporary.HP, &kfm->K);
+    matrix_multsub_symmetric(&kfm->K, &kfm->temporary.HP, &kf->P);
+
+    // start at steady state
+    kf->covariance_frozen = 1;
+    kfm->steady_state.frozen = 1;
+    kfm->steady_state.updates = 0;
+    return 0;
+}
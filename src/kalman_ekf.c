@@ -0,0 +1,53 @@
+#include <assert.h>
+
+#define EXTERN_INLINE_MATRIX static INLINE
+#define EXTERN_INLINE_KALMAN static INLINE
+#include "kalman_ekf.h"
+
+/*!
+* \brief Performs the time update / prediction step of an extended Kalman filter.
+* \param[in] kf The Kalman Filter structure to predict with.
+* \param[in] f The nonlinear state transition x = f(x)
+* \param[in] jacobian The Jacobian of f, which is written into A of the filter
+* \param[in] context The user context passed to both callbacks
+*/
+void kalman_ekf_predict(kalman_t *kf, kalman_ekf_function_t f, kalman_ekf_jacobian_t jacobian, void *context)
+{
+    matrix_t *RESTRICT const x = &kf->x;
+    matrix_t *RESTRICT const xpredicted = &kf->temporary.predicted_x;
+
+    // A = df/dx at the current estimate
+    jacobian(x, &kf->A, context);
+
+    // x = f(x)
+    f(x, xpredicted, context);
+    matrix_copy(xpredicted, x);
+
+    // P = A*P*A' + B*Q*B'
+    kalman_predict_Q(kf);
+}
+
+/*!
+* \brief Performs the measurement update step of an extended Kalman filter.
+* \param[in] kf The Kalman Filter structure to correct.
+* \param[in] kfm The measurement to correct with; z must be set.
+* \param[in] h The nonlinear measurement function
+* \param[in] jacobian The Jacobian of h, which is written into H of the measurement
+* \param[in] context The user context passed to both callbacks
+*/
+void kalman_ekf_correct(kalman_t *kf, kalman_measurement_t *kfm, kalman_ekf_function_t h, kalman_ekf_jacobian_t jacobian, void *context)
+{
+    const matrix_t *RESTRICT const x = &kf->x;
+    matrix_t *RESTRICT const y = &kfm->y;
+
+    assert(kf->temporary.ud_work == (matrix_data_t*)0);
+
+    // H = dh/dx at the current estimate
+    jacobian(x, &kfm->H, context);
+
+    // y = z - h(x)
+    h(x, y, context);
+    matrix_sub_inplace_b(&kfm->z, y);
+
+    kalman_correct_innovation(kf, kfm);
+}
@@ -13,6 +13,7 @@
 #define KALMAN_NAME example
 #define KALMAN_NUM_STATES 4
 #define KALMAN_NUM_INPUTS 0
+#define KALMAN_STACKED_MEASUREMENTS 6
 #include "kalman_factory_filter.h"
 
 // create the measurement structure
@@ -59,9 +60,16 @@ static void test_kalman_1()
     kalman_filter_example_measurement_gyroscope_init();
     kalman_filter_example_measurement_accelerometer_init();
 
+    // both measurements arrive together and share a single covariance update
+    kalman_stack_add(&kalman_filter_example_stack, &kalman_filter_example_measurement_gyroscope);
+    kalman_stack_add(&kalman_filter_example_stack, &kalman_filter_example_measurement_accelerometer);
+
     kalman_filter_example.x.data[0] = 1;
     kalman_filter_example_measurement_gyroscope.z.data[0] = 1;
     kalman_filter_example_measurement_accelerometer.z.data[0] = 1;
+
+    // once P and the H and R of both measurements are set, a single call corrects with both:
+    // kalman_correct_stacked(&kalman_filter_example, &kalman_filter_example_stack);
 }
 
 /*!
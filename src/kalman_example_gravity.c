@@ -18,22 +18,84 @@
 #define EXTERN_INLINE_KALMAN static INLINE
 
 #include <assert.h>
+#include <math.h>
 #include "kalman_example_gravity.h"
+#include "kalman_bank.h"
+#include "kalman_pool.h"
+#include "kalman_information.h"
+#include "kalman_dare.h"
+#include "kalman_ekf.h"
+#include "kalman_ukf.h"
+#include "kalman_smoother.h"
+#include "kalman_fixed_lag.h"
+#include "kalman_oosm.h"
+#include "kalman_stacked.h"
 
 // create the filter structure
 #define KALMAN_NAME gravity
 #define KALMAN_NUM_STATES 3
 #define KALMAN_NUM_INPUTS 0
+#define KALMAN_SPARSE_A 1
+#define KALMAN_SQRT 1
+#define KALMAN_TRANSITION_CACHE 4
+#define KALMAN_SMOOTHER_LENGTH 16
+#define KALMAN_FIXED_LAG 3
+#define KALMAN_OOSM_CHECKPOINTS 8
+#define KALMAN_STACKED_MEASUREMENTS 2
+#define KALMAN_Q_FRACTION_BITS 16
 #include "kalman_factory_filter.h"
 
 // create the measurement structure
 #define KALMAN_MEASUREMENT_NAME position
 #define KALMAN_NUM_MEASUREMENTS 1
+#define KALMAN_MEASUREMENT_STEADY_STATE 1
+#include "kalman_factory_measurement.h"
+
+// create a second measurement structure for the stacked correction
+#define KALMAN_MEASUREMENT_NAME velocity
+#define KALMAN_NUM_MEASUREMENTS 1
 #include "kalman_factory_measurement.h"
 
 // clean up
 #include "kalman_factory_cleanup.h"
 
+// create a filter with the same dimensions in UD form, i.e. with a packed P buffer
+#define KALMAN_NAME gravity_ud
+#define KALMAN_NUM_STATES 3
+#define KALMAN_NUM_INPUTS 0
+#define KALMAN_UD 1
+#include "kalman_factory_filter.h"
+
+#define KALMAN_MEASUREMENT_NAME position
+#define KALMAN_NUM_MEASUREMENTS 1
+#include "kalman_factory_measurement.h"
+
+#include "kalman_factory_cleanup.h"
+
+// create a filter with the same dimensions that measures position and velocity at once
+#define KALMAN_NAME gravity_pv
+#define KALMAN_NUM_STATES 3
+#define KALMAN_NUM_INPUTS 0
+#include "kalman_factory_filter.h"
+
+#define KALMAN_MEASUREMENT_NAME both
+#define KALMAN_NUM_MEASUREMENTS 2
+#include "kalman_factory_measurement.h"
+
+// the same measurement updated channel by channel, as R is diagonal
+#define KALMAN_MEASUREMENT_NAME sequential
+#define KALMAN_NUM_MEASUREMENTS 2
+#define KALMAN_MEASUREMENT_SEQUENTIAL 1
+#include "kalman_factory_measurement.h"
+
+// the same measurement with the gain calculated in double precision
+#define KALMAN_MEASUREMENT_NAME mixed
+#define KALMAN_NUM_MEASUREMENTS 2
+#define KALMAN_MEASUREMENT_MIXED_PRECISION 1
+#include "kalman_factory_measurement.h"
+
+#include "kalman_factory_cleanup.h"
+
 /*!
 * \brief Initializes the gravity Kalman filter
 */
@@ -153,6 +215,123 @@ static matrix_data_t measurement_error[MEAS_COUNT] = {
     (matrix_data_t)-0.015764,
     (matrix_data_t)0.17869 };
 
+// results of the plain filter the other demos are compared against
+static matrix_data_t reference_x[3];
+static matrix_data_t reference_P[3 * 3];
+
+/*!
+* \brief Runs the gravity Kalman filter with \c kalman_predict() and \c kalman_correct() to obtain the reference results.
+* \param[in] scale The factor applied to every measurement
+* \param[in] gap Nonzero to skip every third measurement, predicting only
+*/
+static void kalman_gravity_reference(matrix_data_t scale, int gap)
+{
+    // initialize the filter
+    kalman_gravity_init();
+
+    // fetch structures
+    kalman_t *kf = &kalman_filter_gravity;
+    kalman_measurement_t *kfm = &kalman_filter_gravity_measurement_position;
+
+    matrix_t *z = kalman_get_measurement_vector(kfm);
+
+    // filter!
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        kalman_predict(kf);
+        if (gap && (i % 3 == 2)) continue;
+
+        matrix_set(z, 0, 0, scale * (real_distance[i] + measurement_error[i]));
+        kalman_correct(kf, kfm);
+    }
+
+    for (int i = 0; i < 3; ++i) { reference_x[i] = kf->x.data[i]; }
+    for (int i = 0; i < 3 * 3; ++i) { reference_P[i] = kf->P.data[i]; }
+}
+
+/*!
+* \brief Compares a state and its covariance element by element against the reference results.
+* \param[in] x The state (3)
+* \param[in] P The covariance (3 x 3), or null to only compare the state
+* \param[in] tolerance The largest difference relative to the magnitude of the reference element
+*/
+static void kalman_gravity_assert_reference(const matrix_data_t *x, const matrix_data_t *P, matrix_data_t tolerance)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        assert(fabs(x[i] - reference_x[i]) <= tolerance * (1 + fabs(reference_x[i])));
+    }
+
+    if (P == (matrix_data_t*)0) return;
+    for (int i = 0; i < 3 * 3; ++i)
+    {
+        assert(fabs(P[i] - reference_P[i]) <= tolerance * (1 + fabs(reference_P[i])));
+    }
+}
+
+/*!
+* \brief Initializes the position and velocity Kalman filter with the state, transition and covariance of the gravity filter
+* \param[in] kfm The measurement of the position and velocity filter to set up
+*/
+static void kalman_gravity_pv_init(kalman_measurement_t *kfm)
+{
+    kalman_gravity_init();
+    kalman_t *kf = kalman_filter_gravity_pv_init();
+
+    matrix_copy(&kalman_filter_gravity.x, &kf->x);
+    matrix_copy(&kalman_filter_gravity.A, &kf->A);
+    matrix_copy(&kalman_filter_gravity.P, &kf->P);
+
+    matrix_t *H = kalman_get_measurement_transformation(kfm);
+    matrix_t *R = kalman_get_process_noise(kfm);
+    for (int i = 0; i < 2; ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            matrix_set(H, i, j, (matrix_data_t)(i == j));
+        }
+    }
+
+    matrix_set(R, 0, 0, (matrix_data_t)0.5);     // var(s)
+    matrix_set(R, 0, 1, 0);
+    matrix_set(R, 1, 0, 0);
+    matrix_set(R, 1, 1, 1);     // var(v)
+}
+
+/*!
+* \brief Sets the position and velocity measured at a given time step
+* \param[in] kfm The measurement of the position and velocity filter
+* \param[in] i The time step
+*/
+static void kalman_gravity_pv_measure(kalman_measurement_t *kfm, int i)
+{
+    matrix_t *z = kalman_get_measurement_vector(kfm);
+    matrix_set(z, 0, 0, real_distance[i] + measurement_error[i]);
+    matrix_set(z, 1, 0, (matrix_data_t)9.81 * i + measurement_error[MEAS_COUNT - 1 - i]);
+}
+
+/*!
+* \brief Runs the position and velocity Kalman filter with \c kalman_predict() and \c kalman_correct() to obtain the reference results.
+*/
+static void kalman_gravity_pv_reference()
+{
+    kalman_t *kf = &kalman_filter_gravity_pv;
+    kalman_measurement_t *kfm = &kalman_filter_gravity_pv_measurement_both;
+
+    kalman_filter_gravity_pv_measurement_both_init();
+    kalman_gravity_pv_init(kfm);
+
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        kalman_predict(kf);
+        kalman_gravity_pv_measure(kfm, i);
+        kalman_correct(kf, kfm);
+    }
+
+    for (int i = 0; i < 3; ++i) { reference_x[i] = kf->x.data[i]; }
+    for (int i = 0; i < 3 * 3; ++i) { reference_P[i] = kf->P.data[i]; }
+}
+
 /*!
 * \brief Runs the gravity Kalman filter.
 */
@@ -187,6 +366,44 @@ void kalman_gravity_demo()
     assert(g_estimated > 9 && g_estimated < 10);
 }
 
+/*!
+* \brief Runs the gravity Kalman filter with the sparse prediction.
+*/
+void kalman_gravity_demo_sparse()
+{
+    // the same filter with the dense prediction
+    kalman_gravity_reference(1, 0);
+
+    // initialize the filter
+    kalman_gravity_init();
+
+    // skip the zero and unit entries of A during prediction
+    kalman_filter_gravity_analyze_sparsity();
+
+    // fetch structures
+    kalman_t *kf = &kalman_filter_gravity;
+    kalman_measurement_t *kfm = &kalman_filter_gravity_measurement_position;
+
+    matrix_t *z = kalman_get_measurement_vector(kfm);
+
+    // filter!
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        // prediction.
+        kalman_predict(kf);
+
+        // measure ...
+        matrix_data_t measurement = real_distance[i] + measurement_error[i];
+        matrix_set(z, 0, 0, measurement);
+
+        // update
+        kalman_correct(kf, kfm);
+    }
+
+    // the sparse prediction only skips products with zero and one
+    kalman_gravity_assert_reference(kf->x.data, kf->P.data, (matrix_data_t)1e-4);
+}
+
 /*!
 * \brief Runs the gravity Kalman filter with lambda tuning.
 */
@@ -223,3 +440,1396 @@ void kalman_gravity_demo_lambda()
     matrix_data_t g_estimated = x->data[2];
     assert(g_estimated > 9 && g_estimated < 10);
 }
+
+/*!
+* \brief Runs the gravity Kalman filter using the fixed-size functions created by the factory.
+*/
+void kalman_gravity_demo_fixed()
+{
+    // the same filter with kalman_predict() and kalman_correct()
+    kalman_gravity_reference(1, 0);
+
+    // initialize the filter
+    kalman_gravity_init();
+
+    // fetch structures
+    kalman_t *kf = &kalman_filter_gravity;
+    kalman_measurement_t *kfm = &kalman_filter_gravity_measurement_position;
+
+    matrix_t *x = kalman_get_state_vector(kf);
+    matrix_t *z = kalman_get_measurement_vector(kfm);
+
+    // filter!
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        // prediction.
+        kalman_filter_gravity_predict();
+
+        // measure ...
+        matrix_data_t measurement = real_distance[i] + measurement_error[i];
+        matrix_set(z, 0, 0, measurement);
+
+        // update
+        kalman_filter_gravity_measurement_position_correct();
+    }
+
+    // the fixed-size functions must match the generic ones
+    kalman_gravity_assert_reference(x->data, kf->P.data, (matrix_data_t)1e-4);
+
+    // the same with two measured channels, i.e. with a Cholesky factorization of S
+    kalman_gravity_pv_reference();
+
+    kalman_filter_gravity_pv_measurement_both_init();
+    kalman_gravity_pv_init(&kalman_filter_gravity_pv_measurement_both);
+
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        kalman_predict(&kalman_filter_gravity_pv);
+        kalman_gravity_pv_measure(&kalman_filter_gravity_pv_measurement_both, i);
+        kalman_filter_gravity_pv_measurement_both_correct();
+    }
+
+    kalman_gravity_assert_reference(kalman_filter_gravity_pv.x.data, kalman_filter_gravity_pv.P.data, (matrix_data_t)1e-4);
+}
+
+/*!
+* \brief Runs the gravity Kalman filter using sequential scalar measurement updates.
+*/
+void kalman_gravity_demo_sequential()
+{
+    // the same filter with kalman_predict() and kalman_correct()
+    kalman_gravity_reference(1, 0);
+
+    // initialize the filter
+    kalman_gravity_init();
+
+    // fetch structures
+    kalman_t *kf = &kalman_filter_gravity;
+    kalman_measurement_t *kfm = &kalman_filter_gravity_measurement_position;
+
+    matrix_t *x = kalman_get_state_vector(kf);
+    matrix_t *z = kalman_get_measurement_vector(kfm);
+
+    // filter!
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        // prediction.
+        kalman_predict(kf);
+
+        // measure ...
+        matrix_data_t measurement = real_distance[i] + measurement_error[i];
+        matrix_set(z, 0, 0, measurement);
+
+        // update; R is diagonal, so no residual covariance needs to be factored
+        kalman_correct_sequential(kf, kfm);
+    }
+
+    // with a single measured channel, the sequential update is the plain one
+    kalman_gravity_assert_reference(x->data, kf->P.data, (matrix_data_t)1e-4);
+
+    // with two independent channels, both the generic and the fixed-size sequential update match the joint one
+    kalman_gravity_pv_reference();
+
+    kf = &kalman_filter_gravity_pv;
+    kfm = &kalman_filter_gravity_pv_measurement_sequential;
+    for (int fixed = 0; fixed < 2; ++fixed)
+    {
+        kalman_filter_gravity_pv_measurement_sequential_init();
+        kalman_gravity_pv_init(kfm);
+
+        for (int i = 0; i < MEAS_COUNT; ++i)
+        {
+            kalman_predict(kf);
+            kalman_gravity_pv_measure(kfm, i);
+
+            if (fixed) kalman_filter_gravity_pv_measurement_sequential_correct();
+            else kalman_correct_sequential(kf, kfm);
+        }
+
+        kalman_gravity_assert_reference(kf->x.data, kf->P.data, (matrix_data_t)1e-4);
+    }
+}
+
+/*!
+* \brief Runs the gravity Kalman filter in Q15.16 fixed-point arithmetic.
+*/
+void kalman_gravity_demo_fixed_point()
+{
+    // the same filter with kalman_predict() and kalman_correct()
+    kalman_gravity_reference(1, 0);
+
+    // initialize the filter and convert it to fixed-point
+    kalman_gravity_init();
+    kalman_q_t *kf = kalman_filter_gravity_init_q();
+    kalman_q_measurement_t *kfm = kalman_filter_gravity_measurement_position_init_q();
+
+    const matrix_data_t one = (matrix_data_t)MATRIX_Q_ONE(kf->x.frac);
+
+    // filter!
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        // prediction.
+        kalman_q_predict(kf);
+
+        // measure ...
+        matrix_data_t measurement = real_distance[i] + measurement_error[i];
+        kfm->z.data[0] = (matrix_q_data_t)(measurement * one);
+
+        // update
+        kalman_q_correct(kf, kfm);
+    }
+
+    // the fixed-point filter follows the floating-point one up to its resolution
+    matrix_data_t x_float[3], P_float[3 * 3];
+    matrix_t x, P;
+    matrix_init(&x, 3, 1, x_float);
+    matrix_init(&P, 3, 3, P_float);
+    matrix_q_to_float(&kf->x, &x);
+    matrix_q_to_float(&kf->P, &P);
+    kalman_gravity_assert_reference(x_float, P_float, (matrix_data_t)0.01);
+}
+
+// double precision workspace of the mixed precision demo
+static matrix_wide_t mixed_buffer[1 * (1 + 1)];
+
+/*!
+* \brief Runs the gravity Kalman filter with the gain calculated in double precision.
+*/
+void kalman_gravity_demo_mixed()
+{
+    // the same filter with kalman_predict() and kalman_correct()
+    kalman_gravity_reference(1, 0);
+
+    // initialize the filter
+    kalman_gravity_init();
+
+    // fetch structures
+    kalman_t *kf = &kalman_filter_gravity;
+    kalman_measurement_t *kfm = &kalman_filter_gravity_measurement_position;
+
+    matrix_t *x = kalman_get_state_vector(kf);
+    matrix_t *z = kalman_get_measurement_vector(kfm);
+
+    // factor S and solve for K in double precision
+    kalman_measurement_set_mixed_precision(kfm, mixed_buffer);
+
+    // filter!
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        // prediction.
+        kalman_predict(kf);
+
+        // measure ...
+        matrix_data_t measurement = real_distance[i] + measurement_error[i];
+        matrix_set(z, 0, 0, measurement);
+
+        // update
+        kalman_correct(kf, kfm);
+    }
+
+    // the gain in double precision only differs by rounding
+    kalman_gravity_assert_reference(x->data, kf->P.data, (matrix_data_t)1e-4);
+
+    // the same with two measured channels, with the wide buffer set up by the factory
+    kalman_gravity_pv_reference();
+
+    kf = &kalman_filter_gravity_pv;
+    kfm = &kalman_filter_gravity_pv_measurement_mixed;
+    for (int fixed = 0; fixed < 2; ++fixed)
+    {
+        kalman_filter_gravity_pv_measurement_mixed_init();
+        kalman_gravity_pv_init(kfm);
+        assert(kfm->temporary.wide != (matrix_wide_t*)0);
+
+        for (int i = 0; i < MEAS_COUNT; ++i)
+        {
+            kalman_predict(kf);
+            kalman_gravity_pv_measure(kfm, i);
+
+            if (fixed) kalman_filter_gravity_pv_measurement_mixed_correct();
+            else kalman_correct(kf, kfm);
+        }
+
+        kalman_gravity_assert_reference(kf->x.data, kf->P.data, (matrix_data_t)1e-4);
+    }
+}
+
+/*!
+* \brief Runs the gravity Kalman filter propagating the Cholesky factor of P.
+*/
+void kalman_gravity_demo_sqrt()
+{
+    // the same filter with kalman_predict() and kalman_correct()
+    kalman_gravity_reference(1, 0);
+
+    // initialize the filter
+    kalman_gravity_init();
+
+    // fetch structures
+    kalman_t *kf = &kalman_filter_gravity;
+    kalman_measurement_t *kfm = &kalman_filter_gravity_measurement_position;
+
+    matrix_t *x = kalman_get_state_vector(kf);
+    matrix_t *z = kalman_get_measurement_vector(kfm);
+
+    // an indefinite P is rejected and left as it is
+    matrix_data_t P_initial[3 * 3];
+    for (int i = 0; i < 3 * 3; ++i) { P_initial[i] = kf->P.data[i]; }
+
+    matrix_set(&kf->P, 1, 1, -1);
+    int result = kalman_filter_gravity_enable_sqrt();
+    assert(result != 0 && kf->temporary.sqrt_work == (matrix_data_t*)0);
+    assert(matrix_get(&kf->P, 1, 1) == -1 && kf->P.data[0] == P_initial[0] && kf->P.data[8] == P_initial[8]);
+    matrix_set(&kf->P, 1, 1, P_initial[4]);
+
+    // replace P and R by their factors
+    result = kalman_filter_gravity_enable_sqrt();
+    assert(result == 0);
+    result = kalman_filter_gravity_measurement_position_enable_sqrt();
+    assert(result == 0);
+
+    // filter!
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        // prediction; defers to kalman_predict() in square root form
+        kalman_filter_gravity_predict();
+
+        // measure ...
+        matrix_data_t measurement = real_distance[i] + measurement_error[i];
+        matrix_set(z, 0, 0, measurement);
+
+        // update
+        kalman_filter_gravity_measurement_position_correct();
+    }
+
+    // the covariance recomposed from the factor matches the conventional filter
+    matrix_data_t P_composed[3 * 3];
+    matrix_t P;
+    matrix_init(&P, 3, 3, P_composed);
+    kalman_filter_get_covariance(kf, &P);
+    kalman_gravity_assert_reference(x->data, P_composed, (matrix_data_t)1e-3);
+
+    // the factor of P must have a positive diagonal
+    assert(kf->P.data[0] > 0 && kf->P.data[4] > 0 && kf->P.data[8] > 0);
+}
+
+/*!
+* \brief Runs the gravity Kalman filter in UD form.
+*/
+void kalman_gravity_demo_ud()
+{
+    // the same filter with kalman_predict() and kalman_correct()
+    kalman_gravity_reference(1, 0);
+
+    // set up the model in the full filter and copy it
+    kalman_gravity_init();
+
+    kalman_t *kf = kalman_filter_gravity_ud_init();
+    kalman_measurement_t *kfm = kalman_filter_gravity_ud_measurement_position_init();
+
+    matrix_copy(&kalman_filter_gravity.x, &kf->x);
+    matrix_copy(&kalman_filter_gravity.A, &kf->A);
+    matrix_copy(&kalman_filter_gravity_measurement_position.H, &kfm->H);
+    matrix_copy(&kalman_filter_gravity_measurement_position.R, &kfm->R);
+
+    // factor the initial covariance into the packed P buffer
+    int result = kalman_filter_gravity_ud_enable_ud(&kalman_filter_gravity.P);
+    assert(result == 0);
+
+    matrix_t *x = kalman_get_state_vector(kf);
+    matrix_t *z = kalman_get_measurement_vector(kfm);
+
+    // filter!
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        // prediction.
+        kalman_filter_gravity_ud_predict();
+
+        // measure ...
+        matrix_data_t measurement = real_distance[i] + measurement_error[i];
+        matrix_set(z, 0, 0, measurement);
+
+        // update
+        kalman_filter_gravity_ud_measurement_position_correct();
+    }
+
+    // the covariance recomposed from the factors matches the conventional filter
+    matrix_data_t P_composed[3 * 3];
+    matrix_t P;
+    matrix_init(&P, 3, 3, P_composed);
+    kalman_filter_get_covariance(kf, &P);
+    kalman_gravity_assert_reference(x->data, P_composed, (matrix_data_t)1e-3);
+
+    // the diagonal factor must stay positive
+    assert(kf->P.data[0] > 0 && kf->P.data[2] > 0 && kf->P.data[5] > 0);
+
+    // a transition that resets v leaves it without variance, but the other factors finite
+    matrix_set(&kf->A, 1, 0, 0);
+    matrix_set(&kf->A, 1, 1, 0);
+    matrix_set(&kf->A, 1, 2, 0);
+    kalman_filter_gravity_ud_predict();
+
+    assert(kf->P.data[2] == 0);
+    for (int i = 0; i < 3 * (3 + 1) / 2; ++i)
+    {
+        assert(kf->P.data[i] == kf->P.data[i]);
+    }
+}
+
+/*!
+* \brief Runs the gravity Kalman filter until its gain has converged and continues with the frozen gain.
+*/
+void kalman_gravity_demo_steady_state()
+{
+    // initialize the filter
+    kalman_gravity_init();
+
+    // fetch structures
+    kalman_t *kf = &kalman_filter_gravity;
+    kalman_measurement_t *kfm = &kalman_filter_gravity_measurement_position;
+
+    matrix_t *x = kalman_get_state_vector(kf);
+    matrix_t *z = kalman_get_measurement_vector(kfm);
+
+    // freeze the gain once no element changes by more than the tolerance;
+    // without process noise the gain keeps decaying, so the tolerance is coarse
+    kalman_filter_gravity_measurement_position_enable_steady_state((matrix_data_t)0.05);
+
+    // filter!
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        // prediction; P is no longer propagated once frozen
+        kalman_filter_gravity_predict();
+
+        // measure ...
+        matrix_data_t measurement = real_distance[i] + measurement_error[i];
+        matrix_set(z, 0, 0, measurement);
+
+        // update; defers to kalman_correct()
+        kalman_filter_gravity_measurement_position_correct();
+    }
+
+    // the gain must have converged before the last measurement
+    assert(kfm->steady_state.frozen && kf->covariance_frozen);
+    assert(kfm->steady_state.updates < MEAS_COUNT);
+
+    // fetch estimated g
+    matrix_data_t g_estimated = x->data[2];
+    assert(g_estimated > 9 && g_estimated < 10);
+}
+
+/*!
+* \brief Runs the gravity Kalman filter with a second measurement that keeps correcting after the first froze the covariance.
+*/
+void kalman_gravity_demo_steady_state_shared()
+{
+    matrix_data_t P_frozen[3 * 3];
+    int frozen_at = -1;
+
+    // initialize the filter
+    kalman_gravity_init();
+
+    // fetch structures
+    kalman_t *kf = &kalman_filter_gravity;
+    kalman_measurement_t *kfm_position = &kalman_filter_gravity_measurement_position;
+    kalman_measurement_t *kfm_velocity = kalman_filter_gravity_measurement_velocity_init();
+
+    matrix_t *x = kalman_get_state_vector(kf);
+    matrix_t *z_position = kalman_get_measurement_vector(kfm_position);
+    matrix_t *z_velocity = kalman_get_measurement_vector(kfm_velocity);
+
+    // z = 1*v with var(v) = 1
+    matrix_set(kalman_get_measurement_transformation(kfm_velocity), 0, 1, 1);
+    matrix_set(kalman_get_process_noise(kfm_velocity), 0, 0, 1);
+
+    // only the position gain is checked for convergence
+    kalman_filter_gravity_measurement_position_enable_steady_state((matrix_data_t)0.05);
+
+    // filter!
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        // prediction; P is no longer propagated once frozen
+        kalman_filter_gravity_predict();
+
+        // measure, taking the velocity noise from the other end of the table ...
+        matrix_set(z_position, 0, 0, real_distance[i] + measurement_error[i]);
+        matrix_set(z_velocity, 0, 0, (matrix_data_t)9.81 * i + measurement_error[MEAS_COUNT - 1 - i]);
+
+        // update with both; once the covariance is frozen, neither correction changes P
+        kalman_filter_gravity_measurement_position_correct();
+        kalman_filter_gravity_measurement_velocity_correct();
+
+        if (!kf->covariance_frozen) continue;
+        if (frozen_at < 0)
+        {
+            frozen_at = i;
+            for (int j = 0; j < 3 * 3; ++j) { P_frozen[j] = kf->P.data[j]; }
+            continue;
+        }
+
+        for (int j = 0; j < 3 * 3; ++j)
+        {
+            assert(kf->P.data[j] == P_frozen[j]);
+        }
+    }
+
+    // the velocity corrections after the freeze used a gain frozen against the frozen P
+    assert(frozen_at >= 0 && frozen_at < MEAS_COUNT - 1);
+    assert(kfm_position->steady_state.frozen && kfm_velocity->steady_state.frozen);
+
+    // fetch estimated g
+    matrix_data_t g_estimated = x->data[2];
+    assert(g_estimated > 9 && g_estimated < 10);
+
+    // leaving steady state lets the velocity measurement downdate P again
+    kalman_steady_state_reset(kf, kfm_position);
+    kalman_filter_gravity_predict();
+    kalman_filter_gravity_measurement_velocity_correct();
+
+    assert(!kfm_velocity->steady_state.frozen);
+    assert(kf->P.data[1 * 3 + 1] != P_frozen[1 * 3 + 1]);
+}
+
+// gravity filter with a random walk on g, initialized at steady state
+static kalman_t dare_filter;
+static matrix_data_t dare_x[3];
+static matrix_data_t dare_A[3 * 3];
+static matrix_data_t dare_B[3 * 1] = { 0, 0, 1 };
+static matrix_data_t dare_u[1];
+static matrix_data_t dare_P[3 * 3];
+static matrix_data_t dare_Q[1 * 1] = { (matrix_data_t)0.1 };
+static matrix_data_t dare_aux[3];
+static matrix_data_t dare_predicted_x[3];
+static matrix_data_t dare_BQ[3 * 1];
+static matrix_data_t dare_work[6 * 3 * 3];
+
+/*!
+* \brief Runs a gravity Kalman filter whose gain is computed offline from the Riccati equation.
+*/
+void kalman_gravity_demo_dare()
+{
+    // set up the model in the gravity filter and measurement
+    kalman_gravity_init();
+
+    kalman_t *kf = &dare_filter;
+    kalman_measurement_t *kfm = &kalman_filter_gravity_measurement_position;
+
+    // the model without process noise has the trivial steady state K = 0,
+    // so g is allowed to drift through the input covariance
+    kalman_filter_initialize(kf, 3, 1, dare_A, dare_x, dare_B, dare_u, dare_P, dare_Q, dare_aux, dare_predicted_x, dare_BQ);
+    matrix_copy(&kalman_filter_gravity.A, &kf->A);
+    matrix_copy(&kalman_filter_gravity.x, &kf->x);
+
+    // solve for the steady state P and K; the filter starts at steady state cost
+    int result = kalman_dare_solve(kf, kfm, dare_work, (matrix_data_t)1e-6);
+    assert(result == 0);
+    assert(kfm->steady_state.frozen && kf->covariance_frozen);
+
+    matrix_t *x = kalman_get_state_vector(kf);
+    matrix_t *z = kalman_get_measurement_vector(kfm);
+
+    // filter!
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        // prediction; only x is propagated
+        kalman_predict(kf);
+
+        // measure ...
+        matrix_data_t measurement = real_distance[i] + measurement_error[i];
+        matrix_set(z, 0, 0, measurement);
+
+        // update with the steady state gain
+        kalman_correct(kf, kfm);
+    }
+
+    // fetch estimated g
+    matrix_data_t g_estimated = x->data[2];
+    assert(g_estimated > 9 && g_estimated < 10);
+}
+
+// six independent copies of the random walk gravity model, each with its own position measurement
+#define DARE_CHAINS (6)
+#define DARE_STATES (3 * DARE_CHAINS)
+static kalman_t dare_wide_filter;
+static kalman_measurement_t dare_wide_measurement;
+static matrix_data_t dare_wide_x[DARE_STATES];
+static matrix_data_t dare_wide_A[DARE_STATES * DARE_STATES];
+static matrix_data_t dare_wide_B[DARE_STATES * DARE_CHAINS];
+static matrix_data_t dare_wide_u[DARE_CHAINS];
+static matrix_data_t dare_wide_P[DARE_STATES * DARE_STATES];
+static matrix_data_t dare_wide_Q[DARE_CHAINS * DARE_CHAINS];
+static matrix_data_t dare_wide_aux[DARE_STATES];
+static matrix_data_t dare_wide_predicted_x[DARE_STATES];
+static matrix_data_t dare_wide_BQ[DARE_STATES * DARE_CHAINS];
+static matrix_data_t dare_wide_H[DARE_CHAINS * DARE_STATES];
+static matrix_data_t dare_wide_z[DARE_CHAINS];
+static matrix_data_t dare_wide_R[DARE_CHAINS * DARE_CHAINS];
+static matrix_data_t dare_wide_y[DARE_CHAINS];
+static matrix_data_t dare_wide_S[DARE_CHAINS * DARE_CHAINS];
+static matrix_data_t dare_wide_K[DARE_STATES * DARE_CHAINS];
+static matrix_data_t dare_wide_HP[DARE_CHAINS * DARE_STATES];
+static matrix_data_t dare_wide_work[6 * DARE_STATES * DARE_STATES];
+
+/*!
+* \brief Solves the Riccati equation of a block diagonal model with more than 16 states.
+*
+* Since the copies of the gravity model do not interact, every diagonal block of the steady state
+* covariance and gain must match the solution of the single model, and the off-diagonal blocks must vanish.
+*/
+void kalman_gravity_demo_dare_wide()
+{
+    // solve the single model for reference
+    kalman_gravity_init();
+
+    kalman_t *kf = &dare_filter;
+    kalman_measurement_t *kfm = &kalman_filter_gravity_measurement_position;
+
+    kalman_filter_initialize(kf, 3, 1, dare_A, dare_x, dare_B, dare_u, dare_P, dare_Q, dare_aux, dare_predicted_x, dare_BQ);
+    matrix_copy(&kalman_filter_gravity.A, &kf->A);
+
+    int result = kalman_dare_solve(kf, kfm, dare_work, (matrix_data_t)1e-6);
+    assert(result == 0);
+
+    // set up the block diagonal model
+    kalman_t *wide = &dare_wide_filter;
+    kalman_measurement_t *widem = &dare_wide_measurement;
+
+    kalman_filter_initialize(wide, DARE_STATES, DARE_CHAINS, dare_wide_A, dare_wide_x, dare_wide_B, dare_wide_u, dare_wide_P, dare_wide_Q,
+                             dare_wide_aux, dare_wide_predicted_x, dare_wide_BQ);
+    kalman_measurement_initialize(widem, DARE_STATES, DARE_CHAINS, dare_wide_H, dare_wide_z, dare_wide_R, dare_wide_y, dare_wide_S, dare_wide_K,
+                                  dare_wide_aux, dare_wide_HP);
+
+    for (int c = 0; c < DARE_CHAINS; ++c)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                matrix_set(&wide->A, 3 * c + i, 3 * c + j, matrix_get(&kf->A, i, j));
+            }
+            matrix_set(&wide->B, 3 * c + i, c, matrix_get(&kf->B, i, 0));
+            matrix_set(&widem->H, c, 3 * c + i, matrix_get(&kfm->H, 0, i));
+        }
+        matrix_set(&wide->Q, c, c, matrix_get(&kf->Q, 0, 0));
+        matrix_set(&widem->R, c, c, matrix_get(&kfm->R, 0, 0));
+    }
+
+    result = kalman_dare_solve(wide, widem, dare_wide_work, (matrix_data_t)1e-6);
+    assert(result == 0);
+    assert(widem->steady_state.frozen && wide->covariance_frozen);
+
+    // compare against the single model, block by block
+    for (int i = 0; i < DARE_STATES; ++i)
+    {
+        for (int j = 0; j < DARE_STATES; ++j)
+        {
+            const matrix_data_t expected = (i / 3 == j / 3) ? matrix_get(&kf->P, i % 3, j % 3) : 0;
+            assert(fabs(matrix_get(&wide->P, i, j) - expected) <= 1e-3 * (1 + fabs(expected)));
+        }
+
+        for (int c = 0; c < DARE_CHAINS; ++c)
+        {
+            const matrix_data_t expected = (i / 3 == c) ? matrix_get(&kfm->K, i % 3, 0) : 0;
+            assert(fabs(matrix_get(&widem->K, i, c) - expected) <= 1e-3 * (1 + fabs(expected)));
+        }
+    }
+}
+
+/*!
+* \brief Runs the gravity Kalman filter with a measurement every third tick, coasting over the gaps.
+*/
+void kalman_gravity_demo_steps()
+{
+    // initialize the filter
+    kalman_gravity_init();
+
+    // fetch structures
+    kalman_t *kf = &kalman_filter_gravity;
+    kalman_measurement_t *kfm = &kalman_filter_gravity_measurement_position;
+
+    matrix_t *x = kalman_get_state_vector(kf);
+    matrix_t *z = kalman_get_measurement_vector(kfm);
+
+    // filter!
+    for (int i = 2; i < MEAS_COUNT; i += 3)
+    {
+        // prediction over three ticks at once
+        kalman_filter_gravity_predict_steps(3);
+
+        // measure ...
+        matrix_data_t measurement = real_distance[i] + measurement_error[i];
+        matrix_set(z, 0, 0, measurement);
+
+        // update
+        kalman_filter_gravity_measurement_position_correct();
+    }
+
+    // the transition over three ticks was built once
+    assert(kalman_filter_gravity_transitions.misses == 1);
+
+    // fetch estimated g
+    matrix_data_t g_estimated = x->data[2];
+    assert(g_estimated > 9 && g_estimated < 10);
+}
+
+/*!
+* \brief Discretizes the gravity model over a time step.
+* \param[in] dt The time step
+* \param[out] A The state transition matrix over {\ref dt}
+* \param[out] Q The process noise over {\ref dt}, which is zero for this model
+* \param[in] context Unused
+*/
+static void kalman_gravity_discretize(matrix_data_t dt, matrix_t *A, matrix_t *Q, void *context)
+{
+    (void)context;
+
+    matrix_set(A, 0, 0, 1);
+    matrix_set(A, 0, 1, dt);
+    matrix_set(A, 0, 2, (matrix_data_t)0.5*dt*dt);
+
+    matrix_set(A, 1, 0, 0);
+    matrix_set(A, 1, 1, 1);
+    matrix_set(A, 1, 2, dt);
+
+    matrix_set(A, 2, 0, 0);
+    matrix_set(A, 2, 1, 0);
+    matrix_set(A, 2, 2, 1);
+
+    for (int i = 0; i < 3 * 3; ++i) { Q->data[i] = 0; }
+}
+
+/*!
+* \brief Runs the gravity Kalman filter on irregularly timed measurements.
+*/
+void kalman_gravity_demo_dt()
+{
+    // sensor periods with some timestamp jitter
+    static const matrix_data_t periods[4] = { (matrix_data_t)0.5, (matrix_data_t)1.0, (matrix_data_t)0.75, (matrix_data_t)1.0 };
+    static const matrix_data_t jitter[3] = { (matrix_data_t)-0.002, 0, (matrix_data_t)0.003 };
+
+    // initialize the filter
+    kalman_gravity_init();
+
+    // fetch structures
+    kalman_t *kf = &kalman_filter_gravity;
+    kalman_measurement_t *kfm = &kalman_filter_gravity_measurement_position;
+
+    matrix_t *x = kalman_get_state_vector(kf);
+    matrix_t *z = kalman_get_measurement_vector(kfm);
+
+    // key the transition cache on time steps with 10 ms resolution
+    kalman_transition_cache_set_model(&kalman_filter_gravity_transitions, kalman_gravity_discretize, (void*)0, (matrix_data_t)0.01);
+
+    // filter!
+    matrix_data_t t = 0;
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        // prediction over the time since the last measurement
+        matrix_data_t dt = periods[i % 4] + jitter[i % 3];
+        kalman_filter_gravity_predict_dt(dt);
+        t += dt;
+
+        // measure ...
+        matrix_data_t measurement = (matrix_data_t)0.5*(matrix_data_t)9.81*t*t + measurement_error[i];
+        matrix_set(z, 0, 0, measurement);
+
+        // update
+        kalman_filter_gravity_measurement_position_correct();
+    }
+
+    // only the three distinct periods were discretized, despite the jitter
+    assert(kalman_filter_gravity_transitions.misses == 3);
+
+    // fetch estimated g
+    matrix_data_t g_estimated = x->data[2];
+    assert(g_estimated > 9 && g_estimated < 10);
+}
+
+// lateral offset of the range sensor from the falling object's track
+#define EKF_OFFSET ((matrix_data_t)10.0)
+
+/*!
+* \brief Evaluates the gravity state transition for T = 1.
+*/
+static void kalman_gravity_ekf_f(const matrix_t *x, matrix_t *result, void *context)
+{
+    (void)context;
+    result->data[0] = x->data[0] + x->data[1] + (matrix_data_t)0.5*x->data[2];
+    result->data[1] = x->data[1] + x->data[2];
+    result->data[2] = x->data[2];
+}
+
+/*!
+* \brief Evaluates the Jacobian of the gravity state transition, which is constant.
+*/
+static void kalman_gravity_ekf_F(const matrix_t *x, matrix_t *jacobian, void *context)
+{
+    (void)x;
+    matrix_copy((const matrix_t*)context, jacobian);
+}
+
+/*!
+* \brief Evaluates the range from a sensor placed beside the track, h(x) = sqrt(s^2 + d^2).
+*/
+static void kalman_gravity_ekf_h(const matrix_t *x, matrix_t *result, void *context)
+{
+    (void)context;
+    result->data[0] = (matrix_data_t)sqrt(x->data[0]*x->data[0] + EKF_OFFSET*EKF_OFFSET);
+}
+
+/*!
+* \brief Evaluates the Jacobian of the range, dh/dx = [s/r, 0, 0].
+*/
+static void kalman_gravity_ekf_H(const matrix_t *x, matrix_t *jacobian, void *context)
+{
+    (void)context;
+    matrix_data_t range = (matrix_data_t)sqrt(x->data[0]*x->data[0] + EKF_OFFSET*EKF_OFFSET);
+    matrix_set(jacobian, 0, 0, x->data[0] / range);
+    matrix_set(jacobian, 0, 1, 0);
+    matrix_set(jacobian, 0, 2, 0);
+}
+
+/*!
+* \brief Runs the range measurements through \c kalman_predict() and \c kalman_correct() to obtain the reference results of the extended filter.
+*
+* Linearized at the predicted state x0, the range is the linear measurement z - h(x0) + H*x0 = H*x.
+*/
+static void kalman_gravity_reference_ekf()
+{
+    // initialize the filter
+    kalman_gravity_init();
+
+    // fetch structures
+    kalman_t *kf = &kalman_filter_gravity;
+    kalman_measurement_t *kfm = &kalman_filter_gravity_measurement_position;
+
+    matrix_t *H = kalman_get_measurement_transformation(kfm);
+    matrix_t *z = kalman_get_measurement_vector(kfm);
+
+    matrix_data_t predicted_buffer[1];
+    matrix_t predicted;
+    matrix_init(&predicted, 1, 1, predicted_buffer);
+
+    // filter!
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        kalman_predict(kf);
+
+        // linearize at the predicted state
+        kalman_gravity_ekf_h(&kf->x, &predicted, (void*)0);
+        kalman_gravity_ekf_H(&kf->x, H, (void*)0);
+
+        matrix_data_t range = (matrix_data_t)sqrt(real_distance[i]*real_distance[i] + EKF_OFFSET*EKF_OFFSET);
+        matrix_data_t linearized = range + measurement_error[i] - predicted_buffer[0];
+        for (int k = 0; k < 3; ++k) { linearized += matrix_get(H, 0, k) * kf->x.data[k]; }
+        matrix_set(z, 0, 0, linearized);
+
+        kalman_correct(kf, kfm);
+    }
+
+    for (int i = 0; i < 3; ++i) { reference_x[i] = kf->x.data[i]; }
+    for (int i = 0; i < 3 * 3; ++i) { reference_P[i] = kf->P.data[i]; }
+}
+
+/*!
+* \brief Runs the gravity Kalman filter as an extended Kalman filter with a nonlinear range measurement.
+*/
+void kalman_gravity_demo_ekf()
+{
+    // the same measurements linearized by hand, with kalman_predict() and kalman_correct()
+    kalman_gravity_reference_ekf();
+
+    // initialize the filter
+    kalman_gravity_init();
+
+    // fetch structures; the factory buffers are used as they are
+    kalman_t *kf = &kalman_filter_gravity;
+    kalman_measurement_t *kfm = &kalman_filter_gravity_measurement_position;
+
+    matrix_t *x = kalman_get_state_vector(kf);
+    matrix_t *z = kalman_get_measurement_vector(kfm);
+
+    // keep the constant Jacobian of f aside, since A is overwritten with it
+    matrix_data_t jacobian_buffer[3 * 3];
+    matrix_t jacobian;
+    matrix_init(&jacobian, 3, 3, jacobian_buffer);
+    matrix_copy(&kf->A, &jacobian);
+
+    // filter!
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        // prediction.
+        kalman_ekf_predict(kf, kalman_gravity_ekf_f, kalman_gravity_ekf_F, &jacobian);
+
+        // measure the range ...
+        matrix_data_t range = (matrix_data_t)sqrt(real_distance[i]*real_distance[i] + EKF_OFFSET*EKF_OFFSET);
+        matrix_set(z, 0, 0, range + measurement_error[i]);
+
+        // update
+        kalman_ekf_correct(kf, kfm, kalman_gravity_ekf_h, kalman_gravity_ekf_H, (void*)0);
+    }
+
+    // the callbacks linearize the same way
+    kalman_gravity_assert_reference(x->data, kf->P.data, (matrix_data_t)1e-4);
+}
+
+// unscented filter buffers, 2n + 1 = 7 sigma points
+static matrix_data_t ukf_sigma[3 * 7];
+static matrix_data_t ukf_propagated[3 * 7];
+static matrix_data_t ukf_measured[1 * 7];
+static matrix_data_t ukf_weights[2 * 7];
+static matrix_data_t ukf_factor[3 * 3];
+
+/*!
+* \brief Evaluates the gravity state transition for T = 1 on all sigma points at once.
+*/
+static void kalman_gravity_ukf_f(const matrix_t *sigma, matrix_t *result, void *context)
+{
+    const uint_fast8_t count = sigma->cols;
+    const matrix_data_t *s = &sigma->data[0];
+    const matrix_data_t *v = &sigma->data[count];
+    const matrix_data_t *g = &sigma->data[2 * count];
+
+    (void)context;
+    for (uint_fast8_t j = 0; j < count; ++j)
+    {
+        result->data[j] = s[j] + v[j] + (matrix_data_t)0.5*g[j];
+        result->data[count + j] = v[j] + g[j];
+        result->data[2 * count + j] = g[j];
+    }
+}
+
+/*!
+* \brief Evaluates the range h(x) = sqrt(s^2 + d^2) on all sigma points at once.
+*/
+static void kalman_gravity_ukf_h(const matrix_t *sigma, matrix_t *result, void *context)
+{
+    const uint_fast8_t count = sigma->cols;
+    const matrix_data_t *s = &sigma->data[0];
+
+    (void)context;
+    for (uint_fast8_t j = 0; j < count; ++j)
+    {
+        result->data[j] = (matrix_data_t)sqrt(s[j]*s[j] + EKF_OFFSET*EKF_OFFSET);
+    }
+}
+
+/*!
+* \brief Evaluates the position h(x) = s on all sigma points at once.
+*/
+static void kalman_gravity_ukf_h_position(const matrix_t *sigma, matrix_t *result, void *context)
+{
+    const uint_fast8_t count = sigma->cols;
+
+    (void)context;
+    for (uint_fast8_t j = 0; j < count; ++j)
+    {
+        result->data[j] = sigma->data[j];
+    }
+}
+
+/*!
+* \brief Runs the gravity Kalman filter as an unscented Kalman filter.
+* \param[in] h The measurement model
+* \param[in] range Nonzero if {\ref h} measures the range rather than the position
+*/
+static void kalman_gravity_run_ukf(kalman_ukf_model_t h, int range)
+{
+    // initialize the filter
+    kalman_gravity_init();
+
+    // fetch structures; the factory buffers are used as they are
+    kalman_t *kf = &kalman_filter_gravity;
+    kalman_measurement_t *kfm = &kalman_filter_gravity_measurement_position;
+
+    matrix_t *z = kalman_get_measurement_vector(kfm);
+
+    kalman_ukf_t ukf;
+    kalman_ukf_initialize(&ukf, 3, 1, 2, 0, ukf_sigma, ukf_propagated, ukf_measured, ukf_weights, ukf_factor);
+
+    // filter!
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        // prediction.
+        int result = kalman_ukf_predict(kf, &ukf, kalman_gravity_ukf_f, (void*)0);
+        assert(result == 0);
+
+        // measure the range or the position ...
+        matrix_data_t measured = range
+            ? (matrix_data_t)sqrt(real_distance[i]*real_distance[i] + EKF_OFFSET*EKF_OFFSET)
+            : real_distance[i];
+        matrix_set(z, 0, 0, measured + measurement_error[i]);
+
+        // update
+        result = kalman_ukf_correct(kf, kfm, &ukf, h, (void*)0);
+        assert(result == 0);
+    }
+}
+
+/*!
+* \brief Runs the gravity Kalman filter as an unscented Kalman filter with a nonlinear range measurement.
+*/
+void kalman_gravity_demo_ukf()
+{
+    kalman_t *kf = &kalman_filter_gravity;
+
+    // the unscented transform of the linear model is exact
+    kalman_gravity_reference(1, 0);
+    kalman_gravity_run_ukf(kalman_gravity_ukf_h_position, 0);
+    kalman_gravity_assert_reference(kf->x.data, kf->P.data, (matrix_data_t)1e-3);
+
+    // the range only differs from its linearization by the curvature the sigma points capture
+    kalman_gravity_reference_ekf();
+    kalman_gravity_run_ukf(kalman_gravity_ukf_h, 1);
+    kalman_gravity_assert_reference(kf->x.data, kf->P.data, (matrix_data_t)1e-3);
+}
+
+// smoothed history
+static matrix_data_t smoothed_x[MEAS_COUNT * 3];
+static matrix_data_t smoothed_P[MEAS_COUNT * 3 * 3];
+
+/*!
+* \brief Runs the gravity Kalman filter and smooths its history.
+*/
+void kalman_gravity_demo_smoother()
+{
+    // initialize the filter
+    kalman_gravity_init();
+
+    // fetch structures
+    kalman_t *kf = &kalman_filter_gravity;
+    kalman_measurement_t *kfm = &kalman_filter_gravity_measurement_position;
+    kalman_smoother_t *ks = &kalman_filter_gravity_smoother;
+
+    matrix_t *x = kalman_get_state_vector(kf);
+    matrix_t *z = kalman_get_measurement_vector(kfm);
+
+    // filter!
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        // prediction.
+        kalman_predict(kf);
+        kalman_smoother_record_prediction(ks, kf);
+
+        // measure ...
+        matrix_data_t measurement = real_distance[i] + measurement_error[i];
+        matrix_set(z, 0, 0, measurement);
+
+        // update
+        kalman_correct(kf, kfm);
+        kalman_smoother_record_correction(ks, kf);
+    }
+
+    // smooth the whole run
+    int result = kalman_smoother_smooth(ks, 0, MEAS_COUNT, smoothed_x, smoothed_P);
+    assert(result == 0);
+
+    // g is constant, so all of the run shares the final estimate of it
+    assert(fabs(smoothed_x[2] - x->data[2]) < (matrix_data_t)0.01);
+    assert(fabs(smoothed_P[8] - kf->P.data[8]) < (matrix_data_t)0.01);
+
+    // smooth the first half with the measurements up to its end only
+    result = kalman_smoother_smooth(ks, 0, MEAS_COUNT / 2, smoothed_x, (matrix_data_t*)0);
+    assert(result == 0);
+
+    // fetch estimated g
+    matrix_data_t g_estimated = smoothed_x[2];
+    assert(g_estimated > 9 && g_estimated < 10);
+}
+
+/*!
+* \brief Runs the gravity Kalman filter with a fixed-lag smoother.
+*/
+void kalman_gravity_demo_fixed_lag()
+{
+    // initialize the filter
+    kalman_gravity_init();
+
+    // skip the zero and unit entries of A when propagating the lagged copies
+    kalman_filter_gravity_analyze_sparsity();
+
+    // fetch structures
+    kalman_t *kf = &kalman_filter_gravity;
+    kalman_measurement_t *kfm = &kalman_filter_gravity_measurement_position;
+    kalman_fixed_lag_t *kfl = &kalman_filter_gravity_fixed_lag;
+    kalman_smoother_t *ks = &kalman_filter_gravity_smoother;
+
+    matrix_t *z = kalman_get_measurement_vector(kfm);
+    const matrix_t *lagged = (const matrix_t*)0;
+
+    // filter!
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        // prediction.
+        kalman_fixed_lag_predict(kf, kfl);
+        kalman_smoother_record_prediction(ks, kf);
+
+        // measure ...
+        matrix_data_t measurement = real_distance[i] + measurement_error[i];
+        matrix_set(z, 0, 0, measurement);
+
+        // update
+        kalman_fixed_lag_correct(kf, kfm, kfl);
+        kalman_smoother_record_correction(ks, kf);
+
+        // the smoothed state of three steps ago, the initial state being the first
+        lagged = kalman_fixed_lag_state(kfl, 3);
+        assert((lagged == (const matrix_t*)0) == (i < 2));
+    }
+
+    // the lagged state matches the smoothed history at the same time step
+    int result = kalman_smoother_smooth(ks, 0, MEAS_COUNT, smoothed_x, (matrix_data_t*)0);
+    assert(result == 0);
+    for (int j = 0; j < 3; ++j)
+    {
+        assert(fabs(lagged->data[j] - smoothed_x[(MEAS_COUNT - 4) * 3 + j]) < (matrix_data_t)0.01);
+    }
+
+    // fetch estimated g
+    matrix_data_t g_estimated = lagged->data[2];
+    assert(g_estimated > 9 && g_estimated < 10);
+}
+
+// time between two ticks, and a measurement's offset into its tick, in milliseconds
+#define OOSM_TICK (100)
+#define OOSM_OFFSET (30)
+
+/*!
+* \brief Runs the gravity Kalman filter with every other measurement arriving two ticks late.
+* \param[in] max_replay The largest number of ticks to replay
+* \return The estimated g
+*/
+static matrix_data_t kalman_gravity_run_oosm(uint_fast16_t max_replay)
+{
+    // initialize the filter
+    kalman_gravity_init();
+
+    // fetch structures
+    kalman_t *kf = &kalman_filter_gravity;
+    kalman_measurement_t *kfm = &kalman_filter_gravity_measurement_position;
+    kalman_oosm_t *oosm = &kalman_filter_gravity_oosm;
+
+    matrix_t *x = kalman_get_state_vector(kf);
+    matrix_t *z = kalman_get_measurement_vector(kfm);
+
+    // filter!
+    for (int t = 0; t < MEAS_COUNT + 2; ++t)
+    {
+        // prediction.
+        if (t < MEAS_COUNT)
+        {
+            kalman_predict(kf);
+            kalman_oosm_record_prediction(oosm, kf, (uint_fast32_t)t * OOSM_TICK);
+        }
+
+        // even measurements are in time ...
+        if (t < MEAS_COUNT && (t & 1) == 0)
+        {
+            matrix_set(z, 0, 0, real_distance[t] + measurement_error[t]);
+            int result = kalman_oosm_correct(kf, kfm, oosm, (uint_fast32_t)t * OOSM_TICK + OOSM_OFFSET, max_replay);
+            assert(result == 0 && oosm->cost.steps == 0);
+        }
+
+        // ... odd ones arrive two ticks late
+        int i = t - 2;
+        if (i >= 0 && i < MEAS_COUNT && (i & 1) == 1)
+        {
+            matrix_data_t measurement = real_distance[i] + measurement_error[i];
+            matrix_set(z, 0, 0, measurement);
+            int result = kalman_oosm_correct(kf, kfm, oosm, (uint_fast32_t)i * OOSM_TICK + OOSM_OFFSET, max_replay);
+            assert(result == 0 && oosm->cost.steps > 0 && oosm->cost.steps <= 2);
+
+            // replaying the in-time measurement did not change the late one
+            assert(matrix_get(z, 0, 0) == measurement);
+        }
+    }
+
+    assert(oosm->cost.replays + oosm->cost.retrodictions == MEAS_COUNT / 2);
+    return x->data[2];
+}
+
+/*!
+* \brief Runs the gravity Kalman filter with out-of-sequence measurements.
+*/
+void kalman_gravity_demo_oosm()
+{
+    // replaying is exact, so it matches the in-sequence filter
+    matrix_data_t g_replayed = kalman_gravity_run_oosm(2);
+    assert(kalman_filter_gravity_oosm.cost.replays == MEAS_COUNT / 2);
+
+    // retrodicting is exact for a single late measurement and close for several
+    matrix_data_t g_retrodicted = kalman_gravity_run_oosm(0);
+    assert(kalman_filter_gravity_oosm.cost.retrodictions == MEAS_COUNT / 2);
+    assert(fabs(g_retrodicted - g_replayed) < (matrix_data_t)0.01);
+
+    // fetch estimated g
+    matrix_data_t g_estimated = g_replayed;
+    assert(g_estimated > 9 && g_estimated < 10);
+}
+
+/*!
+* \brief Runs the gravity Kalman filter with position and velocity measurements.
+* \param[in] stacked Nonzero to correct with both measurements at once, zero to correct with one after the other
+*/
+static void kalman_gravity_run_stacked(int stacked)
+{
+    // initialize the filter
+    kalman_gravity_init();
+
+    // fetch structures
+    kalman_t *kf = &kalman_filter_gravity;
+    kalman_measurement_t *kfm_position = &kalman_filter_gravity_measurement_position;
+    kalman_measurement_t *kfm_velocity = kalman_filter_gravity_measurement_velocity_init();
+    kalman_stack_t *stack = &kalman_filter_gravity_stack;
+
+    matrix_t *z_position = kalman_get_measurement_vector(kfm_position);
+    matrix_t *z_velocity = kalman_get_measurement_vector(kfm_velocity);
+
+    // z = 1*v with var(v) = 1
+    matrix_set(kalman_get_measurement_transformation(kfm_velocity), 0, 1, 1);
+    matrix_set(kalman_get_process_noise(kfm_velocity), 0, 0, 1);
+
+    // both measurements arrive at every time step
+    kalman_stack_clear(stack);
+    kalman_stack_add(stack, kfm_position);
+    kalman_stack_add(stack, kfm_velocity);
+
+    // filter!
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        // prediction.
+        kalman_predict(kf);
+
+        // measure, taking the velocity noise from the other end of the table ...
+        matrix_set(z_position, 0, 0, real_distance[i] + measurement_error[i]);
+        matrix_set(z_velocity, 0, 0, (matrix_data_t)9.81 * i + measurement_error[MEAS_COUNT - 1 - i]);
+
+        // update
+        if (stacked)
+        {
+            kalman_correct_stacked(kf, stack);
+        }
+        else
+        {
+            kalman_correct(kf, kfm_position);
+            kalman_correct(kf, kfm_velocity);
+        }
+    }
+}
+
+/*!
+* \brief Runs the gravity Kalman filter with two measurements stacked into one correction.
+*/
+void kalman_gravity_demo_stacked()
+{
+    matrix_data_t x_sequential[3];
+    matrix_data_t P_sequential[3 * 3];
+
+    // one correction per measurement
+    kalman_gravity_run_stacked(0);
+    for (int i = 0; i < 3; ++i) { x_sequential[i] = kalman_filter_gravity.x.data[i]; }
+    for (int i = 0; i < 3 * 3; ++i) { P_sequential[i] = kalman_filter_gravity.P.data[i]; }
+
+    // the stacked correction has the same result
+    kalman_gravity_run_stacked(1);
+    for (int i = 0; i < 3; ++i)
+    {
+        assert(fabs(kalman_filter_gravity.x.data[i] - x_sequential[i]) < (matrix_data_t)0.001);
+    }
+    for (int i = 0; i < 3 * 3; ++i)
+    {
+        assert(fabs(kalman_filter_gravity.P.data[i] - P_sequential[i]) < (matrix_data_t)0.001);
+    }
+
+    // fetch estimated g
+    matrix_data_t g_estimated = kalman_filter_gravity.x.data[2];
+    assert(g_estimated > 9 && g_estimated < 10);
+}
+
+// information form buffers
+static matrix_data_t information_Y[3 * 3];
+static matrix_data_t information_y[3 * 1];
+static matrix_data_t information_factor[3 * 3];
+
+/*!
+* \brief Runs the gravity Kalman filter with the measurement updates in information form.
+*/
+void kalman_gravity_demo_information()
+{
+    // the same filter with kalman_predict() and kalman_correct()
+    kalman_gravity_reference(1, 0);
+
+    // initialize the filter
+    kalman_gravity_init();
+
+    // fetch structures
+    kalman_t *kf = &kalman_filter_gravity;
+    kalman_measurement_t *kfm = &kalman_filter_gravity_measurement_position;
+
+    matrix_t *x = kalman_get_state_vector(kf);
+    matrix_t *z = kalman_get_measurement_vector(kfm);
+
+    kalman_information_t kfi;
+    kalman_information_initialize(&kfi, 3, information_Y, information_y, information_factor);
+
+    // filter!
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        // prediction in covariance form
+        kalman_predict(kf);
+
+        // measure ...
+        matrix_data_t measurement = real_distance[i] + measurement_error[i];
+        matrix_set(z, 0, 0, measurement);
+
+        // update in information form
+        int result = kalman_information_from_filter(kf, &kfi);
+        assert(result == 0);
+
+        kalman_information_correct_diagonal(&kfi, kfm);
+
+        result = kalman_information_to_filter(&kfi, kf);
+        assert(result == 0);
+    }
+
+    // the update in information form matches the one in covariance form
+    kalman_gravity_assert_reference(x->data, kf->P.data, (matrix_data_t)1e-3);
+}
+
+// bank of gravity filters
+#define BANK_COUNT (16)
+static matrix_data_t bank_x[3 * BANK_COUNT];
+static matrix_data_t bank_P[3 * 3 * BANK_COUNT];
+static matrix_data_t bank_z[1 * BANK_COUNT];
+static matrix_data_t bank_y[1 * BANK_COUNT];
+static matrix_data_t bank_S[1 * 1 * BANK_COUNT];
+static matrix_data_t bank_K[3 * 1 * BANK_COUNT];
+static matrix_data_t bank_work[3 * 3 * BANK_COUNT];
+static matrix_data_t bank_mask[BANK_COUNT];
+
+/*!
+* \brief Runs a bank of gravity Kalman filters in lockstep.
+*/
+void kalman_gravity_demo_bank()
+{
+    kalman_bank_t bank;
+
+    // initialize the filter that serves as the model for the bank
+    kalman_gravity_init();
+    kalman_bank_initialize(&bank, BANK_COUNT, &kalman_filter_gravity, &kalman_filter_gravity_measurement_position,
+                           bank_x, bank_P, bank_z, bank_y, bank_S, bank_K, bank_work, bank_mask);
+
+    // filter!
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        // prediction.
+        kalman_bank_predict(&bank);
+
+        // measure ... every filter sees the same trajectory, scaled by the filter index
+        for (int f = 0; f < BANK_COUNT; ++f)
+        {
+            matrix_data_t scale = (matrix_data_t)(1 + f) / BANK_COUNT;
+            bank_z[f] = scale * (real_distance[i] + measurement_error[i]);
+        }
+
+        // update
+        uint_fast16_t failed = kalman_bank_correct(&bank);
+        assert(failed == 0);
+    }
+
+    // every filter matches a single filter fed the same scaled measurements
+    for (int f = 0; f < BANK_COUNT; ++f)
+    {
+        matrix_data_t x[3], P[3 * 3];
+        for (int e = 0; e < 3; ++e) { x[e] = bank_x[e * BANK_COUNT + f]; }
+        for (int e = 0; e < 3 * 3; ++e) { P[e] = bank_P[e * BANK_COUNT + f]; }
+
+        kalman_gravity_reference((matrix_data_t)(1 + f) / BANK_COUNT, 0);
+        kalman_gravity_assert_reference(x, P, (matrix_data_t)1e-4);
+    }
+}
+
+// population of gravity filters sharing A, H and R
+#if KALMAN_HAVE_POOL
+#define POOL_COUNT (64)
+#define POOL_WORKERS (4)
+static kalman_t pool_filters[POOL_COUNT];
+static kalman_measurement_t pool_measurements[POOL_COUNT];
+static kalman_measurement_t *pool_measurement_list[POOL_COUNT];
+static kalman_pool_entry_t pool_entries[POOL_COUNT];
+static kalman_pool_worker_t pool_workers[POOL_WORKERS];
+
+static matrix_data_t pool_x[POOL_COUNT][3];
+static matrix_data_t pool_P[POOL_COUNT][3 * 3];
+static matrix_data_t pool_aux[POOL_COUNT][3];
+static matrix_data_t pool_predicted_x[POOL_COUNT][3];
+static matrix_data_t pool_z[POOL_COUNT][1];
+static matrix_data_t pool_y[POOL_COUNT][1];
+static matrix_data_t pool_S[POOL_COUNT][1 * 1];
+static matrix_data_t pool_K[POOL_COUNT][3 * 1];
+static matrix_data_t pool_HP[POOL_COUNT][1 * 3];
+#endif
+
+/*!
+* \brief Runs a population of gravity Kalman filters on a thread pool.
+*/
+void kalman_gravity_demo_pool()
+{
+#if KALMAN_HAVE_POOL
+    kalman_pool_t pool;
+
+    // the factory filter serves as the model for all filters
+    kalman_gravity_init();
+    kalman_t *model = &kalman_filter_gravity;
+    kalman_measurement_t *model_measurement = &kalman_filter_gravity_measurement_position;
+
+    for (int f = 0; f < POOL_COUNT; ++f)
+    {
+        kalman_filter_initialize(&pool_filters[f], 3, 0, model->A.data, pool_x[f], (matrix_data_t*)0, (matrix_data_t*)0, pool_P[f], (matrix_data_t*)0,
+                                 pool_aux[f], pool_predicted_x[f], (matrix_data_t*)0);
+        kalman_measurement_initialize(&pool_measurements[f], 3, 1, model_measurement->H.data, pool_z[f], model_measurement->R.data,
+                                      pool_y[f], pool_S[f], pool_K[f], pool_aux[f], pool_HP[f]);
+
+        matrix_copy(&model->x, &pool_filters[f].x);
+        matrix_copy(&model->P, &pool_filters[f].P);
+
+        pool_measurement_list[f] = &pool_measurements[f];
+        pool_entries[f].filter = &pool_filters[f];
+        pool_entries[f].measurements = &pool_measurement_list[f];
+        pool_entries[f].num_measurements = 1;
+        pool_entries[f].pending = 0;
+    }
+
+    int result = kalman_pool_initialize(&pool, pool_entries, POOL_COUNT, pool_workers, POOL_WORKERS);
+    assert(result == 0);
+
+    // filter!
+    for (int i = 0; i < MEAS_COUNT; ++i)
+    {
+        // measure ... every other filter misses every third measurement
+        for (int f = 0; f < POOL_COUNT; ++f)
+        {
+            if ((f & 1) && (i % 3 == 2)) continue;
+
+            pool_z[f][0] = real_distance[i] + measurement_error[i];
+            kalman_pool_mark_measurement(&pool, f, 0);
+        }
+
+        // predict and update all filters
+        kalman_pool_tick(&pool);
+        kalman_pool_wait(&pool);
+    }
+
+    kalman_pool_destroy(&pool);
+
+    // every filter matches a single filter fed the same measurements, with or without the gaps
+    for (int gap = 0; gap < 2; ++gap)
+    {
+        kalman_gravity_reference(1, gap);
+        for (int f = gap; f < POOL_COUNT; f += 2)
+        {
+            kalman_gravity_assert_reference(pool_x[f], pool_P[f], (matrix_data_t)1e-4);
+        }
+    }
+#endif
+}
@@ -6,9 +6,119 @@
 */
 void kalman_gravity_demo();
 
+/*!
+* \brief Runs the gravity Kalman filter with the sparse prediction.
+*/
+void kalman_gravity_demo_sparse();
+
 /*!
 * \brief Runs the gravity Kalman filter with lambda tuning.
 */
 void kalman_gravity_demo_lambda();
 
+/*!
+* \brief Runs the gravity Kalman filter using the fixed-size functions created by the factory.
+*/
+void kalman_gravity_demo_fixed();
+
+/*!
+* \brief Runs the gravity Kalman filter using sequential scalar measurement updates.
+*/
+void kalman_gravity_demo_sequential();
+
+/*!
+* \brief Runs the gravity Kalman filter in Q15.16 fixed-point arithmetic.
+*/
+void kalman_gravity_demo_fixed_point();
+
+/*!
+* \brief Runs the gravity Kalman filter with the gain calculated in double precision.
+*/
+void kalman_gravity_demo_mixed();
+
+/*!
+* \brief Runs the gravity Kalman filter in square root form.
+*/
+void kalman_gravity_demo_sqrt();
+
+/*!
+* \brief Runs the gravity Kalman filter in UD form.
+*/
+void kalman_gravity_demo_ud();
+
+/*!
+* \brief Runs the gravity Kalman filter with a frozen gain once it has converged.
+*/
+void kalman_gravity_demo_steady_state();
+
+/*!
+* \brief Runs the gravity Kalman filter with a second measurement that keeps correcting after the first froze the covariance.
+*/
+void kalman_gravity_demo_steady_state_shared();
+
+/*!
+* \brief Runs a gravity Kalman filter initialized at steady state by the Riccati equation solver.
+*/
+void kalman_gravity_demo_dare();
+
+/*!
+* \brief Solves the Riccati equation of a block diagonal model with more than 16 states.
+*/
+void kalman_gravity_demo_dare_wide();
+
+/*!
+* \brief Runs the gravity Kalman filter with a measurement every third tick, coasting over the gaps.
+*/
+void kalman_gravity_demo_steps();
+
+/*!
+* \brief Runs the gravity Kalman filter on irregularly timed measurements.
+*/
+void kalman_gravity_demo_dt();
+
+/*!
+* \brief Runs the gravity Kalman filter as an extended Kalman filter with a nonlinear range measurement.
+*/
+void kalman_gravity_demo_ekf();
+
+/*!
+* \brief Runs the gravity Kalman filter as an unscented Kalman filter with a nonlinear range measurement.
+*/
+void kalman_gravity_demo_ukf();
+
+/*!
+* \brief Runs the gravity Kalman filter and smooths its history.
+*/
+void kalman_gravity_demo_smoother();
+
+/*!
+* \brief Runs the gravity Kalman filter with a fixed-lag smoother.
+*/
+void kalman_gravity_demo_fixed_lag();
+
+/*!
+* \brief Runs the gravity Kalman filter with out-of-sequence measurements.
+*/
+void kalman_gravity_demo_oosm();
+
+/*!
+* \brief Runs the gravity Kalman filter with two measurements stacked into one correction.
+*/
+void kalman_gravity_demo_stacked();
+
+/*!
+* \brief Runs the gravity Kalman filter with the measurement updates in information form.
+*/
+void kalman_gravity_demo_information();
+
+/*!
+* \brief Runs a bank of gravity Kalman filters in lockstep.
+*/
+void kalman_gravity_demo_bank();
+
+/*!
+* \brief Runs a population of gravity Kalman filters on a thread pool.
+*/
+void kalman_gravity_demo_pool();
+
 #endif
@@ -0,0 +1,178 @@
+#include <stdint.h>
+#include <assert.h>
+
+#define EXTERN_INLINE_MATRIX static INLINE
+#define EXTERN_INLINE_KALMAN static INLINE
+#include "cholesky.h"
+#include "kalman_fixed_lag.h"
+
+/*!
+* \brief Initializes a fixed-lag smoother.
+* \param[in] kfl The smoother to initialize
+* \param[in] num_states The number of state variables
+* \param[in] entries The lagged copies ({\ref lag})
+* \param[in] lag The lag in time steps (\c 1 or more)
+* \param[in] buffer The buffer for the lagged copies ({\ref lag} x ({\ref num_states} + {\ref num_states} x {\ref num_states}))
+*/
+void kalman_fixed_lag_initialize(kalman_fixed_lag_t *kfl, uint_fast8_t num_states, kalman_fixed_lag_entry_t *entries, uint_fast8_t lag,
+                                 matrix_data_t *buffer)
+{
+    uint_fast8_t i;
+    const uint_fast16_t stride = (uint_fast16_t)num_states * (num_states + 1);
+
+    assert(lag > 0);
+
+    kfl->entries = entries;
+    kfl->lag = lag;
+
+    for (i = 0; i < lag; ++i)
+    {
+        matrix_init(&entries[i].P, num_states, num_states, &buffer[i * stride]);
+        matrix_init(&entries[i].x, num_states, 1, &buffer[i * stride + (uint_fast16_t)num_states * num_states]);
+    }
+
+    kalman_fixed_lag_clear(kfl);
+}
+
+/*!
+* \brief Discards all lagged copies, e.g. after the filter has been reset.
+* \param[in] kfl The smoother to clear
+*/
+void kalman_fixed_lag_clear(kalman_fixed_lag_t *kfl)
+{
+    kfl->count = 0;
+    kfl->head = 0;
+}
+
+/*!
+* \brief Gets the lagged copy of an age.
+* \param[in] kfl The smoother
+* \param[in] lag The age of the copy (\c 1 to {\ref count})
+* \return The lagged copy
+*/
+static kalman_fixed_lag_entry_t* kalman_fixed_lag_entry(const kalman_fixed_lag_t *kfl, uint_fast8_t lag)
+{
+    uint_fast16_t index = (uint_fast16_t)kfl->head + lag - 1;
+    if (index >= kfl->lag) index -= kfl->lag;
+    return &kfl->entries[index];
+}
+
+/*!
+* \brief Performs the time update / prediction step of the filter and shifts the lagged copies.
+* \param[in] kf The Kalman Filter structure to predict with; must propagate the full covariance
+* \param[in] kfl The smoother
+*/
+void kalman_fixed_lag_predict(kalman_t *kf, kalman_fixed_lag_t *kfl)
+{
+    uint_fast8_t i, r;
+    const uint_fast8_t n = kf->x.rows;
+    const matrix_t *RESTRICT const A = &kf->A;
+    matrix_t *RESTRICT const row_predicted = &kf->temporary.predicted_x;
+    kalman_fixed_lag_entry_t *entry;
+    matrix_t row;
+
+    assert(kf->temporary.sqrt_work == (matrix_data_t*)0 && kf->temporary.ud_work == (matrix_data_t*)0);
+    assert(kfl->entries[0].x.rows == n);
+
+    // the current state becomes the copy with a lag of one, dropping the oldest copy
+    kfl->head = (kfl->head == 0) ? kfl->lag - 1 : kfl->head - 1;
+    if (kfl->count < kfl->lag) ++kfl->count;
+
+    entry = &kfl->entries[kfl->head];
+    matrix_copy(&kf->x, &entry->x);
+    matrix_copy(&kf->P, &entry->P);
+
+    // P_i = P_i*A', i.e. every row p of P_i becomes A*p
+    for (i = 1; i <= kfl->count; ++i)
+    {
+        entry = kalman_fixed_lag_entry(kfl, i);
+        for (r = 0; r < n; ++r)
+        {
+            matrix_init(&row, n, 1, &entry->P.data[r * n]);
+            if (kf->A_sparsity.offsets != (uint_fast16_t*)0)
+            {
+                matrix_mult_rowvector_sparse(A, &kf->A_sparsity, &row, row_predicted);
+            }
+            else
+            {
+                matrix_mult_rowvector(A, &row, row_predicted);
+            }
+            matrix_copy(row_predicted, &row);
+        }
+    }
+
+    kalman_predict(kf);
+}
+
+/*!
+* \brief Performs the measurement update step of the filter and corrects the lagged copies.
+* \param[in] kf The Kalman Filter structure to correct; must propagate the full covariance, which must not be frozen at steady state
+* \param[in] kfm The measurement to correct with; must not be frozen at steady state or use mixed precision
+* \param[in] kfl The smoother
+*/
+void kalman_fixed_lag_correct(kalman_t *kf, kalman_measurement_t *kfm, kalman_fixed_lag_t *kfl)
+{
+    uint_fast8_t i, r, c, j;
+    const uint_fast8_t n = kf->x.rows;
+    const uint_fast8_t m = kfm->z.rows;
+    const matrix_t *RESTRICT const H = &kfm->H;
+    const matrix_data_t *RESTRICT const K = kfm->K.data;
+    matrix_t row, u, w;
+
+    // the lagged gains need the factor of S that only the plain correction leaves behind
+    assert(kf->temporary.sqrt_work == (matrix_data_t*)0 && kf->temporary.ud_work == (matrix_data_t*)0);
+    assert(!kfm->steady_state.frozen && kfm->temporary.wide == (matrix_wide_t*)0);
+    assert(!kf->covariance_frozen);
+
+    kalman_correct(kf, kfm);
+
+    // H*P is no longer required, so its buffer holds w = y' * S^-1, and aux holds u = H*p
+    matrix_init(&w, 1, m, kfm->temporary.HP.data);
+    matrix_init(&u, m, 1, kfm->temporary.aux);
+    cholesky_solve_transb(&kfm->S, &kfm->y, &w);
+
+    for (i = 1; i <= kfl->count; ++i)
+    {
+        kalman_fixed_lag_entry_t *const entry = kalman_fixed_lag_entry(kfl, i);
+
+        // per row p of P_i: x_i = x_i + (H*p)' * S^-1*y and p = p - K*(H*p)
+        for (r = 0; r < n; ++r)
+        {
+            matrix_data_t *RESTRICT const p = &entry->P.data[r * n];
+            matrix_data_t correction = 0;
+
+            matrix_init(&row, n, 1, p);
+            matrix_mult_rowvector(H, &row, &u);
+
+            for (j = 0; j < m; ++j)
+            {
+                correction += u.data[j] * w.data[j];
+            }
+            entry->x.data[r] += correction;
+
+            for (c = 0; c < n; ++c)
+            {
+                matrix_data_t total = 0;
+                for (j = 0; j < m; ++j)
+                {
+                    total += K[c * m + j] * u.data[j];
+                }
+                p[c] -= total;
+            }
+        }
+    }
+}
+
+/*!
+* \brief Gets the smoothed state of a past time step.
+* \param[in] kfl The smoother
+* \param[in] lag The age of the time step (\c 1 to {\ref lag})
+* \return The smoothed state, or null if fewer than {\ref lag} time steps have been predicted yet.
+*/
+const matrix_t* kalman_fixed_lag_state(const kalman_fixed_lag_t *kfl, uint_fast8_t lag)
+{
+    assert(lag > 0 && lag <= kfl->lag);
+
+    if (lag > kfl->count) return (const matrix_t*)0;
+    return &kalman_fixed_lag_entry(kfl, lag)->x;
+}
@@ -0,0 +1,204 @@
+#include <stdint.h>
+#include <assert.h>
+
+#define EXTERN_INLINE_MATRIX static INLINE
+#define EXTERN_INLINE_KALMAN static INLINE
+#include "cholesky.h"
+#include "kalman_information.h"
+
+/*!
+* \brief Initializes an information form structure.
+* \param[in] kfi The structure to initialize
+* \param[in] num_states The number of state variables
+* \param[in] Y The information matrix ({\ref num_states} x {\ref num_states})
+* \param[in] y The information vector ({\ref num_states} x \c 1)
+* \param[in] temp_factor The temporary matrix for the Cholesky factor ({\ref num_states} x {\ref num_states})
+*/
+void kalman_information_initialize(kalman_information_t *kfi, uint_fast8_t num_states, matrix_data_t *Y, matrix_data_t *y, matrix_data_t *temp_factor)
+{
+    matrix_init(&kfi->Y, num_states, num_states, Y);
+    matrix_init(&kfi->y, num_states, 1, y);
+
+    // set temporaries
+    matrix_init(&kfi->temporary.factor, num_states, num_states, temp_factor);
+}
+
+/*!
+* \brief Converts the state and covariance of a filter into information form.
+* \param[in] kf The filter to read x and P from; must propagate the full covariance
+* \param[out] kfi The information form structure
+* \return Zero in case of success, nonzero if P is not positive definite.
+*/
+int kalman_information_from_filter(const kalman_t *kf, kalman_information_t *kfi)
+{
+    matrix_t *RESTRICT const factor = &kfi->temporary.factor;
+
+    assert(kf->temporary.sqrt_work == (matrix_data_t*)0 && kf->temporary.ud_work == (matrix_data_t*)0);
+    assert(kf->P.rows == kfi->Y.rows);
+
+    // Y = P^-1
+    matrix_copy(&kf->P, factor);
+    if (cholesky_decompose_lower(factor) != 0) return 1;
+    matrix_invert_lower(factor, &kfi->Y);
+
+    // y = Y*x
+    matrix_mult_rowvector(&kfi->Y, &kf->x, &kfi->y);
+    return 0;
+}
+
+/*!
+* \brief Converts the information form back into the state and covariance of a filter.
+* \param[in] kfi The information form structure
+* \param[out] kf The filter to write x and P to; must propagate the full covariance
+* \return Zero in case of success, nonzero if Y is not positive definite.
+*/
+int kalman_information_to_filter(kalman_information_t *kfi, kalman_t *kf)
+{
+    matrix_t *RESTRICT const factor = &kfi->temporary.factor;
+
+    assert(kf->temporary.sqrt_work == (matrix_data_t*)0 && kf->temporary.ud_work == (matrix_data_t*)0);
+    assert(kf->P.rows == kfi->Y.rows);
+
+    // P = Y^-1
+    matrix_copy(&kfi->Y, factor);
+    if (cholesky_decompose_lower(factor) != 0) return 1;
+    matrix_invert_lower(factor, &kf->P);
+
+    // x = P*y
+    matrix_mult_rowvector(&kf->P, &kfi->y, &kf->x);
+    return 0;
+}
+
+/*!
+* \brief Clears the information matrix and vector, e.g. of a partial structure prior to accumulation.
+* \param[in] kfi The information form structure
+*/
+void kalman_information_clear(kalman_information_t *kfi)
+{
+    uint_fast16_t i;
+    const uint_fast8_t n = kfi->Y.rows;
+
+    for (i = 0; i < (uint_fast16_t)n * n; ++i) { kfi->Y.data[i] = 0; }
+    for (i = 0; i < n; ++i) { kfi->y.data[i] = 0; }
+}
+
+/*!
+* \brief Adds a partial information matrix and vector, such that Y = Y + Y_partial and y = y + y_partial.
+* \param[in] kfi The information form structure to add to
+* \param[in] partial The partial information, e.g. accumulated from a block of measurements
+*/
+void kalman_information_merge(kalman_information_t *kfi, const kalman_information_t *partial)
+{
+    matrix_add_inplace(&kfi->Y, &partial->Y);
+    matrix_add_inplace(&kfi->y, &partial->y);
+}
+
+/*!
+* \brief Accumulates Y = Y + H'*W*H and y = y + H'*W*z for a diagonal weight W.
+* \param[in] kfi The information form structure to add to
+* \param[in] H The measurement transformation ({\ref m} x {\ref n})
+* \param[in] z The measurement ({\ref m} x \c 1)
+* \param[in] R The diagonal measurement covariance ({\ref m} x {\ref m}), whose inverse diagonal is W, or null if W = I
+* \param[in] m The number of measurements
+*
+* Only the lower triangle of Y is accumulated row by row of H; the upper triangle is mirrored once at the end.
+*/
+static void kalman_information_accumulate(kalman_information_t *kfi, const matrix_data_t *RESTRICT H, const matrix_data_t *RESTRICT z,
+                                          const matrix_data_t *RESTRICT R, const uint_fast8_t m)
+{
+    uint_fast8_t r, i, j;
+    const uint_fast8_t n = kfi->Y.rows;
+    matrix_data_t *RESTRICT const Y = kfi->Y.data;
+    matrix_data_t *RESTRICT const y = kfi->y.data;
+
+    for (r = 0; r < m; ++r)
+    {
+        const matrix_data_t *RESTRICT const h = &H[r * n];
+        const matrix_data_t w = (R != (matrix_data_t*)0) ? (matrix_data_t)1.0 / R[r * m + r] : (matrix_data_t)1.0;
+        const matrix_data_t wz = w * z[r];
+
+        for (i = 0; i < n; ++i)
+        {
+            const matrix_data_t hw = h[i] * w;
+            if (hw == 0) continue;
+
+            y[i] += h[i] * wz;
+            for (j = 0; j <= i; ++j)
+            {
+                Y[i * n + j] += hw * h[j];
+            }
+        }
+    }
+
+    // mirror the lower triangle
+    for (i = 1; i < n; ++i)
+    {
+        for (j = 0; j < i; ++j)
+        {
+            Y[j * n + i] = Y[i * n + j];
+        }
+    }
+}
+
+/*!
+* \brief Performs the measurement update in information form with a diagonal measurement covariance.
+* \param[in] kfi The information form structure to correct
+* \param[in] kfm The measurement providing H, R and z; R must be diagonal, off-diagonal entries are ignored.
+*/
+void kalman_information_correct_diagonal(kalman_information_t *kfi, const kalman_measurement_t *kfm)
+{
+    assert(kfm->H.cols == kfi->Y.rows);
+
+    kalman_information_accumulate(kfi, kfm->H.data, kfm->z.data, kfm->R.data, kfm->H.rows);
+}
+
+/*!
+* \brief Performs the measurement update in information form with a full measurement covariance.
+* \param[in] kfi The information form structure to correct
+* \param[in] kfm The measurement providing H, R and z
+* \return Zero in case of success, nonzero if R is not positive definite.
+*/
+int kalman_information_correct(kalman_information_t *kfi, kalman_measurement_t *kfm)
+{
+    uint_fast8_t r, k, c;
+    const uint_fast8_t n = kfm->H.cols;
+    const uint_fast8_t m = kfm->H.rows;
+
+    const matrix_data_t *RESTRICT const H = kfm->H.data;
+    const matrix_data_t *RESTRICT const z = kfm->z.data;
+    const matrix_data_t *RESTRICT const L = kfm->S.data;
+    matrix_data_t *RESTRICT const Hw = kfm->temporary.HP.data;
+    matrix_data_t *RESTRICT const zw = kfm->y.data;
+
+    assert(n == kfi->Y.rows);
+    assert(Hw != (matrix_data_t*)0 && kfm->S.data != (matrix_data_t*)0);
+
+    // R = L*L'
+    matrix_copy(&kfm->R, &kfm->S);
+    if (cholesky_decompose_lower(&kfm->S) != 0) return 1;
+
+    // Hw = L^-1 * H, zw = L^-1 * z by forward substitution, row by row
+    for (r = 0; r < m; ++r)
+    {
+        const matrix_data_t inv_l = (matrix_data_t)1.0 / L[r * m + r];
+        matrix_data_t *RESTRICT const hrow = &Hw[r * n];
+        matrix_data_t zsum = z[r];
+
+        for (c = 0; c < n; ++c) { hrow[c] = H[r * n + c]; }
+        for (k = 0; k < r; ++k)
+        {
+            const matrix_data_t l = L[r * m + k];
+            if (l == 0) continue;
+
+            for (c = 0; c < n; ++c) { hrow[c] -= l * Hw[k * n + c]; }
+            zsum -= l * zw[k];
+        }
+
+        for (c = 0; c < n; ++c) { hrow[c] *= inv_l; }
+        zw[r] = zsum * inv_l;
+    }
+
+    // the whitened measurements have unit covariance
+    kalman_information_accumulate(kfi, Hw, zw, (matrix_data_t*)0, m);
+    return 0;
+}
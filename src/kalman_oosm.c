@@ -0,0 +1,415 @@
+#include <stdint.h>
+#include <assert.h>
+
+#define EXTERN_INLINE_MATRIX static INLINE
+#define EXTERN_INLINE_KALMAN static INLINE
+#include "cholesky.h"
+#include "kalman_oosm.h"
+
+/*!
+* \brief Initializes out-of-sequence measurement handling.
+* \param[in] oosm The structure to initialize
+* \param[in] num_states The number of state variables
+* \param[in] checkpoints The checkpoints ({\ref capacity})
+* \param[in] capacity The number of checkpoints (\c 2 or more)
+* \param[in] buffer The buffer for the checkpoint matrices ({\ref capacity} x (2 x {\ref num_states} + 3 x {\ref num_states} x {\ref num_states}))
+* \param[in] log The measurement logs ({\ref capacity} x {\ref log_capacity})
+* \param[in] log_capacity The number of logged measurements per checkpoint (\c 1 or more)
+* \param[in] log_buffer The buffer for the logged measurement vectors ({\ref capacity} x {\ref log_capacity} x {\ref max_measurements})
+* \param[in] max_measurements The largest number of measurements of any logged measurement structure
+* \param[in] temp The temporary buffer (5 x {\ref num_states} x {\ref num_states} + 3 x {\ref num_states})
+*/
+void kalman_oosm_initialize(kalman_oosm_t *oosm, uint_fast8_t num_states, kalman_oosm_checkpoint_t *checkpoints, uint_fast16_t capacity,
+                            matrix_data_t *buffer, kalman_oosm_log_t *log, uint_fast8_t log_capacity, matrix_data_t *log_buffer,
+                            uint_fast8_t max_measurements, matrix_data_t *temp)
+{
+    uint_fast16_t i;
+    uint_fast8_t j;
+    const uint_fast16_t size = (uint_fast16_t)num_states * num_states;
+    const uint_fast16_t stride = 2 * (uint_fast16_t)num_states + 3 * size;
+
+    assert(capacity > 1 && log_capacity > 0 && max_measurements > 0);
+
+    oosm->checkpoints = checkpoints;
+    oosm->capacity = capacity;
+    oosm->log_capacity = log_capacity;
+    oosm->max_measurements = max_measurements;
+
+    for (i = 0; i < capacity; ++i)
+    {
+        kalman_oosm_checkpoint_t *const checkpoint = &checkpoints[i];
+        matrix_data_t *const data = &buffer[i * stride];
+
+        matrix_init(&checkpoint->A, num_states, num_states, &data[0]);
+        matrix_init(&checkpoint->P_predicted, num_states, num_states, &data[size]);
+        matrix_init(&checkpoint->P, num_states, num_states, &data[2 * size]);
+        matrix_init(&checkpoint->x_predicted, num_states, 1, &data[3 * size]);
+        matrix_init(&checkpoint->x, num_states, 1, &data[3 * size + num_states]);
+
+        // the rows of the logged vectors are set when logging
+        checkpoint->log = &log[i * log_capacity];
+        for (j = 0; j < log_capacity; ++j)
+        {
+            matrix_init(&checkpoint->log[j].z, max_measurements, 1, &log_buffer[((uint_fast32_t)i * log_capacity + j) * max_measurements]);
+        }
+    }
+
+    // set temporaries
+    matrix_init(&oosm->temporary.factor, num_states, num_states, &temp[0]);
+    matrix_init(&oosm->temporary.gain, num_states, num_states, &temp[size]);
+    matrix_init(&oosm->temporary.product, num_states, num_states, &temp[2 * size]);
+    matrix_init(&oosm->temporary.P, num_states, num_states, &temp[3 * size]);
+    matrix_init(&oosm->temporary.cross, num_states, num_states, &temp[4 * size]);
+    matrix_init(&oosm->temporary.x, num_states, 1, &temp[5 * size]);
+    matrix_init(&oosm->temporary.difference, num_states, 1, &temp[5 * size + num_states]);
+    oosm->temporary.aux = &temp[5 * size + 2 * num_states];
+
+    oosm->cost.replays = 0;
+    oosm->cost.retrodictions = 0;
+
+    kalman_oosm_clear(oosm);
+}
+
+/*!
+* \brief Discards all checkpoints, e.g. after the filter has been reset.
+* \param[in] oosm The structure to clear
+*/
+void kalman_oosm_clear(kalman_oosm_t *oosm)
+{
+    oosm->count = 0;
+    oosm->head = 0;
+    oosm->sequence = 0;
+    oosm->stale.begin = 0;
+    oosm->stale.end = 0;
+    oosm->cost.steps = 0;
+    oosm->cost.corrections = 0;
+}
+
+/*!
+* \brief Gets the checkpoint of an age.
+* \param[in] oosm The structure
+* \param[in] age The age from the newest checkpoint (less than {\ref count})
+* \return The checkpoint
+*/
+static kalman_oosm_checkpoint_t* kalman_oosm_checkpoint(const kalman_oosm_t *oosm, uint_fast16_t age)
+{
+    uint_fast16_t index = oosm->head + oosm->capacity - 1 - age;
+    if (index >= oosm->capacity) index -= oosm->capacity;
+    return &oosm->checkpoints[index];
+}
+
+/*!
+* \brief Logs the measurement vector of a measurement structure at a checkpoint.
+* \param[in] oosm The structure
+* \param[in] checkpoint The checkpoint
+* \param[in] kfm The measurement
+*/
+static void kalman_oosm_log(const kalman_oosm_t *oosm, kalman_oosm_checkpoint_t *checkpoint, kalman_measurement_t *kfm)
+{
+    kalman_oosm_log_t *entry;
+
+    // the z buffers are sized for the largest measurement
+    assert(kfm->z.rows <= oosm->max_measurements);
+
+    if (checkpoint->log_count == oosm->log_capacity)
+    {
+        checkpoint->log_overflow = 1;
+        return;
+    }
+
+    entry = &checkpoint->log[checkpoint->log_count++];
+    entry->kfm = kfm;
+    entry->z.rows = kfm->z.rows;
+    matrix_copy(&kfm->z, &entry->z);
+}
+
+/*!
+* \brief Opens a checkpoint after a prediction.
+* \param[in] oosm The structure
+* \param[in] kf The filter that has just been predicted; must propagate the full covariance
+* \param[in] timestamp The time stamp of the predicted time step, later than that of the previous checkpoint
+*/
+void kalman_oosm_record_prediction(kalman_oosm_t *oosm, const kalman_t *kf, uint_fast32_t timestamp)
+{
+    kalman_oosm_checkpoint_t *const checkpoint = &oosm->checkpoints[oosm->head];
+
+    assert(kf->temporary.sqrt_work == (matrix_data_t*)0 && kf->temporary.ud_work == (matrix_data_t*)0);
+    assert(oosm->count == 0 || timestamp > kalman_oosm_checkpoint(oosm, 0)->timestamp);
+    assert(checkpoint->A.rows == kf->A.rows);
+
+    checkpoint->timestamp = timestamp;
+    checkpoint->sequence = oosm->sequence++;
+    checkpoint->log_count = 0;
+    checkpoint->log_overflow = 0;
+
+    matrix_copy(&kf->A, &checkpoint->A);
+    matrix_copy(&kf->x, &checkpoint->x_predicted);
+    matrix_copy(&kf->P, &checkpoint->P_predicted);
+
+    // without a correction, the a posteriori values are the a priori ones
+    matrix_copy(&kf->x, &checkpoint->x);
+    matrix_copy(&kf->P, &checkpoint->P);
+
+    // advance, overwriting the oldest checkpoint once the ring is full
+    if (++oosm->head == oosm->capacity) oosm->head = 0;
+    if (oosm->count < oosm->capacity) ++oosm->count;
+}
+
+/*!
+* \brief Updates the newest checkpoint after an in-sequence correction and logs the measurement.
+* \param[in] oosm The structure
+* \param[in] kf The filter that has just been corrected; must propagate the full covariance
+* \param[in] kfm The measurement the filter has just been corrected with
+*/
+void kalman_oosm_record_correction(kalman_oosm_t *oosm, const kalman_t *kf, kalman_measurement_t *kfm)
+{
+    kalman_oosm_checkpoint_t *checkpoint;
+
+    assert(oosm->count > 0);
+    assert(kf->temporary.sqrt_work == (matrix_data_t*)0 && kf->temporary.ud_work == (matrix_data_t*)0);
+
+    checkpoint = kalman_oosm_checkpoint(oosm, 0);
+    matrix_copy(&kf->x, &checkpoint->x);
+    matrix_copy(&kf->P, &checkpoint->P);
+
+    kalman_oosm_log(oosm, checkpoint, kfm);
+}
+
+/*!
+* \brief Determines whether a replay starting at a checkpoint re-creates all measurements.
+* \param[in] oosm The structure
+* \param[in] age The age of the checkpoint
+* \return Nonzero if the replay is exact.
+*/
+static int kalman_oosm_replayable(const kalman_oosm_t *oosm, uint_fast16_t age)
+{
+    uint_fast16_t i;
+    const kalman_oosm_checkpoint_t *const start = kalman_oosm_checkpoint(oosm, age);
+    const uint_fast32_t sequence = start->sequence;
+
+    // the a posteriori values of the start must not lack a retrodicted measurement
+    if (sequence >= oosm->stale.begin && sequence < oosm->stale.end) return 0;
+
+    // the late measurement is logged at the start, which also keeps its vector to restore
+    if (start->log_count == oosm->log_capacity) return 0;
+
+    // all newer corrections must be logged
+    for (i = 0; i < age; ++i)
+    {
+        if (kalman_oosm_checkpoint(oosm, i)->log_overflow) return 0;
+    }
+    return 1;
+}
+
+/*!
+* \brief Applies a late measurement by replaying the filter from a checkpoint.
+* \param[in] kf The Kalman Filter structure
+* \param[in] kfm The late measurement
+* \param[in] oosm The structure
+* \param[in] age The age of the checkpoint the measurement belongs to
+*/
+static void kalman_oosm_replay(kalman_t *kf, kalman_measurement_t *kfm, kalman_oosm_t *oosm, uint_fast16_t age)
+{
+    uint_fast8_t j;
+    matrix_t *RESTRICT const difference = &oosm->temporary.difference;
+    matrix_t *RESTRICT const product = &oosm->temporary.product;
+    matrix_data_t *RESTRICT const aux = oosm->temporary.aux;
+    kalman_oosm_checkpoint_t *checkpoint = kalman_oosm_checkpoint(oosm, age);
+    const kalman_oosm_log_t *const late = &checkpoint->log[checkpoint->log_count];
+
+    // the replay re-creates the a posteriori values of all newer checkpoints
+    if (checkpoint->sequence < oosm->stale.begin) oosm->stale.end = oosm->stale.begin;
+
+    // correct the checkpoint with the late measurement
+    matrix_copy(&checkpoint->x, &kf->x);
+    matrix_copy(&checkpoint->P, &kf->P);
+    kalman_correct(kf, kfm);
+    kalman_oosm_log(oosm, checkpoint, kfm);
+
+    for (;;)
+    {
+        // the change of the a posteriori values
+        matrix_copy(&checkpoint->x, difference);
+        matrix_sub_inplace_b(&kf->x, difference);
+        matrix_copy(&checkpoint->P, product);
+        matrix_sub_inplace_b(&kf->P, product);
+
+        matrix_copy(&kf->x, &checkpoint->x);
+        matrix_copy(&kf->P, &checkpoint->P);
+
+        if (age == 0) break;
+        checkpoint = kalman_oosm_checkpoint(oosm, --age);
+        ++oosm->cost.steps;
+
+        // the change propagates linearly: x = x + A*dx, P = P + A*dP*A'
+        matrix_multadd_rowvector(&checkpoint->A, difference, &checkpoint->x_predicted);
+        matrix_mult_abat(&checkpoint->A, product, 1, (matrix_t*)0, (matrix_t*)0, aux);
+        matrix_add_inplace(&checkpoint->P_predicted, product);
+
+        // re-run the logged corrections
+        matrix_copy(&checkpoint->x_predicted, &kf->x);
+        matrix_copy(&checkpoint->P_predicted, &kf->P);
+        for (j = 0; j < checkpoint->log_count; ++j)
+        {
+            kalman_oosm_log_t *const entry = &checkpoint->log[j];
+            matrix_copy(&entry->z, &entry->kfm->z);
+            kalman_correct(kf, entry->kfm);
+            ++oosm->cost.corrections;
+        }
+    }
+
+    // the logged corrections may have reused the structure of the late measurement
+    matrix_copy(&late->z, &kfm->z);
+
+    ++oosm->cost.replays;
+}
+
+/*!
+* \brief Applies a late measurement in one step through the retrodicted state at a checkpoint.
+* \param[in] kf The Kalman Filter structure
+* \param[in] kfm The late measurement
+* \param[in] oosm The structure
+* \param[in] age The age of the checkpoint the measurement belongs to
+* \return Zero in case of success, nonzero if a covariance is not positive definite.
+*/
+static int kalman_oosm_retrodict(kalman_t *kf, kalman_measurement_t *kfm, kalman_oosm_t *oosm, uint_fast16_t age)
+{
+    uint_fast16_t i;
+    matrix_t *RESTRICT const factor = &oosm->temporary.factor;
+    matrix_t *RESTRICT const gain = &oosm->temporary.gain;
+    matrix_t *RESTRICT const product = &oosm->temporary.product;
+    matrix_t *RESTRICT const Ps = &oosm->temporary.P;
+    matrix_t *RESTRICT const cross = &oosm->temporary.cross;
+    matrix_t *RESTRICT const xs = &oosm->temporary.x;
+    matrix_t *RESTRICT const difference = &oosm->temporary.difference;
+    matrix_data_t *RESTRICT const aux = oosm->temporary.aux;
+    matrix_t *RESTRICT const HP = &kfm->temporary.HP;
+    kalman_oosm_checkpoint_t *const newest = kalman_oosm_checkpoint(oosm, 0);
+
+    assert(!kfm->steady_state.frozen && !kf->covariance_frozen);
+
+    /************************************************************************/
+    /* Retrodict with a Rauch-Tung-Striebel backward pass                   */
+    /* C = P*A' * P_predicted^-1                                            */
+    /* x_s = x + C*(x_s - x_predicted)                                      */
+    /* P_s = P + C*(P_s - P_predicted)*C'                                   */
+    /* X = C*X, the cross covariance with the current state                 */
+    /************************************************************************/
+
+    matrix_copy(&newest->x, xs);
+    matrix_copy(&newest->P, Ps);
+    matrix_copy(&newest->P, cross);
+
+    for (i = 0; i < age; ++i)
+    {
+        const kalman_oosm_checkpoint_t *const next = kalman_oosm_checkpoint(oosm, i);
+        const kalman_oosm_checkpoint_t *const checkpoint = kalman_oosm_checkpoint(oosm, i + 1);
+        ++oosm->cost.steps;
+
+        // C = (A*P)' * P_predicted^-1
+        matrix_mult(&next->A, &checkpoint->P, product, aux);
+        matrix_copy(&next->P_predicted, factor);
+        if (cholesky_decompose_lower(factor) != 0) return 1;
+        cholesky_solve_transb(factor, product, gain);
+
+        // x_s = x + C*(x_s - x_predicted)
+        matrix_copy(&next->x_predicted, difference);
+        matrix_sub_inplace_b(xs, difference);
+        matrix_copy(&checkpoint->x, xs);
+        matrix_multadd_rowvector(gain, difference, xs);
+
+        // P_s = P + C*(P_s - P_predicted)*C'
+        matrix_copy(&next->P_predicted, product);
+        matrix_sub_inplace_b(Ps, product);
+        matrix_mult_abat(gain, product, 1, (matrix_t*)0, (matrix_t*)0, aux);
+        matrix_copy(&checkpoint->P, Ps);
+        matrix_add_inplace(Ps, product);
+
+        // X = C*X
+        matrix_mult(gain, cross, product, aux);
+        matrix_copy(product, cross);
+    }
+
+    /************************************************************************/
+    /* Correct the current state                                            */
+    /* S = H*P_s*H' + R                                                     */
+    /* K = X'*H' * S^-1                                                     */
+    /* x = x + K*(z - H*x_s)                                                */
+    /* P = P - K*(H*X)                                                      */
+    /************************************************************************/
+
+    // S = H*P_s*H' + R
+    matrix_mult(&kfm->H, Ps, HP, aux);
+    matrix_mult_transb_symmetric(HP, &kfm->H, &kfm->S);
+    matrix_add_inplace(&kfm->S, &kfm->R);
+
+    // y = z - H*x_s
+    matrix_mult_rowvector(&kfm->H, xs, &kfm->y);
+    matrix_sub_inplace_b(&kfm->z, &kfm->y);
+
+    // K = (H*X)' * S^-1
+    matrix_mult(&kfm->H, cross, HP, aux);
+    if (cholesky_decompose_lower(&kfm->S) != 0) return 1;
+    cholesky_solve_transb(&kfm->S, HP, &kfm->K);
+
+    // x = x + K*y, P = P - K*(H*X)
+    matrix_multadd_rowvector(&kfm->K, &kfm->y, &kf->x);
+    matrix_multsub_symmetric(&kfm->K, HP, &kf->P);
+
+    matrix_copy(&kf->x, &newest->x);
+    matrix_copy(&kf->P, &newest->P);
+
+    // the checkpoints in between now lack the measurement
+    kalman_oosm_log(oosm, kalman_oosm_checkpoint(oosm, age), kfm);
+    {
+        const uint_fast32_t begin = kalman_oosm_checkpoint(oosm, age)->sequence;
+        if (oosm->stale.end == oosm->stale.begin || begin < oosm->stale.begin) oosm->stale.begin = begin;
+        oosm->stale.end = newest->sequence;
+    }
+
+    ++oosm->cost.retrodictions;
+    return 0;
+}
+
+/*!
+* \brief Applies a measurement that may be older than the current time step.
+* \param[in] kf The Kalman Filter structure to correct; must propagate the full covariance
+* \param[in] kfm The measurement to correct with; z must be set
+* \param[in] oosm The structure
+* \param[in] timestamp The time stamp of the measurement
+* \param[in] max_replay The largest number of checkpoints to replay
+* \return Zero in case of success, nonzero if the measurement is older than the oldest checkpoint or a covariance
+*         is not positive definite.
+*/
+int kalman_oosm_correct(kalman_t *kf, kalman_measurement_t *kfm, kalman_oosm_t *oosm, uint_fast32_t timestamp, uint_fast16_t max_replay)
+{
+    uint_fast16_t age;
+
+    assert(kf->temporary.sqrt_work == (matrix_data_t*)0 && kf->temporary.ud_work == (matrix_data_t*)0);
+
+    oosm->cost.steps = 0;
+    oosm->cost.corrections = 0;
+
+    // find the newest checkpoint not later than the measurement
+    for (age = 0; age < oosm->count; ++age)
+    {
+        if (kalman_oosm_checkpoint(oosm, age)->timestamp <= timestamp) break;
+    }
+    if (age == oosm->count) return 1;
+
+    // in sequence
+    if (age == 0)
+    {
+        kalman_correct(kf, kfm);
+        kalman_oosm_record_correction(oosm, kf, kfm);
+        return 0;
+    }
+
+    if (age <= max_replay && kalman_oosm_replayable(oosm, age))
+    {
+        kalman_oosm_replay(kf, kfm, oosm, age);
+        return 0;
+    }
+
+    return kalman_oosm_retrodict(kf, kfm, oosm, age);
+}
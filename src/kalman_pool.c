@@ -0,0 +1,303 @@
+#include <stdint.h>
+#include <assert.h>
+
+#define EXTERN_INLINE_MATRIX static INLINE
+#define EXTERN_INLINE_KALMAN static INLINE
+#include "kalman_pool.h"
+
+#if KALMAN_HAVE_POOL
+
+/*!
+* \brief Packs a range of entry indices, tagged with the tick it belongs to.
+*
+* A worker only takes or steals from ranges of the tick it is working on, so that a worker that is
+* still looking for work of a completed tick cannot interfere with the ranges of the next one.
+*/
+static INLINE uint64_t kalman_pool_range(uint16_t tick, uint32_t begin, uint32_t end)
+{
+    return ((uint64_t)tick << 48) | ((uint64_t)begin << 24) | end;
+}
+
+#define KALMAN_POOL_RANGE_TICK(range)       ((uint16_t)((range) >> 48))
+#define KALMAN_POOL_RANGE_BEGIN(range)      ((uint32_t)((range) >> 24) & 0xFFFFFFu)
+#define KALMAN_POOL_RANGE_END(range)        ((uint32_t)(range) & 0xFFFFFFu)
+
+/*!
+* \brief Takes the next entry from the front of a worker's own range.
+* \param[in] worker The worker
+* \param[in] tick The tick the worker is working on
+* \param[out] index The index of the entry
+* \return Nonzero if an entry was taken, zero if the range is empty.
+*/
+static int kalman_pool_take(kalman_pool_worker_t *worker, uint16_t tick, uint32_t *index)
+{
+    uint64_t range = __atomic_load_n(&worker->range, __ATOMIC_ACQUIRE);
+    for (;;)
+    {
+        const uint32_t begin = KALMAN_POOL_RANGE_BEGIN(range);
+        const uint32_t end = KALMAN_POOL_RANGE_END(range);
+        if (KALMAN_POOL_RANGE_TICK(range) != tick || begin >= end) return 0;
+
+        if (__atomic_compare_exchange_n(&worker->range, &range, kalman_pool_range(tick, begin + 1, end), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            *index = begin;
+            return 1;
+        }
+    }
+}
+
+/*!
+* \brief Steals the back half of a victim's range into the (empty) range of the thief.
+* \param[in] victim The worker to steal from
+* \param[in] thief The worker to steal for
+* \param[in] tick The tick the thief is working on
+* \return Nonzero if entries were stolen.
+*/
+static int kalman_pool_steal(kalman_pool_worker_t *victim, kalman_pool_worker_t *thief, uint16_t tick)
+{
+    uint64_t range = __atomic_load_n(&victim->range, __ATOMIC_ACQUIRE);
+    for (;;)
+    {
+        const uint32_t begin = KALMAN_POOL_RANGE_BEGIN(range);
+        const uint32_t end = KALMAN_POOL_RANGE_END(range);
+        uint32_t split;
+        if (KALMAN_POOL_RANGE_TICK(range) != tick || begin >= end) return 0;
+
+        split = end - (end - begin + 1) / 2;
+        if (__atomic_compare_exchange_n(&victim->range, &range, kalman_pool_range(tick, begin, split), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            __atomic_store_n(&thief->range, kalman_pool_range(tick, split, end), __ATOMIC_RELEASE);
+            return 1;
+        }
+    }
+}
+
+/*!
+* \brief Predicts a filter and corrects it with all pending measurements.
+* \param[in] entry The filter
+*/
+static void kalman_pool_run(kalman_pool_entry_t *entry)
+{
+    uint_fast8_t i;
+    kalman_t *const kf = entry->filter;
+
+    kalman_predict(kf);
+
+    for (i = 0; i < entry->num_measurements; ++i)
+    {
+        if (entry->pending & ((uint32_t)1 << i))
+        {
+            kalman_correct(kf, entry->measurements[i]);
+        }
+    }
+
+    entry->pending = 0;
+}
+
+/*!
+* \brief Processes entries until neither the worker's own range nor any other worker has any left.
+* \param[in] worker The worker
+* \param[in] tick The tick to work on
+*/
+static void kalman_pool_work(kalman_pool_worker_t *worker, uint16_t tick)
+{
+    kalman_pool_t *const pool = worker->pool;
+    const uint_fast16_t num_workers = pool->num_workers;
+    uint32_t index;
+
+    for (;;)
+    {
+        uint_fast16_t v;
+
+        while (kalman_pool_take(worker, tick, &index))
+        {
+            kalman_pool_run(&pool->entries[index]);
+
+            // the last filter of the tick releases the barrier
+            if (__atomic_add_fetch(&pool->completed, 1, __ATOMIC_ACQ_REL) == pool->count)
+            {
+                pthread_mutex_lock(&pool->lock);
+                pthread_cond_broadcast(&pool->done);
+                pthread_mutex_unlock(&pool->lock);
+            }
+        }
+
+        // out of work, try the other workers in turn
+        for (v = 1; v < num_workers; ++v)
+        {
+            if (kalman_pool_steal(&pool->workers[(worker->index + v) % num_workers], worker, tick)) break;
+        }
+
+        if (v >= num_workers) return;
+    }
+}
+
+/*!
+* \brief Thread entry point of a worker.
+* \param[in] arg The worker
+*/
+static void* kalman_pool_worker_main(void *arg)
+{
+    kalman_pool_worker_t *const worker = (kalman_pool_worker_t*)arg;
+    kalman_pool_t *const pool = worker->pool;
+    uint_fast32_t seen = 0;
+
+    for (;;)
+    {
+        // wait for the next tick
+        pthread_mutex_lock(&pool->lock);
+        while (pool->generation == seen && !pool->shutdown)
+        {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+
+        if (pool->shutdown)
+        {
+            pthread_mutex_unlock(&pool->lock);
+            return (void*)0;
+        }
+
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        kalman_pool_work(worker, (uint16_t)seen);
+    }
+}
+
+/*!
+* \brief Initializes the pool and starts the worker threads.
+* \param[in] pool The pool to initialize
+* \param[in] entries The filters ({\ref count} entries), each with at most 32 measurements
+* \param[in] count The number of filters (less than 2^24)
+* \param[in] workers The worker buffer ({\ref num_workers} entries)
+* \param[in] num_workers The number of worker threads to start
+* \return Zero in case of success, nonzero if the threads could not be started.
+*/
+int kalman_pool_initialize(kalman_pool_t *pool, kalman_pool_entry_t *entries, uint_fast32_t count,
+    kalman_pool_worker_t *workers, uint_fast16_t num_workers)
+{
+    uint_fast32_t e;
+    uint_fast16_t w;
+
+    assert(num_workers > 0);
+    assert(count <= 0xFFFFFFu);
+
+    // the pending measurements of an entry are bits of a 32 bit mask
+    for (e = 0; e < count; ++e)
+    {
+        assert(entries[e].num_measurements <= 32);
+    }
+
+    pool->entries = entries;
+    pool->count = count;
+    pool->workers = workers;
+    pool->num_workers = num_workers;
+    pool->completed = count;
+    pool->generation = 0;
+    pool->shutdown = 0;
+
+    pthread_mutex_init(&pool->lock, (pthread_mutexattr_t*)0);
+    pthread_cond_init(&pool->start, (pthread_condattr_t*)0);
+    pthread_cond_init(&pool->done, (pthread_condattr_t*)0);
+
+    for (w = 0; w < num_workers; ++w)
+    {
+        workers[w].range = 0;
+        workers[w].index = w;
+        workers[w].pool = pool;
+    }
+
+    for (w = 0; w < num_workers; ++w)
+    {
+        if (pthread_create(&workers[w].thread, (pthread_attr_t*)0, kalman_pool_worker_main, &workers[w]) != 0)
+        {
+            // stop the workers that were already started
+            pool->num_workers = w;
+            kalman_pool_destroy(pool);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*!
+* \brief Stops and joins the worker threads.
+* \param[in] pool The pool to destroy
+*/
+void kalman_pool_destroy(kalman_pool_t *pool)
+{
+    uint_fast16_t w;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (w = 0; w < pool->num_workers; ++w)
+    {
+        pthread_join(pool->workers[w].thread, (void**)0);
+    }
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+}
+
+/*!
+* \brief Marks a measurement of a filter as arrived, so that it is used for correction in the next tick.
+* \param[in] pool The pool
+* \param[in] filter The index of the filter
+* \param[in] measurement The index of the measurement of that filter
+*/
+void kalman_pool_mark_measurement(kalman_pool_t *pool, uint_fast32_t filter, uint_fast8_t measurement)
+{
+    assert(filter < pool->count);
+    assert(measurement < pool->entries[filter].num_measurements);
+
+    pool->entries[filter].pending |= (uint32_t)1 << measurement;
+}
+
+/*!
+* \brief Starts a tick, i.e. the prediction and correction of all filters, and returns immediately.
+* \param[in] pool The pool
+*/
+void kalman_pool_tick(kalman_pool_t *pool)
+{
+    uint_fast16_t w;
+    const uint_fast16_t num_workers = pool->num_workers;
+    const uint64_t count = pool->count;
+
+    assert(__atomic_load_n(&pool->completed, __ATOMIC_ACQUIRE) == pool->count);
+
+    __atomic_store_n(&pool->completed, 0, __ATOMIC_RELAXED);
+
+    // split the filters evenly, the workers balance the remainder by stealing
+    for (w = 0; w < num_workers; ++w)
+    {
+        const uint32_t begin = (uint32_t)(count * w / num_workers);
+        const uint32_t end = (uint32_t)(count * (w + 1) / num_workers);
+        __atomic_store_n(&pool->workers[w].range, kalman_pool_range((uint16_t)(pool->generation + 1), begin, end), __ATOMIC_RELEASE);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    ++pool->generation;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/*!
+* \brief Waits for the current tick to complete.
+* \param[in] pool The pool
+*/
+void kalman_pool_wait(kalman_pool_t *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    while (__atomic_load_n(&pool->completed, __ATOMIC_ACQUIRE) != pool->count)
+    {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+#endif
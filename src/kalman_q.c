@@ -0,0 +1,203 @@
+#include <stdint.h>
+#include <assert.h>
+
+#define EXTERN_INLINE_MATRIX static INLINE
+#define EXTERN_INLINE_KALMAN static INLINE
+#include "cholesky.h"
+#include "kalman_q.h"
+
+/*!
+* \brief Initializes a fixed-point Kalman filter structure.
+* \param[in] kf The filter to initialize
+* \param[in] num_states The number of state variables
+* \param[in] num_inputs The number of input variables
+* \param[in] frac The number of fractional bits of all matrices
+* \param[in] A The state transition matrix ({\ref num_states} x {\ref num_states})
+* \param[in] x The state vector ({\ref num_states} x \c 1)
+* \param[in] B The input transition matrix ({\ref num_states} x {\ref num_inputs})
+* \param[in] P The state covariance matrix ({\ref num_states} x {\ref num_states})
+* \param[in] Q The input covariance matrix ({\ref num_inputs} x {\ref num_inputs})
+* \param[in] predictedX The temporary vector for the predicted x ({\ref num_states} x \c 1)
+* \param[in] temp_AP The temporary matrix for A*P ({\ref num_states} x {\ref num_states})
+* \param[in] temp_BQ The temporary matrix for BxQ ({\ref num_states} x {\ref num_inputs})
+*/
+void kalman_q_filter_initialize(kalman_q_t *kf, uint_fast8_t num_states, uint_fast8_t num_inputs, uint_fast8_t frac,
+    matrix_q_data_t *A, matrix_q_data_t *x, matrix_q_data_t *B, matrix_q_data_t *P, matrix_q_data_t *Q,
+    matrix_q_data_t *predictedX, matrix_q_data_t *temp_AP, matrix_q_data_t *temp_BQ)
+{
+    matrix_q_init(&kf->A, num_states, num_states, frac, A);
+    matrix_q_init(&kf->P, num_states, num_states, frac, P);
+    matrix_q_init(&kf->x, num_states, 1, frac, x);
+
+    matrix_q_init(&kf->B, num_states, num_inputs, frac, B);
+    matrix_q_init(&kf->Q, num_inputs, num_inputs, frac, Q);
+
+    // set temporaries
+    matrix_q_init(&kf->temporary.predicted_x, num_states, 1, frac, predictedX);
+    matrix_q_init(&kf->temporary.AP, num_states, num_states, frac, temp_AP);
+    matrix_q_init(&kf->temporary.BQ, num_states, num_inputs, frac, temp_BQ);
+}
+
+/*!
+* \brief Initializes a fixed-point Kalman filter measurement structure.
+* \param[in] kfm The measurement to initialize
+* \param[in] num_states The number of states
+* \param[in] num_measurements The number of measurements
+* \param[in] frac The number of fractional bits of all matrices
+* \param[in] H The measurement transformation matrix ({\ref num_measurements} x {\ref num_states})
+* \param[in] z The measurement vector ({\ref num_measurements} x \c 1)
+* \param[in] R The process noise / measurement uncertainty ({\ref num_measurements} x {\ref num_measurements})
+* \param[in] y The innovation ({\ref num_measurements} x \c 1)
+* \param[in] S The residual covariance ({\ref num_measurements} x {\ref num_measurements})
+* \param[in] K The Kalman gain ({\ref num_states} x {\ref num_measurements})
+* \param[in] temp_HP The temporary matrix for HxP ({\ref num_measurements} x {\ref num_states})
+*/
+void kalman_q_measurement_initialize(kalman_q_measurement_t *kfm, uint_fast8_t num_states, uint_fast8_t num_measurements, uint_fast8_t frac,
+    matrix_q_data_t *H, matrix_q_data_t *z, matrix_q_data_t *R,
+    matrix_q_data_t *y, matrix_q_data_t *S, matrix_q_data_t *K, matrix_q_data_t *temp_HP)
+{
+    matrix_q_init(&kfm->H, num_measurements, num_states, frac, H);
+    matrix_q_init(&kfm->R, num_measurements, num_measurements, frac, R);
+    matrix_q_init(&kfm->z, num_measurements, 1, frac, z);
+
+    matrix_q_init(&kfm->K, num_states, num_measurements, frac, K);
+    matrix_q_init(&kfm->S, num_measurements, num_measurements, frac, S);
+    matrix_q_init(&kfm->y, num_measurements, 1, frac, y);
+
+    // set temporary HxP matrix
+    matrix_q_init(&kfm->temporary.HP, num_measurements, num_states, frac, temp_HP);
+}
+
+/*!
+* \brief Converts the model and state of a floating point filter into a fixed-point filter.
+* \param[in] kf The floating point filter to read A, x, B, P and Q from
+* \param[out] kfq The fixed-point filter of the same dimensions
+*/
+void kalman_q_filter_from_float(const kalman_t *kf, kalman_q_t *kfq)
+{
+    matrix_q_from_float(&kf->A, &kfq->A);
+    matrix_q_from_float(&kf->x, &kfq->x);
+    matrix_q_from_float(&kf->P, &kfq->P);
+
+    if (kf->B.cols > 0)
+    {
+        matrix_q_from_float(&kf->B, &kfq->B);
+        matrix_q_from_float(&kf->Q, &kfq->Q);
+    }
+}
+
+/*!
+* \brief Converts a floating point measurement into a fixed-point measurement.
+* \param[in] kfm The floating point measurement to read H, R and z from
+* \param[out] kfmq The fixed-point measurement of the same dimensions
+*/
+void kalman_q_measurement_from_float(const kalman_measurement_t *kfm, kalman_q_measurement_t *kfmq)
+{
+    matrix_q_from_float(&kfm->H, &kfmq->H);
+    matrix_q_from_float(&kfm->R, &kfmq->R);
+    matrix_q_from_float(&kfm->z, &kfmq->z);
+}
+
+/*!
+* \brief Performs the time update / prediction step in fixed-point arithmetic.
+* \param[in] kf The Kalman Filter structure to predict with.
+*/
+void kalman_q_predict(kalman_q_t *kf)
+{
+    uint_fast8_t i;
+
+    // matrices and vectors
+    const matrix_q_t *RESTRICT const A = &kf->A;
+    matrix_q_t *RESTRICT const P = &kf->P;
+    matrix_q_t *RESTRICT const x = &kf->x;
+
+    // temporaries
+    matrix_q_t *RESTRICT const xpredicted = &kf->temporary.predicted_x;
+    matrix_q_t *RESTRICT const AP = &kf->temporary.AP;
+
+    /************************************************************************/
+    /* Predict next state using system dynamics                             */
+    /* x = A*x                                                              */
+    /************************************************************************/
+
+    matrix_q_mult_rowvector(A, x, xpredicted);
+    for (i = 0; i < x->rows; ++i)
+    {
+        x->data[i] = xpredicted->data[i];
+    }
+
+    /************************************************************************/
+    /* Predict next covariance using system dynamics and input              */
+    /* P = A*P*A' + B*Q*B'                                                  */
+    /************************************************************************/
+
+    // P = A*P*A'
+    matrix_q_mult(A, P, AP);                    // temp = A*P
+    matrix_q_mult_transb(AP, A, P);             // P = temp*A'
+
+    // P = P + B*Q*B'
+    if (kf->B.cols > 0)
+    {
+        matrix_q_mult(&kf->B, &kf->Q, &kf->temporary.BQ);        // temp = B*Q
+        matrix_q_mult_transb(&kf->temporary.BQ, &kf->B, AP);    // temp2 = temp*B'
+        matrix_q_add_inplace(P, AP);                            // P += temp2
+    }
+}
+
+/*!
+* \brief Performs the measurement update step in fixed-point arithmetic.
+* \param[in] kf The Kalman Filter structure to correct.
+* \param[in] kfm The measurement to correct with.
+* \return Zero in case of success, nonzero if the residual covariance was not positive definite.
+*/
+int kalman_q_correct(kalman_q_t *kf, kalman_q_measurement_t *kfm)
+{
+    matrix_q_t *RESTRICT const P = &kf->P;
+    const matrix_q_t *RESTRICT const H = &kfm->H;
+    matrix_q_t *RESTRICT const K = &kfm->K;
+    matrix_q_t *RESTRICT const S = &kfm->S;
+    matrix_q_t *RESTRICT const y = &kfm->y;
+    matrix_q_t *RESTRICT const x = &kf->x;
+
+    // temporaries
+    matrix_q_t *RESTRICT const temp_HP = &kfm->temporary.HP;
+
+    /************************************************************************/
+    /* Calculate innovation and residual covariance                         */
+    /* y = z - H*x                                                          */
+    /* S = H*P*H' + R                                                       */
+    /************************************************************************/
+
+    // y = z - H*x
+    matrix_q_mult_rowvector(H, x, y);
+    matrix_q_sub_inplace_b(&kfm->z, y);
+
+    // S = H*P*H' + R
+    matrix_q_mult(H, P, temp_HP);               // temp = H*P
+    matrix_q_mult_transb(temp_HP, H, S);        // S = temp*H'
+    matrix_q_add_inplace(S, &kfm->R);           // S += R
+
+    /************************************************************************/
+    /* Calculate Kalman gain                                                */
+    /* K = P*H' * S^-1                                                      */
+    /************************************************************************/
+
+    // K = (H*P)' * S^-1
+    if (cholesky_decompose_lower_q(S) != 0) return 1;
+    cholesky_solve_transb_q(S, temp_HP, K);
+
+    /************************************************************************/
+    /* Correct state prediction                                             */
+    /* x = x + K*y                                                          */
+    /************************************************************************/
+
+    matrix_q_multadd_rowvector(K, y, x);
+
+    /************************************************************************/
+    /* Correct state covariances                                            */
+    /* P = P - K*(H*P)                                                      */
+    /************************************************************************/
+
+    matrix_q_multsub(K, temp_HP, P);
+    return 0;
+}
@@ -0,0 +1,191 @@
+#include <stdint.h>
+#include <assert.h>
+
+#define EXTERN_INLINE_MATRIX static INLINE
+#define EXTERN_INLINE_KALMAN static INLINE
+#include "cholesky.h"
+#include "kalman_smoother.h"
+
+/*!
+* \brief Initializes a smoother.
+* \param[in] ks The smoother to initialize
+* \param[in] num_states The number of state variables
+* \param[in] records The records ({\ref capacity})
+* \param[in] capacity The number of records (\c 2 or more)
+* \param[in] buffer The buffer for the recorded matrices ({\ref capacity} x (2 x {\ref num_states} + 3 x {\ref num_states} x {\ref num_states}))
+* \param[in] temp The temporary buffer (4 x {\ref num_states} x {\ref num_states} + 3 x {\ref num_states})
+*/
+void kalman_smoother_initialize(kalman_smoother_t *ks, uint_fast8_t num_states, kalman_smoother_record_t *records, uint_fast16_t capacity,
+                                matrix_data_t *buffer, matrix_data_t *temp)
+{
+    uint_fast16_t i;
+    const uint_fast16_t size = (uint_fast16_t)num_states * num_states;
+    const uint_fast16_t stride = 2 * (uint_fast16_t)num_states + 3 * size;
+
+    assert(capacity > 1);
+
+    ks->records = records;
+    ks->capacity = capacity;
+
+    for (i = 0; i < capacity; ++i)
+    {
+        matrix_data_t *const data = &buffer[i * stride];
+        matrix_init(&records[i].A, num_states, num_states, &data[0]);
+        matrix_init(&records[i].P_predicted, num_states, num_states, &data[size]);
+        matrix_init(&records[i].P, num_states, num_states, &data[2 * size]);
+        matrix_init(&records[i].x_predicted, num_states, 1, &data[3 * size]);
+        matrix_init(&records[i].x, num_states, 1, &data[3 * size + num_states]);
+    }
+
+    // set temporaries
+    matrix_init(&ks->temporary.factor, num_states, num_states, &temp[0]);
+    matrix_init(&ks->temporary.gain, num_states, num_states, &temp[size]);
+    matrix_init(&ks->temporary.product, num_states, num_states, &temp[2 * size]);
+    matrix_init(&ks->temporary.P, num_states, num_states, &temp[3 * size]);
+    matrix_init(&ks->temporary.x, num_states, 1, &temp[4 * size]);
+    matrix_init(&ks->temporary.difference, num_states, 1, &temp[4 * size + num_states]);
+    ks->temporary.aux = &temp[4 * size + 2 * num_states];
+
+    kalman_smoother_clear(ks);
+}
+
+/*!
+* \brief Discards all records, e.g. after the filter has been reset.
+* \param[in] ks The smoother to clear
+*/
+void kalman_smoother_clear(kalman_smoother_t *ks)
+{
+    ks->count = 0;
+    ks->head = 0;
+}
+
+/*!
+* \brief Gets the record of an age.
+* \param[in] ks The smoother
+* \param[in] age The age from the oldest record (less than {\ref count})
+* \return The record
+*/
+static kalman_smoother_record_t* kalman_smoother_record(const kalman_smoother_t *ks, uint_fast16_t age)
+{
+    uint_fast16_t index = ks->head + ks->capacity - ks->count + age;
+    if (index >= ks->capacity) index -= ks->capacity;
+    return &ks->records[index];
+}
+
+/*!
+* \brief Records the a priori state, covariance and transition after a prediction.
+* \param[in] ks The smoother
+* \param[in] kf The filter that has just been predicted; must propagate the full covariance
+*/
+void kalman_smoother_record_prediction(kalman_smoother_t *ks, const kalman_t *kf)
+{
+    kalman_smoother_record_t *const record = &ks->records[ks->head];
+
+    assert(kf->temporary.sqrt_work == (matrix_data_t*)0 && kf->temporary.ud_work == (matrix_data_t*)0);
+    assert(record->A.rows == kf->A.rows);
+
+    matrix_copy(&kf->A, &record->A);
+    matrix_copy(&kf->x, &record->x_predicted);
+    matrix_copy(&kf->P, &record->P_predicted);
+
+    // without a correction, the a posteriori values are the a priori ones
+    matrix_copy(&kf->x, &record->x);
+    matrix_copy(&kf->P, &record->P);
+
+    // advance, overwriting the oldest record once the ring is full
+    if (++ks->head == ks->capacity) ks->head = 0;
+    if (ks->count < ks->capacity) ++ks->count;
+}
+
+/*!
+* \brief Records the a posteriori state and covariance after a correction.
+* \param[in] ks The smoother
+* \param[in] kf The filter that has just been corrected; must propagate the full covariance
+*/
+void kalman_smoother_record_correction(kalman_smoother_t *ks, const kalman_t *kf)
+{
+    kalman_smoother_record_t *record;
+
+    assert(ks->count > 0);
+    assert(kf->temporary.sqrt_work == (matrix_data_t*)0 && kf->temporary.ud_work == (matrix_data_t*)0);
+
+    record = kalman_smoother_record(ks, ks->count - 1);
+    matrix_copy(&kf->x, &record->x);
+    matrix_copy(&kf->P, &record->P);
+}
+
+/*!
+* \brief Runs the Rauch-Tung-Striebel backward pass over a window of records.
+* \param[in] ks The smoother
+* \param[in] first The age of the first record of the window
+* \param[in] length The number of records of the window (\c 1 or more)
+* \param[out] x The smoothed states ({\ref length} x {\ref num_states}), oldest first
+* \param[out] P The smoothed covariances ({\ref length} x {\ref num_states} x {\ref num_states}), oldest first; may be null
+* \return Zero in case of success, nonzero if an a priori covariance is not positive definite.
+*/
+int kalman_smoother_smooth(kalman_smoother_t *ks, uint_fast16_t first, uint_fast16_t length, matrix_data_t *x, matrix_data_t *P)
+{
+    uint_fast16_t i;
+    matrix_t *RESTRICT const factor = &ks->temporary.factor;
+    matrix_t *RESTRICT const gain = &ks->temporary.gain;
+    matrix_t *RESTRICT const product = &ks->temporary.product;
+    matrix_t *RESTRICT const Ps = &ks->temporary.P;
+    matrix_t *RESTRICT const xs = &ks->temporary.x;
+    matrix_t *RESTRICT const difference = &ks->temporary.difference;
+    matrix_data_t *RESTRICT const aux = ks->temporary.aux;
+    const uint_fast8_t n = xs->rows;
+    const uint_fast16_t size = (uint_fast16_t)n * n;
+    matrix_t output;
+
+    assert(length > 0 && first + length <= ks->count);
+    assert(x != (matrix_data_t*)0);
+
+    // the last record of the window keeps its a posteriori values
+    i = length - 1;
+    {
+        const kalman_smoother_record_t *const record = kalman_smoother_record(ks, first + i);
+        matrix_copy(&record->x, xs);
+        matrix_copy(&record->P, Ps);
+    }
+
+    for (;;)
+    {
+        // store the smoothed values of the current record
+        matrix_init(&output, n, 1, &x[i * n]);
+        matrix_copy(xs, &output);
+        if (P != (matrix_data_t*)0)
+        {
+            matrix_init(&output, n, n, &P[i * size]);
+            matrix_copy(Ps, &output);
+        }
+
+        if (i == 0) break;
+        --i;
+
+        {
+            const kalman_smoother_record_t *const record = kalman_smoother_record(ks, first + i);
+            const kalman_smoother_record_t *const next = kalman_smoother_record(ks, first + i + 1);
+
+            // C = P*A' * P_predicted^-1 = (A*P)' * P_predicted^-1
+            matrix_mult(&next->A, &record->P, product, aux);
+            matrix_copy(&next->P_predicted, factor);
+            if (cholesky_decompose_lower(factor) != 0) return 1;
+            cholesky_solve_transb(factor, product, gain);
+
+            // x_s = x + C*(x_s - x_predicted)
+            matrix_copy(&next->x_predicted, difference);
+            matrix_sub_inplace_b(xs, difference);
+            matrix_copy(&record->x, xs);
+            matrix_multadd_rowvector(gain, difference, xs);
+
+            // P_s = P + C*(P_s - P_predicted)*C'
+            matrix_copy(&next->P_predicted, product);
+            matrix_sub_inplace_b(Ps, product);
+            matrix_mult_abat(gain, product, 1, (matrix_t*)0, (matrix_t*)0, aux);
+            matrix_copy(&record->P, Ps);
+            matrix_add_inplace(Ps, product);
+        }
+    }
+
+    return 0;
+}
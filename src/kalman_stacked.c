@@ -0,0 +1,202 @@
+#include <stdint.h>
+#include <assert.h>
+
+#define EXTERN_INLINE_MATRIX static INLINE
+#define EXTERN_INLINE_KALMAN static INLINE
+#include "cholesky.h"
+#include "kalman_stacked.h"
+
+/*!
+* \brief Initializes an empty measurement stack.
+* \param[in] stack The stack to initialize
+* \param[in] num_states The number of state variables
+* \param[in] measurements The array of stacked measurements ({\ref capacity})
+* \param[in] capacity The largest number of stacked rows (\c 1 or more)
+* \param[in] y The stacked innovation vector ({\ref capacity} x \c 1)
+* \param[in] S The stacked residual covariance matrix ({\ref capacity} x {\ref capacity})
+* \param[in] K The stacked Kalman gain matrix ({\ref num_states} x {\ref capacity})
+* \param[in] aux The auxiliary buffer ({\ref num_states})
+* \param[in] temp_HP The temporary stacked H*P ({\ref capacity} x {\ref num_states})
+*/
+void kalman_stack_initialize(kalman_stack_t *stack, uint_fast8_t num_states, kalman_measurement_t **measurements, uint_fast8_t capacity,
+                             matrix_data_t *y, matrix_data_t *S, matrix_data_t *K, matrix_data_t *aux, matrix_data_t *temp_HP)
+{
+    assert(capacity > 0);
+
+    stack->measurements = measurements;
+    stack->capacity = capacity;
+
+    matrix_init(&stack->y, 0, 1, y);
+    matrix_init(&stack->S, 0, 0, S);
+    matrix_init(&stack->K, num_states, 0, K);
+
+    // set temporaries
+    stack->temporary.aux = aux;
+    matrix_init(&stack->temporary.HP, 0, num_states, temp_HP);
+
+    kalman_stack_clear(stack);
+}
+
+/*!
+* \brief Resizes the stacked matrices to a number of rows.
+* \param[in] stack The stack
+* \param[in] rows The number of stacked rows
+*/
+static void kalman_stack_resize(kalman_stack_t *stack, uint_fast8_t rows)
+{
+    const uint_fast8_t n = stack->K.rows;
+
+    matrix_init(&stack->y, rows, 1, stack->y.data);
+    matrix_init(&stack->S, rows, rows, stack->S.data);
+    matrix_init(&stack->K, n, rows, stack->K.data);
+    matrix_init(&stack->temporary.HP, rows, n, stack->temporary.HP.data);
+}
+
+/*!
+* \brief Removes all measurements from the stack.
+* \param[in] stack The stack to clear
+*/
+void kalman_stack_clear(kalman_stack_t *stack)
+{
+    stack->count = 0;
+    stack->frozen = 0;
+    kalman_stack_resize(stack, 0);
+}
+
+/*!
+* \brief Appends a measurement to the stack.
+* \param[in] stack The stack
+* \param[in] kfm The measurement to append; its rows must fit into the remaining capacity
+*/
+void kalman_stack_add(kalman_stack_t *stack, kalman_measurement_t *kfm)
+{
+    const uint_fast16_t rows = (uint_fast16_t)stack->y.rows + kfm->H.rows;
+
+    assert(kfm->H.cols == stack->K.rows);
+    assert(rows <= stack->capacity);
+
+    stack->measurements[stack->count++] = kfm;
+    stack->frozen = 0;
+    kalman_stack_resize(stack, (uint_fast8_t)rows);
+}
+
+/*!
+* \brief Performs the measurement update step with all stacked measurements at once.
+* \param[in] kf The Kalman Filter structure to correct; must propagate the full covariance
+* \param[in] stack The stack of measurements to correct with; their z must be set
+*/
+void kalman_correct_stacked(kalman_t *kf, kalman_stack_t *stack)
+{
+    uint_fast8_t b, c, i, j, k, row, column;
+    const uint_fast8_t n = kf->x.rows;
+    const uint_fast8_t m = stack->y.rows;
+    matrix_data_t *RESTRICT const S = stack->S.data;
+    matrix_data_t *RESTRICT const HP = stack->temporary.HP.data;
+    matrix_t block;
+
+    // at steady state, only the state is corrected with the frozen gain
+    const uint_fast8_t frozen = stack->frozen && kf->covariance_frozen;
+
+    // the square root and UD corrections have no residual covariance to stack
+    assert(kf->temporary.sqrt_work == (matrix_data_t*)0 && kf->temporary.ud_work == (matrix_data_t*)0);
+    assert(stack->count > 0 && stack->K.rows == n);
+
+    /************************************************************************/
+    /* Calculate innovation and H*P block by block                          */
+    /* y = z - H*x                                                          */
+    /************************************************************************/
+
+    row = 0;
+    for (b = 0; b < stack->count; ++b)
+    {
+        kalman_measurement_t *const kfm = stack->measurements[b];
+        const uint_fast8_t rows = kfm->H.rows;
+
+        // y = z - H*x
+        matrix_mult_rowvector(&kfm->H, &kf->x, &kfm->y);
+        matrix_sub_inplace_b(&kfm->z, &kfm->y);
+        for (i = 0; i < rows; ++i)
+        {
+            stack->y.data[row + i] = kfm->y.data[i];
+        }
+
+        // temp = H*P, the rows of the block are contiguous
+        if (!frozen)
+        {
+            matrix_init(&block, rows, n, &HP[row * n]);
+            matrix_mult(&kfm->H, &kf->P, &block, stack->temporary.aux);
+        }
+
+        row += rows;
+    }
+
+    if (frozen)
+    {
+        matrix_multadd_rowvector(&stack->K, &stack->y, &kf->x);
+        return;
+    }
+    stack->frozen = 0;
+
+    /************************************************************************/
+    /* Calculate residual covariance and Kalman gain                        */
+    /* S = H*P*H' + R, R block diagonal                                     */
+    /* K = P*H' * S^-1                                                      */
+    /************************************************************************/
+
+    // S = temp*H' + R, lower triangle mirrored; the off-diagonal blocks only couple through P
+    row = 0;
+    for (b = 0; b < stack->count; ++b)
+    {
+        const kalman_measurement_t *const kfm = stack->measurements[b];
+        const uint_fast8_t rows = kfm->H.rows;
+
+        column = 0;
+        for (c = 0; c <= b; ++c)
+        {
+            const matrix_data_t *RESTRICT const H = stack->measurements[c]->H.data;
+            const uint_fast8_t columns = stack->measurements[c]->H.rows;
+
+            for (i = 0; i < rows; ++i)
+            {
+                const matrix_data_t *RESTRICT const hp = &HP[(row + i) * n];
+                const uint_fast8_t last = (c == b) ? i + 1 : columns;
+
+                for (j = 0; j < last; ++j)
+                {
+                    matrix_data_t total = (c == b) ? kfm->R.data[i * rows + j] : 0;
+                    for (k = 0; k < n; ++k)
+                    {
+                        total += hp[k] * H[j * n + k];
+                    }
+                    S[(row + i) * m + column + j] = total;
+                    S[(column + j) * m + row + i] = total;
+                }
+            }
+
+            column += columns;
+        }
+
+        row += rows;
+    }
+
+    // K = (H*P)' * S^-1
+    cholesky_decompose_lower(&stack->S);                                    // S = L*L'
+    cholesky_solve_transb(&stack->S, &stack->temporary.HP, &stack->K);      // K*L*L' = temp'
+
+    /************************************************************************/
+    /* Correct state prediction and covariances                             */
+    /* x = x + K*y                                                          */
+    /* P = P - K*(H*P)                                                      */
+    /************************************************************************/
+
+    matrix_multadd_rowvector(&stack->K, &stack->y, &kf->x);
+
+    // a measurement froze the covariance, so the stacked gain is frozen as well
+    if (kf->covariance_frozen)
+    {
+        stack->frozen = 1;
+        return;
+    }
+
+    matrix_multsub_symmetric(&stack->K, &stack->temporary.HP, &kf->P);
+}
@@ -0,0 +1,260 @@
+#include <stdint.h>
+#include <assert.h>
+
+#define EXTERN_INLINE_MATRIX static INLINE
+#define EXTERN_INLINE_KALMAN static INLINE
+#include "kalman_transition.h"
+
+/*!
+* \brief Initializes a transition cache.
+* \param[in] cache The cache to initialize
+* \param[in] num_states The number of state variables
+* \param[in] entries The cache entries ({\ref count})
+* \param[in] count The number of cache entries
+* \param[in] buffer The buffer for the cached matrices (2 x {\ref count} x {\ref num_states} x {\ref num_states})
+* \param[in] temp The temporary buffer (3 x {\ref num_states} x {\ref num_states})
+*/
+void kalman_transition_cache_initialize(kalman_transition_cache_t *cache, uint_fast8_t num_states, kalman_transition_t *entries, uint_fast8_t count,
+                                        matrix_data_t *buffer, matrix_data_t *temp)
+{
+    uint_fast8_t i;
+    const uint_fast16_t size = (uint_fast16_t)num_states * num_states;
+
+    assert(count > 0);
+
+    cache->entries = entries;
+    cache->count = count;
+
+    for (i = 0; i < count; ++i)
+    {
+        matrix_init(&entries[i].A, num_states, num_states, &buffer[(2 * i) * size]);
+        matrix_init(&entries[i].Q, num_states, num_states, &buffer[(2 * i + 1) * size]);
+    }
+
+    // set temporaries
+    matrix_init(&cache->temporary.A, num_states, num_states, &temp[0]);
+    matrix_init(&cache->temporary.Q, num_states, num_states, &temp[size]);
+    matrix_init(&cache->temporary.product, num_states, num_states, &temp[2 * size]);
+
+    // keyed on step counts by default
+    cache->discretize = (kalman_discretize_t)0;
+    cache->context = (void*)0;
+    cache->resolution = 0;
+
+    kalman_transition_cache_clear(cache);
+}
+
+/*!
+* \brief Invalidates all entries, e.g. after A, B or Q of the filter have changed.
+* \param[in] cache The cache to clear
+*/
+void kalman_transition_cache_clear(kalman_transition_cache_t *cache)
+{
+    uint_fast8_t i;
+    for (i = 0; i < cache->count; ++i)
+    {
+        cache->entries[i].key = 0;
+        cache->entries[i].last_used = 0;
+    }
+
+    cache->clock = 0;
+    cache->hits = 0;
+    cache->misses = 0;
+}
+
+/*!
+* \brief Keys the cache on time steps discretized by a model.
+* \param[in] cache The cache
+* \param[in] discretize The function providing A(dt) and Q(dt)
+* \param[in] context The context passed to {\ref discretize}
+* \param[in] resolution The time step quantum (greater than zero)
+*/
+void kalman_transition_cache_set_model(kalman_transition_cache_t *cache, kalman_discretize_t discretize, void *context, matrix_data_t resolution)
+{
+    assert(discretize != (kalman_discretize_t)0);
+    assert(resolution > 0);
+
+    cache->discretize = discretize;
+    cache->context = context;
+    cache->resolution = resolution;
+
+    kalman_transition_cache_clear(cache);
+}
+
+/*!
+* \brief Finds the entry of a key, or claims the least recently used entry for it.
+* \param[in] cache The cache to search
+* \param[in] key The key to find (nonzero)
+* \param[out] found Set to nonzero if the entry was found, zero if it was claimed and must be built
+* \return The entry
+*/
+static kalman_transition_t* kalman_transition_lookup(kalman_transition_cache_t *cache, const uint_fast32_t key, uint_fast8_t *found)
+{
+    uint_fast8_t i;
+    kalman_transition_t *oldest = &cache->entries[0];
+
+    ++cache->clock;
+    for (i = 0; i < cache->count; ++i)
+    {
+        kalman_transition_t *const entry = &cache->entries[i];
+        if (entry->key == key)
+        {
+            entry->last_used = cache->clock;
+            ++cache->hits;
+            *found = 1;
+            return entry;
+        }
+
+        if (entry->last_used < oldest->last_used) oldest = entry;
+    }
+
+    oldest->key = key;
+    oldest->last_used = cache->clock;
+    ++cache->misses;
+    *found = 0;
+    return oldest;
+}
+
+/*!
+* \brief Applies a cached transition such that x = A*x and P = A*P*A' + Q.
+* \param[in] kf The Kalman Filter structure to predict with
+* \param[in] entry The transition to apply
+*/
+static void kalman_transition_apply(kalman_t *kf, const kalman_transition_t *entry)
+{
+    // x = A*x
+    matrix_mult_rowvector(&entry->A, &kf->x, &kf->temporary.predicted_x);
+    matrix_copy(&kf->temporary.predicted_x, &kf->x);
+
+    // the covariance is at steady state
+    if (kf->covariance_frozen) return;
+
+    // P = A*P*A' + Q
+    matrix_mult_abat(&entry->A, &kf->P, 1, (matrix_t*)0, (matrix_t*)0, kf->temporary.aux);
+    matrix_add_inplace(&kf->P, &entry->Q);
+}
+
+/*!
+* \brief Builds the transition over a number of steps by repeated squaring.
+* \param[in] kf The Kalman Filter structure providing A, B and Q
+* \param[in] cache The cache providing the temporaries
+* \param[in] entry The entry to build
+* \param[in] steps The number of steps
+*
+* The transitions over a and b steps combine to A_a+b = A_b*A_a and Q_a+b = A_b*Q_a*A_b' + Q_b;
+* since all of them are built from the same A, the order does not matter.
+*/
+static void kalman_transition_build(kalman_t *kf, kalman_transition_cache_t *cache, kalman_transition_t *entry, uint_fast16_t steps)
+{
+    uint_fast16_t i;
+    const uint_fast8_t n = kf->A.rows;
+    matrix_t *RESTRICT const Ap = &cache->temporary.A;
+    matrix_t *RESTRICT const Qp = &cache->temporary.Q;
+    matrix_t *RESTRICT const product = &cache->temporary.product;
+    matrix_data_t *RESTRICT const aux = kf->temporary.aux;
+
+    // start with the empty interval
+    for (i = 0; i < (uint_fast16_t)n * n; ++i)
+    {
+        entry->A.data[i] = (i % (n + 1) == 0) ? (matrix_data_t)1.0 : (matrix_data_t)0.0;
+        entry->Q.data[i] = 0;
+    }
+
+    // A_1 = A, Q_1 = B*Q*B'
+    matrix_copy(&kf->A, Ap);
+    if (kf->B.cols > 0)
+    {
+        matrix_mult(&kf->B, &kf->Q, &kf->temporary.BQ, aux);
+        matrix_mult_transb_symmetric(&kf->temporary.BQ, &kf->B, Qp);
+    }
+    else
+    {
+        for (i = 0; i < (uint_fast16_t)n * n; ++i) { Qp->data[i] = 0; }
+    }
+
+    for (;;)
+    {
+        // append the squared interval if its bit is set
+        if (steps & 1)
+        {
+            matrix_mult_abat(Ap, &entry->Q, 1, (matrix_t*)0, (matrix_t*)0, aux);
+            matrix_add_inplace(&entry->Q, Qp);
+
+            matrix_mult(Ap, &entry->A, product, aux);
+            matrix_copy(product, &entry->A);
+        }
+
+        steps >>= 1;
+        if (steps == 0) break;
+
+        // Q_2a = A_a*Q_a*A_a' + Q_a
+        matrix_copy(Qp, product);
+        matrix_mult_abat(Ap, Qp, 1, (matrix_t*)0, (matrix_t*)0, aux);
+        matrix_add_inplace(Qp, product);
+
+        // A_2a = A_a*A_a
+        matrix_mult(Ap, Ap, product, aux);
+        matrix_copy(product, Ap);
+    }
+}
+
+/*!
+* \brief Performs {\ref steps} prediction steps at the cost of a single one.
+* \param[in] kf The Kalman Filter structure to predict with; must propagate the full covariance
+* \param[in] cache The cache of transitions keyed on the number of steps
+* \param[in] steps The number of prediction steps (\c 1 or more)
+*/
+void kalman_predict_steps(kalman_t *kf, kalman_transition_cache_t *cache, uint_fast16_t steps)
+{
+    kalman_transition_t *entry;
+    uint_fast8_t found;
+
+    assert(steps > 0);
+    assert(cache->discretize == (kalman_discretize_t)0);
+    assert(kf->temporary.sqrt_work == (matrix_data_t*)0 && kf->temporary.ud_work == (matrix_data_t*)0);
+    assert(cache->entries[0].A.rows == kf->A.rows);
+
+    if (steps == 1)
+    {
+        kalman_predict(kf);
+        return;
+    }
+
+    entry = kalman_transition_lookup(cache, steps, &found);
+    if (!found)
+    {
+        kalman_transition_build(kf, cache, entry, steps);
+    }
+
+    kalman_transition_apply(kf, entry);
+}
+
+/*!
+* \brief Predicts over a variable time step.
+* \param[in] kf The Kalman Filter structure to predict with; must propagate the full covariance
+* \param[in] cache The cache of transitions keyed on time steps, see {\ref kalman_transition_cache_set_model}
+* \param[in] dt The time step (\c 0 or more)
+*/
+void kalman_predict_dt(kalman_t *kf, kalman_transition_cache_t *cache, matrix_data_t dt)
+{
+    kalman_transition_t *entry;
+    uint_fast32_t key;
+    uint_fast8_t found;
+
+    assert(cache->discretize != (kalman_discretize_t)0);
+    assert(dt >= 0 && dt / cache->resolution < (matrix_data_t)UINT32_MAX);
+    assert(kf->temporary.sqrt_work == (matrix_data_t*)0 && kf->temporary.ud_work == (matrix_data_t*)0);
+    assert(cache->entries[0].A.rows == kf->A.rows);
+
+    // round to the nearest multiple of the resolution
+    key = (uint_fast32_t)(dt / cache->resolution + (matrix_data_t)0.5);
+    if (key == 0) return;
+
+    entry = kalman_transition_lookup(cache, key, &found);
+    if (!found)
+    {
+        cache->discretize((matrix_data_t)key * cache->resolution, &entry->A, &entry->Q, cache->context);
+    }
+
+    kalman_transition_apply(kf, entry);
+}
@@ -0,0 +1,227 @@
+#include <stdint.h>
+#include <assert.h>
+#include <math.h>
+
+#define EXTERN_INLINE_MATRIX static INLINE
+#define EXTERN_INLINE_KALMAN static INLINE
+#include "cholesky.h"
+#include "kalman_ukf.h"
+
+/*!
+* \brief Initializes the sigma point workspace of an unscented Kalman filter.
+* \param[in] ukf The workspace to initialize
+* \param[in] num_states The number of state variables
+* \param[in] alpha The spread of the sigma points around the mean (\c 0 < {\ref alpha} <= \c 1)
+* \param[in] beta Prior knowledge of the distribution, \c 2 for Gaussians
+* \param[in] kappa Secondary scaling, usually \c 0
+* \param[in] sigma The sigma point buffer ({\ref num_states} x (2 * {\ref num_states} + 1))
+* \param[in] propagated The propagated sigma point buffer ({\ref num_states} x (2 * {\ref num_states} + 1))
+* \param[in] measured The predicted measurement buffer (maximum number of measurements x (2 * {\ref num_states} + 1))
+* \param[in] weights The weight buffer (2 x (2 * {\ref num_states} + 1))
+* \param[in] temp_factor The temporary matrix for the Cholesky factor ({\ref num_states} x {\ref num_states})
+*/
+void kalman_ukf_initialize(kalman_ukf_t *ukf, uint_fast8_t num_states, matrix_data_t alpha, matrix_data_t beta, matrix_data_t kappa,
+                           matrix_data_t *sigma, matrix_data_t *propagated, matrix_data_t *measured, matrix_data_t *weights,
+                           matrix_data_t *temp_factor)
+{
+    uint_fast8_t i;
+    const uint_fast8_t count = 2 * num_states + 1;
+    const matrix_data_t lambda = alpha * alpha * (num_states + kappa) - num_states;
+    const matrix_data_t weight = (matrix_data_t)0.5 / (num_states + lambda);
+
+    assert(alpha > 0 && num_states + lambda > 0);
+
+    matrix_init(&ukf->sigma, num_states, count, sigma);
+    matrix_init(&ukf->propagated, num_states, count, propagated);
+    ukf->measured = measured;
+
+    // W_0 = lambda / (n + lambda), W_i = 1 / (2 * (n + lambda))
+    ukf->weights_mean = weights;
+    ukf->weights_covariance = &weights[count];
+    for (i = 1; i < count; ++i)
+    {
+        ukf->weights_mean[i] = weight;
+        ukf->weights_covariance[i] = weight;
+    }
+    ukf->weights_mean[0] = lambda / (num_states + lambda);
+    ukf->weights_covariance[0] = ukf->weights_mean[0] + (1 - alpha * alpha + beta);
+
+    ukf->gamma = (matrix_data_t)sqrt(num_states + lambda);
+
+    // set temporaries
+    matrix_init(&ukf->temporary.factor, num_states, num_states, temp_factor);
+}
+
+/*!
+* \brief Generates the sigma points x, x + gamma * L_i and x - gamma * L_i from the columns of P = L*L'.
+* \param[in] kf The filter providing x and P
+* \param[in] ukf The sigma point workspace
+* \return Zero in case of success, nonzero if P is not positive definite.
+*/
+static int kalman_ukf_generate(const kalman_t *kf, kalman_ukf_t *ukf)
+{
+    uint_fast8_t i, j;
+    const uint_fast8_t n = kf->x.rows;
+    const uint_fast8_t count = ukf->sigma.cols;
+    const matrix_data_t *RESTRICT const x = kf->x.data;
+    const matrix_data_t *RESTRICT const L = ukf->temporary.factor.data;
+    matrix_data_t *RESTRICT const sigma = ukf->sigma.data;
+
+    // P = L*L'
+    matrix_copy(&kf->P, &ukf->temporary.factor);
+    if (cholesky_decompose_lower(&ukf->temporary.factor) != 0) return 1;
+
+    for (i = 0; i < n; ++i)
+    {
+        matrix_data_t *RESTRICT const row = &sigma[i * count];
+
+        row[0] = x[i];
+        for (j = 0; j < n; ++j)
+        {
+            const matrix_data_t offset = (j <= i) ? ukf->gamma * L[i * n + j] : (matrix_data_t)0.0;
+            row[1 + j] = x[i] + offset;
+            row[1 + n + j] = x[i] - offset;
+        }
+    }
+
+    return 0;
+}
+
+/*!
+* \brief Calculates the weighted mean of points stored one per column.
+* \param[in] points The points (rows x number of points)
+* \param[in] weights The weights (number of points)
+* \param[out] mean The mean (rows x \c 1)
+*/
+static void kalman_ukf_mean(const matrix_t *points, const matrix_data_t *RESTRICT weights, const matrix_t *mean)
+{
+    uint_fast8_t i, j;
+    const uint_fast8_t count = points->cols;
+
+    for (i = 0; i < points->rows; ++i)
+    {
+        const matrix_data_t *RESTRICT const row = &points->data[i * count];
+        matrix_data_t total = 0;
+
+        for (j = 0; j < count; ++j)
+        {
+            total += weights[j] * row[j];
+        }
+        mean->data[i] = total;
+    }
+}
+
+/*!
+* \brief Replaces points stored one per column by their deviations from a mean.
+* \param[in] points The points (rows x number of points), overwritten
+* \param[in] mean The mean (rows x \c 1)
+*/
+static void kalman_ukf_deviate(const matrix_t *points, const matrix_t *mean)
+{
+    uint_fast8_t i, j;
+    const uint_fast8_t count = points->cols;
+
+    for (i = 0; i < points->rows; ++i)
+    {
+        matrix_data_t *RESTRICT const row = &points->data[i * count];
+        const matrix_data_t value = mean->data[i];
+
+        for (j = 0; j < count; ++j)
+        {
+            row[j] -= value;
+        }
+    }
+}
+
+/*!
+* \brief Performs the time update / prediction step of an unscented Kalman filter.
+* \param[in] kf The Kalman Filter structure to predict with; must propagate the full covariance
+* \param[in] ukf The sigma point workspace
+* \param[in] f The process model, called once for all sigma points
+* \param[in] context The user context passed to the model
+* \return Zero in case of success, nonzero if P is not positive definite.
+*/
+int kalman_ukf_predict(kalman_t *kf, kalman_ukf_t *ukf, kalman_ukf_model_t f, void *context)
+{
+    uint_fast16_t i;
+    matrix_t *RESTRICT const P = &kf->P;
+    matrix_t *RESTRICT const propagated = &ukf->propagated;
+
+    assert(kf->temporary.sqrt_work == (matrix_data_t*)0 && kf->temporary.ud_work == (matrix_data_t*)0);
+    assert(ukf->sigma.rows == kf->x.rows);
+
+    if (kalman_ukf_generate(kf, ukf) != 0) return 1;
+
+    // X = f(X)
+    f(&ukf->sigma, propagated, context);
+
+    // x = sum(Wm_i * X_i)
+    kalman_ukf_mean(propagated, ukf->weights_mean, &kf->x);
+
+    // P = sum(Wc_i * (X_i - x)*(X_i - x)') + B*Q*B'
+    kalman_ukf_deviate(propagated, &kf->x);
+    for (i = 0; i < (uint_fast16_t)P->rows * P->cols; ++i) { P->data[i] = 0; }
+    matrix_multadd_weighted_transb(propagated, ukf->weights_covariance, propagated, P);
+
+    if (kf->B.cols > 0)
+    {
+        matrix_mult(&kf->B, &kf->Q, &kf->temporary.BQ, kf->temporary.aux);
+        matrix_multadd_transb_symmetric(&kf->temporary.BQ, &kf->B, P);
+    }
+
+    return 0;
+}
+
+/*!
+* \brief Performs the measurement update step of an unscented Kalman filter.
+* \param[in] kf The Kalman Filter structure to correct; must propagate the full covariance
+* \param[in] kfm The measurement to correct with; z and R must be set. H is not used.
+* \param[in] ukf The sigma point workspace
+* \param[in] h The measurement model, called once for all sigma points
+* \param[in] context The user context passed to the model
+* \return Zero in case of success, nonzero if P or the residual covariance S is not positive definite.
+*/
+int kalman_ukf_correct(kalman_t *kf, kalman_measurement_t *kfm, kalman_ukf_t *ukf, kalman_ukf_model_t h, void *context)
+{
+    matrix_t *RESTRICT const S = &kfm->S;
+    matrix_t *RESTRICT const K = &kfm->K;
+    matrix_t *RESTRICT const y = &kfm->y;
+    matrix_t *RESTRICT const Pzx = &kfm->temporary.HP;
+    matrix_t measured;
+    uint_fast16_t i;
+
+    assert(kf->temporary.sqrt_work == (matrix_data_t*)0 && kf->temporary.ud_work == (matrix_data_t*)0);
+    assert(S->data != (matrix_data_t*)0 && Pzx->data != (matrix_data_t*)0);
+    assert(ukf->sigma.rows == kf->x.rows && !kf->covariance_frozen);
+
+    if (kalman_ukf_generate(kf, ukf) != 0) return 1;
+
+    // Z = h(X)
+    matrix_init(&measured, kfm->z.rows, ukf->sigma.cols, ukf->measured);
+    h(&ukf->sigma, &measured, context);
+
+    // y = z - sum(Wm_i * Z_i)
+    kalman_ukf_mean(&measured, ukf->weights_mean, y);
+    kalman_ukf_deviate(&measured, y);
+    matrix_sub_inplace_b(&kfm->z, y);
+
+    // S = sum(Wc_i * (Z_i - z)*(Z_i - z)') + R
+    matrix_copy(&kfm->R, S);
+    matrix_multadd_weighted_transb(&measured, ukf->weights_covariance, &measured, S);
+
+    // HP = sum(Wc_i * (Z_i - z)*(X_i - x)'), the transposed cross covariance
+    kalman_ukf_deviate(&ukf->sigma, &kf->x);
+    for (i = 0; i < (uint_fast16_t)Pzx->rows * Pzx->cols; ++i) { Pzx->data[i] = 0; }
+    matrix_multadd_weighted_transb(&measured, ukf->weights_covariance, &ukf->sigma, Pzx);
+
+    // K = HP' * S^-1
+    if (cholesky_decompose_lower(S) != 0) return 1;
+    cholesky_solve_transb(S, Pzx, K);
+
+    // x = x + K*y
+    matrix_multadd_rowvector(K, y, &kf->x);
+
+    // P = P - K*S*K' = P - K*HP
+    matrix_multsub_symmetric(K, Pzx, &kf->P);
+    return 0;
+}
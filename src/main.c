@@ -9,5 +9,27 @@ void main()
     matrix_unittests();
  
     kalman_gravity_demo();
+    kalman_gravity_demo_sparse();
     kalman_gravity_demo_lambda();
+    kalman_gravity_demo_fixed();
+    kalman_gravity_demo_sequential();
+    kalman_gravity_demo_fixed_point();
+    kalman_gravity_demo_mixed();
+    kalman_gravity_demo_sqrt();
+    kalman_gravity_demo_ud();
+    kalman_gravity_demo_steady_state();
+    kalman_gravity_demo_steady_state_shared();
+    kalman_gravity_demo_dare();
+    kalman_gravity_demo_dare_wide();
+    kalman_gravity_demo_steps();
+    kalman_gravity_demo_dt();
+    kalman_gravity_demo_ekf();
+    kalman_gravity_demo_ukf();
+    kalman_gravity_demo_smoother();
+    kalman_gravity_demo_fixed_lag();
+    kalman_gravity_demo_oosm();
+    kalman_gravity_demo_stacked();
+    kalman_gravity_demo_information();
+    kalman_gravity_demo_bank();
+    kalman_gravity_demo_pool();
 }
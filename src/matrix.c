@@ -1,8 +1,10 @@
 #include <stdint.h>
 #include <assert.h>
+#include <math.h>
 
 #define EXTERN_INLINE_MATRIX static INLINE
 #include "matrix.h"
+#include "matrix_avx2.h"
 
 /**
 * \brief Initializes a matrix structure.
@@ -66,6 +68,57 @@ void matrix_invert_lower(const matrix_t *RESTRICT const lower, matrix_t *RESTRIC
     }
 }
 
+/**
+* \brief Triangularizes a wide matrix using Givens rotations, such that {\ref mat} = [L 0] * Q' for an orthogonal Q.
+* \param[in] mat The matrix ({\ref rows} x {\ref cols}, with {\ref cols} not less than {\ref rows}) to triangularize in place.
+*/
+void matrix_triangularize_lower(const matrix_t *const mat)
+{
+    uint_fast8_t i, j, k;
+    const uint_fast8_t rows = mat->rows;
+    const uint_fast8_t cols = mat->cols;
+    matrix_data_t *RESTRICT const m = mat->data;
+
+    assert(cols >= rows);
+
+    for (i = 0; i < rows; ++i)
+    {
+        matrix_data_t *RESTRICT const mrow = &m[i * cols];
+
+        // rotate the columns right of the diagonal into the diagonal element;
+        // the rows above are already zero in these columns and are not affected
+        for (j = i + 1; j < cols; ++j)
+        {
+            matrix_data_t c, s, r;
+            if (mrow[j] == 0) continue;
+
+            r = (matrix_data_t)sqrt(mrow[i] * mrow[i] + mrow[j] * mrow[j]);
+            c = mrow[i] / r;
+            s = mrow[j] / r;
+
+            mrow[i] = r;
+            mrow[j] = 0;
+            for (k = i + 1; k < rows; ++k)
+            {
+                matrix_data_t *RESTRICT const krow = &m[k * cols];
+                const matrix_data_t ki = krow[i];
+                const matrix_data_t kj = krow[j];
+                krow[i] = c * ki + s * kj;
+                krow[j] = c * kj - s * ki;
+            }
+        }
+
+        // make the diagonal nonnegative by flipping the sign of the column
+        if (mrow[i] < 0)
+        {
+            for (k = i; k < rows; ++k)
+            {
+                m[k * cols + i] = -m[k * cols + i];
+            }
+        }
+    }
+}
+
 /*!
 * \brief Performs a matrix multiplication such that {\ref c} = {\ref a} * {\ref b}
 * \param[in] a Matrix A
@@ -75,7 +128,7 @@ void matrix_invert_lower(const matrix_t *RESTRICT const lower, matrix_t *RESTRIC
 *
 * Kudos: https://code.google.com/p/efficient-java-matrix-library
 */
-void matrix_mult(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c, matrix_data_t *const baux)
+static void matrix_mult_scalar(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c, matrix_data_t *const baux)
 {
     register int_fast16_t i, j, k;
     const uint_fast8_t bcols = b->cols;
@@ -127,7 +180,7 @@ void matrix_mult(const matrix_t *const a, const matrix_t *const b, const matrix_
 *
 * Kudos: https://code.google.com/p/efficient-java-matrix-library
 */
-void matrix_mult_transb(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c)
+static void matrix_mult_transb_scalar(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c)
 {
     register uint_fast16_t xA, xB, indexA, indexB, end;
     const uint_fast8_t bcols = b->cols;
@@ -171,7 +224,7 @@ void matrix_mult_transb(const matrix_t *const a, const matrix_t *const b, const
 *
 * Kudos: https://code.google.com/p/efficient-java-matrix-library
 */
-void matrix_multadd_transb(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c)
+static void matrix_multadd_transb_scalar(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c)
 {
     register uint_fast16_t xA, xB, indexA, indexB, end;
     const uint_fast8_t bcols = b->cols;
@@ -215,7 +268,7 @@ void matrix_multadd_transb(const matrix_t *const a, const matrix_t *const b, con
 *
 * Kudos: https://code.google.com/p/efficient-java-matrix-library
 */
-void matrix_multscale_transb(const matrix_t *const a, const matrix_t *const b, register const matrix_data_t scale, const matrix_t *RESTRICT c)
+static void matrix_multscale_transb_scalar(const matrix_t *const a, const matrix_t *const b, register const matrix_data_t scale, const matrix_t *RESTRICT c)
 {
     register uint_fast16_t xA, xB, indexA, indexB, end;
     const uint_fast8_t bcols = b->cols;
@@ -258,7 +311,7 @@ void matrix_multscale_transb(const matrix_t *const a, const matrix_t *const b, r
 *
 * Kudos: https://code.google.com/p/efficient-java-matrix-library
 */
-void matrix_mult_rowvector(const matrix_t *RESTRICT const a, const matrix_t *RESTRICT const x, matrix_t *RESTRICT const c)
+static void matrix_mult_rowvector_scalar(const matrix_t *RESTRICT const a, const matrix_t *RESTRICT const x, matrix_t *RESTRICT const c)
 {
     uint_fast16_t i, j;
     const uint_fast8_t arows = a->rows;
@@ -294,7 +347,7 @@ void matrix_mult_rowvector(const matrix_t *RESTRICT const a, const matrix_t *RES
 *
 * Kudos: https://code.google.com/p/efficient-java-matrix-library
 */
-void matrix_multadd_rowvector(const matrix_t *RESTRICT const a, const matrix_t *RESTRICT const x, matrix_t *RESTRICT const c)
+static void matrix_multadd_rowvector_scalar(const matrix_t *RESTRICT const a, const matrix_t *RESTRICT const x, matrix_t *RESTRICT const c)
 {
     uint_fast16_t i, j;
     const uint_fast8_t arows = a->rows;
@@ -320,3 +373,771 @@ void matrix_multadd_rowvector(const matrix_t *RESTRICT const a, const matrix_t *
         cdata[cIndex++] += total;
     }
 }
+
+/*!
+* \brief Performs a matrix multiplication with transposed B such that {\ref c} = {\ref a} * {\ref b'}, where the result is known to be symmetric
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[in] c Resulting square matrix C (will be overwritten)
+*
+* Only the lower triangle of C is calculated; it is mirrored into the upper triangle.
+*/
+static void matrix_mult_transb_symmetric_scalar(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c)
+{
+    register uint_fast16_t xA, xB, indexA, indexB, end;
+    const uint_fast8_t bcols = b->cols;
+    const uint_fast8_t arows = a->rows;
+    const uint_fast8_t acols = a->cols;
+
+    matrix_data_t *const adata = a->data;
+    matrix_data_t *const bdata = b->data;
+    matrix_data_t *RESTRICT const cdata = c->data;
+
+    uint_fast16_t aIndexStart = 0;
+
+    assert(a->rows == b->rows);
+    assert(c->rows == c->cols);
+
+    for (xA = 0; xA < arows; ++xA)
+    {
+        end = aIndexStart + bcols;
+        indexB = 0;
+        for (xB = 0; xB <= xA; ++xB)
+        {
+            indexA = aIndexStart;
+            matrix_data_t total = 0;
+
+            while (indexA < end)
+            {
+                total += adata[indexA++] * bdata[indexB++];
+            }
+
+            cdata[xA * arows + xB] = cdata[xB * arows + xA] = total;
+        }
+        aIndexStart += acols;
+    }
+}
+
+/*!
+* \brief Performs a matrix multiplication with transposed B and adds the result to {\ref c} such that {\ref c} = {\ref c} + {\ref a} * {\ref b'}, where the result is known to be symmetric
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[in] c Resulting symmetric matrix C (will be added to)
+*
+* Only the lower triangle of C is calculated; it is mirrored into the upper triangle.
+*/
+static void matrix_multadd_transb_symmetric_scalar(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c)
+{
+    register uint_fast16_t xA, xB, indexA, indexB, end;
+    const uint_fast8_t bcols = b->cols;
+    const uint_fast8_t arows = a->rows;
+    const uint_fast8_t acols = a->cols;
+
+    matrix_data_t *const adata = a->data;
+    matrix_data_t *const bdata = b->data;
+    matrix_data_t *RESTRICT const cdata = c->data;
+
+    uint_fast16_t aIndexStart = 0;
+
+    assert(a->rows == b->rows);
+    assert(c->rows == c->cols);
+
+    for (xA = 0; xA < arows; ++xA)
+    {
+        end = aIndexStart + bcols;
+        indexB = 0;
+        for (xB = 0; xB <= xA; ++xB)
+        {
+            indexA = aIndexStart;
+            matrix_data_t total = 0;
+
+            while (indexA < end)
+            {
+                total += adata[indexA++] * bdata[indexB++];
+            }
+
+            cdata[xB * arows + xA] = (cdata[xA * arows + xB] += total);
+        }
+        aIndexStart += acols;
+    }
+}
+
+/*!
+* \brief Performs a matrix multiplication with transposed B and scales the result such that {\ref c} = {\ref a} * {\ref b'} * {\ref scale}, where the result is known to be symmetric
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[in] scale Scaling factor
+* \param[in] c Resulting square matrix C (will be overwritten)
+*
+* Only the lower triangle of C is calculated; it is mirrored into the upper triangle.
+*/
+static void matrix_multscale_transb_symmetric_scalar(const matrix_t *const a, const matrix_t *const b, register const matrix_data_t scale, const matrix_t *RESTRICT c)
+{
+    register uint_fast16_t xA, xB, indexA, indexB, end;
+    const uint_fast8_t bcols = b->cols;
+    const uint_fast8_t arows = a->rows;
+    const uint_fast8_t acols = a->cols;
+
+    matrix_data_t *const adata = a->data;
+    matrix_data_t *const bdata = b->data;
+    matrix_data_t *RESTRICT const cdata = c->data;
+
+    uint_fast16_t aIndexStart = 0;
+
+    assert(a->rows == b->rows);
+    assert(c->rows == c->cols);
+
+    for (xA = 0; xA < arows; ++xA)
+    {
+        end = aIndexStart + bcols;
+        indexB = 0;
+        for (xB = 0; xB <= xA; ++xB)
+        {
+            indexA = aIndexStart;
+            matrix_data_t total = 0;
+
+            while (indexA < end)
+            {
+                total += adata[indexA++] * bdata[indexB++];
+            }
+
+            cdata[xA * arows + xB] = cdata[xB * arows + xA] = total * scale;
+        }
+        aIndexStart += acols;
+    }
+}
+
+/*!
+* \brief Performs the in-place covariance propagation {\ref p} = {\ref scale} * {\ref a} * {\ref p} * {\ref a'} + {\ref bq} * {\ref b'}
+* \param[in] a Matrix A
+* \param[in] p Symmetric matrix P (will be overwritten)
+* \param[in] scale Scaling factor for A*P*A'
+* \param[in] bq Optional product B*Q; may be null
+* \param[in] b Optional matrix B; may be null if {\ref bq} is null
+* \param[in] aux Auxiliary vector that can hold a row of {\ref p}
+*
+* The product is formed without an intermediate matrix: first, W = P*A' is calculated in place row by row,
+* since each row of W only depends on the same row of P. Then the rows of A*W are accumulated from the rows
+* of W, from the last row to the first and only up to the diagonal, as the result is symmetric. Row i of the
+* result only reads the first i+1 columns of W, so it is stored transposed into column i, which no remaining
+* row reads. B*Q*B' is accumulated into each row directly before the upper triangle is mirrored.
+*/
+static void matrix_mult_abat_scalar(const matrix_t *const a, const matrix_t *RESTRICT p, register const matrix_data_t scale, const matrix_t *const bq, const matrix_t *const b, matrix_data_t *const aux)
+{
+    register uint_fast16_t i, j, k;
+    int_fast16_t r;
+    const uint_fast8_t n = p->rows;
+    const uint_fast8_t bcols = (bq != (matrix_t*)0) ? bq->cols : 0;
+
+    const matrix_data_t *RESTRICT const adata = a->data;
+    matrix_data_t *RESTRICT const pdata = p->data;
+
+    // assert pointer validity
+    assert(a != (matrix_t*)0);
+    assert(p != (matrix_t*)0);
+    assert(aux != (matrix_data_t*)0);
+    assert(bq == (matrix_t*)0 || b != (matrix_t*)0);
+
+    // test dimensions
+    assert(a->rows == n && a->cols == n);
+    assert(p->cols == n);
+
+    // W = P*A', row by row
+    for (i = 0; i < n; ++i)
+    {
+        matrix_data_t *RESTRICT const prow = &pdata[i * n];
+        matrix_get_row_copy(p, (uint_fast8_t)i, aux);
+
+        for (j = 0; j < n; ++j)
+        {
+            const matrix_data_t *RESTRICT const arow = &adata[j * n];
+            matrix_data_t total = 0;
+            for (k = 0; k < n; ++k)
+            {
+                total += aux[k] * arow[k];
+            }
+            prow[j] = total;
+        }
+    }
+
+    // P = scale*A*W + BQ*B', row by row from the last, lower triangle stored transposed
+    for (r = n - 1; r >= 0; --r)
+    {
+        const matrix_data_t *RESTRICT const arow = &adata[r * n];
+
+        // aux = A(r,:)*W(:,0:r), streaming the rows of W
+        for (j = 0; j <= (uint_fast16_t)r; ++j)
+        {
+            aux[j] = 0;
+        }
+        for (k = 0; k < n; ++k)
+        {
+            const matrix_data_t *RESTRICT const wrow = &pdata[k * n];
+            const matrix_data_t factor = arow[k];
+            for (j = 0; j <= (uint_fast16_t)r; ++j)
+            {
+                aux[j] += factor * wrow[j];
+            }
+        }
+
+        for (j = 0; j <= (uint_fast16_t)r; ++j)
+        {
+            matrix_data_t total = aux[j] * scale;
+
+            if (bcols > 0)
+            {
+                const matrix_data_t *RESTRICT const bqrow = &bq->data[r * bcols];
+                const matrix_data_t *RESTRICT const brow = &b->data[j * bcols];
+                for (k = 0; k < bcols; ++k)
+                {
+                    total += bqrow[k] * brow[k];
+                }
+            }
+
+            pdata[j * n + r] = total;
+        }
+    }
+
+    // mirror the upper triangle
+    for (i = 1; i < n; ++i)
+    {
+        for (j = 0; j < i; ++j)
+        {
+            pdata[i * n + j] = pdata[j * n + i];
+        }
+    }
+}
+
+/*!
+* \brief Accumulates a weighted sum of outer products such that {\ref c} = {\ref c} + {\ref a} * diag({\ref w}) * {\ref b'}
+* \param[in] a Matrix A (rows x k)
+* \param[in] w The weights (k)
+* \param[in] b Matrix B (cols x k)
+* \param[in] c Resulting matrix C (rows x cols, will be added to)
+*
+* Each element of C is a contiguous dot product over a row of A, the weights and a row of B; A*diag(w) is
+* never formed. If A and B are the same matrix, C is symmetric and only its lower triangle is calculated
+* and then mirrored.
+*/
+void matrix_multadd_weighted_transb(const matrix_t *const a, const matrix_data_t *RESTRICT const w, const matrix_t *const b, const matrix_t *RESTRICT c)
+{
+    register uint_fast16_t i, j, k;
+    const uint_fast8_t rows = c->rows;
+    const uint_fast8_t cols = c->cols;
+    const uint_fast8_t count = a->cols;
+    const uint_fast8_t symmetric = (a == b);
+
+    const matrix_data_t *RESTRICT const adata = a->data;
+    const matrix_data_t *RESTRICT const bdata = b->data;
+    matrix_data_t *RESTRICT const cdata = c->data;
+
+    // test dimensions
+    assert(b->cols == count);
+    assert(a->rows == rows && b->rows == cols);
+
+    for (i = 0; i < rows; ++i)
+    {
+        const matrix_data_t *RESTRICT const arow = &adata[i * count];
+        const uint_fast8_t end = symmetric ? (uint_fast8_t)(i + 1) : cols;
+
+        for (j = 0; j < end; ++j)
+        {
+            const matrix_data_t *RESTRICT const brow = &bdata[j * count];
+            matrix_data_t total = 0;
+
+            for (k = 0; k < count; ++k)
+            {
+                total += arow[k] * w[k] * brow[k];
+            }
+            cdata[i * cols + j] += total;
+        }
+    }
+
+    // mirror the lower triangle
+    if (symmetric)
+    {
+        for (i = 1; i < rows; ++i)
+        {
+            for (j = 0; j < i; ++j)
+            {
+                cdata[j * cols + i] = cdata[i * cols + j];
+            }
+        }
+    }
+}
+
+/*!
+* \brief Performs a matrix multiplication and subtracts the result from {\ref c} such that {\ref c} = {\ref c} - {\ref a} * {\ref b}, where the result is known to be symmetric
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[in] c Resulting symmetric matrix C (will be subtracted from)
+*
+* Rows of B are streamed with A's elements as factors, so no column copies are needed. Only the lower
+* triangle of C is calculated; it is mirrored into the upper triangle.
+*/
+void matrix_multsub_symmetric(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c)
+{
+    register uint_fast16_t i, j, k;
+    const uint_fast8_t n = c->rows;
+    const uint_fast8_t acols = a->cols;
+
+    const matrix_data_t *RESTRICT const adata = a->data;
+    const matrix_data_t *RESTRICT const bdata = b->data;
+    matrix_data_t *RESTRICT const cdata = c->data;
+
+    // test dimensions
+    assert(a->cols == b->rows);
+    assert(a->rows == n && b->cols == n && c->cols == n);
+
+    for (i = 0; i < n; ++i)
+    {
+        matrix_data_t *RESTRICT const crow = &cdata[i * n];
+        for (k = 0; k < acols; ++k)
+        {
+            const matrix_data_t factor = adata[i * acols + k];
+            const matrix_data_t *RESTRICT const brow = &bdata[k * n];
+            for (j = 0; j <= i; ++j)
+            {
+                crow[j] -= factor * brow[j];
+            }
+        }
+    }
+
+    // mirror the lower triangle
+    for (i = 1; i < n; ++i)
+    {
+        for (j = 0; j < i; ++j)
+        {
+            cdata[j * n + i] = cdata[i * n + j];
+        }
+    }
+}
+
+/************************************************************************/
+/* Sparse kernels                                                       */
+/************************************************************************/
+
+/*!
+* \brief Determines the sparsity pattern of a matrix.
+* \param[in] a The matrix to analyze
+* \param[in] sparsity The pattern to fill; its buffers must be set and large enough for {\ref a}
+* \return The number of multiplications per matrix/vector product, i.e. the number of general entries.
+*/
+uint_fast16_t matrix_sparsity_analyze(const matrix_t *const a, matrix_sparsity_t *const sparsity)
+{
+    uint_fast8_t i, j;
+    uint_fast16_t count = 0, general = 0;
+    const uint_fast8_t cols = a->cols;
+
+    assert(sparsity->offsets != (uint_fast16_t*)0);
+    assert(sparsity->columns != (uint_fast8_t*)0);
+
+    sparsity->rows = a->rows;
+
+    for (i = 0; i < a->rows; ++i)
+    {
+        const matrix_data_t *RESTRICT const arow = &a->data[i * cols];
+
+        // unit entries first
+        sparsity->offsets[2 * i] = count;
+        for (j = 0; j < cols; ++j)
+        {
+            if (arow[j] == 1) sparsity->columns[count++] = j;
+        }
+
+        // general entries next
+        sparsity->offsets[2 * i + 1] = count;
+        for (j = 0; j < cols; ++j)
+        {
+            if (arow[j] != 0 && arow[j] != 1)
+            {
+                sparsity->columns[count++] = j;
+                ++general;
+            }
+        }
+    }
+
+    sparsity->offsets[2 * a->rows] = count;
+    return general;
+}
+
+/*!
+* \brief Calculates the dot product of a sparse matrix row with a dense vector.
+* \param[in] arow The row of the matrix
+* \param[in] sparsity The sparsity pattern of the matrix
+* \param[in] row The index of the row
+* \param[in] x The dense vector
+* \return The dot product
+*/
+static INLINE matrix_data_t matrix_sparse_row_dot(const matrix_data_t *RESTRICT const arow, const matrix_sparsity_t *RESTRICT const sparsity, const uint_fast8_t row, const matrix_data_t *RESTRICT const x)
+{
+    const uint_fast8_t *RESTRICT const columns = sparsity->columns;
+    const uint_fast16_t general = sparsity->offsets[2 * row + 1];
+    const uint_fast16_t end = sparsity->offsets[2 * row + 2];
+    uint_fast16_t e = sparsity->offsets[2 * row];
+    matrix_data_t total = 0;
+
+    // unit entries need no multiplication
+    for (; e < general; ++e)
+    {
+        total += x[columns[e]];
+    }
+
+    for (; e < end; ++e)
+    {
+        const uint_fast8_t k = columns[e];
+        total += arow[k] * x[k];
+    }
+
+    return total;
+}
+
+/*!
+* \brief Performs a matrix multiplication such that {\ref c} = {\ref a} * {\ref x}, skipping the zero and unit entries of {\ref a}
+* \param[in] a Matrix A
+* \param[in] sparsity The sparsity pattern of {\ref a}
+* \param[in] x Vector x
+* \param[in] c Resulting vector C (will be overwritten)
+*/
+void matrix_mult_rowvector_sparse(const matrix_t *RESTRICT const a, const matrix_sparsity_t *RESTRICT const sparsity, const matrix_t *RESTRICT const x, matrix_t *RESTRICT const c)
+{
+    uint_fast8_t i;
+    const uint_fast8_t cols = a->cols;
+
+    // test dimensions
+    assert(sparsity->rows == a->rows);
+    assert(a->cols == x->rows);
+    assert(a->rows == c->rows);
+
+    for (i = 0; i < a->rows; ++i)
+    {
+        c->data[i] = matrix_sparse_row_dot(&a->data[i * cols], sparsity, i, x->data);
+    }
+}
+
+/*!
+* \brief Performs the in-place covariance propagation {\ref p} = {\ref scale} * {\ref a} * {\ref p} * {\ref a'} + {\ref bq} * {\ref b'}, skipping the zero and unit entries of {\ref a}
+* \param[in] a Square matrix A
+* \param[in] sparsity The sparsity pattern of {\ref a}
+* \param[in] p Symmetric matrix P (will be overwritten)
+* \param[in] scale Scaling factor for A*P*A'
+* \param[in] bq Optional product B*Q; may be null
+* \param[in] b Optional matrix B; may be null if {\ref bq} is null
+* \param[in] aux Auxiliary vector that can hold a row of {\ref p}
+*
+* This follows the scheme of {\ref matrix_mult_abat}; the first pass only visits the nonzero entries of the rows of A
+* and the second pass only streams the rows of W that they select.
+*/
+void matrix_mult_abat_sparse(const matrix_t *const a, const matrix_sparsity_t *RESTRICT const sparsity, const matrix_t *RESTRICT p, register const matrix_data_t scale, const matrix_t *const bq, const matrix_t *const b, matrix_data_t *const aux)
+{
+    register uint_fast16_t i, j, k, e;
+    int_fast16_t r;
+    const uint_fast8_t n = p->rows;
+    const uint_fast8_t bcols = (bq != (matrix_t*)0) ? bq->cols : 0;
+
+    const matrix_data_t *RESTRICT const adata = a->data;
+    matrix_data_t *RESTRICT const pdata = p->data;
+
+    // assert pointer validity
+    assert(sparsity != (matrix_sparsity_t*)0);
+    assert(aux != (matrix_data_t*)0);
+    assert(bq == (matrix_t*)0 || b != (matrix_t*)0);
+
+    // test dimensions
+    assert(a->rows == n && a->cols == n);
+    assert(sparsity->rows == n);
+    assert(p->cols == n);
+
+    // W = P*A', row by row
+    for (i = 0; i < n; ++i)
+    {
+        matrix_data_t *RESTRICT const prow = &pdata[i * n];
+        matrix_get_row_copy(p, (uint_fast8_t)i, aux);
+
+        for (j = 0; j < n; ++j)
+        {
+            prow[j] = matrix_sparse_row_dot(&adata[j * n], sparsity, (uint_fast8_t)j, aux);
+        }
+    }
+
+    // P = scale*A*W + BQ*B', row by row from the last, lower triangle stored transposed
+    for (r = n - 1; r >= 0; --r)
+    {
+        const matrix_data_t *RESTRICT const arow = &adata[r * n];
+        const uint_fast16_t general = sparsity->offsets[2 * r + 1];
+        const uint_fast16_t end = sparsity->offsets[2 * r + 2];
+
+        // aux = A(r,:)*W(:,0:r), streaming only the rows of W selected by the nonzero entries of A
+        for (j = 0; j <= (uint_fast16_t)r; ++j)
+        {
+            aux[j] = 0;
+        }
+        for (e = sparsity->offsets[2 * r]; e < general; ++e)
+        {
+            const matrix_data_t *RESTRICT const wrow = &pdata[sparsity->columns[e] * n];
+            for (j = 0; j <= (uint_fast16_t)r; ++j)
+            {
+                aux[j] += wrow[j];
+            }
+        }
+        for (; e < end; ++e)
+        {
+            const uint_fast8_t column = sparsity->columns[e];
+            const matrix_data_t *RESTRICT const wrow = &pdata[column * n];
+            const matrix_data_t factor = arow[column];
+            for (j = 0; j <= (uint_fast16_t)r; ++j)
+            {
+                aux[j] += factor * wrow[j];
+            }
+        }
+
+        for (j = 0; j <= (uint_fast16_t)r; ++j)
+        {
+            matrix_data_t total = aux[j] * scale;
+
+            if (bcols > 0)
+            {
+                const matrix_data_t *RESTRICT const bqrow = &bq->data[r * bcols];
+                const matrix_data_t *RESTRICT const brow = &b->data[j * bcols];
+                for (k = 0; k < bcols; ++k)
+                {
+                    total += bqrow[k] * brow[k];
+                }
+            }
+
+            pdata[j * n + r] = total;
+        }
+    }
+
+    // mirror the upper triangle
+    for (i = 1; i < n; ++i)
+    {
+        for (j = 0; j < i; ++j)
+        {
+            pdata[i * n + j] = pdata[j * n + i];
+        }
+    }
+}
+
+/************************************************************************/
+/* Kernel dispatch                                                      */
+/************************************************************************/
+
+/*!
+* \brief Table of the matrix kernels of one backend
+*/
+typedef struct
+{
+    matrix_backend_t backend;
+    void (*mult)(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c, matrix_data_t *const baux);
+    void (*mult_transb)(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c);
+    void (*multadd_transb)(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c);
+    void (*multscale_transb)(const matrix_t *const a, const matrix_t *const b, register const matrix_data_t scale, const matrix_t *RESTRICT c);
+    void (*mult_rowvector)(const matrix_t *RESTRICT const a, const matrix_t *RESTRICT const x, matrix_t *RESTRICT const c);
+    void (*multadd_rowvector)(const matrix_t *RESTRICT const a, const matrix_t *RESTRICT const x, matrix_t *RESTRICT const c);
+    void (*mult_transb_symmetric)(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c);
+    void (*multadd_transb_symmetric)(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c);
+    void (*multscale_transb_symmetric)(const matrix_t *const a, const matrix_t *const b, register const matrix_data_t scale, const matrix_t *RESTRICT c);
+    void (*mult_abat)(const matrix_t *const a, const matrix_t *RESTRICT p, register const matrix_data_t scale, const matrix_t *const bq, const matrix_t *const b, matrix_data_t *const aux);
+} matrix_kernels_t;
+
+/*!
+* \brief The portable scalar kernels
+*/
+static const matrix_kernels_t matrix_kernels_scalar = {
+    MATRIX_BACKEND_SCALAR,
+    matrix_mult_scalar,
+    matrix_mult_transb_scalar,
+    matrix_multadd_transb_scalar,
+    matrix_multscale_transb_scalar,
+    matrix_mult_rowvector_scalar,
+    matrix_multadd_rowvector_scalar,
+    matrix_mult_transb_symmetric_scalar,
+    matrix_multadd_transb_symmetric_scalar,
+    matrix_multscale_transb_symmetric_scalar,
+    matrix_mult_abat_scalar
+};
+
+#if MATRIX_HAVE_AVX2
+
+/*!
+* \brief The AVX2/FMA kernels
+*/
+static const matrix_kernels_t matrix_kernels_avx2 = {
+    MATRIX_BACKEND_AVX2_FMA,
+    matrix_mult_avx2,
+    matrix_mult_transb_avx2,
+    matrix_multadd_transb_avx2,
+    matrix_multscale_transb_avx2,
+    matrix_mult_rowvector_avx2,
+    matrix_multadd_rowvector_avx2,
+    matrix_mult_transb_symmetric_avx2,
+    matrix_multadd_transb_symmetric_avx2,
+    matrix_multscale_transb_symmetric_avx2,
+    matrix_mult_abat_avx2
+};
+
+#endif
+
+/*!
+* \brief The currently active kernel table
+*/
+static const matrix_kernels_t *matrix_kernels = &matrix_kernels_scalar;
+
+/*!
+* \brief Selects the kernel backend used by the matrix operations.
+* \param[in] backend The backend to use, or {\ref MATRIX_BACKEND_AUTO} to pick the fastest one supported by the CPU.
+* \return The backend that is now active; this is {\ref MATRIX_BACKEND_SCALAR} if the requested one is not available.
+*/
+matrix_backend_t matrix_select_backend(matrix_backend_t backend)
+{
+#if MATRIX_HAVE_AVX2
+    if ((backend == MATRIX_BACKEND_AUTO || backend == MATRIX_BACKEND_AVX2_FMA) && matrix_avx2_supported())
+    {
+        matrix_kernels = &matrix_kernels_avx2;
+        return matrix_kernels->backend;
+    }
+#else
+    (void)backend;
+#endif
+
+    matrix_kernels = &matrix_kernels_scalar;
+    return matrix_kernels->backend;
+}
+
+/*!
+* \brief Gets the kernel backend used by the matrix operations.
+* \return The active backend.
+*/
+matrix_backend_t matrix_get_backend()
+{
+    return matrix_kernels->backend;
+}
+
+#if MATRIX_HAVE_AVX2
+
+/*!
+* \brief Selects the fastest supported backend once at startup.
+*/
+__attribute__ ((constructor)) static void matrix_select_backend_at_startup()
+{
+    matrix_select_backend(MATRIX_BACKEND_AUTO);
+}
+
+#endif
+
+/*!
+* \brief Performs a matrix multiplication such that {\ref c} = {\ref a} * {\ref b}
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[in] c Resulting matrix C (will be overwritten)
+* \param[in] aux Auxiliary vector that can hold a column of {\ref b}
+*/
+void matrix_mult(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c, matrix_data_t *const baux)
+{
+    matrix_kernels->mult(a, b, c, baux);
+}
+
+/*!
+* \brief Performs a matrix multiplication with transposed B such that {\ref c} = {\ref a} * {\ref b'}
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[in] c Resulting matrix C (will be overwritten)
+*/
+void matrix_mult_transb(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c)
+{
+    matrix_kernels->mult_transb(a, b, c);
+}
+
+/*!
+* \brief Performs a matrix multiplication with transposed B and adds the result to {\ref c} such that {\ref c} = {\ref c} + {\ref a} * {\ref b'}
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[in] c Resulting matrix C (will be added to)
+*/
+void matrix_multadd_transb(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c)
+{
+    matrix_kernels->multadd_transb(a, b, c);
+}
+
+/*!
+* \brief Performs a matrix multiplication with transposed B and scales the result such that {\ref c} = {\ref a} * {\ref b'} * {\ref scale}
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[in] scale Scaling factor
+* \param[in] c Resulting matrix C(will be overwritten)
+*/
+void matrix_multscale_transb(const matrix_t *const a, const matrix_t *const b, register const matrix_data_t scale, const matrix_t *RESTRICT c)
+{
+    matrix_kernels->multscale_transb(a, b, scale, c);
+}
+
+/*!
+* \brief Performs a matrix multiplication such that {\ref c} = {\ref x} * {\ref b}
+* \param[in] a Matrix A
+* \param[in] x Vector x
+* \param[in] c Resulting vector C (will be overwritten)
+*/
+void matrix_mult_rowvector(const matrix_t *RESTRICT const a, const matrix_t *RESTRICT const x, matrix_t *RESTRICT const c)
+{
+    matrix_kernels->mult_rowvector(a, x, c);
+}
+
+/*!
+* \brief Performs a matrix multiplication such that {\ref c} = {\ref c} + {\ref x} * {\ref b}
+* \param[in] a Matrix A
+* \param[in] x Vector x
+* \param[in] c Resulting vector C (will be added to)
+*/
+void matrix_multadd_rowvector(const matrix_t *RESTRICT const a, const matrix_t *RESTRICT const x, matrix_t *RESTRICT const c)
+{
+    matrix_kernels->multadd_rowvector(a, x, c);
+}
+
+/*!
+* \brief Performs a matrix multiplication with transposed B such that {\ref c} = {\ref a} * {\ref b'}, where the result is known to be symmetric
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[in] c Resulting square matrix C (will be overwritten)
+*/
+void matrix_mult_transb_symmetric(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c)
+{
+    matrix_kernels->mult_transb_symmetric(a, b, c);
+}
+
+/*!
+* \brief Performs a matrix multiplication with transposed B and adds the result to {\ref c} such that {\ref c} = {\ref c} + {\ref a} * {\ref b'}, where the result is known to be symmetric
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[in] c Resulting symmetric matrix C (will be added to)
+*/
+void matrix_multadd_transb_symmetric(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c)
+{
+    matrix_kernels->multadd_transb_symmetric(a, b, c);
+}
+
+/*!
+* \brief Performs a matrix multiplication with transposed B and scales the result such that {\ref c} = {\ref a} * {\ref b'} * {\ref scale}, where the result is known to be symmetric
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[in] scale Scaling factor
+* \param[in] c Resulting square matrix C (will be overwritten)
+*/
+void matrix_multscale_transb_symmetric(const matrix_t *const a, const matrix_t *const b, register const matrix_data_t scale, const matrix_t *RESTRICT c)
+{
+    matrix_kernels->multscale_transb_symmetric(a, b, scale, c);
+}
+
+/*!
+* \brief Performs the in-place covariance propagation {\ref p} = {\ref scale} * {\ref a} * {\ref p} * {\ref a'} + {\ref bq} * {\ref b'}
+* \param[in] a Matrix A
+* \param[in] p Symmetric matrix P (will be overwritten)
+* \param[in] scale Scaling factor for A*P*A'
+* \param[in] bq Optional product B*Q; may be null
+* \param[in] b Optional matrix B; may be null if {\ref bq} is null
+* \param[in] aux Auxiliary vector that can hold a row of {\ref p}
+*/
+void matrix_mult_abat(const matrix_t *const a, const matrix_t *RESTRICT p, register const matrix_data_t scale, const matrix_t *const bq, const matrix_t *const b, matrix_data_t *const aux)
+{
+    matrix_kernels->mult_abat(a, p, scale, bq, b, aux);
+}
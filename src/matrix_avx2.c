@@ -0,0 +1,435 @@
+#include <stdint.h>
+#include <assert.h>
+
+#define EXTERN_INLINE_MATRIX static INLINE
+#include "matrix.h"
+#include "matrix_avx2.h"
+
+#if MATRIX_HAVE_AVX2
+
+#include <immintrin.h>
+
+/**
+* \brief The kernels below operate on single precision data only.
+*/
+typedef char matrix_avx2_requires_float[(sizeof(matrix_data_t) == sizeof(float)) ? 1 : -1];
+
+/**
+* \def TARGET_AVX2 Compiles a single function for AVX2 and FMA
+*/
+#define TARGET_AVX2 __attribute__ ((target("avx2,fma")))
+
+/**
+* \brief Lookup table for tail masks; loading 8 entries from offset (8 - n) enables the first n lanes.
+*/
+static const int32_t tail_mask_table[16] = { -1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+/*!
+* \brief Creates a lane mask enabling the first {\ref count} lanes (\c 0 < {\ref count} < \c 8)
+*/
+TARGET_AVX2 static inline __m256i tail_mask(const uint_fast8_t count)
+{
+    return _mm256_loadu_si256((const __m256i*)&tail_mask_table[8 - count]);
+}
+
+/*!
+* \brief Sums all lanes of a vector
+*/
+TARGET_AVX2 static inline matrix_data_t horizontal_sum(const __m256 v)
+{
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+    return _mm_cvtss_f32(sum);
+}
+
+/*!
+* \brief Calculates the dot product of two contiguous vectors of length {\ref count}
+*/
+TARGET_AVX2 static inline matrix_data_t dot(const matrix_data_t *RESTRICT a, const matrix_data_t *RESTRICT b, const uint_fast16_t count)
+{
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    uint_fast16_t k = 0;
+
+    // two independent accumulators hide the FMA latency
+    for (; k + 16 <= count; k += 16)
+    {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(&a[k]), _mm256_loadu_ps(&b[k]), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(&a[k + 8]), _mm256_loadu_ps(&b[k + 8]), acc1);
+    }
+    if (k + 8 <= count)
+    {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(&a[k]), _mm256_loadu_ps(&b[k]), acc0);
+        k += 8;
+    }
+    if (k < count)
+    {
+        const __m256i mask = tail_mask((uint_fast8_t)(count - k));
+        acc1 = _mm256_fmadd_ps(_mm256_maskload_ps(&a[k], mask), _mm256_maskload_ps(&b[k], mask), acc1);
+    }
+
+    return horizontal_sum(_mm256_add_ps(acc0, acc1));
+}
+
+/*!
+* \brief Determines whether the executing CPU supports AVX2 and FMA.
+* \return Nonzero if the AVX2/FMA kernels can be used.
+*/
+int matrix_avx2_supported()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+/*!
+* \brief Performs a matrix multiplication such that {\ref c} = {\ref a} * {\ref b}
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[in] c Resulting matrix C (will be overwritten)
+* \param[in] baux Unused; rows of {\ref b} are streamed directly.
+*
+* Each row of C is accumulated eight columns at a time by broadcasting the elements of A's row.
+*/
+TARGET_AVX2 void matrix_mult_avx2(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c, matrix_data_t *const baux)
+{
+    uint_fast16_t i, j, k;
+    const uint_fast8_t bcols = b->cols;
+    const uint_fast8_t brows = b->rows;
+    const uint_fast8_t arows = a->rows;
+
+    const matrix_data_t *RESTRICT const adata = a->data;
+    const matrix_data_t *RESTRICT const bdata = b->data;
+    matrix_data_t *RESTRICT const cdata = c->data;
+
+    // assert pointer validity
+    assert(a != (matrix_t*)0);
+    assert(b != (matrix_t*)0);
+    assert(c != (matrix_t*)0);
+    (void)baux;
+
+    // test dimensions of a and b
+    assert(a->cols == b->rows);
+
+    // test dimension of c
+    assert(a->rows == c->rows);
+    assert(b->cols == c->cols);
+
+    for (i = 0; i < arows; ++i)
+    {
+        const matrix_data_t *RESTRICT const arow = &adata[i * brows];
+        matrix_data_t *RESTRICT const crow = &cdata[i * bcols];
+
+        for (j = 0; j + 8 <= bcols; j += 8)
+        {
+            __m256 acc = _mm256_setzero_ps();
+            for (k = 0; k < brows; ++k)
+            {
+                acc = _mm256_fmadd_ps(_mm256_broadcast_ss(&arow[k]), _mm256_loadu_ps(&bdata[k * bcols + j]), acc);
+            }
+            _mm256_storeu_ps(&crow[j], acc);
+        }
+
+        if (j < bcols)
+        {
+            const __m256i mask = tail_mask((uint_fast8_t)(bcols - j));
+            __m256 acc = _mm256_setzero_ps();
+            for (k = 0; k < brows; ++k)
+            {
+                acc = _mm256_fmadd_ps(_mm256_broadcast_ss(&arow[k]), _mm256_maskload_ps(&bdata[k * bcols + j], mask), acc);
+            }
+            _mm256_maskstore_ps(&crow[j], mask, acc);
+        }
+    }
+}
+
+/*!
+* \brief Performs a matrix multiplication with transposed B such that {\ref c} = {\ref a} * {\ref b'}
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[in] c Resulting matrix C (will be overwritten)
+*/
+TARGET_AVX2 void matrix_mult_transb_avx2(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c)
+{
+    uint_fast16_t xA, xB;
+    const uint_fast8_t bcols = b->cols;
+    const uint_fast8_t brows = b->rows;
+    const uint_fast8_t arows = a->rows;
+    const uint_fast8_t acols = a->cols;
+
+    const matrix_data_t *const adata = a->data;
+    const matrix_data_t *const bdata = b->data;
+    matrix_data_t *RESTRICT const cdata = c->data;
+
+    uint_fast16_t cIndex = 0;
+    for (xA = 0; xA < arows; ++xA)
+    {
+        for (xB = 0; xB < brows; ++xB)
+        {
+            cdata[cIndex++] = dot(&adata[xA * acols], &bdata[xB * bcols], bcols);
+        }
+    }
+}
+
+/*!
+* \brief Performs a matrix multiplication with transposed B and adds the result to {\ref c} such that {\ref c} = {\ref c} + {\ref a} * {\ref b'}
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[in] c Resulting matrix C (will be added to)
+*/
+TARGET_AVX2 void matrix_multadd_transb_avx2(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c)
+{
+    uint_fast16_t xA, xB;
+    const uint_fast8_t bcols = b->cols;
+    const uint_fast8_t brows = b->rows;
+    const uint_fast8_t arows = a->rows;
+    const uint_fast8_t acols = a->cols;
+
+    const matrix_data_t *const adata = a->data;
+    const matrix_data_t *const bdata = b->data;
+    matrix_data_t *RESTRICT const cdata = c->data;
+
+    uint_fast16_t cIndex = 0;
+    for (xA = 0; xA < arows; ++xA)
+    {
+        for (xB = 0; xB < brows; ++xB)
+        {
+            cdata[cIndex++] += dot(&adata[xA * acols], &bdata[xB * bcols], bcols);
+        }
+    }
+}
+
+/*!
+* \brief Performs a matrix multiplication with transposed B and scales the result such that {\ref c} = {\ref a} * {\ref b'} * {\ref scale}
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[in] scale Scaling factor
+* \param[in] c Resulting matrix C (will be overwritten)
+*/
+TARGET_AVX2 void matrix_multscale_transb_avx2(const matrix_t *const a, const matrix_t *const b, register const matrix_data_t scale, const matrix_t *RESTRICT c)
+{
+    uint_fast16_t xA, xB;
+    const uint_fast8_t bcols = b->cols;
+    const uint_fast8_t brows = b->rows;
+    const uint_fast8_t arows = a->rows;
+    const uint_fast8_t acols = a->cols;
+
+    const matrix_data_t *const adata = a->data;
+    const matrix_data_t *const bdata = b->data;
+    matrix_data_t *RESTRICT const cdata = c->data;
+
+    uint_fast16_t cIndex = 0;
+    for (xA = 0; xA < arows; ++xA)
+    {
+        for (xB = 0; xB < brows; ++xB)
+        {
+            cdata[cIndex++] = dot(&adata[xA * acols], &bdata[xB * bcols], bcols) * scale;
+        }
+    }
+}
+
+/*!
+* \brief Performs a matrix multiplication such that {\ref c} = {\ref a} * {\ref x}
+* \param[in] a Matrix A
+* \param[in] x Vector x
+* \param[in] c Resulting vector C (will be overwritten)
+*/
+TARGET_AVX2 void matrix_mult_rowvector_avx2(const matrix_t *RESTRICT const a, const matrix_t *RESTRICT const x, matrix_t *RESTRICT const c)
+{
+    uint_fast16_t i;
+    const uint_fast8_t arows = a->rows;
+    const uint_fast8_t acols = a->cols;
+
+    const matrix_data_t *RESTRICT const adata = a->data;
+    const matrix_data_t *RESTRICT const xdata = x->data;
+    matrix_data_t *RESTRICT const cdata = c->data;
+
+    for (i = 0; i < arows; ++i)
+    {
+        cdata[i] = dot(&adata[i * acols], xdata, acols);
+    }
+}
+
+/*!
+* \brief Performs a matrix multiplication such that {\ref c} = {\ref c} + {\ref a} * {\ref x}
+* \param[in] a Matrix A
+* \param[in] x Vector x
+* \param[in] c Resulting vector C (will be added to)
+*/
+TARGET_AVX2 void matrix_multadd_rowvector_avx2(const matrix_t *RESTRICT const a, const matrix_t *RESTRICT const x, matrix_t *RESTRICT const c)
+{
+    uint_fast16_t i;
+    const uint_fast8_t arows = a->rows;
+    const uint_fast8_t acols = a->cols;
+
+    const matrix_data_t *RESTRICT const adata = a->data;
+    const matrix_data_t *RESTRICT const xdata = x->data;
+    matrix_data_t *RESTRICT const cdata = c->data;
+
+    for (i = 0; i < arows; ++i)
+    {
+        cdata[i] += dot(&adata[i * acols], xdata, acols);
+    }
+}
+
+/*!
+* \brief Performs a matrix multiplication with transposed B such that {\ref c} = {\ref a} * {\ref b'}, where the result is known to be symmetric
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[in] c Resulting square matrix C (will be overwritten)
+*/
+TARGET_AVX2 void matrix_mult_transb_symmetric_avx2(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c)
+{
+    uint_fast16_t xA, xB;
+    const uint_fast8_t bcols = b->cols;
+    const uint_fast8_t arows = a->rows;
+    const uint_fast8_t acols = a->cols;
+
+    const matrix_data_t *const adata = a->data;
+    const matrix_data_t *const bdata = b->data;
+    matrix_data_t *RESTRICT const cdata = c->data;
+
+    for (xA = 0; xA < arows; ++xA)
+    {
+        for (xB = 0; xB <= xA; ++xB)
+        {
+            cdata[xA * arows + xB] = cdata[xB * arows + xA] = dot(&adata[xA * acols], &bdata[xB * bcols], bcols);
+        }
+    }
+}
+
+/*!
+* \brief Performs a matrix multiplication with transposed B and adds the result to {\ref c} such that {\ref c} = {\ref c} + {\ref a} * {\ref b'}, where the result is known to be symmetric
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[in] c Resulting symmetric matrix C (will be added to)
+*/
+TARGET_AVX2 void matrix_multadd_transb_symmetric_avx2(const matrix_t *const a, const matrix_t *const b, const matrix_t *RESTRICT c)
+{
+    uint_fast16_t xA, xB;
+    const uint_fast8_t bcols = b->cols;
+    const uint_fast8_t arows = a->rows;
+    const uint_fast8_t acols = a->cols;
+
+    const matrix_data_t *const adata = a->data;
+    const matrix_data_t *const bdata = b->data;
+    matrix_data_t *RESTRICT const cdata = c->data;
+
+    for (xA = 0; xA < arows; ++xA)
+    {
+        for (xB = 0; xB <= xA; ++xB)
+        {
+            cdata[xB * arows + xA] = (cdata[xA * arows + xB] += dot(&adata[xA * acols], &bdata[xB * bcols], bcols));
+        }
+    }
+}
+
+/*!
+* \brief Performs a matrix multiplication with transposed B and scales the result such that {\ref c} = {\ref a} * {\ref b'} * {\ref scale}, where the result is known to be symmetric
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[in] scale Scaling factor
+* \param[in] c Resulting square matrix C (will be overwritten)
+*/
+TARGET_AVX2 void matrix_multscale_transb_symmetric_avx2(const matrix_t *const a, const matrix_t *const b, register const matrix_data_t scale, const matrix_t *RESTRICT c)
+{
+    uint_fast16_t xA, xB;
+    const uint_fast8_t bcols = b->cols;
+    const uint_fast8_t arows = a->rows;
+    const uint_fast8_t acols = a->cols;
+
+    const matrix_data_t *const adata = a->data;
+    const matrix_data_t *const bdata = b->data;
+    matrix_data_t *RESTRICT const cdata = c->data;
+
+    for (xA = 0; xA < arows; ++xA)
+    {
+        for (xB = 0; xB <= xA; ++xB)
+        {
+            cdata[xA * arows + xB] = cdata[xB * arows + xA] = dot(&adata[xA * acols], &bdata[xB * bcols], bcols) * scale;
+        }
+    }
+}
+
+/*!
+* \brief Performs the in-place covariance propagation {\ref p} = {\ref scale} * {\ref a} * {\ref p} * {\ref a'} + {\ref bq} * {\ref b'}
+* \param[in] a Matrix A
+* \param[in] p Symmetric matrix P (will be overwritten)
+* \param[in] scale Scaling factor for A*P*A'
+* \param[in] bq Optional product B*Q; may be null
+* \param[in] b Optional matrix B; may be null if {\ref bq} is null
+* \param[in] aux Auxiliary vector that can hold a row of {\ref p}
+*/
+TARGET_AVX2 void matrix_mult_abat_avx2(const matrix_t *const a, const matrix_t *RESTRICT p, register const matrix_data_t scale, const matrix_t *const bq, const matrix_t *const b, matrix_data_t *const aux)
+{
+    uint_fast16_t i, j, k;
+    int_fast16_t r;
+    const uint_fast8_t n = p->rows;
+    const uint_fast8_t bcols = (bq != (matrix_t*)0) ? bq->cols : 0;
+
+    const matrix_data_t *const adata = a->data;
+    matrix_data_t *RESTRICT const pdata = p->data;
+
+    assert(a->rows == n && a->cols == n);
+    assert(p->cols == n);
+
+    // W = P*A', row by row
+    for (i = 0; i < n; ++i)
+    {
+        matrix_get_row_copy(p, (uint_fast8_t)i, aux);
+        for (j = 0; j < n; ++j)
+        {
+            pdata[i * n + j] = dot(aux, &adata[j * n], n);
+        }
+    }
+
+    // P = scale*A*W + BQ*B', row by row from the last, lower triangle stored transposed
+    for (r = n - 1; r >= 0; --r)
+    {
+        const matrix_data_t *RESTRICT const arow = &adata[r * n];
+        const uint_fast16_t width = (uint_fast16_t)r + 1;
+
+        // aux = A(r,:)*W(:,0:r), eight columns at a time by broadcasting the elements of A's row
+        for (j = 0; j + 8 <= width; j += 8)
+        {
+            __m256 acc = _mm256_setzero_ps();
+            for (k = 0; k < n; ++k)
+            {
+                acc = _mm256_fmadd_ps(_mm256_broadcast_ss(&arow[k]), _mm256_loadu_ps(&pdata[k * n + j]), acc);
+            }
+            _mm256_storeu_ps(&aux[j], acc);
+        }
+
+        if (j < width)
+        {
+            const __m256i mask = tail_mask((uint_fast8_t)(width - j));
+            __m256 acc = _mm256_setzero_ps();
+            for (k = 0; k < n; ++k)
+            {
+                acc = _mm256_fmadd_ps(_mm256_broadcast_ss(&arow[k]), _mm256_maskload_ps(&pdata[k * n + j], mask), acc);
+            }
+            _mm256_maskstore_ps(&aux[j], mask, acc);
+        }
+
+        for (j = 0; j < width; ++j)
+        {
+            matrix_data_t total = aux[j] * scale;
+            if (bcols > 0)
+            {
+                total += dot(&bq->data[r * bcols], &b->data[j * bcols], bcols);
+            }
+            pdata[j * n + r] = total;
+        }
+    }
+
+    // mirror the upper triangle
+    for (i = 1; i < n; ++i)
+    {
+        for (j = 0; j < i; ++j)
+        {
+            pdata[i * n + j] = pdata[j * n + i];
+        }
+    }
+}
+
+#endif
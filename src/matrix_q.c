@@ -0,0 +1,241 @@
+#include <stdint.h>
+#include <assert.h>
+#include <math.h>
+
+#define EXTERN_INLINE_MATRIX static INLINE
+#include "matrix_q.h"
+
+/**
+* \brief Initializes a fixed-point matrix structure.
+* \param[in] mat The matrix to initialize
+* \param[in] rows The number of rows
+* \param[in] cols The number of columns
+* \param[in] frac The number of fractional bits (at most 31)
+* \param[in] buffer The data buffer (of size {\see rows} x {\see cols}).
+*/
+void matrix_q_init(matrix_q_t *const mat, const uint_fast8_t rows, const uint_fast8_t cols, const uint_fast8_t frac, matrix_q_data_t *const buffer)
+{
+    assert(frac <= 31);
+
+    mat->cols = cols;
+    mat->rows = rows;
+    mat->frac = frac;
+    mat->data = buffer;
+}
+
+/**
+* \brief Converts a floating point matrix to fixed-point, saturating values out of range.
+* \param[in] mat The floating point matrix
+* \param[out] target The fixed-point matrix of the same dimensions
+*/
+void matrix_q_from_float(const matrix_t *RESTRICT const mat, matrix_q_t *RESTRICT const target)
+{
+    uint_fast16_t i;
+    const uint_fast16_t count = mat->rows * mat->cols;
+    const double scale = ldexp(1.0, target->frac);
+
+    assert(mat->rows == target->rows && mat->cols == target->cols);
+
+    for (i = 0; i < count; ++i)
+    {
+        const double value = floor(mat->data[i] * scale + 0.5);
+        if (value >= (double)MATRIX_Q_MAX) target->data[i] = MATRIX_Q_MAX;
+        else if (value <= (double)MATRIX_Q_MIN) target->data[i] = MATRIX_Q_MIN;
+        else target->data[i] = (matrix_q_data_t)value;
+    }
+}
+
+/**
+* \brief Converts a fixed-point matrix to floating point.
+* \param[in] mat The fixed-point matrix
+* \param[out] target The floating point matrix of the same dimensions
+*/
+void matrix_q_to_float(const matrix_q_t *RESTRICT const mat, matrix_t *RESTRICT const target)
+{
+    uint_fast16_t i;
+    const uint_fast16_t count = mat->rows * mat->cols;
+    const double scale = ldexp(1.0, -(int)mat->frac);
+
+    assert(mat->rows == target->rows && mat->cols == target->cols);
+
+    for (i = 0; i < count; ++i)
+    {
+        target->data[i] = (matrix_data_t)(mat->data[i] * scale);
+    }
+}
+
+/*!
+* \brief Calculates the saturating dot product of two strided fixed-point vectors.
+* \param[in] a The first vector
+* \param[in] b The second vector
+* \param[in] bstride The stride of the second vector
+* \param[in] count The number of elements
+* \return The dot product with the fractional bits of both vectors combined
+*/
+static INLINE matrix_q_accum_t matrix_q_dot(const matrix_q_data_t *RESTRICT a, const matrix_q_data_t *RESTRICT b, const uint_fast8_t bstride, const uint_fast8_t count)
+{
+    uint_fast8_t k;
+    matrix_q_accum_t total = 0;
+
+    for (k = 0; k < count; ++k)
+    {
+        total = matrix_q_accum_add(total, (matrix_q_accum_t)a[k] * b[k * bstride]);
+    }
+
+    return total;
+}
+
+/*!
+* \brief Performs a matrix multiplication such that {\ref c} = {\ref a} * {\ref b}
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[out] c Resulting matrix C
+*/
+void matrix_q_mult(const matrix_q_t *const a, const matrix_q_t *const b, const matrix_q_t *RESTRICT c)
+{
+    uint_fast8_t i, j;
+    const int_fast8_t shift = (int_fast8_t)(a->frac + b->frac) - (int_fast8_t)c->frac;
+
+    assert(a->cols == b->rows);
+    assert(c->rows == a->rows && c->cols == b->cols);
+    assert(a->data != c->data && b->data != c->data);
+
+    for (i = 0; i < a->rows; ++i)
+    {
+        const matrix_q_data_t *RESTRICT const arow = &a->data[i * a->cols];
+        for (j = 0; j < b->cols; ++j)
+        {
+            c->data[i * c->cols + j] = matrix_q_narrow(matrix_q_dot(arow, &b->data[j], b->cols, a->cols), shift);
+        }
+    }
+}
+
+/*!
+* \brief Performs a matrix multiplication with transposed B such that {\ref c} = {\ref a} * {\ref b'}
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[out] c Resulting matrix C
+*/
+void matrix_q_mult_transb(const matrix_q_t *const a, const matrix_q_t *const b, const matrix_q_t *RESTRICT c)
+{
+    uint_fast8_t i, j;
+    const int_fast8_t shift = (int_fast8_t)(a->frac + b->frac) - (int_fast8_t)c->frac;
+
+    assert(a->cols == b->cols);
+    assert(c->rows == a->rows && c->cols == b->rows);
+    assert(a->data != c->data && b->data != c->data);
+
+    for (i = 0; i < a->rows; ++i)
+    {
+        const matrix_q_data_t *RESTRICT const arow = &a->data[i * a->cols];
+        for (j = 0; j < b->rows; ++j)
+        {
+            c->data[i * c->cols + j] = matrix_q_narrow(matrix_q_dot(arow, &b->data[j * b->cols], 1, a->cols), shift);
+        }
+    }
+}
+
+/*!
+* \brief Performs a matrix multiplication such that {\ref c} = {\ref a} * {\ref x}
+* \param[in] a Matrix A
+* \param[in] x Vector x
+* \param[out] c Resulting vector C (will be overwritten)
+*/
+void matrix_q_mult_rowvector(const matrix_q_t *RESTRICT const a, const matrix_q_t *RESTRICT const x, matrix_q_t *RESTRICT const c)
+{
+    uint_fast8_t i;
+    const int_fast8_t shift = (int_fast8_t)(a->frac + x->frac) - (int_fast8_t)c->frac;
+
+    assert(a->cols == x->rows && x->cols == 1);
+    assert(c->rows == a->rows && c->cols == 1);
+
+    for (i = 0; i < a->rows; ++i)
+    {
+        c->data[i] = matrix_q_narrow(matrix_q_dot(&a->data[i * a->cols], x->data, 1, a->cols), shift);
+    }
+}
+
+/*!
+* \brief Performs a matrix multiplication such that {\ref c} = {\ref c} + {\ref a} * {\ref x}
+* \param[in] a Matrix A
+* \param[in] x Vector x
+* \param[out] c Resulting vector C (will be added to)
+*/
+void matrix_q_multadd_rowvector(const matrix_q_t *RESTRICT const a, const matrix_q_t *RESTRICT const x, matrix_q_t *RESTRICT const c)
+{
+    uint_fast8_t i;
+    const int_fast8_t shift = (int_fast8_t)(a->frac + x->frac) - (int_fast8_t)c->frac;
+
+    assert(a->cols == x->rows && x->cols == 1);
+    assert(c->rows == a->rows && c->cols == 1);
+
+    for (i = 0; i < a->rows; ++i)
+    {
+        const matrix_q_accum_t total = (matrix_q_accum_t)c->data[i] + matrix_q_narrow(matrix_q_dot(&a->data[i * a->cols], x->data, 1, a->cols), shift);
+        c->data[i] = matrix_q_narrow(total, 0);
+    }
+}
+
+/*!
+* \brief Performs a matrix multiplication such that {\ref c} = {\ref c} - {\ref a} * {\ref b}
+* \param[in] a Matrix A
+* \param[in] b Matrix B
+* \param[out] c Resulting matrix C (will be subtracted from)
+*/
+void matrix_q_multsub(const matrix_q_t *RESTRICT const a, const matrix_q_t *RESTRICT const b, const matrix_q_t *RESTRICT c)
+{
+    uint_fast8_t i, j;
+    const int_fast8_t shift = (int_fast8_t)(a->frac + b->frac) - (int_fast8_t)c->frac;
+
+    assert(a->cols == b->rows);
+    assert(c->rows == a->rows && c->cols == b->cols);
+
+    for (i = 0; i < a->rows; ++i)
+    {
+        const matrix_q_data_t *RESTRICT const arow = &a->data[i * a->cols];
+        for (j = 0; j < b->cols; ++j)
+        {
+            matrix_q_data_t *RESTRICT const target = &c->data[i * c->cols + j];
+            const matrix_q_accum_t total = (matrix_q_accum_t)*target - matrix_q_narrow(matrix_q_dot(arow, &b->data[j], b->cols, a->cols), shift);
+            *target = matrix_q_narrow(total, 0);
+        }
+    }
+}
+
+/*!
+* \brief Adds two matrices in place, using {\ref a} = {\ref a} + {\ref b}
+* \param[in] a The matrix to add to, also the output.
+* \param[in] b The values to add.
+*/
+void matrix_q_add_inplace(const matrix_q_t *RESTRICT a, const matrix_q_t *RESTRICT const b)
+{
+    uint_fast16_t i;
+    const uint_fast16_t count = a->rows * a->cols;
+
+    assert(a->rows == b->rows && a->cols == b->cols);
+    assert(a->frac == b->frac);
+
+    for (i = 0; i < count; ++i)
+    {
+        a->data[i] = matrix_q_narrow((matrix_q_accum_t)a->data[i] + b->data[i], 0);
+    }
+}
+
+/*!
+* \brief Subtracts two matrices in place, using {\ref b} = {\ref a} - {\ref b}
+* \param[in] a The matrix to subtract from.
+* \param[in] b The values to subtract, also the output.
+*/
+void matrix_q_sub_inplace_b(const matrix_q_t *RESTRICT const a, const matrix_q_t *RESTRICT b)
+{
+    uint_fast16_t i;
+    const uint_fast16_t count = a->rows * a->cols;
+
+    assert(a->rows == b->rows && a->cols == b->cols);
+    assert(a->frac == b->frac);
+
+    for (i = 0; i < count; ++i)
+    {
+        b->data[i] = matrix_q_narrow((matrix_q_accum_t)a->data[i] - b->data[i], 0);
+    }
+}
@@ -1,5 +1,7 @@
 #include <stdio.h>
 #include <assert.h>
+#include <math.h>
+#include <stdlib.h>
 
 #define EXTERN_INLINE_MATRIX static INLINE
 
@@ -42,6 +44,157 @@ void test_matrix_inverse()
     assert(test >= 1.3);
 }
 
+/**
+* \brief Tests solving X*S = B' using the Cholesky decomposition of S
+*/
+void test_cholesky_solve_transb()
+{
+    int result;
+
+    // data buffer for the original and decomposed matrix
+    matrix_data_t d[2 * 2] = { 4, 2,
+        2, 3 };
+
+    // right-hand side, chosen such that X = [1 0; 0 1; 1 -1]
+    matrix_data_t b[2 * 3] = { 4, 2, 2,
+        2, 3, -1 };
+
+    // data buffer for the solution
+    matrix_data_t x[3 * 2] = { 0 };
+
+    // prepare matrix structures
+    matrix_t m, mb, mx;
+
+    // initialize the matrices
+    matrix_init(&m, 2, 2, d);
+    matrix_init(&mb, 2, 3, b);
+    matrix_init(&mx, 3, 2, x);
+
+    // decompose matrix to lower triangular
+    result = cholesky_decompose_lower(&m);
+    assert(result == 0);
+
+    // solve using the lower triangular
+    cholesky_solve_transb(&m, &mb, &mx);
+
+    // test the result
+    assert(fabs(x[0] - 1) < 1e-5 && fabs(x[1] - 0) < 1e-5);
+    assert(fabs(x[2] - 0) < 1e-5 && fabs(x[3] - 1) < 1e-5);
+    assert(fabs(x[4] - 1) < 1e-5 && fabs(x[5] + 1) < 1e-5);
+}
+
+/*!
+* \brief Tests the double precision Cholesky decomposition and substitution
+*/
+void test_cholesky_solve_transb_wide()
+{
+    int result;
+
+    // data buffer for the original and decomposed matrix
+    matrix_wide_t d[2 * 2] = { 4, 2,
+        2, 3 };
+
+    // right-hand side, chosen such that X = [1 0; 0 1; 1 -1]
+    matrix_data_t b[2 * 3] = { 4, 2, 2,
+        2, 3, -1 };
+
+    // data buffer for the solution
+    matrix_data_t x[3 * 2] = { 0 };
+
+    // auxiliary buffer for the substitution
+    matrix_wide_t aux[2];
+
+    // prepare matrix structures
+    matrix_t mb, mx;
+
+    // initialize the matrices
+    matrix_init(&mb, 2, 3, b);
+    matrix_init(&mx, 3, 2, x);
+
+    // decompose matrix to lower triangular
+    result = cholesky_decompose_lower_wide(d, 2);
+    assert(result == 0);
+    assert(d[0] == 2 && d[1] == 0 && d[2] == 1);
+
+    // solve using the lower triangular
+    cholesky_solve_transb_wide(d, &mb, &mx, aux);
+
+    // test the result
+    assert(fabs(x[0] - 1) < 1e-6 && fabs(x[1] - 0) < 1e-6);
+    assert(fabs(x[2] - 0) < 1e-6 && fabs(x[3] - 1) < 1e-6);
+    assert(fabs(x[4] - 1) < 1e-6 && fabs(x[5] + 1) < 1e-6);
+}
+
+/*!
+* \brief Tests the fixed-point kernels and Cholesky decomposition
+*/
+void test_matrix_q()
+{
+    int result;
+
+    // Q15.16 data, [1 2; 3 4] * [0.5 -1; 0.25 2]
+    matrix_q_data_t ad[2 * 2] = { 1 << 16, 2 << 16,
+        3 << 16, 4 << 16 };
+    matrix_q_data_t bd[2 * 2] = { 1 << 15, -(1 << 16),
+        1 << 14, 2 << 16 };
+    matrix_q_data_t cd[2 * 2];
+
+    // S = [4 2; 2 3] decomposes into L = [2 0; 1 sqrt(2)]
+    matrix_data_t sd[2 * 2] = { 4, 2,
+        2, 3 };
+    matrix_q_data_t sqd[2 * 2];
+
+    // right-hand side, chosen such that X = [1 0; 0 1; 1 -1]
+    matrix_q_data_t rd[2 * 3] = { 4 << 16, 2 << 16, 2 << 16,
+        2 << 16, 3 << 16, -(1 << 16) };
+    matrix_q_data_t xd[3 * 2];
+
+    // saturation
+    matrix_q_data_t hd[1 * 1] = { MATRIX_Q_MAX };
+    matrix_q_data_t od[1 * 1];
+
+    // prepare matrix structures
+    matrix_q_t a, b, c, sq, r, x, h, o;
+    matrix_t s;
+
+    // initialize the matrices
+    matrix_q_init(&a, 2, 2, 16, ad);
+    matrix_q_init(&b, 2, 2, 16, bd);
+    matrix_q_init(&c, 2, 2, 16, cd);
+    matrix_q_init(&sq, 2, 2, 16, sqd);
+    matrix_q_init(&r, 2, 3, 16, rd);
+    matrix_q_init(&x, 3, 2, 16, xd);
+    matrix_q_init(&h, 1, 1, 16, hd);
+    matrix_q_init(&o, 1, 1, 16, od);
+    matrix_init(&s, 2, 2, sd);
+
+    // C = A*B = [1 3; 2.5 5]
+    matrix_q_mult(&a, &b, &c);
+    assert(cd[0] == (1 << 16) && cd[1] == (3 << 16));
+    assert(cd[2] == (5 << 15) && cd[3] == (5 << 16));
+
+    // C = A*B' = [-1.5 4.25; -2.5 8.75]
+    matrix_q_mult_transb(&a, &b, &c);
+    assert(cd[0] == -(3 << 15) && cd[1] == (17 << 14));
+    assert(cd[2] == -(5 << 15) && cd[3] == (35 << 14));
+
+    // decompose and solve
+    matrix_q_from_float(&s, &sq);
+    result = cholesky_decompose_lower_q(&sq);
+    assert(result == 0);
+    assert(sqd[0] == (2 << 16) && sqd[1] == 0 && sqd[2] == (1 << 16));
+    assert(abs(sqd[3] - 92682) <= 1);
+
+    cholesky_solve_transb_q(&sq, &r, &x);
+    assert(abs(xd[0] - (1 << 16)) <= 2 && abs(xd[1]) <= 2);
+    assert(abs(xd[2]) <= 2 && abs(xd[3] - (1 << 16)) <= 2);
+    assert(abs(xd[4] - (1 << 16)) <= 2 && abs(xd[5] + (1 << 16)) <= 2);
+
+    // saturation instead of overflow
+    matrix_q_mult(&h, &h, &o);
+    assert(od[0] == MATRIX_Q_MAX);
+}
+
 /*!
 * \brief Tests column and row fetching
 */
@@ -218,6 +371,292 @@ void test_matrix_multadd_transb()
     assert(cd[8] == 11 + 90);
 }
 
+/*!
+*  \brief Tests matrix multiplication with transposed B and a symmetric result
+*/
+void test_matrix_multiply_transb_symmetric()
+{
+    matrix_data_t ad[3 * 2] = { 1, 2,
+        3, 4,
+        5, 6 };
+
+    matrix_data_t cd[3 * 3] = { 0, 0, 0,
+        0, 0, 0,
+        0, 0, 0 };
+
+    matrix_data_t ed[3 * 3] = { 1, 2, 3,
+        2, 1, 4,
+        3, 4, 1 };
+
+    // prepare matrix structures
+    matrix_t a, c, e;
+
+    // initialize the matrices
+    matrix_init(&a, 3, 2, ad);
+    matrix_init(&c, 3, 3, cd);
+    matrix_init(&e, 3, 3, ed);
+
+    // multiply
+    matrix_mult_transb_symmetric(&a, &a, &c);
+    assert(cd[0] == 5);
+    assert(cd[1] == 11 && cd[3] == 11);
+    assert(cd[5] == 39 && cd[7] == 39);
+    assert(cd[8] == 61);
+
+    // multiply and scale
+    matrix_multscale_transb_symmetric(&a, &a, 2, &c);
+    assert(cd[2] == 17 * 2 && cd[6] == 17 * 2);
+    assert(cd[4] == 25 * 2);
+
+    // multiply and add
+    matrix_multadd_transb_symmetric(&a, &a, &e);
+    assert(ed[0] == 5 + 1);
+    assert(ed[1] == 11 + 2 && ed[3] == 11 + 2);
+    assert(ed[7] == 39 + 4 && ed[5] == 39 + 4);
+}
+
+/*!
+*  \brief Tests the in-place covariance propagation A*P*A' + BQ*B'
+*/
+void test_matrix_mult_abat()
+{
+    matrix_data_t ad[3 * 3] = { 1, 1, 0.5,
+        0, 1, 1,
+        0, 0, 1 };
+
+    matrix_data_t pd[3 * 3] = { 1, 0.5, 0,
+        0.5, 2, 0,
+        0, 0, 1 };
+
+    matrix_data_t bqd[3 * 1] = { 2, 2, 4 };
+
+    matrix_data_t bd[3 * 1] = { 1, 1, 2 };
+
+    matrix_data_t aux[3] = { 0, 0, 0 };
+
+    // prepare matrix structures
+    matrix_t a, p, bq, b;
+
+    // initialize the matrices
+    matrix_init(&a, 3, 3, ad);
+    matrix_init(&p, 3, 3, pd);
+    matrix_init(&bq, 3, 1, bqd);
+    matrix_init(&b, 3, 1, bd);
+
+    // A*P*A' = [4.25 3 0.5; 3 3 1; 0.5 1 1], BQ*B' = [2 2 4; 2 2 4; 4 4 8]
+    matrix_mult_abat(&a, &p, 2, &bq, &b, aux);
+    assert(pd[0] == 4.25 * 2 + 2);
+    assert(pd[1] == 3 * 2 + 2 && pd[3] == 3 * 2 + 2);
+    assert(pd[2] == 0.5 * 2 + 4 && pd[6] == 0.5 * 2 + 4);
+    assert(pd[4] == 3 * 2 + 2);
+    assert(pd[5] == 1 * 2 + 4 && pd[7] == 1 * 2 + 4);
+    assert(pd[8] == 1 * 2 + 8);
+}
+
+/*!
+*  \brief Tests the sparse kernels against their dense counterparts
+*/
+void test_matrix_sparse()
+{
+    matrix_data_t ad[3 * 3] = { 1, 1, 0.5,
+        0, 1, 1,
+        0, 0, 1 };
+
+    matrix_data_t pd[3 * 3] = { 1, 0.5, 0,
+        0.5, 2, 0,
+        0, 0, 1 };
+
+    matrix_data_t pds[3 * 3] = { 1, 0.5, 0,
+        0.5, 2, 0,
+        0, 0, 1 };
+
+    matrix_data_t bqd[3 * 1] = { 2, 2, 4 };
+
+    matrix_data_t bd[3 * 1] = { 1, 1, 2 };
+
+    matrix_data_t xd[3] = { 1, 2, 3 };
+    matrix_data_t cd[3] = { 0, 0, 0 };
+    matrix_data_t cds[3] = { 0, 0, 0 };
+
+    matrix_data_t aux[3] = { 0, 0, 0 };
+
+    uint_fast16_t offsets[2 * 3 + 1];
+    uint_fast8_t columns[3 * 3];
+    uint_fast16_t count;
+    int i;
+
+    // prepare matrix structures
+    matrix_t a, p, ps, bq, b, x, c, cs;
+    matrix_sparsity_t sparsity;
+
+    // initialize the matrices
+    matrix_init(&a, 3, 3, ad);
+    matrix_init(&p, 3, 3, pd);
+    matrix_init(&ps, 3, 3, pds);
+    matrix_init(&bq, 3, 1, bqd);
+    matrix_init(&b, 3, 1, bd);
+    matrix_init(&x, 3, 1, xd);
+    matrix_init(&c, 3, 1, cd);
+    matrix_init(&cs, 3, 1, cds);
+
+    // five unit entries and a single general entry (0.5)
+    sparsity.offsets = offsets;
+    sparsity.columns = columns;
+    count = matrix_sparsity_analyze(&a, &sparsity);
+    assert(count == 1);
+    assert(offsets[0] == 0 && offsets[1] == 2 && offsets[2] == 3);
+    assert(offsets[3] == 5 && offsets[4] == 5);
+    assert(offsets[5] == 6 && offsets[6] == 6);
+
+    matrix_mult_rowvector(&a, &x, &c);
+    matrix_mult_rowvector_sparse(&a, &sparsity, &x, &cs);
+    for (i = 0; i < 3; ++i) { assert(cd[i] == cds[i]); }
+
+    matrix_mult_abat(&a, &p, 2, &bq, &b, aux);
+    matrix_mult_abat_sparse(&a, &sparsity, &ps, 2, &bq, &b, aux);
+    for (i = 0; i < 3 * 3; ++i) { assert(fabs(pd[i] - pds[i]) < 1e-5); }
+}
+
+/*!
+*  \brief Tests the triangularization of a wide matrix
+*/
+void test_matrix_triangularize_lower()
+{
+    matrix_data_t md[3 * 5] = { 1, 2, 0, 1, 0,
+        -1, 0, 3, 0, 2,
+        4, 1, 1, -2, 0 };
+
+    matrix_data_t ld[3 * 5];
+    matrix_data_t mmt[3 * 3];
+    matrix_data_t llt[3 * 3];
+    int i, j;
+
+    // prepare matrix structures
+    matrix_t m, l, a, b;
+
+    // initialize the matrices
+    matrix_init(&m, 3, 5, md);
+    matrix_init(&l, 3, 5, ld);
+    matrix_init(&a, 3, 3, mmt);
+    matrix_init(&b, 3, 3, llt);
+
+    // L = M*Q', with L*L' = M*M'
+    matrix_copy(&m, &l);
+    matrix_triangularize_lower(&l);
+    matrix_mult_transb(&m, &m, &a);
+    matrix_mult_transb(&l, &l, &b);
+
+    for (i = 0; i < 3; ++i)
+    {
+        assert(ld[i * 5 + i] > 0);
+        for (j = i + 1; j < 5; ++j) { assert(ld[i * 5 + j] == 0); }
+    }
+    for (i = 0; i < 3 * 3; ++i) { assert(fabs(mmt[i] - llt[i]) < 1e-4); }
+}
+
+/*!
+*  \brief Tests the packed UD decomposition
+*/
+void test_cholesky_udu()
+{
+    matrix_data_t pd[3 * 3] = { 4, 2, 0.4,
+        2, 3, 0.5,
+        0.4, 0.5, 2 };
+
+    matrix_data_t ud[3 * (3 + 1) / 2];
+    matrix_data_t rd[3 * 3];
+    int result, i;
+
+    // prepare matrix structures
+    matrix_t p, r;
+
+    // initialize the matrices
+    matrix_init(&p, 3, 3, pd);
+    matrix_init(&r, 3, 3, rd);
+
+    // D(2) = P(2,2), U(1,2) = P(1,2) / D(2)
+    result = cholesky_decompose_udu(&p, ud);
+    assert(result == 0);
+    assert(ud[5] == 2);
+    assert(fabs(ud[4] - 0.25) < 1e-6);
+
+    cholesky_compose_udu(ud, &r);
+    for (i = 0; i < 3 * 3; ++i) { assert(fabs(pd[i] - rd[i]) < 1e-5); }
+
+    // not positive definite
+    pd[0] = 1;
+    result = cholesky_decompose_udu(&p, ud);
+    assert(result != 0);
+}
+
+/*!
+*  \brief Tests symmetric matrix multiplication and subtraction
+*/
+void test_matrix_multsub_symmetric()
+{
+    matrix_data_t kd[3 * 1] = { 1, 2, 3 };
+
+    matrix_data_t hpd[1 * 3] = { 1, 2, 3 };
+
+    matrix_data_t pd[3 * 3] = { 10, 20, 30,
+        20, 50, 60,
+        30, 60, 90 };
+
+    // prepare matrix structures
+    matrix_t k, hp, p;
+
+    // initialize the matrices
+    matrix_init(&k, 3, 1, kd);
+    matrix_init(&hp, 1, 3, hpd);
+    matrix_init(&p, 3, 3, pd);
+
+    // P -= K*HP
+    matrix_multsub_symmetric(&k, &hp, &p);
+    assert(pd[0] == 10 - 1);
+    assert(pd[1] == 20 - 2 && pd[3] == 20 - 2);
+    assert(pd[5] == 60 - 6 && pd[7] == 60 - 6);
+    assert(pd[8] == 90 - 9);
+}
+
+/*!
+*  \brief Tests the weighted sum of outer products
+*/
+void test_matrix_multadd_weighted_transb()
+{
+    // three samples of two and one variables, one sample per column
+    matrix_data_t ad[2 * 3] = { 1, -1, 2,
+        0, 3, 1 };
+
+    matrix_data_t bd[1 * 3] = { 2, 1, -1 };
+
+    matrix_data_t w[3] = { 0.5, 2, 1 };
+
+    matrix_data_t cd[2 * 2] = { 1, 0,
+        0, 1 };
+
+    matrix_data_t xd[2 * 1] = { 0, 0 };
+
+    // prepare matrix structures
+    matrix_t a, b, c, x;
+
+    // initialize the matrices
+    matrix_init(&a, 2, 3, ad);
+    matrix_init(&b, 1, 3, bd);
+    matrix_init(&c, 2, 2, cd);
+    matrix_init(&x, 2, 1, xd);
+
+    // C += A*diag(w)*A'
+    matrix_multadd_weighted_transb(&a, w, &a, &c);
+    assert(cd[0] == 1 + 0.5 + 2 + 4);
+    assert(cd[1] == -6 + 2 && cd[2] == -6 + 2);
+    assert(cd[3] == 1 + 18 + 1);
+
+    // X = A*diag(w)*B'
+    matrix_multadd_weighted_transb(&a, w, &b, &x);
+    assert(xd[0] == 1 - 2 - 2);
+    assert(xd[1] == 6 - 1);
+}
+
 /*!
 *  \brief Tests matrix multiplication
 */
@@ -386,21 +825,110 @@ void test_matrix_copy()
     assert(ad[8] == 11);
 }
 
+/*!
+* \brief Runs every dispatched kernel on odd-sized operands using the currently selected backend
+*/
+static void run_matrix_kernels(matrix_data_t *results)
+{
+    matrix_data_t ad[13 * 11], bd[11 * 9], btd[9 * 11], xd[11], sd[13 * 13];
+    matrix_data_t aux[11];
+    int i;
+
+    // prepare matrix structures
+    matrix_t a, b, bt, x, c, ct, ctt, v, sym;
+
+    for (i = 0; i < 13 * 11; ++i) { ad[i] = (matrix_data_t)((i * 7) % 13) - 6; }
+    for (i = 0; i < 11 * 9; ++i) { bd[i] = (matrix_data_t)((i * 5) % 11) * (matrix_data_t)0.25; }
+    for (i = 0; i < 9 * 11; ++i) { btd[i] = (matrix_data_t)((i * 3) % 7) - 3; }
+    for (i = 0; i < 11; ++i) { xd[i] = (matrix_data_t)i * (matrix_data_t)0.5; }
+
+    // initialize the matrices
+    matrix_init(&a, 13, 11, ad);
+    matrix_init(&b, 11, 9, bd);
+    matrix_init(&bt, 9, 11, btd);
+    matrix_init(&x, 11, 1, xd);
+    matrix_init(&c, 13, 9, &results[0]);
+    matrix_init(&ct, 13, 9, &results[13 * 9]);
+    matrix_init(&ctt, 13, 9, &results[2 * 13 * 9]);
+    matrix_init(&v, 13, 1, &results[3 * 13 * 9]);
+    matrix_init(&sym, 13, 13, sd);
+
+    // multiply
+    matrix_mult(&a, &b, &c, aux);
+    matrix_multadd_transb(&a, &bt, &c);
+    matrix_multscale_transb(&a, &bt, 2, &ct);
+    matrix_mult_transb(&a, &bt, &ctt);
+    matrix_mult_rowvector(&a, &x, &v);
+    matrix_multadd_rowvector(&a, &x, &v);
+
+    // symmetric products, folded into the vector result
+    matrix_mult_transb_symmetric(&a, &a, &sym);
+    for (i = 0; i < 13; ++i) { results[3 * 13 * 9 + i] += sd[i * 13 + (12 - i)]; }
+    matrix_multscale_transb_symmetric(&a, &a, 3, &sym);
+    matrix_multadd_transb_symmetric(&a, &a, &sym);
+    for (i = 0; i < 13; ++i) { results[3 * 13 * 9 + i] += sd[(12 - i) * 13 + i]; }
+
+    // covariance propagation of the symmetric product
+    matrix_init(&a, 11, 11, ad);
+    matrix_init(&sym, 11, 11, sd);
+    matrix_init(&bt, 11, 9, btd);
+    matrix_mult_abat(&a, &sym, (matrix_data_t)0.5, &bt, &bt, aux);
+    for (i = 0; i < 11; ++i) { results[3 * 13 * 9 + i] += sd[i * 11 + (10 - i)] * (matrix_data_t)0.01; }
+}
+
+/*!
+*  \brief Tests that all kernel backends produce the same results
+*/
+void test_matrix_backends()
+{
+    matrix_data_t expected[3 * 13 * 9 + 13];
+    matrix_data_t actual[3 * 13 * 9 + 13];
+    const matrix_backend_t previous = matrix_get_backend();
+    int i;
+
+    // reference results from the scalar kernels
+    matrix_select_backend(MATRIX_BACKEND_SCALAR);
+    assert(matrix_get_backend() == MATRIX_BACKEND_SCALAR);
+    run_matrix_kernels(expected);
+
+    // results of the best available backend
+    matrix_select_backend(MATRIX_BACKEND_AUTO);
+    run_matrix_kernels(actual);
+
+    for (i = 0; i < 3 * 13 * 9 + 13; ++i)
+    {
+        assert(fabs(expected[i] - actual[i]) <= 1e-4 * (1 + fabs(expected[i])));
+    }
+
+    matrix_select_backend(previous);
+}
+
 /*!
 * \brief Unit tests for matrix operations
 */
 void matrix_unittests()
 {
     test_matrix_inverse();
+    test_cholesky_solve_transb();
+    test_cholesky_solve_transb_wide();
+    test_cholesky_udu();
+    test_matrix_q();
     test_matrix_copy_cols_and_rows();
     test_matrix_multiply_aux();
     test_matrix_multiply_transb();
     test_matrix_multscale_transb();
     test_matrix_multadd_transb();
+    test_matrix_multiply_transb_symmetric();
+    test_matrix_mult_abat();
+    test_matrix_sparse();
+    test_matrix_triangularize_lower();
+    test_matrix_multsub_symmetric();
+    test_matrix_multadd_weighted_transb();
     test_matrix_multiply_vector();
     test_matrix_multiplyadd_vector();
     test_matrix_add_inplace();
     test_matrix_sub_inplace_b();
     test_matrix_sub();
     test_matrix_copy();
+    test_matrix_backends();
 }